@@ -5,6 +5,7 @@
 #include "xwalk/application/browser/application.h"
 
 #include <string>
+#include <vector>
 
 #include "base/files/file_enumerator.h"
 #include "base/json/json_reader.h"
@@ -39,19 +40,30 @@ namespace widget_keys = application_widget_keys;
 
 namespace {
 
-GURL GetDefaultWidgetEntryPage(
+std::vector<base::FilePath> GetWidgetEntryPageCandidates(
     scoped_refptr<xwalk::application::ApplicationData> data) {
+  std::vector<base::FilePath> files;
+  if (data->archive())
+    return data->archive()->GetFilePaths();
+
   base::ThreadRestrictions::SetIOAllowed(true);
   base::FileEnumerator iter(
       data->path(), true,
       base::FileEnumerator::FILES,
       FILE_PATH_LITERAL("index.*"));
+  for (base::FilePath file = iter.Next(); !file.empty(); file = iter.Next())
+    files.push_back(file);
+  return files;
+}
+
+GURL GetDefaultWidgetEntryPage(
+    scoped_refptr<xwalk::application::ApplicationData> data) {
   const std::vector<std::string>& defaultWidgetEntryPages =
       application::WGTPackage::GetDefaultWidgetEntryPages();
   size_t priority = defaultWidgetEntryPages.size();
   std::string source;
 
-  for (base::FilePath file = iter.Next(); !file.empty(); file = iter.Next()) {
+  for (const base::FilePath& file : GetWidgetEntryPageCandidates(data)) {
     for (size_t i = 0; i < priority; ++i) {
       if (file.BaseName().MaybeAsASCII() == defaultWidgetEntryPages[i]) {
         source = defaultWidgetEntryPages[i];
@@ -5,6 +5,9 @@
 
 #include "xwalk/application/browser/application_protocols.h"
 
+#include <inttypes.h>
+#include <string.h>
+
 #include <algorithm>
 #include <map>
 #include <list>
@@ -13,29 +16,43 @@
 #include <vector>
 
 #include "base/files/file_path.h"
+#include "base/files/file_util.h"
 #include "base/memory/weak_ptr.h"
 #include "base/numerics/safe_math.h"
+#include "base/strings/string_piece.h"
+#include "base/strings/string_split.h"
 #include "base/strings/stringprintf.h"
 #include "base/strings/string_util.h"
+#include "base/task_runner_util.h"
 #include "base/threading/thread_restrictions.h"
-#include "base/threading/worker_pool.h"
+#include "base/threading/thread_task_runner_handle.h"
 #include "base/threading/sequenced_worker_pool.h"
+#include "base/time/time.h"
 #include "content/public/browser/browser_thread.h"
 #include "content/public/browser/resource_request_info.h"
 #include "url/url_util.h"
+#include "net/base/io_buffer.h"
+#include "net/base/mime_util.h"
 #include "net/base/net_errors.h"
+#include "net/filter/filter.h"
+#include "net/http/http_byte_range.h"
+#include "net/http/http_request_headers.h"
 #include "net/http/http_response_headers.h"
 #include "net/http/http_response_info.h"
+#include "net/http/http_util.h"
 #include "net/url_request/url_request_error_job.h"
 #include "net/url_request/url_request_file_job.h"
 #include "net/url_request/url_request_simple_job.h"
 #include "xwalk/application/browser/application_service.h"
+#include "xwalk/application/browser/application_snapshot_map.h"
 #include "xwalk/application/common/application_data.h"
 #include "xwalk/application/common/application_file_util.h"
 #include "xwalk/application/common/application_manifest_constants.h"
 #include "xwalk/application/common/application_resource.h"
+#include "xwalk/application/common/application_resource_cache.h"
 #include "xwalk/application/common/constants.h"
 #include "xwalk/application/common/manifest_handlers/csp_handler.h"
+#include "xwalk/application/common/package/package_archive.h"
 #include "xwalk/runtime/common/xwalk_system_locale.h"
 
 using content::BrowserThread;
@@ -49,34 +66,116 @@ namespace application {
 
 namespace {
 
+// Resources are revalidated before each use unless the manifest says
+// otherwise.
+const char kDefaultCacheControl[] = "no-cache";
+const base::FilePath::CharType kGzipExtension[] = FILE_PATH_LITERAL(".gz");
+
+const char kSpace[] = " ";
+const char kSemicolon[] = ";";
+
+// The |locale| should be expanded to user agent locale.
+// Such as, "en-us" will be expaned as "en-us, en".
+void GetUserAgentLocales(const std::string& sys_locale,
+                         std::list<std::string>& ua_locales) {  // NOLINT
+  if (sys_locale.empty())
+    return;
+
+  std::string locale = base::ToLowerASCII(sys_locale);
+  size_t position;
+  do {
+    ua_locales.push_back(locale);
+    position = locale.find_last_of("-");
+    locale = locale.substr(0, position);
+  } while (position != std::string::npos);
+}
+
+// What the app:// responses of an application have in common. It is built
+// once, when the application is launched, and shared by all the requests.
+class ResponseTemplate : public base::RefCountedThreadSafe<ResponseTemplate> {
+ public:
+  explicit ResponseTemplate(scoped_refptr<ApplicationData> application)
+      : application_(application) {
+    const char* csp_key = GetCSPKey(application->manifest_type());
+    const CSPInfo* csp_info =
+        static_cast<CSPInfo*>(application->GetManifestData(csp_key));
+    if (csp_info && !csp_info->GetDirectives().empty()) {
+      headers_.append(1, '\0');
+      headers_.append("Content-Security-Policy: ");
+      for (auto& directive : csp_info->GetDirectives()) {
+        headers_.append(directive.first)
+            .append(kSpace)
+            .append(base::JoinString(directive.second, kSpace))
+            .append(kSemicolon);
+      }
+    }
+    headers_.append(1, '\0');
+    headers_.append("Access-Control-Allow-Origin: *");
+
+    if (!application->GetManifest()->GetString(keys::kXWalkCacheControlKey,
+                                               &cache_control_) ||
+        !net::HttpUtil::IsValidHeaderValue(cache_control_)) {
+      cache_control_ = kDefaultCacheControl;
+    }
+
+    if (application->manifest_type() == Manifest::TYPE_WIDGET) {
+      GetUserAgentLocales(GetSystemLocale(), locales_);
+      GetUserAgentLocales(application->GetManifest()->default_locale(),
+                          locales_);
+    }
+  }
+
+  ApplicationData* application() const { return application_.get(); }
+
+  // The headers every response has, in the format of the raw headers given
+  // to net::HttpResponseHeaders, each one preceded by a '\0'.
+  const std::string& headers() const { return headers_; }
+
+  const std::string& cache_control() const { return cache_control_; }
+
+  // The locales resources are looked up for, in order.
+  const std::list<std::string>& locales() const { return locales_; }
+
+ private:
+  friend class base::RefCountedThreadSafe<ResponseTemplate>;
+
+  ~ResponseTemplate() {}
+
+  scoped_refptr<ApplicationData> application_;
+  std::string headers_;
+  std::string cache_control_;
+  std::list<std::string> locales_;
+
+  DISALLOW_COPY_AND_ASSIGN(ResponseTemplate);
+};
+
 net::HttpResponseHeaders* BuildHttpHeaders(
-    const std::string& content_security_policy,
+    const ResponseTemplate& response_template,
     const std::string& mime_type, const std::string& method,
     const base::FilePath& file_path, const base::FilePath& relative_path) {
-  std::string raw_headers;
-  if (method == "GET") {
+  const char* status_line;
+  if (method == "GET" || method == "HEAD") {
     if (relative_path.empty())
-      raw_headers.append("HTTP/1.1 400 Bad Request");
+      status_line = "HTTP/1.1 400 Bad Request";
     else if (file_path.empty())
-      raw_headers.append("HTTP/1.1 404 Not Found");
+      status_line = "HTTP/1.1 404 Not Found";
     else
-      raw_headers.append("HTTP/1.1 200 OK");
+      status_line = "HTTP/1.1 200 OK";
   } else {
-    raw_headers.append("HTTP/1.1 501 Not Implemented");
-  }
-
-  if (!content_security_policy.empty()) {
-    raw_headers.append(1, '\0');
-    raw_headers.append("Content-Security-Policy: ");
-    raw_headers.append(content_security_policy);
+    status_line = "HTTP/1.1 501 Not Implemented";
   }
 
-  raw_headers.append(1, '\0');
-  raw_headers.append("Access-Control-Allow-Origin: *");
+  static const char kContentType[] = "Content-Type: ";
+  std::string raw_headers;
+  raw_headers.reserve(strlen(status_line) +
+                      response_template.headers().size() +
+                      sizeof(kContentType) + mime_type.size() + 2);
+  raw_headers.append(status_line);
+  raw_headers.append(response_template.headers());
 
   if (!mime_type.empty()) {
     raw_headers.append(1, '\0');
-    raw_headers.append("Content-Type: ");
+    raw_headers.append(kContentType);
     raw_headers.append(mime_type);
   }
 
@@ -84,10 +183,119 @@ net::HttpResponseHeaders* BuildHttpHeaders(
   return new net::HttpResponseHeaders(raw_headers);
 }
 
-void ReadResourceFilePath(
+// Formats |time| as an HTTP-date, e.g. "Sun, 06 Nov 1994 08:49:37 GMT".
+std::string FormatHTTPDate(base::Time time) {
+  static const char* const kDays[] = {
+      "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+  static const char* const kMonths[] = {
+      "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+      "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+  base::Time::Exploded exploded;
+  time.UTCExplode(&exploded);
+  return base::StringPrintf("%s, %02d %s %04d %02d:%02d:%02d GMT",
+                            kDays[exploded.day_of_week],
+                            exploded.day_of_month,
+                            kMonths[exploded.month - 1],
+                            exploded.year,
+                            exploded.hour,
+                            exploded.minute,
+                            exploded.second);
+}
+
+// Returns true if the conditional headers of a request show that the
+// client already has the resource with these validators.
+bool IsNotModified(const net::HttpRequestHeaders& request_headers,
+                   const std::string& etag,
+                   base::Time last_modified) {
+  std::string value;
+  // If-Modified-Since is ignored when If-None-Match is present.
+  if (request_headers.GetHeader(net::HttpRequestHeaders::kIfNoneMatch,
+                                &value)) {
+    for (base::StringPiece tag : base::SplitStringPiece(
+             value, ",", base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY)) {
+      // If-None-Match uses the weak comparison.
+      if (tag.starts_with("W/"))
+        tag.remove_prefix(2);
+      if (tag == "*" || tag == etag)
+        return true;
+    }
+    return false;
+  }
+
+  base::Time since;
+  if (last_modified.is_null() ||
+      !request_headers.GetHeader(net::HttpRequestHeaders::kIfModifiedSince,
+                                 &value) ||
+      !base::Time::FromString(value.c_str(), &since))
+    return false;
+  // Last-Modified only has a one second precision.
+  return base::Time::FromTimeT(last_modified.ToTimeT()) <= since;
+}
+
+void AddCacheHeaders(net::HttpResponseHeaders* headers,
+                     const std::string& cache_control,
+                     const std::string& etag,
+                     base::Time last_modified) {
+  headers->AddHeader("Cache-Control: " + cache_control);
+  headers->AddHeader("ETag: " + etag);
+  if (!last_modified.is_null())
+    headers->AddHeader("Last-Modified: " + FormatHTTPDate(last_modified));
+}
+
+// What was found on disk for a resource of an application.
+struct FileResourceInfo {
+  FileResourceInfo() : is_directory(false), size(0), encoded_size(0) {}
+
+  // Empty if the resource was not found.
+  base::FilePath file_path;
+  // The gzip compressed copy of |file_path| next to it, if there is one.
+  base::FilePath encoded_file_path;
+  std::string mime_type;
+  bool is_directory;
+  int64_t size;
+  base::Time last_modified;
+  // Those of |encoded_file_path|, which can be updated on its own.
+  int64_t encoded_size;
+  base::Time encoded_last_modified;
+};
+
+// Resources |application| resolved before only need to be checked for
+// changes.
+FileResourceInfo ReadFileResourceInfo(
+    scoped_refptr<ApplicationData> application,
     const ApplicationResource& resource,
-    base::FilePath* file_path) {
-  *file_path = resource.GetFilePath();
+    bool allow_encoded) {
+  FileResourceInfo info;
+  info.file_path = application->resource_cache()->GetFilePath(resource);
+  base::File::Info file_info;
+  if (info.file_path.empty() ||
+      !base::GetFileInfo(info.file_path, &file_info)) {
+    info.file_path.clear();
+    return info;
+  }
+
+  info.is_directory = file_info.is_directory;
+  info.size = file_info.size;
+  info.last_modified = file_info.last_modified;
+  if (info.is_directory)
+    return info;
+  net::GetMimeTypeFromFile(info.file_path, &info.mime_type);
+
+  if (!allow_encoded)
+    return info;
+  // |file_path| is resolved, so the copy is inside the application too if
+  // it resolves to the same folder.
+  base::FilePath encoded_file_path =
+      info.file_path.AddExtension(kGzipExtension);
+  if (base::GetFileInfo(encoded_file_path, &file_info) &&
+      !file_info.is_directory &&
+      base::MakeAbsoluteFilePath(encoded_file_path).DirName() ==
+          info.file_path.DirName()) {
+    info.encoded_file_path = encoded_file_path;
+    info.encoded_size = file_info.size;
+    info.encoded_last_modified = file_info.last_modified;
+  }
+  return info;
 }
 
 class URLRequestApplicationJob : public net::URLRequestFileJob {
@@ -96,80 +304,372 @@ class URLRequestApplicationJob : public net::URLRequestFileJob {
       net::URLRequest* request,
       net::NetworkDelegate* network_delegate,
       const scoped_refptr<base::TaskRunner>& file_task_runner,
-      const std::string& application_id,
-      const base::FilePath& directory_path,
-      const base::FilePath& relative_path,
-      const std::string& content_security_policy,
-      const std::list<std::string>& locales)
+      scoped_refptr<const ResponseTemplate> response_template,
+      const base::FilePath& relative_path)
       : net::URLRequestFileJob(
           request, network_delegate, base::FilePath(), file_task_runner),
-        content_security_policy_(content_security_policy),
-        locales_(locales),
-        resource_(application_id, directory_path, relative_path),
+        file_task_runner_(file_task_runner),
+        response_template_(response_template),
+        resource_(response_template->application()->ID(),
+                  response_template->application()->path(),
+                  relative_path),
         relative_path_(relative_path),
+        not_modified_(false),
         weak_factory_(this) {
   }
 
+  bool GetMimeType(std::string* mime_type) const override {
+    // |file_path_| may be the compressed copy.
+    if (info_.mime_type.empty())
+      return net::URLRequestFileJob::GetMimeType(mime_type);
+    *mime_type = info_.mime_type;
+    return true;
+  }
+
+  void SetExtraRequestHeaders(
+      const net::HttpRequestHeaders& headers) override {
+    request_headers_.CopyFrom(headers);
+    net::URLRequestFileJob::SetExtraRequestHeaders(headers);
+  }
+
   void GetResponseInfo(net::HttpResponseInfo* info) override {
     std::string mime_type;
     GetMimeType(&mime_type);
     std::string method = request()->method();
     response_info_.headers = BuildHttpHeaders(
-        content_security_policy_, mime_type, method, file_path_,
-        relative_path_);
+        *response_template_, mime_type, method, file_path_, relative_path_);
+    if (!etag_.empty() && (method == "GET" || method == "HEAD")) {
+      net::HttpResponseHeaders* headers = response_info_.headers.get();
+      if (not_modified_)
+        headers->ReplaceStatusLine("HTTP/1.1 304 Not Modified");
+      AddCacheHeaders(headers, response_template_->cache_control(), etag_,
+                      last_modified_);
+      if (!info_.encoded_file_path.empty()) {
+        headers->AddHeader("Content-Encoding: gzip");
+      } else if (method == "HEAD" && !not_modified_) {
+        headers->AddHeader(base::StringPrintf(
+            "Content-Length: %" PRId64, info_.size));
+      }
+    }
     *info = response_info_;
   }
 
   void Start() override {
-    base::FilePath* read_file_path = new base::FilePath;
-
-    resource_.SetLocales(locales_);
-    bool posted = base::WorkerPool::PostTaskAndReply(
+    // A range would apply to the compressed data.
+    bool allow_encoded =
+        !request_headers_.HasHeader(net::HttpRequestHeaders::kRange);
+    resource_.SetLocales(response_template_->locales());
+    bool posted = base::PostTaskAndReplyWithResult(
+        file_task_runner_.get(),
         FROM_HERE,
-        base::Bind(&ReadResourceFilePath, resource_,
-                   base::Unretained(read_file_path)),
-        base::Bind(&URLRequestApplicationJob::OnFilePathRead,
-                   weak_factory_.GetWeakPtr(),
-                   base::Owned(read_file_path)),
-        true /* task is slow */);
+        base::Bind(&ReadFileResourceInfo,
+                   make_scoped_refptr(response_template_->application()),
+                   resource_, allow_encoded),
+        base::Bind(&URLRequestApplicationJob::OnResourceInfoRead,
+                   weak_factory_.GetWeakPtr()));
     DCHECK(posted);
   }
 
+  std::unique_ptr<net::Filter> SetupFilter() const override {
+    if (!info_.encoded_file_path.empty())
+      return net::Filter::GZipFactory();
+    return net::URLRequestFileJob::SetupFilter();
+  }
+
  protected:
   ~URLRequestApplicationJob() override {}
 
-  std::string content_security_policy_;
-  std::list<std::string> locales_;
+  scoped_refptr<base::TaskRunner> file_task_runner_;
+  scoped_refptr<const ResponseTemplate> response_template_;
   ApplicationResource resource_;
   base::FilePath relative_path_;
 
  private:
-  void OnFilePathRead(base::FilePath* read_file_path) {
-    file_path_ = *read_file_path;
-    if (file_path_.empty())
+  void OnResourceInfoRead(const FileResourceInfo& info) {
+    info_ = info;
+    file_path_ = info.file_path;
+    if (file_path_.empty()) {
       NotifyHeadersComplete();
-    else
-      URLRequestFileJob::Start();
+      return;
+    }
+
+    std::string method = request()->method();
+    if (!info_.is_directory && (method == "GET" || method == "HEAD")) {
+      // Like most HTTP servers do for static files, the validator is
+      // derived from the modification time and the size. Those of the
+      // compressed copy are included when it is the one served.
+      etag_ = base::StringPrintf(
+          "\"%" PRIx64 "-%" PRIx64,
+          static_cast<uint64_t>(info_.last_modified.ToInternalValue()),
+          static_cast<uint64_t>(info_.size));
+      last_modified_ = info_.last_modified;
+      if (!info_.encoded_file_path.empty()) {
+        base::StringAppendF(
+            &etag_, "-%" PRIx64 "-%" PRIx64,
+            static_cast<uint64_t>(
+                info_.encoded_last_modified.ToInternalValue()),
+            static_cast<uint64_t>(info_.encoded_size));
+        last_modified_ = std::max(last_modified_,
+                                  info_.encoded_last_modified);
+      }
+      etag_ += "\"";
+      not_modified_ = IsNotModified(request_headers_, etag_, last_modified_);
+    }
+    if (not_modified_ || method == "HEAD") {
+      NotifyHeadersComplete();
+      return;
+    }
+
+    if (!info_.encoded_file_path.empty())
+      file_path_ = info_.encoded_file_path;
+    URLRequestFileJob::Start();
   }
 
+  net::HttpRequestHeaders request_headers_;
+  FileResourceInfo info_;
+  std::string etag_;
+  base::Time last_modified_;
+  bool not_modified_;
   net::HttpResponseInfo response_info_;
   base::WeakPtrFactory<URLRequestApplicationJob> weak_factory_;
 };
 
+int ReadArchiveEntry(PackageArchive::EntryReader* reader,
+                     scoped_refptr<net::IOBuffer> buffer,
+                     int size) {
+  return reader->Read(buffer->data(), size);
+}
+
+// Serves the resources of an application straight from its package file.
+// The entry is looked up in the archive index on the IO thread; reading,
+// which inflates deflated entries chunk by chunk, happens on
+// |file_task_runner|. A single byte range may be requested. The package
+// can't change while it is served, so the CRC-32 and size of an entry make
+// its validator.
+class URLRequestApplicationArchiveJob : public net::URLRequestJob {
+ public:
+  URLRequestApplicationArchiveJob(
+      net::URLRequest* request,
+      net::NetworkDelegate* network_delegate,
+      const scoped_refptr<base::SequencedTaskRunner>& file_task_runner,
+      scoped_refptr<const ResponseTemplate> response_template,
+      const base::FilePath& relative_path)
+      : net::URLRequestJob(request, network_delegate),
+        file_task_runner_(file_task_runner),
+        response_template_(response_template),
+        archive_(response_template->application()->archive()),
+        resource_(response_template->application()->ID(), archive_->path(),
+                  relative_path),
+        relative_path_(relative_path),
+        entry_(NULL),
+        encoded_entry_(NULL),
+        not_modified_(false),
+        content_length_(0),
+        remaining_bytes_(0),
+        range_parse_result_(net::OK),
+        weak_factory_(this) {
+    resource_.SetLocales(response_template->locales());
+  }
+
+  void Start() override {
+    base::ThreadTaskRunnerHandle::Get()->PostTask(
+        FROM_HERE,
+        base::Bind(&URLRequestApplicationArchiveJob::DidStart,
+                   weak_factory_.GetWeakPtr()));
+  }
+
+  void Kill() override {
+    weak_factory_.InvalidateWeakPtrs();
+    net::URLRequestJob::Kill();
+  }
+
+  bool GetMimeType(std::string* mime_type) const override {
+    if (entry_path_.empty())
+      return false;
+    return net::GetMimeTypeFromFile(entry_path_, mime_type);
+  }
+
+  void SetExtraRequestHeaders(
+      const net::HttpRequestHeaders& headers) override {
+    request_headers_.CopyFrom(headers);
+    std::string range_header;
+    if (!headers.GetHeader(net::HttpRequestHeaders::kRange, &range_header))
+      return;
+
+    // Like for file:// URLs, only a single range is supported.
+    std::vector<net::HttpByteRange> ranges;
+    if (net::HttpUtil::ParseRangeHeader(range_header, &ranges)) {
+      if (ranges.size() == 1)
+        byte_range_ = ranges[0];
+      else
+        range_parse_result_ = net::ERR_REQUEST_RANGE_NOT_SATISFIABLE;
+    }
+  }
+
+  void GetResponseInfo(net::HttpResponseInfo* info) override {
+    std::string mime_type;
+    GetMimeType(&mime_type);
+    info->headers = BuildHttpHeaders(
+        *response_template_, mime_type, request()->method(), entry_path_,
+        relative_path_);
+    if (etag_.empty())
+      return;
+
+    net::HttpResponseHeaders* headers = info->headers.get();
+    if (not_modified_) {
+      headers->ReplaceStatusLine("HTTP/1.1 304 Not Modified");
+    } else if (reader_ && byte_range_.IsValid()) {
+      headers->ReplaceStatusLine("HTTP/1.1 206 Partial Content");
+      headers->AddHeader(base::StringPrintf(
+          "Content-Range: bytes %" PRId64 "-%" PRId64 "/%u",
+          byte_range_.first_byte_position(),
+          byte_range_.last_byte_position(), entry_->size));
+    }
+    AddCacheHeaders(headers, response_template_->cache_control(), etag_,
+                    archive_->last_modified());
+    if (encoded_entry_) {
+      headers->AddHeader("Content-Encoding: gzip");
+    } else if (!not_modified_) {
+      headers->AddHeader("Accept-Ranges: bytes");
+      headers->AddHeader(base::StringPrintf(
+          "Content-Length: %" PRId64, content_length_));
+    }
+  }
+
+  std::unique_ptr<net::Filter> SetupFilter() const override {
+    if (encoded_entry_)
+      return net::Filter::GZipFactory();
+    return nullptr;
+  }
+
+  int ReadRawData(net::IOBuffer* buf, int buf_size) override {
+    if (!reader_ || remaining_bytes_ <= 0)
+      return 0;
+
+    int size = static_cast<int>(
+        std::min<int64_t>(buf_size, remaining_bytes_));
+    bool posted = base::PostTaskAndReplyWithResult(
+        file_task_runner_.get(),
+        FROM_HERE,
+        base::Bind(&ReadArchiveEntry, base::Unretained(reader_.get()),
+                   make_scoped_refptr(buf), size),
+        base::Bind(&URLRequestApplicationArchiveJob::DidRead,
+                   weak_factory_.GetWeakPtr()));
+    DCHECK(posted);
+    return net::ERR_IO_PENDING;
+  }
+
+ protected:
+  ~URLRequestApplicationArchiveJob() override {
+    // Reads might still be pending.
+    if (reader_)
+      file_task_runner_->DeleteSoon(FROM_HERE, reader_.release());
+  }
+
+ private:
+  void DidStart() {
+    if (range_parse_result_ != net::OK) {
+      NotifyStartError(net::URLRequestStatus(net::URLRequestStatus::FAILED,
+                                             range_parse_result_));
+      return;
+    }
+
+    entry_path_ = resource_.GetArchivePath(archive_.get());
+    if (!entry_path_.empty())
+      entry_ = archive_->FindEntry(entry_path_);
+    std::string method = request()->method();
+    if (!entry_ || (method != "GET" && method != "HEAD")) {
+      NotifyHeadersComplete();
+      return;
+    }
+
+    etag_ = base::StringPrintf("\"%08x-%x\"", entry_->crc32, entry_->size);
+    not_modified_ = IsNotModified(request_headers_, etag_,
+                                  archive_->last_modified());
+    content_length_ = entry_->size;
+    if (not_modified_ || method == "HEAD") {
+      NotifyHeadersComplete();
+      return;
+    }
+
+    // A range would apply to the compressed data.
+    if (!byte_range_.IsValid()) {
+      encoded_entry_ =
+          archive_->FindEntry(entry_path_.AddExtension(kGzipExtension));
+    }
+    if (encoded_entry_) {
+      // The size after decompression is not known.
+      remaining_bytes_ = encoded_entry_->size;
+      reader_.reset(
+          new PackageArchive::EntryReader(archive_, *encoded_entry_));
+      NotifyHeadersComplete();
+      return;
+    }
+
+    int64_t first_byte = 0;
+    if (byte_range_.IsValid()) {
+      if (!byte_range_.ComputeBounds(entry_->size)) {
+        NotifyStartError(net::URLRequestStatus(
+            net::URLRequestStatus::FAILED,
+            net::ERR_REQUEST_RANGE_NOT_SATISFIABLE));
+        return;
+      }
+      first_byte = byte_range_.first_byte_position();
+      content_length_ = byte_range_.last_byte_position() - first_byte + 1;
+    }
+
+    remaining_bytes_ = content_length_;
+    set_expected_content_size(content_length_);
+    reader_.reset(new PackageArchive::EntryReader(archive_, *entry_));
+    reader_->Skip(static_cast<uint32_t>(first_byte));
+    NotifyHeadersComplete();
+  }
+
+  void DidRead(int result) {
+    if (result < 0) {
+      result = net::ERR_FAILED;
+    } else {
+      remaining_bytes_ -= result;
+    }
+    ReadRawDataComplete(result);
+  }
+
+  scoped_refptr<base::SequencedTaskRunner> file_task_runner_;
+  scoped_refptr<const ResponseTemplate> response_template_;
+  scoped_refptr<PackageArchive> archive_;
+  ApplicationResource resource_;
+  base::FilePath relative_path_;
+  // Path of the resource in the package, empty if it was not found.
+  base::FilePath entry_path_;
+  const PackageArchive::Entry* entry_;
+  // The gzip compressed copy of |entry_| that is served instead, if any.
+  const PackageArchive::Entry* encoded_entry_;
+  net::HttpRequestHeaders request_headers_;
+  std::string etag_;
+  bool not_modified_;
+  std::unique_ptr<PackageArchive::EntryReader> reader_;
+  net::HttpByteRange byte_range_;
+  int64_t content_length_;
+  int64_t remaining_bytes_;
+  net::Error range_parse_result_;
+  base::WeakPtrFactory<URLRequestApplicationArchiveJob> weak_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(URLRequestApplicationArchiveJob);
+};
+
 // This class is a thread-safe cache of active application's data.
 // This class is used by ApplicationProtocolHandler which lives on
 // IO thread and hence cannot access ApplicationService directly.
+// Lookups, done for every app:// request, never wait for the UI thread
+// launching or stopping applications.
 class ApplicationDataCache : public ApplicationService::Observer {
  public:
-  scoped_refptr<ApplicationData> GetApplicationData(
+  // Must be called on the IO thread.
+  scoped_refptr<const ResponseTemplate> GetResponseTemplate(
       const std::string& application_id) const {
-    base::AutoLock lock(lock_);
-    ApplicationData::ApplicationDataMap::const_iterator it =
-        cache_.find(application_id);
-    if (it != cache_.end()) {
-      return it->second;
-    }
-    return NULL;
+    scoped_refptr<const ResponseTemplate> response_template;
+    cache_.Get(application_id, &response_template);
+    return response_template;
   }
 
   static void CreateIfNeeded(ApplicationService* service) {
@@ -188,23 +688,23 @@ class ApplicationDataCache : public ApplicationService::Observer {
 
  private:
   void DidLaunchApplication(Application* app) override {
-    base::AutoLock lock(lock_);
-    cache_.insert(std::pair<std::string, scoped_refptr<ApplicationData> >(
-        app->id(), app->data()));
+    scoped_refptr<const ResponseTemplate> response_template(
+        new ResponseTemplate(app->data()));
+    cache_.Set(app->id(), response_template);
   }
 
   void WillDestroyApplication(Application* app) override {
-    base::AutoLock lock(lock_);
-    cache_.erase(app->id());
+    cache_.Erase(app->id());
   }
 
-  ApplicationDataCache() = default;
+  ApplicationDataCache()
+      : cache_(BrowserThread::GetMessageLoopProxyForThread(
+            BrowserThread::IO)) {}
   // The life time of the cache instance is equal to the process life time,
   // it is not supposed to be explicitly destroyed.
   ~ApplicationDataCache() override = default;
 
-  ApplicationData::ApplicationDataMap cache_;
-  mutable base::Lock lock_;
+  ApplicationSnapshotMap<scoped_refptr<const ResponseTemplate>> cache_;
 
   static ApplicationDataCache* s_instance_;
 };
@@ -228,58 +728,31 @@ class ApplicationProtocolHandler
   DISALLOW_COPY_AND_ASSIGN(ApplicationProtocolHandler);
 };
 
-// The |locale| should be expanded to user agent locale.
-// Such as, "en-us" will be expaned as "en-us, en".
-void GetUserAgentLocales(const std::string& sys_locale,
-                         std::list<std::string>& ua_locales) {  // NOLINT
-  if (sys_locale.empty())
-    return;
-
-  std::string locale = base::ToLowerASCII(sys_locale);
-  size_t position;
-  do {
-    ua_locales.push_back(locale);
-    position = locale.find_last_of("-");
-    locale = locale.substr(0, position);
-  } while (position != std::string::npos);
-}
-
-namespace {
-const char kSpace[] = " ";
-const char kSemicolon[] = ";";
-}  // namespace
-
 net::URLRequestJob*
 ApplicationProtocolHandler::MaybeCreateJob(
     net::URLRequest* request, net::NetworkDelegate* network_delegate) const {
   const std::string& application_id = request->url().host();
-  scoped_refptr<ApplicationData> application =
-      ApplicationDataCache::Get()->GetApplicationData(application_id);
+  scoped_refptr<const ResponseTemplate> response_template =
+      ApplicationDataCache::Get()->GetResponseTemplate(application_id);
 
-  if (!application.get())
+  if (!response_template.get())
     return new net::URLRequestErrorJob(
         request, network_delegate, net::ERR_FILE_NOT_FOUND);
 
   base::FilePath relative_path =
       ApplicationURLToRelativeFilePath(request->url());
-  base::FilePath directory_path = application->path();
-  std::string content_security_policy;
-  const char* csp_key = GetCSPKey(application->manifest_type());
-  const CSPInfo* csp_info =
-      static_cast<CSPInfo*>(application->GetManifestData(csp_key));
-  if (csp_info) {
-    for (auto& directive : csp_info->GetDirectives()) {
-      content_security_policy.append(directive.first)
-          .append(kSpace)
-          .append(base::JoinString(directive.second, kSpace))
-          .append(kSemicolon);
-    }
-  }
 
-  std::list<std::string> locales;
-  if (application->manifest_type() == Manifest::TYPE_WIDGET) {
-    GetUserAgentLocales(GetSystemLocale(), locales);
-    GetUserAgentLocales(application->GetManifest()->default_locale(), locales);
+  if (response_template->application()->archive()) {
+    base::SequencedWorkerPool* pool =
+        content::BrowserThread::GetBlockingPool();
+    return new URLRequestApplicationArchiveJob(
+        request,
+        network_delegate,
+        pool->GetSequencedTaskRunnerWithShutdownBehavior(
+            pool->GetSequenceToken(),
+            base::SequencedWorkerPool::SKIP_ON_SHUTDOWN),
+        response_template,
+        relative_path);
   }
 
   return new URLRequestApplicationJob(
@@ -288,11 +761,8 @@ ApplicationProtocolHandler::MaybeCreateJob(
       content::BrowserThread::GetBlockingPool()->
       GetTaskRunnerWithShutdownBehavior(
           base::SequencedWorkerPool::SKIP_ON_SHUTDOWN),
-      application_id,
-      directory_path,
-      relative_path,
-      content_security_policy,
-      locales);
+      response_template,
+      relative_path);
 }
 
 }  // namespace
@@ -9,6 +9,7 @@
 #include <string>
 
 #include "base/numerics/safe_conversions.h"
+#include "base/trace_event/trace_event.h"
 #include "content/public/browser/render_process_host.h"
 #include "extensions/common/url_pattern.h"
 #include "xwalk/application/browser/application.h"
@@ -26,6 +27,8 @@ namespace widget_keys = application_widget_keys;
 
 namespace application {
 
+const int ApplicationSecurityPolicy::kSecurityPolicyVersion = 1;
+
 ApplicationSecurityPolicy::WhitelistEntry::WhitelistEntry(
     const GURL& dest, const std::string& dest_host, bool subdomains)
     : dest(dest),
@@ -74,17 +77,8 @@ bool ApplicationSecurityPolicy::IsAccessAllowed(const GURL& url) const {
       url.SchemeIs(kApplicationScheme) && url.host() == app_data_->ID())
     return true;
 
-  for (const WhitelistEntry& entry : whitelist_entries_) {
-    const GURL& policy = entry.dest;
-    bool subdomains = entry.subdomains;
-    bool is_host_matched = subdomains ?
-        url.DomainIs(policy.host().c_str()) : url.host() == policy.host();
-    if (url.scheme() == policy.scheme() && is_host_matched &&
-        base::StartsWith(url.path(), policy.path(),
-                         base::CompareCase::INSENSITIVE_ASCII))
-      return true;
-  }
-  return false;
+  // The entries apply to any requesting document.
+  return whitelist_matcher_.Matches(GURL(), url);
 }
 
 void ApplicationSecurityPolicy::EnforceForRenderer(
@@ -94,14 +88,24 @@ void ApplicationSecurityPolicy::EnforceForRenderer(
   if (!enabled_)
     return;
 
+  TRACE_EVENT1("xwalk", "ApplicationSecurityPolicy::EnforceForRenderer",
+               "entries", whitelist_entries_.size());
   DCHECK(!whitelist_entries_.empty());
-  const GURL& app_url = app_data_->URL();
+  ViewMsg_SecurityPolicy_Params params;
+  params.version = kSecurityPolicyVersion;
+  params.app_url = app_data_->URL();
+  params.mode = mode_;
+  params.whitelist.reserve(whitelist_entries_.size());
   for (const WhitelistEntry& entry : whitelist_entries_) {
-    rph->Send(new ViewMsg_SetAccessWhiteList(
-        app_url, entry.dest, entry.dest_host, entry.subdomains));
+    ViewMsg_AccessWhiteListEntry whitelist_entry;
+    whitelist_entry.dest = entry.dest;
+    whitelist_entry.dest_host = entry.dest_host;
+    whitelist_entry.allow_subdomains = entry.subdomains;
+    params.whitelist.push_back(whitelist_entry);
   }
+  params.send_time = base::TimeTicks::Now();
 
-  rph->Send(new ViewMsg_EnableSecurityMode(app_url, mode_));
+  rph->Send(new ViewMsg_SetSecurityPolicy(params));
 }
 
 void ApplicationSecurityPolicy::AddWhitelistEntry(
@@ -113,6 +117,7 @@ void ApplicationSecurityPolicy::AddWhitelistEntry(
     return;
 
   whitelist_entries_.push_back(entry);
+  whitelist_matcher_.AddEntry(GURL(), url, subdomains, false);
 }
 
 ApplicationSecurityPolicyWARP::ApplicationSecurityPolicyWARP(
@@ -9,6 +9,7 @@
 #include <vector>
 #include "base/memory/ref_counted.h"
 #include "url/gurl.h"
+#include "xwalk/application/common/access_whitelist_matcher.h"
 
 namespace content {
 class RenderProcessHost;
@@ -27,12 +28,16 @@ class ApplicationSecurityPolicy {
     WARP
   };
 
+  // Bumped whenever the policy sent to renderers changes meaning.
+  static const int kSecurityPolicyVersion;
+
   static std::unique_ptr<ApplicationSecurityPolicy> Create(
       scoped_refptr<ApplicationData> app_data);
   virtual ~ApplicationSecurityPolicy();
 
   bool IsAccessAllowed(const GURL& url) const;
 
+  // Sends the whole policy to the renderer in a single message.
   void EnforceForRenderer(content::RenderProcessHost* rph) const;
 
  protected:
@@ -57,6 +62,8 @@ class ApplicationSecurityPolicy {
 
   scoped_refptr<ApplicationData> const app_data_;
   std::vector<WhitelistEntry> whitelist_entries_;
+  // |whitelist_entries_| compiled for IsAccessAllowed().
+  AccessWhitelistMatcher whitelist_matcher_;
   SecurityMode mode_;
   bool enabled_;
 };
@@ -4,6 +4,10 @@
 
 #include "xwalk/application/browser/application_service.h"
 
+#include <set>
+
+#include "base/bind.h"
+#include "base/command_line.h"
 #include "base/files/file_util.h"
 #include "base/memory/ptr_util.h"
 #include "base/strings/utf_string_conversions.h"
@@ -13,11 +17,15 @@
 #include "xwalk/application/browser/application.h"
 #include "xwalk/application/common/application_manifest_constants.h"
 #include "xwalk/application/common/application_file_util.h"
+#include "xwalk/application/common/constants.h"
 #include "xwalk/application/common/id_util.h"
+#include "xwalk/application/common/package/package.h"
+#include "xwalk/application/common/package/package_archive.h"
 #include "xwalk/runtime/browser/runtime.h"
 #include "xwalk/runtime/browser/xwalk_browser_context.h"
 #include "xwalk/runtime/browser/xwalk_runner.h"
 #include "xwalk/runtime/common/xwalk_paths.h"
+#include "xwalk/runtime/common/xwalk_switches.h"
 
 #if defined(OS_WIN)
 #include <shobjidl.h>
@@ -27,6 +35,66 @@ namespace xwalk {
 
 namespace application {
 
+namespace {
+
+// Extracted packages are kept here, so that relaunching an unchanged
+// package doesn't extract it again.
+base::FilePath GetPackageCachePath(XWalkBrowserContext* browser_context) {
+  return browser_context->GetPath().Append(FILE_PATH_LITERAL("PackageCache"));
+}
+
+bool CreateTemporaryPackageDir(const Package& package,
+                               base::FilePath* target_dir) {
+  base::FilePath tmp_dir;
+  if (!GetTempDir(&tmp_dir)) {
+    LOG(ERROR) << "Failed to obtain system temp directory.";
+    return false;
+  }
+
+#if defined (OS_WIN)
+  return base::CreateTemporaryDirInDir(tmp_dir,
+      base::UTF8ToWide(package.name()), target_dir);
+#else
+  return base::CreateTemporaryDirInDir(tmp_dir, package.name(), target_dir);
+#endif
+}
+
+// Loads the application without extracting the package: only the manifest
+// is written to a temporary folder, the resources are then served from the
+// package file.
+scoped_refptr<ApplicationData> LoadApplicationFromArchive(
+    const Package& package, const base::FilePath& path,
+    const std::string& app_id, std::string* error) {
+  scoped_refptr<PackageArchive> archive = PackageArchive::Open(path);
+  if (!archive)
+    return NULL;
+
+  base::FilePath manifest_name =
+      GetManifestPath(base::FilePath(), package.manifest_type());
+  std::string manifest;
+  base::FilePath target_dir;
+  if (!archive->ReadEntry(manifest_name, &manifest) ||
+      !CreateTemporaryPackageDir(package, &target_dir))
+    return NULL;
+  if (base::WriteFile(target_dir.Append(manifest_name), manifest.data(),
+                      manifest.size()) != static_cast<int>(manifest.size())) {
+    base::DeleteFile(target_dir, true);
+    return NULL;
+  }
+
+  scoped_refptr<ApplicationData> application_data = LoadApplication(
+      target_dir, app_id, ApplicationData::TEMP_DIRECTORY,
+      package.manifest_type(), error);
+  if (!application_data.get()) {
+    base::DeleteFile(target_dir, true);
+    return NULL;
+  }
+  application_data->set_archive(archive);
+  return application_data;
+}
+
+}  // namespace
+
 ApplicationService::ApplicationService(XWalkBrowserContext* browser_context)
   : browser_context_(browser_context) {
 }
@@ -112,38 +180,59 @@ Application* ApplicationService::LaunchFromPackagePath(
     return NULL;
   }
 
-  base::FilePath tmp_dir, target_dir;
-  if (!GetTempDir(&tmp_dir)) {
-    LOG(ERROR) << "Failed to obtain system temp directory.";
-    return NULL;
-  }
-
-#if defined (OS_WIN)
-  base::CreateTemporaryDirInDir(tmp_dir,
-      base::UTF8ToWide(package->name()), &target_dir);
-#else
-  base::CreateTemporaryDirInDir(tmp_dir, package->name(), &target_dir);
-#endif
-  if (!package->ExtractTo(target_dir)) {
-    LOG(ERROR) << "Failed to unpack to a temporary directory: "
-               << target_dir.MaybeAsASCII();
-    return NULL;
-  }
-
   std::string app_id;
   if (package->manifest_type() == Manifest::TYPE_MANIFEST)
     app_id = package->Id();
   std::string error;
-  scoped_refptr<ApplicationData> application_data = LoadApplication(
-      target_dir, app_id, ApplicationData::TEMP_DIRECTORY,
-      package->manifest_type(), &error);
+
+  if (base::CommandLine::ForCurrentProcess()->HasSwitch(
+          switches::kServePackagesFromArchive)) {
+    scoped_refptr<ApplicationData> application_data =
+        LoadApplicationFromArchive(*package, path, app_id, &error);
+    if (application_data.get())
+      return Launch(application_data);
+    LOG(WARNING) << "Failed to load the application from its package, "
+                 << "extracting it. " << error;
+    error.clear();
+  }
+
+  base::FilePath target_dir;
+  scoped_refptr<ApplicationData> application_data;
+  bool cached = package->ExtractToCache(GetPackageCachePath(browser_context_),
+                                        &target_dir);
+  if (cached) {
+    // The package cache is kept across launches, so is the manifest cache.
+    // It is next to the extraction, app:// only serves what is inside.
+    application_data = LoadApplicationWithManifestCache(
+        target_dir, app_id, ApplicationData::TEMP_DIRECTORY,
+        package->manifest_type(),
+        target_dir.AddExtension(kManifestCacheExtension), XWALK_VERSION,
+        &error);
+  } else {
+    LOG(WARNING) << "Failed to unpack to the package cache, "
+                 << "using a temporary directory.";
+    if (!CreateTemporaryPackageDir(*package, &target_dir))
+      return NULL;
+    if (!package->ExtractTo(target_dir)) {
+      LOG(ERROR) << "Failed to unpack to a temporary directory: "
+                 << target_dir.MaybeAsASCII();
+      return NULL;
+    }
+    application_data = LoadApplication(
+        target_dir, app_id, ApplicationData::TEMP_DIRECTORY,
+        package->manifest_type(), &error);
+  }
+
   if (!application_data.get()) {
     LOG(ERROR) << "Error occurred while trying to load application: "
                << error;
     return NULL;
   }
 
-  return Launch(application_data);
+  Application* application = Launch(application_data);
+  if (application && cached)
+    DeleteUnusedPackageExtractions(package->Id());
+  return application;
 }
 
 // Launch an application created from arbitrary url.
@@ -236,11 +325,14 @@ void ApplicationService::OnApplicationTerminated(
   applications_.erase(found);
 
   if (app_data->source_type() == ApplicationData::TEMP_DIRECTORY) {
-      LOG(INFO) << "Deleting the app temporary directory "
-                << app_data->path().AsUTF8Unsafe();
-      content::BrowserThread::PostTask(content::BrowserThread::FILE,
-          FROM_HERE, base::Bind(base::IgnoreResult(&base::DeleteFile),
-                                app_data->path(), true /*recursive*/));
+      // Extractions in the package cache are kept for the next launch.
+      if (!GetPackageCachePath(browser_context_).IsParent(app_data->path())) {
+        LOG(INFO) << "Deleting the app temporary directory "
+                  << app_data->path().AsUTF8Unsafe();
+        content::BrowserThread::PostTask(content::BrowserThread::FILE,
+            FROM_HERE, base::Bind(base::IgnoreResult(&base::DeleteFile),
+                                  app_data->path(), true /*recursive*/));
+      }
       // FIXME: So far we simply clean up all the app persistent data,
       // further we need to add an appropriate logic to handle it.
       content::BrowserContext::GarbageCollectStoragePartitions(
@@ -255,6 +347,20 @@ void ApplicationService::OnApplicationTerminated(
   }
 }
 
+void ApplicationService::DeleteUnusedPackageExtractions(
+    const std::string& package_id) {
+  // Includes the extraction the application was just launched from.
+  base::FilePath cache_path = GetPackageCachePath(browser_context_);
+  std::set<base::FilePath> paths_in_use;
+  for (const Application* application : applications_) {
+    if (cache_path.IsParent(application->data()->path()))
+      paths_in_use.insert(application->data()->path());
+  }
+  content::BrowserThread::PostTask(content::BrowserThread::FILE, FROM_HERE,
+      base::Bind(&Package::DeleteUnusedExtractions, cache_path, package_id,
+                 paths_in_use));
+}
+
 void ApplicationService::CheckAPIAccessControl(const std::string& app_id,
     const std::string& extension_name,
     const std::string& api_name, const PermissionCallback& callback) {
@@ -45,8 +45,8 @@ class ApplicationService : public Application::Observer {
                                       Manifest::Type manifest_type);
 
   // Launch an application using path to its package file.
-  // Note: the given package is unpacked to a temporary folder,
-  // which is deleted after the application terminates.
+  // Note: the given package is unpacked to a cache folder keyed by the
+  // package hash, which is reused while the package doesn't change.
   Application* LaunchFromPackagePath(const base::FilePath& path);
 
   // Launch an application from an arbitrary URL.
@@ -84,6 +84,10 @@ class ApplicationService : public Application::Observer {
   // Implementation of Application::Observer.
   void OnApplicationTerminated(Application* app) override;
 
+  // Deletes, on the FILE thread, the extractions of the package
+  // |package_id| in the package cache that no application runs from.
+  void DeleteUnusedPackageExtractions(const std::string& package_id);
+
   XWalkBrowserContext* browser_context_;
   ScopedVector<Application> applications_;
   base::ObserverList<Observer> observers_;
@@ -0,0 +1,104 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_APPLICATION_BROWSER_APPLICATION_SNAPSHOT_MAP_H_
+#define XWALK_APPLICATION_BROWSER_APPLICATION_SNAPSHOT_MAP_H_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "base/atomicops.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/single_thread_task_runner.h"
+#include "base/synchronization/lock.h"
+#include "xwalk/application/common/application_data.h"
+
+namespace xwalk {
+namespace application {
+
+// Maps application ids to |Value|s. One thread, the reader thread, looks
+// values up without ever taking a lock, while any thread may update the map.
+//
+// The map is never modified in place: each update copies the current map,
+// changes the copy and publishes it with an atomic pointer swap. The map it
+// replaces is deleted by a task posted to the reader thread, which can only
+// run once no lookup is using it any more. Updates are serialized by a lock
+// and cost a copy of the map, so they must be much rarer than lookups,
+// like applications being launched compared to their resources being loaded.
+template <typename Value>
+class ApplicationSnapshotMap {
+ public:
+  explicit ApplicationSnapshotMap(
+      scoped_refptr<base::SingleThreadTaskRunner> reader_task_runner)
+      : reader_task_runner_(reader_task_runner),
+        map_(reinterpret_cast<base::subtle::AtomicWord>(new Map)) {
+  }
+
+  ~ApplicationSnapshotMap() {
+    delete GetMap();
+  }
+
+  // Must be called on the reader thread. Returns false if there is no
+  // value for |application_id|.
+  bool Get(const std::string& application_id, Value* value) const {
+    DCHECK(reader_task_runner_->BelongsToCurrentThread());
+    const Map* map = GetMap();
+    typename Map::const_iterator it = map->find(application_id);
+    if (it == map->end())
+      return false;
+    *value = it->second;
+    return true;
+  }
+
+  void Set(const std::string& application_id, const Value& value) {
+    base::AutoLock lock(update_lock_);
+    std::unique_ptr<Map> map(new Map(*GetMap()));
+    (*map)[application_id] = value;
+    Publish(std::move(map));
+  }
+
+  void Erase(const std::string& application_id) {
+    base::AutoLock lock(update_lock_);
+    if (!GetMap()->count(application_id))
+      return;
+    std::unique_ptr<Map> map(new Map(*GetMap()));
+    map->erase(application_id);
+    Publish(std::move(map));
+  }
+
+ private:
+  typedef std::map<std::string, Value, ApplicationData::ApplicationIdCompare>
+      Map;
+
+  const Map* GetMap() const {
+    return reinterpret_cast<const Map*>(base::subtle::Acquire_Load(&map_));
+  }
+
+  void Publish(std::unique_ptr<Map> map) {
+    update_lock_.AssertAcquired();
+    const Map* old_map = GetMap();
+    base::subtle::Release_Store(
+        &map_, reinterpret_cast<base::subtle::AtomicWord>(map.release()));
+    // If the reader thread is gone, nothing can read the old map but it
+    // can't be deleted safely either, so it is leaked.
+    reader_task_runner_->DeleteSoon(FROM_HERE, old_map);
+  }
+
+  scoped_refptr<base::SingleThreadTaskRunner> reader_task_runner_;
+  // The current const Map*.
+  base::subtle::AtomicWord map_;
+  base::Lock update_lock_;
+
+  DISALLOW_COPY_AND_ASSIGN(ApplicationSnapshotMap);
+};
+
+}  // namespace application
+}  // namespace xwalk
+
+#endif  // XWALK_APPLICATION_BROWSER_APPLICATION_SNAPSHOT_MAP_H_
@@ -0,0 +1,144 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/browser/application_snapshot_map.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/atomicops.h"
+#include "base/bind.h"
+#include "base/memory/ref_counted_memory.h"
+#include "base/strings/stringprintf.h"
+#include "base/threading/thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+typedef ApplicationSnapshotMap<scoped_refptr<base::RefCountedString>>
+    TestMap;
+
+const int kUpdaterCount = 4;
+const int kLaunchCount = 500;
+// How many applications of each updater stay running.
+const int kRunningCount = 3;
+
+std::string GetApplicationId(int updater, int launch) {
+  return base::StringPrintf("app-%d-%d", updater, launch);
+}
+
+scoped_refptr<base::RefCountedString> CreateValue(const std::string& id) {
+  std::string data(id);
+  return base::RefCountedString::TakeString(&data);
+}
+
+// Launches and stops applications, like the UI thread does.
+void LaunchApplications(TestMap* map, int updater) {
+  for (int launch = 0; launch < kLaunchCount; ++launch) {
+    std::string id = GetApplicationId(updater, launch);
+    map->Set(id, CreateValue(id));
+    if (launch >= kRunningCount)
+      map->Erase(GetApplicationId(updater, launch - kRunningCount));
+  }
+}
+
+// Looks applications up until |done| is set, like the IO thread does for
+// each app:// request. Values must always match their id.
+void LookUpApplications(const TestMap* map,
+                        const base::subtle::Atomic32* done) {
+  while (!base::subtle::Acquire_Load(done)) {
+    for (int updater = 0; updater < kUpdaterCount; ++updater) {
+      for (int launch = 0; launch < kLaunchCount; launch += 7) {
+        std::string id = GetApplicationId(updater, launch);
+        scoped_refptr<base::RefCountedString> value;
+        if (map->Get(id, &value)) {
+          ASSERT_TRUE(value.get());
+          ASSERT_EQ(id, value->data());
+        }
+      }
+    }
+  }
+}
+
+void CheckRunningApplications(const TestMap* map) {
+  for (int updater = 0; updater < kUpdaterCount; ++updater) {
+    for (int launch = 0; launch < kLaunchCount; ++launch) {
+      std::string id = GetApplicationId(updater, launch);
+      scoped_refptr<base::RefCountedString> value;
+      bool running = launch >= kLaunchCount - kRunningCount;
+      ASSERT_EQ(running, map->Get(id, &value)) << id;
+      if (running)
+        EXPECT_EQ(id, value->data());
+    }
+  }
+  // Lookups are case insensitive, like application ids.
+  scoped_refptr<base::RefCountedString> value;
+  EXPECT_TRUE(map->Get(base::StringPrintf("APP-0-%d", kLaunchCount - 1),
+                       &value));
+}
+
+void CheckReplacedAndErased(const TestMap* map) {
+  scoped_refptr<base::RefCountedString> value;
+  ASSERT_TRUE(map->Get("app", &value));
+  EXPECT_EQ("second", value->data());
+  EXPECT_FALSE(map->Get("other", &value));
+  EXPECT_FALSE(map->Get("stopped", &value));
+}
+
+}  // namespace
+
+TEST(ApplicationSnapshotMapTest, ConcurrentLaunchesAndLookups) {
+  base::Thread reader("Reader");
+  ASSERT_TRUE(reader.Start());
+  std::unique_ptr<TestMap> map(new TestMap(reader.task_runner()));
+
+  base::subtle::Atomic32 done = 0;
+  reader.task_runner()->PostTask(
+      FROM_HERE,
+      base::Bind(&LookUpApplications, base::Unretained(map.get()),
+                 base::Unretained(&done)));
+
+  std::vector<std::unique_ptr<base::Thread>> updaters;
+  for (int updater = 0; updater < kUpdaterCount; ++updater) {
+    updaters.push_back(std::unique_ptr<base::Thread>(
+        new base::Thread(base::StringPrintf("Updater%d", updater))));
+    ASSERT_TRUE(updaters.back()->Start());
+    updaters.back()->task_runner()->PostTask(
+        FROM_HERE,
+        base::Bind(&LaunchApplications, base::Unretained(map.get()),
+                   updater));
+  }
+  // Stopping the threads waits for their tasks.
+  for (auto& updater : updaters)
+    updater->Stop();
+
+  base::subtle::Release_Store(&done, 1);
+  reader.task_runner()->PostTask(
+      FROM_HERE,
+      base::Bind(&CheckRunningApplications, base::Unretained(map.get())));
+  // Also deletes the maps replaced while the lookups were running.
+  reader.Stop();
+  map.reset();
+}
+
+TEST(ApplicationSnapshotMapTest, SetAndErase) {
+  base::Thread reader("Reader");
+  ASSERT_TRUE(reader.Start());
+  TestMap map(reader.task_runner());
+  map.Set("app", CreateValue("first"));
+  map.Set("app", CreateValue("second"));
+  map.Set("stopped", CreateValue("stopped"));
+  map.Erase("stopped");
+  map.Erase("other");
+  reader.task_runner()->PostTask(
+      FROM_HERE, base::Bind(&CheckReplacedAndErased, base::Unretained(&map)));
+  reader.Stop();
+}
+
+}  // namespace application
+}  // namespace xwalk
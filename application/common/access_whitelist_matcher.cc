@@ -0,0 +1,131 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/access_whitelist_matcher.h"
+
+#include "base/strings/string_piece.h"
+#include "base/strings/string_util.h"
+#include "url/gurl.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+// Like GURL::DomainIs(), ignores the trailing dot of fully qualified hosts.
+base::StringPiece GetDomain(const std::string& host) {
+  base::StringPiece domain(host);
+  if (domain.ends_with("."))
+    domain.remove_suffix(1);
+  return domain;
+}
+
+// Splits the last label off |domain| and returns it.
+base::StringPiece PopLastLabel(base::StringPiece* domain) {
+  size_t dot = domain->rfind('.');
+  if (dot == base::StringPiece::npos) {
+    base::StringPiece label = *domain;
+    *domain = base::StringPiece();
+    return label;
+  }
+  base::StringPiece label = domain->substr(dot + 1);
+  *domain = domain->substr(0, dot);
+  return label;
+}
+
+}  // namespace
+
+AccessWhitelistMatcher::HostNode::HostNode() {}
+
+AccessWhitelistMatcher::HostNode::~HostNode() {}
+
+AccessWhitelistMatcher::AccessWhitelistMatcher() {}
+
+AccessWhitelistMatcher::~AccessWhitelistMatcher() {}
+
+void AccessWhitelistMatcher::AddEntry(const GURL& source, const GURL& dest,
+                                      bool subdomains, bool match_port) {
+  if (!dest.is_valid())
+    return;
+
+  Rule rule;
+  rule.path = dest.path();
+  rule.port = match_port ? dest.EffectiveIntPort() : -1;
+  SchemeEntries& entries = origins_[source.GetOrigin().spec()][dest.scheme()];
+  std::string host = dest.host();
+  if (!subdomains) {
+    entries.exact_hosts[host].push_back(rule);
+    return;
+  }
+
+  base::StringPiece domain = GetDomain(host);
+  // Like GURL::DomainIs(), an empty domain matches nothing.
+  if (domain.empty())
+    return;
+  HostNode* node = &entries.subdomain_hosts;
+  while (!domain.empty()) {
+    std::unique_ptr<HostNode>& child =
+        node->children[PopLastLabel(&domain).as_string()];
+    if (!child)
+      child.reset(new HostNode);
+    node = child.get();
+  }
+  node->rules.push_back(rule);
+}
+
+bool AccessWhitelistMatcher::Matches(const GURL& source,
+                                     const GURL& url) const {
+  if (!url.is_valid())
+    return false;
+
+  auto origin = origins_.find(source.GetOrigin().spec());
+  if (origin == origins_.end())
+    return false;
+  auto scheme = origin->second.find(url.scheme());
+  if (scheme == origin->second.end())
+    return false;
+  const SchemeEntries& entries = scheme->second;
+
+  std::string host = url.host();
+  auto exact_host = entries.exact_hosts.find(host);
+  if (exact_host != entries.exact_hosts.end() &&
+      MatchesRules(exact_host->second, url))
+    return true;
+
+  // Each node on the way matches |url| as a subdomain.
+  base::StringPiece domain = GetDomain(host);
+  const HostNode* node = &entries.subdomain_hosts;
+  while (!domain.empty()) {
+    auto child = node->children.find(PopLastLabel(&domain).as_string());
+    if (child == node->children.end())
+      return false;
+    node = child->second.get();
+    if (MatchesRules(node->rules, url))
+      return true;
+  }
+  return false;
+}
+
+void AccessWhitelistMatcher::Clear() {
+  origins_.clear();
+}
+
+// static
+bool AccessWhitelistMatcher::MatchesRules(const RuleList& rules,
+                                          const GURL& url) {
+  if (rules.empty())
+    return false;
+  std::string path = url.path();
+  int port = url.EffectiveIntPort();
+  for (const Rule& rule : rules) {
+    if ((rule.port == -1 || rule.port == port) &&
+        base::StartsWith(path, rule.path,
+                         base::CompareCase::INSENSITIVE_ASCII))
+      return true;
+  }
+  return false;
+}
+
+}  // namespace application
+}  // namespace xwalk
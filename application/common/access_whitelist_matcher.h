@@ -0,0 +1,84 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_APPLICATION_COMMON_ACCESS_WHITELIST_MATCHER_H_
+#define XWALK_APPLICATION_COMMON_ACCESS_WHITELIST_MATCHER_H_
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "base/macros.h"
+
+class GURL;
+
+namespace xwalk {
+namespace application {
+
+// Matches requested URLs against the access whitelist of an application,
+// e.g. the <access> elements of a widget or its CSP sources.
+//
+// Entries are indexed by the origin of the requesting document and by the
+// requested scheme. Exact hosts are looked up in a hash map, while hosts
+// allowing subdomains are stored in a trie of their labels in reverse order
+// ("com" -> "example" -> "www"), so that a lookup costs one probe per label
+// of the requested host whatever the number of entries.
+class AccessWhitelistMatcher {
+ public:
+  AccessWhitelistMatcher();
+  ~AccessWhitelistMatcher();
+
+  // Allows documents from the origin of |source| to request URLs with the
+  // scheme and host of |dest| and a path starting with the path of |dest|,
+  // compared case insensitively. If |subdomains| is true, the subdomains
+  // of the host match too. If |match_port| is true, the port must match
+  // as well. Invalid |dest| URLs are ignored.
+  void AddEntry(const GURL& source, const GURL& dest,
+                bool subdomains, bool match_port);
+
+  // Returns true if an entry added for the origin of |source| allows
+  // requesting |url|.
+  bool Matches(const GURL& source, const GURL& url) const;
+
+  void Clear();
+  bool empty() const { return origins_.empty(); }
+
+ private:
+  struct Rule {
+    std::string path;
+    // -1 when any port matches.
+    int port;
+  };
+  typedef std::vector<Rule> RuleList;
+
+  // A label of a host allowing subdomains, the children are the labels
+  // left of it.
+  struct HostNode {
+    HostNode();
+    ~HostNode();
+
+    RuleList rules;
+    std::unordered_map<std::string, std::unique_ptr<HostNode>> children;
+  };
+
+  // The entries of an origin for a given scheme.
+  struct SchemeEntries {
+    std::unordered_map<std::string, RuleList> exact_hosts;
+    HostNode subdomain_hosts;
+  };
+  typedef std::unordered_map<std::string, SchemeEntries> SchemeMap;
+
+  static bool MatchesRules(const RuleList& rules, const GURL& url);
+
+  // Keyed by the origin of the requesting document.
+  std::unordered_map<std::string, SchemeMap> origins_;
+
+  DISALLOW_COPY_AND_ASSIGN(AccessWhitelistMatcher);
+};
+
+}  // namespace application
+}  // namespace xwalk
+
+#endif  // XWALK_APPLICATION_COMMON_ACCESS_WHITELIST_MATCHER_H_
@@ -0,0 +1,165 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/access_whitelist_matcher.h"
+
+#include <string>
+#include <vector>
+
+#include "base/strings/string_util.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "url/gurl.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+const char kSource[] = "app://abcdefgh/index.html";
+
+struct Entry {
+  GURL dest;
+  bool subdomains;
+};
+
+// The linear scan the renderer used to do for each request, for a single
+// source origin.
+bool MatchesLinearly(const std::vector<Entry>& entries, const GURL& url) {
+  for (const Entry& entry : entries) {
+    if (!entry.subdomains &&
+        entry.dest.GetOrigin() == url.GetOrigin() &&
+        base::StartsWith(url.path(), entry.dest.path(),
+                         base::CompareCase::INSENSITIVE_ASCII))
+      return true;
+    if (entry.subdomains &&
+        url.scheme() == entry.dest.scheme() &&
+        url.DomainIs(entry.dest.host().c_str()) &&
+        url.EffectiveIntPort() == entry.dest.EffectiveIntPort() &&
+        base::StartsWith(url.path(), entry.dest.path(),
+                         base::CompareCase::INSENSITIVE_ASCII))
+      return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+TEST(AccessWhitelistMatcherTest, ExactHosts) {
+  AccessWhitelistMatcher matcher;
+  GURL source(kSource);
+  matcher.AddEntry(source, GURL("https://example.com/api/"), false, true);
+
+  EXPECT_TRUE(matcher.Matches(source, GURL("https://example.com/api/a")));
+  EXPECT_TRUE(matcher.Matches(source, GURL("https://example.com/API/a")));
+  EXPECT_TRUE(matcher.Matches(source, GURL("https://example.com:443/api/")));
+  EXPECT_FALSE(matcher.Matches(source, GURL("https://example.com/other")));
+  EXPECT_FALSE(matcher.Matches(source, GURL("http://example.com/api/a")));
+  EXPECT_FALSE(matcher.Matches(source, GURL("https://example.com:8443/api/")));
+  EXPECT_FALSE(matcher.Matches(source, GURL("https://www.example.com/api/")));
+  // Entries only apply to the origin they were added for.
+  EXPECT_FALSE(matcher.Matches(GURL("app://other/index.html"),
+                               GURL("https://example.com/api/a")));
+}
+
+TEST(AccessWhitelistMatcherTest, Subdomains) {
+  AccessWhitelistMatcher matcher;
+  GURL source(kSource);
+  matcher.AddEntry(source, GURL("http://example.com/"), true, false);
+  matcher.AddEntry(source, GURL("http://deep.test.org/images"), true, false);
+
+  EXPECT_TRUE(matcher.Matches(source, GURL("http://example.com/")));
+  EXPECT_TRUE(matcher.Matches(source, GURL("http://a.b.example.com/x")));
+  EXPECT_TRUE(matcher.Matches(source, GURL("http://www.example.com./")));
+  EXPECT_TRUE(matcher.Matches(source, GURL("http://example.com:8080/")));
+  EXPECT_FALSE(matcher.Matches(source, GURL("http://badexample.com/")));
+  EXPECT_FALSE(matcher.Matches(source, GURL("http://com/")));
+  EXPECT_TRUE(matcher.Matches(source,
+                              GURL("http://x.deep.test.org/images/a.png")));
+  EXPECT_FALSE(matcher.Matches(source, GURL("http://x.deep.test.org/")));
+  EXPECT_FALSE(matcher.Matches(source, GURL("http://test.org/images")));
+
+  matcher.Clear();
+  EXPECT_TRUE(matcher.empty());
+  EXPECT_FALSE(matcher.Matches(source, GURL("http://example.com/")));
+}
+
+TEST(AccessWhitelistMatcherTest, MatchesLikeLinearScan) {
+  GURL source(kSource);
+  std::vector<Entry> entries = {
+    { GURL("http://example.com/"), true },
+    { GURL("https://example.com/secure/"), false },
+    { GURL("http://api.example.net:8080/v1"), false },
+    { GURL("https://cdn.example.org/"), true },
+  };
+  AccessWhitelistMatcher matcher;
+  for (const Entry& entry : entries)
+    matcher.AddEntry(source, entry.dest, entry.subdomains, true);
+
+  const char* kUrls[] = {
+    "http://example.com/index.html",
+    "http://www.example.com/",
+    "https://www.example.com/secure/",
+    "https://example.com/secure/page",
+    "https://example.com/public",
+    "http://api.example.net:8080/v1/users",
+    "http://api.example.net/v1/users",
+    "https://static.cdn.example.org/lib.js",
+    "https://cdn.example.org:444/lib.js",
+    "ftp://example.com/",
+  };
+  for (const char* url : kUrls) {
+    EXPECT_EQ(MatchesLinearly(entries, GURL(url)),
+              matcher.Matches(source, GURL(url))) << url;
+  }
+}
+
+// Checks requests against a WARP whitelist of hundreds of entries, half of
+// them allowing subdomains.
+TEST(AccessWhitelistMatcherTest, MatchHundredsOfEntries) {
+  const int kEntryCount = 500;
+  const int kRequestCount = 2000;
+  GURL source(kSource);
+  std::vector<Entry> entries;
+  AccessWhitelistMatcher matcher;
+  for (int i = 0; i < kEntryCount; ++i) {
+    Entry entry = { GURL(base::StringPrintf("https://host%d.example.com/", i)),
+                    i % 2 == 0 };
+    entries.push_back(entry);
+    matcher.AddEntry(source, entry.dest, entry.subdomains, true);
+  }
+
+  // Half of the requests are allowed.
+  std::vector<GURL> urls;
+  for (int i = 0; i < kRequestCount; ++i) {
+    urls.push_back(GURL(base::StringPrintf(
+        "https://%shost%d.example.com/res/%d.js", i % 4 ? "" : "www.",
+        (i * 7) % (2 * kEntryCount), i)));
+  }
+
+  int linear_matches = 0;
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (const GURL& url : urls)
+    linear_matches += MatchesLinearly(entries, url);
+  base::TimeDelta linear = base::TimeTicks::Now() - start;
+
+  int indexed_matches = 0;
+  start = base::TimeTicks::Now();
+  for (const GURL& url : urls)
+    indexed_matches += matcher.Matches(source, url);
+  base::TimeDelta indexed = base::TimeTicks::Now() - start;
+  EXPECT_EQ(linear_matches, indexed_matches);
+
+  perf_test::PrintResult("access_whitelist_match", "", "linear",
+                         linear.InMicrosecondsF() / kRequestCount, "us",
+                         true);
+  perf_test::PrintResult("access_whitelist_match", "", "indexed",
+                         indexed.InMicrosecondsF() / kRequestCount, "us",
+                         true);
+}
+
+}  // namespace application
+}  // namespace xwalk
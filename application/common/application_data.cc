@@ -110,7 +110,8 @@ ApplicationData::ApplicationData(
       application_id_(id),
       manifest_(manifest.release()),
       finished_parsing_manifest_(false),
-      source_type_(source_type) {
+      source_type_(source_type),
+      resource_cache_(new ApplicationResourceCache) {
   DCHECK(path_.empty() || path_.IsAbsolute());
 }
 
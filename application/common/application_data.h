@@ -22,9 +22,11 @@
 #include "base/threading/thread_checker.h"
 #include "ui/gfx/geometry/rect.h"
 #include "url/gurl.h"
+#include "xwalk/application/common/application_resource_cache.h"
 #include "xwalk/application/common/manifest.h"
 #include "xwalk/application/common/permission_types.h"
 #include "xwalk/application/common/package/package.h"
+#include "xwalk/application/common/package/package_archive.h"
 
 #if defined(OS_WIN)
 #define strcasecmp _stricmp
@@ -115,6 +117,18 @@ class ApplicationData : public base::RefCountedThreadSafe<ApplicationData> {
     return window_max_size_;
   }
 
+  // The package the resources are served from when it was not extracted,
+  // NULL otherwise. |path| then only holds the manifest.
+  PackageArchive* archive() const { return archive_.get(); }
+  void set_archive(scoped_refptr<PackageArchive> archive) {
+    archive_ = archive;
+  }
+
+  // Where the resources requested through app:// URLs were found.
+  ApplicationResourceCache* resource_cache() const {
+    return resource_cache_.get();
+  }
+
   const Manifest* GetManifest() const {
     return manifest_.get();
   }
@@ -207,6 +221,10 @@ class ApplicationData : public base::RefCountedThreadSafe<ApplicationData> {
   // The source the application was loaded from.
   SourceType source_type_;
 
+  scoped_refptr<PackageArchive> archive_;
+
+  std::unique_ptr<ApplicationResourceCache> resource_cache_;
+
   // Main window bounds
   gfx::Rect window_bounds_;
   gfx::Size window_min_size_;
@@ -13,11 +13,12 @@
 #include "base/files/file_util.h"
 #include "base/files/scoped_temp_dir.h"
 #include "base/i18n/rtl.h"
-#include "base/json/json_file_value_serializer.h"
+#include "base/json/json_string_value_serializer.h"
 #include "base/logging.h"
 #include "base/memory/ptr_util.h"
 #include "base/metrics/histogram.h"
 #include "base/path_service.h"
+#include "base/sha1.h"
 #include "base/strings/string16.h"
 #include "base/strings/stringprintf.h"
 #include "base/strings/string_util.h"
@@ -31,6 +32,7 @@
 #include "xwalk/application/common/application_manifest_constants.h"
 #include "xwalk/application/common/constants.h"
 #include "xwalk/application/common/manifest.h"
+#include "xwalk/application/common/manifest_cache.h"
 #include "xwalk/application/common/manifest_handler.h"
 
 namespace errors = xwalk::application_manifest_errors;
@@ -319,12 +321,12 @@ base::DictionaryValue* LoadXMLNode(
       list->Append(sub_value);
     } else {
       DCHECK(temp->IsType(base::Value::TYPE_DICTIONARY));
-      base::DictionaryValue* dict;
-      temp->GetAsDictionary(&dict);
-      base::DictionaryValue* prev_value = dict->DeepCopy();
+      // Moves the first element into the list instead of copying it.
+      std::unique_ptr<base::Value> prev_value;
+      value->RemoveWithoutPathExpansion(sub_node_name, &prev_value);
 
       base::ListValue* list = new base::ListValue();
-      list->Append(prev_value);
+      list->Append(std::move(prev_value));
       list->Append(sub_value);
       value->Set(sub_node_name, list);
     }
@@ -350,28 +352,18 @@ base::DictionaryValue* LoadXMLNode(
   return value.release();
 }
 
-}  // namespace
-
 template <Manifest::Type>
-std::unique_ptr<Manifest> LoadManifest(
-    const base::FilePath& manifest_path, std::string* error);
+std::unique_ptr<Manifest> ParseManifest(
+    const std::string& manifest_contents, std::string* error);
 
 template <>
-std::unique_ptr<Manifest> LoadManifest<Manifest::TYPE_MANIFEST>(
-    const base::FilePath& manifest_path, std::string* error) {
-  JSONFileValueDeserializer deserializer(manifest_path);
+std::unique_ptr<Manifest> ParseManifest<Manifest::TYPE_MANIFEST>(
+    const std::string& manifest_contents, std::string* error) {
+  JSONStringValueDeserializer deserializer(manifest_contents);
   std::unique_ptr<base::Value> root(deserializer.Deserialize(NULL, error));
   if (!root) {
-    if (error->empty()) {
-      // If |error| is empty, than the file could not be read.
-      // It would be cleaner to have the JSON reader give a specific error
-      // in this case, but other code tests for a file error with
-      // error->empty().  For now, be consistent.
-      *error = base::StringPrintf("%s", errors::kManifestUnreadable);
-    } else {
-      *error = base::StringPrintf("%s  %s",
-          errors::kManifestParseError, error->c_str());
-    }
+    *error = base::StringPrintf("%s  %s",
+        errors::kManifestParseError, error->c_str());
     return std::unique_ptr<Manifest>();
   }
 
@@ -386,12 +378,14 @@ std::unique_ptr<Manifest> LoadManifest<Manifest::TYPE_MANIFEST>(
 }
 
 template <>
-std::unique_ptr<Manifest> LoadManifest<Manifest::TYPE_WIDGET>(
-    const base::FilePath& manifest_path,
+std::unique_ptr<Manifest> ParseManifest<Manifest::TYPE_WIDGET>(
+    const std::string& manifest_contents,
     std::string* error) {
   xmlDoc * doc = NULL;
   xmlNode* root_node = NULL;
-  doc = xmlReadFile(manifest_path.MaybeAsASCII().c_str(), NULL, 0);
+  doc = xmlReadMemory(manifest_contents.data(),
+                      static_cast<int>(manifest_contents.size()), NULL, NULL,
+                      0);
   if (doc == NULL) {
     *error = base::StringPrintf("%s", errors::kManifestUnreadable);
     return std::unique_ptr<Manifest>();
@@ -401,23 +395,42 @@ std::unique_ptr<Manifest> LoadManifest<Manifest::TYPE_WIDGET>(
   std::unique_ptr<base::DictionaryValue> result(new base::DictionaryValue);
   if (dv)
     result->Set(ToConstCharPointer(root_node->name), dv);
+  xmlFreeDoc(doc);
 
   return base::WrapUnique(new Manifest(std::move(result),
                                       Manifest::TYPE_WIDGET));
 }
 
-std::unique_ptr<Manifest> LoadManifest(const base::FilePath& manifest_path,
+std::unique_ptr<Manifest> ParseManifest(const std::string& manifest_contents,
     Manifest::Type type, std::string* error) {
   if (type == Manifest::TYPE_MANIFEST)
-    return LoadManifest<Manifest::TYPE_MANIFEST>(manifest_path, error);
+    return ParseManifest<Manifest::TYPE_MANIFEST>(manifest_contents, error);
 
   if (type == Manifest::TYPE_WIDGET)
-    return LoadManifest<Manifest::TYPE_WIDGET>(manifest_path, error);
+    return ParseManifest<Manifest::TYPE_WIDGET>(manifest_contents, error);
 
   *error = base::StringPrintf("%s", errors::kManifestUnreadable);
   return std::unique_ptr<Manifest>();
 }
 
+bool ReadManifestFile(const base::FilePath& manifest_path,
+                      std::string* manifest_contents, std::string* error) {
+  if (base::ReadFileToString(manifest_path, manifest_contents))
+    return true;
+  *error = base::StringPrintf("%s", errors::kManifestUnreadable);
+  return false;
+}
+
+}  // namespace
+
+std::unique_ptr<Manifest> LoadManifest(const base::FilePath& manifest_path,
+    Manifest::Type type, std::string* error) {
+  std::string manifest_contents;
+  if (!ReadManifestFile(manifest_path, &manifest_contents, error))
+    return std::unique_ptr<Manifest>();
+  return ParseManifest(manifest_contents, type, error);
+}
+
 base::FilePath GetManifestPath(
     const base::FilePath& app_directory, Manifest::Type type) {
   base::FilePath manifest_path;
@@ -450,6 +463,41 @@ scoped_refptr<ApplicationData> LoadApplication(
       app_root, app_id, source_type, std::move(manifest), error);
 }
 
+scoped_refptr<ApplicationData> LoadApplicationWithManifestCache(
+    const base::FilePath& app_root, const std::string& app_id,
+    ApplicationData::SourceType source_type, Manifest::Type manifest_type,
+    const base::FilePath& cache_path, const std::string& runtime_version,
+    std::string* error) {
+  DCHECK(!app_root.IsParent(cache_path));
+  std::string manifest_contents;
+  if (!ReadManifestFile(GetManifestPath(app_root, manifest_type),
+                        &manifest_contents, error))
+    return NULL;
+
+  std::string manifest_hash = base::SHA1HashString(manifest_contents);
+  std::unique_ptr<Manifest> manifest = ReadManifestCache(
+      cache_path, manifest_hash, runtime_version, manifest_type);
+  bool cached = !!manifest;
+  if (!cached) {
+    manifest = ParseManifest(manifest_contents, manifest_type, error);
+    if (!manifest)
+      return NULL;
+  }
+
+  // The handlers still run on the cached manifest: they are cheap compared
+  // to the parsing, and they validate it against the current runtime.
+  scoped_refptr<ApplicationData> application = ApplicationData::Create(
+      app_root, app_id, source_type, std::move(manifest), error);
+  // Only valid manifests are cached, so that invalid ones keep reporting
+  // their parse errors.
+  if (application.get() && !cached &&
+      !WriteManifestCache(cache_path, manifest_hash, runtime_version,
+                          *application->GetManifest()))
+    LOG(WARNING) << "Failed to write the manifest cache "
+                 << cache_path.AsUTF8Unsafe();
+  return application;
+}
+
 base::FilePath ApplicationURLToRelativeFilePath(const GURL& url) {
   std::string url_path = url.path();
   if (url_path.empty() || url_path[0] != '/')
@@ -50,6 +50,16 @@ scoped_refptr<ApplicationData> LoadApplication(
     ApplicationData::SourceType source_type, Manifest::Type manifest_type,
     std::string* error);
 
+// Same as LoadApplication(), but keeps the parsed manifest in |cache_path|,
+// so that the next loads by the same |runtime_version| skip the parsing. See
+// manifest_cache.h. |cache_path| must be outside of |app_root|, where the
+// application could load it as one of its resources.
+scoped_refptr<ApplicationData> LoadApplicationWithManifestCache(
+    const base::FilePath& app_root, const std::string& app_id,
+    ApplicationData::SourceType source_type, Manifest::Type manifest_type,
+    const base::FilePath& cache_path, const std::string& runtime_version,
+    std::string* error);
+
 // Get a relative file path from an app:// URL.
 base::FilePath ApplicationURLToRelativeFilePath(const GURL& url);
 
@@ -61,6 +61,7 @@ const char kPermissionsKey[] = "permissions";
 const char kXWalkVersionKey[] = "xwalk_version";
 const char kXWalkDescriptionKey[] = "xwalk_description";
 const char kXWalkHostsKey[] = "xwalk_hosts";
+const char kXWalkCacheControlKey[] = "xwalk_cache_control";
 const char kXWalkLaunchScreen[] = "xwalk_launch_screen";
 const char kXWalkLaunchScreenDefault[] = "xwalk_launch_screen.default";
 const char kXWalkLaunchScreenImageBorderDefault[] =
@@ -59,6 +59,7 @@ namespace application_manifest_keys {
   extern const char kXWalkVersionKey[];
   extern const char kXWalkDescriptionKey[];
   extern const char kXWalkHostsKey[];
+  extern const char kXWalkCacheControlKey[];
   extern const char kXWalkLaunchScreen[];
   extern const char kXWalkLaunchScreenDefault[];
   extern const char kXWalkLaunchScreenImageBorderDefault[];
@@ -66,6 +66,26 @@ const base::FilePath& ApplicationResource::GetFilePath() const {
   return full_resource_path_;
 }
 
+const base::FilePath& ApplicationResource::GetArchivePath(
+    const PackageArchive* archive) const {
+  DCHECK(archive);
+  if (relative_path_.empty() || !full_resource_path_.empty())
+    return full_resource_path_;
+
+  for (std::list<std::string>::const_iterator it = locales_.begin();
+       it != locales_.end(); ++it) {
+    base::FilePath path = base::FilePath(WGT_LOCALE_DIRECTORY)
+        .AppendASCII(*it).Append(relative_path_);
+    if (archive->FindEntry(path)) {
+      full_resource_path_ = path;
+      return full_resource_path_;
+    }
+  }
+  if (archive->FindEntry(relative_path_))
+    full_resource_path_ = relative_path_;
+  return full_resource_path_;
+}
+
 // static
 base::FilePath ApplicationResource::GetFilePath(
     const base::FilePath& application_root,
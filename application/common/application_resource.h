@@ -9,6 +9,8 @@
 #include <string>
 
 #include "base/files/file_path.h"
+#include "base/memory/ref_counted.h"
+#include "xwalk/application/common/package/package_archive.h"
 
 namespace xwalk {
 namespace application {
@@ -43,6 +45,10 @@ class ApplicationResource {
   // easily load application images on the UI thread, see ImageLoader.
   const base::FilePath& GetFilePath() const;
 
+  // Same as GetFilePath(), but looks the resource up in |archive| and
+  // returns its path relative to the package root. Only files are found.
+  const base::FilePath& GetArchivePath(const PackageArchive* archive) const;
+
   // Gets the physical file path for the application resource, taking into
   // account localization. In the browser process, this will DCHECK if not
   // called on the file thread. To easily load application images on the UI
@@ -59,6 +65,7 @@ class ApplicationResource {
   const std::string& application_id() const { return application_id_; }
   const base::FilePath& application_root() const { return application_root_; }
   const base::FilePath& relative_path() const { return relative_path_; }
+  const std::list<std::string>& locales() const { return locales_; }
 
   // Setters
   void SetLocales(const std::list<std::string>& locales) {
@@ -0,0 +1,74 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/application_resource_cache.h"
+
+#include "xwalk/application/common/application_resource.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+// Neither can be part of a locale or of a path.
+const char kLocaleSeparator = ',';
+const char kPathSeparator = '\0';
+
+}  // namespace
+
+ApplicationResourceCache::ApplicationResourceCache() {}
+
+ApplicationResourceCache::~ApplicationResourceCache() {}
+
+bool ApplicationResourceCache::Lookup(const base::FilePath& relative_path,
+                                      const std::list<std::string>& locales,
+                                      base::FilePath* file_path) const {
+  std::string key = GetKey(relative_path, locales);
+  base::AutoLock lock(lock_);
+  PathMap::const_iterator it = paths_.find(key);
+  if (it == paths_.end())
+    return false;
+  *file_path = it->second;
+  return true;
+}
+
+void ApplicationResourceCache::Insert(const base::FilePath& relative_path,
+                                      const std::list<std::string>& locales,
+                                      const base::FilePath& file_path) {
+  if (relative_path.empty() || file_path.empty())
+    return;
+  std::string key = GetKey(relative_path, locales);
+  base::AutoLock lock(lock_);
+  paths_[key] = file_path;
+}
+
+base::FilePath ApplicationResourceCache::GetFilePath(
+    const ApplicationResource& resource) {
+  base::FilePath file_path;
+  if (Lookup(resource.relative_path(), resource.locales(), &file_path))
+    return file_path;
+  file_path = resource.GetFilePath();
+  Insert(resource.relative_path(), resource.locales(), file_path);
+  return file_path;
+}
+
+size_t ApplicationResourceCache::size() const {
+  base::AutoLock lock(lock_);
+  return paths_.size();
+}
+
+// static
+std::string ApplicationResourceCache::GetKey(
+    const base::FilePath& relative_path,
+    const std::list<std::string>& locales) {
+  std::string key;
+  for (const std::string& locale : locales)
+    key.append(locale).push_back(kLocaleSeparator);
+  key.push_back(kPathSeparator);
+  key.append(relative_path.AsUTF8Unsafe());
+  return key;
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -0,0 +1,67 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_APPLICATION_COMMON_APPLICATION_RESOURCE_CACHE_H_
+#define XWALK_APPLICATION_COMMON_APPLICATION_RESOURCE_CACHE_H_
+
+#include <list>
+#include <string>
+#include <unordered_map>
+
+#include "base/files/file_path.h"
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
+
+namespace xwalk {
+namespace application {
+
+class ApplicationResource;
+
+// Remembers where the resources of an application were found on disk, so
+// that ApplicationResource::GetFilePath(), which resolves symlinks and stats
+// every locale specific candidate, runs once per resource and locale list.
+// Only resources that were found are remembered: a file added later is
+// still looked up. The cache belongs to an ApplicationData, so it is dropped
+// when the application is installed again.
+// This class is thread-safe.
+class ApplicationResourceCache {
+ public:
+  ApplicationResourceCache();
+  ~ApplicationResourceCache();
+
+  // Returns true and sets |file_path| if |relative_path| was resolved for
+  // |locales| before.
+  bool Lookup(const base::FilePath& relative_path,
+              const std::list<std::string>& locales,
+              base::FilePath* file_path) const;
+
+  // Remembers that |relative_path| resolves to |file_path| for |locales|.
+  // Empty paths are ignored.
+  void Insert(const base::FilePath& relative_path,
+              const std::list<std::string>& locales,
+              const base::FilePath& file_path);
+
+  // Returns where |resource| is found for its locales, resolving it with
+  // ApplicationResource::GetFilePath() and remembering the result if it was
+  // not looked up before. Empty if the resource is not found.
+  base::FilePath GetFilePath(const ApplicationResource& resource);
+
+  size_t size() const;
+
+ private:
+  typedef std::unordered_map<std::string, base::FilePath> PathMap;
+
+  static std::string GetKey(const base::FilePath& relative_path,
+                            const std::list<std::string>& locales);
+
+  PathMap paths_;
+  mutable base::Lock lock_;
+
+  DISALLOW_COPY_AND_ASSIGN(ApplicationResourceCache);
+};
+
+}  // namespace application
+}  // namespace xwalk
+
+#endif  // XWALK_APPLICATION_COMMON_APPLICATION_RESOURCE_CACHE_H_
@@ -0,0 +1,124 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/application_resource_cache.h"
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "xwalk/application/common/application_resource.h"
+
+namespace xwalk {
+namespace application {
+
+class ApplicationResourceCacheTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    root_ = base::MakeAbsoluteFilePath(temp_dir_.path());
+  }
+
+  ApplicationResource CreateResource(const base::FilePath& relative_path,
+                                     const std::list<std::string>& locales) {
+    ApplicationResource resource(std::string(), root_, relative_path);
+    resource.SetLocales(locales);
+    return resource;
+  }
+
+  base::FilePath CreateFile(const std::string& relative_path) {
+    base::FilePath path = root_.AppendASCII(relative_path);
+    EXPECT_TRUE(base::CreateDirectory(path.DirName()));
+    EXPECT_EQ(1, base::WriteFile(path, "x", 1));
+    return path;
+  }
+
+  base::ScopedTempDir temp_dir_;
+  base::FilePath root_;
+};
+
+TEST_F(ApplicationResourceCacheTest, LookupIsKeyedByLocales) {
+  ApplicationResourceCache cache;
+  base::FilePath relative_path(FILE_PATH_LITERAL("index.html"));
+  std::list<std::string> en = { "en-us", "en" };
+  std::list<std::string> fr = { "fr" };
+  base::FilePath en_path = CreateFile("locales/en/index.html");
+  base::FilePath default_path = CreateFile("index.html");
+
+  base::FilePath file_path;
+  EXPECT_FALSE(cache.Lookup(relative_path, en, &file_path));
+  EXPECT_EQ(en_path, cache.GetFilePath(CreateResource(relative_path, en)));
+  EXPECT_EQ(default_path,
+            cache.GetFilePath(CreateResource(relative_path, fr)));
+  EXPECT_EQ(2u, cache.size());
+
+  ASSERT_TRUE(cache.Lookup(relative_path, en, &file_path));
+  EXPECT_EQ(en_path, file_path);
+  ASSERT_TRUE(cache.Lookup(relative_path, fr, &file_path));
+  EXPECT_EQ(default_path, file_path);
+  EXPECT_FALSE(cache.Lookup(relative_path, std::list<std::string>(),
+                            &file_path));
+}
+
+TEST_F(ApplicationResourceCacheTest, MissingResourcesAreNotCached) {
+  ApplicationResourceCache cache;
+  base::FilePath relative_path(FILE_PATH_LITERAL("late.js"));
+  std::list<std::string> locales;
+
+  ApplicationResource resource = CreateResource(relative_path, locales);
+  EXPECT_TRUE(cache.GetFilePath(resource).empty());
+  EXPECT_EQ(0u, cache.size());
+
+  // A file created after a failed lookup is still found.
+  base::FilePath path = CreateFile("late.js");
+  EXPECT_EQ(path, cache.GetFilePath(resource));
+  EXPECT_EQ(1u, cache.size());
+}
+
+// Resolves every resource of an application with thousands of them, half of
+// which are localized, the way repeated app:// loads do on the file thread.
+TEST_F(ApplicationResourceCacheTest, ResolveThousandsOfResources) {
+  const int kResourceCount = 2000;
+  const int kLoadCount = 5;
+  std::list<std::string> locales = { "en-us", "en" };
+  std::vector<ApplicationResource> resources;
+  for (int i = 0; i < kResourceCount; ++i) {
+    std::string path = base::StringPrintf("assets/%d/file%d.js", i % 20, i);
+    CreateFile(i % 2 ? "locales/en/" + path : path);
+    resources.push_back(
+        CreateResource(base::FilePath::FromUTF8Unsafe(path), locales));
+  }
+
+  // ApplicationResource remembers its path, each load gets fresh copies
+  // like each app:// request does.
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int load = 0; load < kLoadCount; ++load) {
+    for (const ApplicationResource& resource : resources)
+      EXPECT_FALSE(ApplicationResource(resource).GetFilePath().empty());
+  }
+  base::TimeDelta uncached = base::TimeTicks::Now() - start;
+
+  ApplicationResourceCache cache;
+  start = base::TimeTicks::Now();
+  for (int load = 0; load < kLoadCount; ++load) {
+    for (const ApplicationResource& resource : resources)
+      EXPECT_FALSE(cache.GetFilePath(ApplicationResource(resource)).empty());
+  }
+  base::TimeDelta cached = base::TimeTicks::Now() - start;
+  EXPECT_EQ(static_cast<size_t>(kResourceCount), cache.size());
+
+  perf_test::PrintResult("application_resource_lookup", "", "uncached",
+                         uncached.InMillisecondsF() / kLoadCount, "ms", true);
+  perf_test::PrintResult("application_resource_lookup", "", "cached",
+                         cached.InMillisecondsF() / kLoadCount, "ms", true);
+}
+
+}  // namespace application
+}  // namespace xwalk
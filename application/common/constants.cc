@@ -14,6 +14,8 @@ const base::FilePath::CharType kManifestXpkFilename[] =
     FILE_PATH_LITERAL("manifest.json");
 const base::FilePath::CharType kManifestWgtFilename[] =
     FILE_PATH_LITERAL("config.xml");
+const base::FilePath::CharType kManifestCacheExtension[] =
+    FILE_PATH_LITERAL(".manifest_cache");
 const base::FilePath::CharType kMessagesFilename[] =
     FILE_PATH_LITERAL("messages.json");
 const char kGeneratedMainDocumentFilename[] =
@@ -20,6 +20,10 @@ extern const base::FilePath::CharType kManifestXpkFilename[];
 // The name of the manifest inside a WGT-packaged application.
 extern const base::FilePath::CharType kManifestWgtFilename[];
 
+// The extension of the file caching the parsed manifest of a package
+// extraction, which is next to the extraction folder, see manifest_cache.h.
+extern const base::FilePath::CharType kManifestCacheExtension[];
+
 // The name of the messages file inside an application.
 extern const base::FilePath::CharType kMessagesFilename[];
 
@@ -116,15 +116,14 @@ bool Manifest::GetString(
   if (!CanAccessPath(path))
     return false;
 
-  if (i18n_data_->Get(path, NULL)) {
-    List::const_iterator it = user_agent_locales_->begin();
-    for (; it != user_agent_locales_->end(); ++it) {
-      if (i18n_data_->GetString(GetLocalizedKey(path, *it), out_value))
-        return true;
-    }
-    return false;
+  LocalizedStringMap::const_iterator it = localized_strings_.find(path);
+  if (it != localized_strings_.end()) {
+    *out_value = it->second;
+    return true;
   }
 
+  // The i18n paths without a string in any locale are never strings in
+  // |data_| either.
   return data_->GetString(path, out_value);
 }
 
@@ -133,13 +132,10 @@ bool Manifest::GetString(
   if (!CanAccessPath(path))
     return false;
 
-  if (i18n_data_->Get(path, NULL)) {
-    List::const_iterator it = user_agent_locales_->begin();
-    for (; it != user_agent_locales_->end(); ++it) {
-      if (i18n_data_->GetString(GetLocalizedKey(path, *it), out_value))
-        return true;
-    }
-    return false;
+  LocalizedStringMap::const_iterator it = localized_strings_.find(path);
+  if (it != localized_strings_.end()) {
+    *out_value = base::UTF8ToUTF16(it->second);
+    return true;
   }
 
   return data_->GetString(path, out_value);
@@ -175,6 +171,10 @@ bool Manifest::CanAccessKey(const std::string& key) const {
 }
 
 void Manifest::SetSystemLocale(const std::string& locale) {
+  if (user_agent_locales_ && locale == system_locale_)
+    return;
+  system_locale_ = locale;
+
   std::unique_ptr<List> list_for_expand(new List);
   list_for_expand->push_back(locale);
   list_for_expand->push_back(default_locale_);
@@ -182,6 +182,20 @@ void Manifest::SetSystemLocale(const std::string& locale) {
   list_for_expand->push_back(kLocaleAuto);
   list_for_expand->push_back(kLocaleFirstOne);
   user_agent_locales_ = ExpandUserAgentLocalesList(list_for_expand);
+  ResolveLocalizedStrings();
+}
+
+void Manifest::ResolveLocalizedStrings() {
+  localized_strings_.clear();
+  for (const std::string& path : i18n_paths_) {
+    for (const std::string& locale : *user_agent_locales_) {
+      std::string value;
+      if (i18n_data_->GetString(GetLocalizedKey(path, locale), &value)) {
+        localized_strings_[path] = value;
+        break;
+      }
+    }
+  }
 }
 
 void Manifest::ParseWGTI18n() {
@@ -244,10 +258,11 @@ bool Manifest::ParseWGTI18nEachElement(base::Value* value,
 
   base::DictionaryValue::Iterator iter(*dict);
   while (!iter.IsAtEnd()) {
-    std::string locale_key(
-        GetLocalizedKey(path + kPathConnectSymbol + iter.key(), xml_lang));
+    std::string i18n_path(path + kPathConnectSymbol + iter.key());
+    std::string locale_key(GetLocalizedKey(i18n_path, xml_lang));
     if (!i18n_data_->Get(locale_key, NULL))
       i18n_data_->Set(locale_key, iter.value().DeepCopy());
+    i18n_paths_.insert(i18n_path);
 
     iter.Advance();
   }
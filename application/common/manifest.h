@@ -10,6 +10,7 @@
 #include <memory>
 #include <string>
 #include <set>
+#include <unordered_map>
 #include <vector>
 
 #include "base/strings/string16.h"
@@ -78,10 +79,17 @@ class Manifest {
     return default_locale_;
   }
 
-  // Update user agent locale when system locale is changed.
+  // Update user agent locale when system locale is changed. The i18n paths
+  // are resolved for the new locale here, once, rather than on each
+  // GetString().
   void SetSystemLocale(const std::string& locale);
 
  private:
+  // Maps i18n paths to their value in the current locale.
+  typedef std::unordered_map<std::string, std::string> LocalizedStringMap;
+
+  void ResolveLocalizedStrings();
+
   void ParseWGTI18n();
   void ParseWGTI18nEachPath(const std::string& path);
   bool ParseWGTI18nEachElement(base::Value* value,
@@ -96,7 +104,12 @@ class Manifest {
   std::unique_ptr<base::DictionaryValue> data_;
   std::unique_ptr<base::DictionaryValue> i18n_data_;
 
+  // The paths found in |i18n_data_|, without their locale suffix.
+  std::set<std::string> i18n_paths_;
+  LocalizedStringMap localized_strings_;
+
   std::string default_locale_;
+  std::string system_locale_;
   std::unique_ptr<std::list<std::string> > user_agent_locales_;
 
   Type type_;
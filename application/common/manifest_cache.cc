@@ -0,0 +1,217 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/manifest_cache.h"
+
+#include <utility>
+
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/files/important_file_writer.h"
+#include "base/files/memory_mapped_file.h"
+#include "base/logging.h"
+#include "base/pickle.h"
+#include "base/values.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+// Bumped whenever the format of the file or the way manifests are turned
+// into values changes.
+const int kManifestCacheVersion = 1;
+
+// Manifests are much shallower, this only guards the recursion against
+// corrupt files.
+const int kMaxValueDepth = 100;
+
+bool WriteValue(const base::Value& value, int depth, base::Pickle* pickle) {
+  if (depth > kMaxValueDepth)
+    return false;
+
+  pickle->WriteInt(value.GetType());
+  switch (value.GetType()) {
+    case base::Value::TYPE_NULL:
+      return true;
+    case base::Value::TYPE_BOOLEAN: {
+      bool boolean;
+      value.GetAsBoolean(&boolean);
+      pickle->WriteBool(boolean);
+      return true;
+    }
+    case base::Value::TYPE_INTEGER: {
+      int integer;
+      value.GetAsInteger(&integer);
+      pickle->WriteInt(integer);
+      return true;
+    }
+    case base::Value::TYPE_DOUBLE: {
+      double number;
+      value.GetAsDouble(&number);
+      pickle->WriteDouble(number);
+      return true;
+    }
+    case base::Value::TYPE_STRING: {
+      std::string string;
+      value.GetAsString(&string);
+      pickle->WriteString(string);
+      return true;
+    }
+    case base::Value::TYPE_DICTIONARY: {
+      const base::DictionaryValue* dict;
+      value.GetAsDictionary(&dict);
+      pickle->WriteInt(dict->size());
+      for (base::DictionaryValue::Iterator it(*dict); !it.IsAtEnd();
+           it.Advance()) {
+        pickle->WriteString(it.key());
+        if (!WriteValue(it.value(), depth + 1, pickle))
+          return false;
+      }
+      return true;
+    }
+    case base::Value::TYPE_LIST: {
+      const base::ListValue* list;
+      value.GetAsList(&list);
+      pickle->WriteInt(list->GetSize());
+      for (const auto& item : *list) {
+        if (!WriteValue(*item, depth + 1, pickle))
+          return false;
+      }
+      return true;
+    }
+    default:
+      // Manifests never contain binary values.
+      return false;
+  }
+}
+
+std::unique_ptr<base::Value> ReadValue(base::PickleIterator* iter,
+                                       int depth) {
+  int type;
+  if (depth > kMaxValueDepth || !iter->ReadInt(&type))
+    return NULL;
+
+  switch (type) {
+    case base::Value::TYPE_NULL:
+      return base::Value::CreateNullValue();
+    case base::Value::TYPE_BOOLEAN: {
+      bool boolean;
+      if (!iter->ReadBool(&boolean))
+        return NULL;
+      return std::unique_ptr<base::Value>(
+          new base::FundamentalValue(boolean));
+    }
+    case base::Value::TYPE_INTEGER: {
+      int integer;
+      if (!iter->ReadInt(&integer))
+        return NULL;
+      return std::unique_ptr<base::Value>(
+          new base::FundamentalValue(integer));
+    }
+    case base::Value::TYPE_DOUBLE: {
+      double number;
+      if (!iter->ReadDouble(&number))
+        return NULL;
+      return std::unique_ptr<base::Value>(new base::FundamentalValue(number));
+    }
+    case base::Value::TYPE_STRING: {
+      std::string string;
+      if (!iter->ReadString(&string))
+        return NULL;
+      return std::unique_ptr<base::Value>(new base::StringValue(string));
+    }
+    case base::Value::TYPE_DICTIONARY: {
+      int size;
+      if (!iter->ReadInt(&size) || size < 0)
+        return NULL;
+      std::unique_ptr<base::DictionaryValue> dict(new base::DictionaryValue);
+      for (int i = 0; i < size; ++i) {
+        std::string key;
+        if (!iter->ReadString(&key))
+          return NULL;
+        std::unique_ptr<base::Value> item = ReadValue(iter, depth + 1);
+        if (!item)
+          return NULL;
+        dict->SetWithoutPathExpansion(key, std::move(item));
+      }
+      return std::move(dict);
+    }
+    case base::Value::TYPE_LIST: {
+      int size;
+      if (!iter->ReadInt(&size) || size < 0)
+        return NULL;
+      std::unique_ptr<base::ListValue> list(new base::ListValue);
+      for (int i = 0; i < size; ++i) {
+        std::unique_ptr<base::Value> item = ReadValue(iter, depth + 1);
+        if (!item)
+          return NULL;
+        list->Append(std::move(item));
+      }
+      return std::move(list);
+    }
+    default:
+      return NULL;
+  }
+}
+
+}  // namespace
+
+std::unique_ptr<Manifest> ReadManifestCache(
+    const base::FilePath& cache_path, const std::string& manifest_hash,
+    const std::string& runtime_version, Manifest::Type type) {
+  std::unique_ptr<base::DictionaryValue> value;
+  {
+    base::MemoryMappedFile file;
+    if (!file.Initialize(cache_path))
+      return NULL;
+
+    // The pickle reads the mapped memory in place.
+    base::Pickle pickle(reinterpret_cast<const char*>(file.data()),
+                        static_cast<int>(file.length()));
+    base::PickleIterator iter(pickle);
+    int version;
+    std::string cached_runtime_version;
+    std::string cached_manifest_hash;
+    int cached_type;
+    if (iter.ReadInt(&version) && version == kManifestCacheVersion &&
+        iter.ReadString(&cached_runtime_version) &&
+        cached_runtime_version == runtime_version &&
+        iter.ReadString(&cached_manifest_hash) &&
+        cached_manifest_hash == manifest_hash &&
+        iter.ReadInt(&cached_type) && cached_type == type) {
+      std::unique_ptr<base::Value> root = ReadValue(&iter, 0);
+      if (root && root->IsType(base::Value::TYPE_DICTIONARY))
+        value.reset(static_cast<base::DictionaryValue*>(root.release()));
+    }
+  }
+
+  if (!value) {
+    LOG(INFO) << "Ignoring the outdated or invalid manifest cache "
+              << cache_path.AsUTF8Unsafe();
+    base::DeleteFile(cache_path, false);
+    return NULL;
+  }
+  return std::unique_ptr<Manifest>(new Manifest(std::move(value), type));
+}
+
+bool WriteManifestCache(
+    const base::FilePath& cache_path, const std::string& manifest_hash,
+    const std::string& runtime_version, const Manifest& manifest) {
+  base::Pickle pickle;
+  pickle.WriteInt(kManifestCacheVersion);
+  pickle.WriteString(runtime_version);
+  pickle.WriteString(manifest_hash);
+  pickle.WriteInt(manifest.type());
+  if (!WriteValue(*manifest.value(), 0, &pickle))
+    return false;
+
+  return base::ImportantFileWriter::WriteFileAtomically(
+      cache_path,
+      base::StringPiece(static_cast<const char*>(pickle.data()),
+                        pickle.size()));
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -0,0 +1,43 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_APPLICATION_COMMON_MANIFEST_CACHE_H_
+#define XWALK_APPLICATION_COMMON_MANIFEST_CACHE_H_
+
+#include <memory>
+#include <string>
+
+#include "xwalk/application/common/manifest.h"
+
+namespace base {
+class FilePath;
+}
+
+namespace xwalk {
+namespace application {
+
+// The manifest cache keeps the value tree built from an application manifest
+// in a binary file, so that launching the application again doesn't go
+// through the XML or JSON parser. The file is memory-mapped when read.
+//
+// A cache is only used for the manifest contents it was written for, which
+// are identified by their SHA-1 hash, and by the runtime version that wrote
+// it, since the way manifests are turned into values changes between
+// versions. Invalid or outdated caches are deleted when read.
+
+// Returns the manifest cached in |cache_path|, or NULL if there is no usable
+// cache for a manifest of |type| hashing to |manifest_hash|.
+std::unique_ptr<Manifest> ReadManifestCache(
+    const base::FilePath& cache_path, const std::string& manifest_hash,
+    const std::string& runtime_version, Manifest::Type type);
+
+// Writes |manifest| to |cache_path| atomically. Returns false on failure.
+bool WriteManifestCache(
+    const base::FilePath& cache_path, const std::string& manifest_hash,
+    const std::string& runtime_version, const Manifest& manifest);
+
+}  // namespace application
+}  // namespace xwalk
+
+#endif  // XWALK_APPLICATION_COMMON_MANIFEST_CACHE_H_
@@ -0,0 +1,176 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/manifest_cache.h"
+
+#include <string>
+
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/sha1.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "xwalk/application/common/application_data.h"
+#include "xwalk/application/common/application_file_util.h"
+#include "xwalk/application/common/constants.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+const char kRuntimeVersion[] = "1.2.3.4";
+
+// Returns a config.xml with |element_count| <access> and <preference>
+// elements.
+std::string CreateWidgetManifest(const std::string& name, int element_count) {
+  std::string manifest =
+      "<widget xmlns=\"http://www.w3.org/ns/widgets\" version=\"1.0\">"
+      "<name>" + name + "</name>"
+      "<description xml:lang=\"en\">A test widget.</description>"
+      "<content src=\"index.html\"/>";
+  for (int i = 0; i < element_count; ++i) {
+    manifest += base::StringPrintf(
+        "<access origin=\"http://host%d.example.com\" subdomains=\"true\"/>"
+        "<preference name=\"key%d\" value=\"value%d\"/>", i, i, i);
+  }
+  return manifest + "</widget>";
+}
+
+}  // namespace
+
+class ManifestCacheTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    // Laid out like the package cache, the cache is next to the application.
+    app_root_ = temp_dir_.path().AppendASCII("app");
+    ASSERT_TRUE(base::CreateDirectory(app_root_));
+    cache_path_ = app_root_.AddExtension(kManifestCacheExtension);
+  }
+
+  void WriteManifest(const std::string& manifest) {
+    manifest_ = manifest;
+    ASSERT_EQ(static_cast<int>(manifest.size()),
+              base::WriteFile(app_root_.Append(kManifestWgtFilename),
+                              manifest.data(), manifest.size()));
+  }
+
+  scoped_refptr<ApplicationData> Load(bool use_cache) {
+    std::string error;
+    scoped_refptr<ApplicationData> application = use_cache ?
+        LoadApplicationWithManifestCache(
+            app_root_, std::string(), ApplicationData::TEMP_DIRECTORY,
+            Manifest::TYPE_WIDGET, cache_path_, kRuntimeVersion, &error) :
+        LoadApplication(
+            app_root_, std::string(), ApplicationData::TEMP_DIRECTORY,
+            Manifest::TYPE_WIDGET, &error);
+    EXPECT_TRUE(application.get()) << error;
+    return application;
+  }
+
+  std::unique_ptr<Manifest> ReadCache(const std::string& runtime_version) {
+    return ReadManifestCache(cache_path_, base::SHA1HashString(manifest_),
+                             runtime_version, Manifest::TYPE_WIDGET);
+  }
+
+  // Loads the application |load_count| times and returns the average time
+  // one load took.
+  double MeasureLoad(bool use_cache, int load_count) {
+    base::TimeTicks start = base::TimeTicks::Now();
+    for (int i = 0; i < load_count; ++i)
+      Load(use_cache);
+    return (base::TimeTicks::Now() - start).InMillisecondsF() / load_count;
+  }
+
+  base::ScopedTempDir temp_dir_;
+  base::FilePath app_root_;
+  base::FilePath cache_path_;
+  std::string manifest_;
+};
+
+TEST_F(ManifestCacheTest, CachedManifestMatchesParsedOne) {
+  WriteManifest(CreateWidgetManifest("Cached", 10));
+  scoped_refptr<ApplicationData> parsed = Load(false);
+  ASSERT_TRUE(parsed.get());
+  EXPECT_FALSE(base::PathExists(cache_path_));
+
+  ASSERT_TRUE(Load(true).get());
+  ASSERT_TRUE(base::PathExists(cache_path_));
+  std::unique_ptr<Manifest> cached = ReadCache(kRuntimeVersion);
+  ASSERT_TRUE(cached);
+  EXPECT_TRUE(cached->value()->Equals(parsed->GetManifest()->value()));
+
+  scoped_refptr<ApplicationData> application = Load(true);
+  ASSERT_TRUE(application.get());
+  EXPECT_EQ("Cached", application->Name());
+  EXPECT_TRUE(application->GetManifest()->value()->Equals(
+      parsed->GetManifest()->value()));
+}
+
+TEST_F(ManifestCacheTest, ChangedManifestIsParsedAgain) {
+  WriteManifest(CreateWidgetManifest("Before", 1));
+  ASSERT_TRUE(Load(true).get());
+
+  WriteManifest(CreateWidgetManifest("After", 1));
+  EXPECT_FALSE(ReadCache(kRuntimeVersion));
+  scoped_refptr<ApplicationData> application = Load(true);
+  ASSERT_TRUE(application.get());
+  EXPECT_EQ("After", application->Name());
+  EXPECT_TRUE(ReadCache(kRuntimeVersion));
+}
+
+TEST_F(ManifestCacheTest, OtherRuntimeVersionDropsCache) {
+  WriteManifest(CreateWidgetManifest("Versioned", 1));
+  ASSERT_TRUE(Load(true).get());
+
+  EXPECT_FALSE(ReadCache("5.6.7.8"));
+  EXPECT_FALSE(base::PathExists(cache_path_));
+}
+
+TEST_F(ManifestCacheTest, CorruptCacheIsReplaced) {
+  WriteManifest(CreateWidgetManifest("Corrupt", 1));
+  const char kGarbage[] = "not a manifest cache";
+  ASSERT_EQ(static_cast<int>(sizeof(kGarbage)),
+            base::WriteFile(cache_path_, kGarbage, sizeof(kGarbage)));
+
+  scoped_refptr<ApplicationData> application = Load(true);
+  ASSERT_TRUE(application.get());
+  EXPECT_EQ("Corrupt", application->Name());
+  EXPECT_TRUE(ReadCache(kRuntimeVersion));
+}
+
+// Measures how long turning the manifest into ApplicationData takes, with
+// and without the cache, for a small widget and for one with thousands of
+// <access> and <preference> elements.
+TEST_F(ManifestCacheTest, LoadSmallAndLargeManifests) {
+  const int kLoadCount = 5;
+  const struct {
+    const char* name;
+    int element_count;
+  } kManifests[] = {
+    { "small", 1 },
+    { "large", 5000 },
+  };
+
+  for (const auto& test : kManifests) {
+    WriteManifest(CreateWidgetManifest(test.name, test.element_count));
+    base::DeleteFile(cache_path_, false);
+    double parsed = MeasureLoad(false, kLoadCount);
+    // Writes the cache.
+    Load(true);
+    double cached = MeasureLoad(true, kLoadCount);
+
+    perf_test::PrintResult("manifest_to_application_data", test.name,
+                           "parsed", parsed, "ms", true);
+    perf_test::PrintResult("manifest_to_application_data", test.name,
+                           "cached", cached, "ms", true);
+  }
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -17,6 +17,7 @@
 
 namespace errors = xwalk::application_manifest_errors;
 namespace keys = xwalk::application_manifest_keys;
+namespace widget_keys = xwalk::application_widget_keys;
 
 namespace xwalk {
 namespace application {
@@ -84,6 +85,52 @@ TEST_F(ManifestTest, ApplicationTypes) {
   EXPECT_TRUE(error.empty());
 }
 
+// Verifies that localized widget strings follow the system locale.
+TEST_F(ManifestTest, WidgetStringsFollowSystemLocale) {
+  std::unique_ptr<base::ListValue> names(new base::ListValue);
+  std::unique_ptr<base::DictionaryValue> name(new base::DictionaryValue);
+  name->SetString("#text", "unlocalized name");
+  names->Append(std::move(name));
+  name.reset(new base::DictionaryValue);
+  name->SetString("#text", "zh-CN name");
+  name->SetString(widget_keys::kXmlLangKey, "zh-CN");
+  names->Append(std::move(name));
+  name.reset(new base::DictionaryValue);
+  name->SetString("#text", "en-US name");
+  name->SetString("@short", "en-US short");
+  name->SetString(widget_keys::kXmlLangKey, "en-US");
+  names->Append(std::move(name));
+  std::unique_ptr<base::DictionaryValue> value(new base::DictionaryValue);
+  value->Set("widget.name", names.release());
+  value->SetString("widget.@version", "1.0");
+
+  Manifest manifest(std::move(value), Manifest::TYPE_WIDGET);
+  std::string string;
+  base::string16 string16;
+
+  manifest.SetSystemLocale("zh-CN");
+  EXPECT_TRUE(manifest.GetString(widget_keys::kNameKey, &string));
+  EXPECT_EQ("zh-CN name", string);
+  EXPECT_TRUE(manifest.GetString(widget_keys::kNameKey, &string16));
+  EXPECT_EQ(base::ASCIIToUTF16("zh-CN name"), string16);
+  // Only the en-US element has a short name, which is the fallback.
+  EXPECT_TRUE(manifest.GetString(widget_keys::kShortNameKey, &string));
+  EXPECT_EQ("en-US short", string);
+
+  manifest.SetSystemLocale("en-US");
+  EXPECT_TRUE(manifest.GetString(widget_keys::kNameKey, &string));
+  EXPECT_EQ("en-US name", string);
+
+  manifest.SetSystemLocale("fr");
+  EXPECT_TRUE(manifest.GetString(widget_keys::kNameKey, &string));
+  EXPECT_EQ("unlocalized name", string);
+
+  // Paths outside of the i18n ones are read from the manifest.
+  EXPECT_TRUE(manifest.GetString(widget_keys::kVersionKey, &string));
+  EXPECT_EQ("1.0", string);
+  EXPECT_FALSE(manifest.GetString("widget.name", &string));
+}
+
 }  // namespace application
 }  // namespace xwalk
 
@@ -4,11 +4,26 @@
 
 #include "xwalk/application/common/package/package.h"
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/files/file_enumerator.h"
 #include "base/files/file_path.h"
 #include "base/files/file_util.h"
 #include "base/logging.h"
+#include "base/macros.h"
+#include "base/memory/scoped_vector.h"
 #include "base/path_service.h"
-#include "third_party/zlib/google/zip.h"
+#include "base/stl_util.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_util.h"
+#include "base/sys_info.h"
+#include "base/threading/simple_thread.h"
+#include "crypto/secure_hash.h"
+#include "crypto/sha2.h"
+#include "third_party/zlib/google/zip_reader.h"
+#include "xwalk/application/common/constants.h"
 #include "xwalk/application/common/id_util.h"
 #include "xwalk/application/common/package/wgt_package.h"
 #include "xwalk/application/common/package/xpk_package.h"
@@ -16,6 +31,106 @@
 namespace xwalk {
 namespace application {
 
+namespace {
+
+const size_t kReadBufferSize = 1 << 16;
+
+// Packages are extracted by up to this number of threads, each one
+// decompressing every n-th entry with its own reader.
+const int kMaxExtractThreads = 4;
+const int kMinEntriesPerThread = 16;
+
+class EntryExtractor : public base::DelegateSimpleThread::Delegate {
+ public:
+  EntryExtractor(const base::FilePath& zip_path,
+                 const base::FilePath& target_path,
+                 int index,
+                 int count)
+      : zip_path_(zip_path),
+        target_path_(target_path),
+        index_(index),
+        count_(count),
+        succeeded_(false) {}
+
+  void Run() override { succeeded_ = Extract(); }
+
+  bool succeeded() const { return succeeded_; }
+
+ private:
+  // Same as zip::Unzip(), but only for the entries of this extractor.
+  bool Extract() {
+    zip::ZipReader reader;
+    if (!reader.Open(zip_path_))
+      return false;
+
+    for (int i = 0; reader.HasMore(); ++i) {
+      if (i % count_ == index_) {
+        if (!reader.OpenCurrentEntryInZip())
+          return false;
+        const zip::ZipReader::EntryInfo* entry = reader.current_entry_info();
+        if (entry->is_unsafe())
+          return false;
+        base::FilePath path = target_path_.Append(entry->file_path());
+        if (entry->is_directory()) {
+          if (!base::CreateDirectory(path))
+            return false;
+        } else if (!reader.ExtractCurrentEntryToFilePath(path)) {
+          return false;
+        }
+      }
+      if (!reader.AdvanceToNextEntry())
+        return false;
+    }
+    return true;
+  }
+
+  base::FilePath zip_path_;
+  base::FilePath target_path_;
+  int index_;
+  int count_;
+  bool succeeded_;
+
+  DISALLOW_COPY_AND_ASSIGN(EntryExtractor);
+};
+
+bool ExtractPackage(const base::FilePath& zip_path,
+                    const base::FilePath& target_path) {
+  int entries = 0;
+  {
+    zip::ZipReader reader;
+    if (!reader.Open(zip_path))
+      return false;
+    entries = reader.num_entries();
+  }
+
+  int thread_count = std::min(
+      std::min(kMaxExtractThreads, base::SysInfo::NumberOfProcessors()),
+      std::max(1, entries / kMinEntriesPerThread));
+  if (thread_count <= 1) {
+    EntryExtractor extractor(zip_path, target_path, 0, 1);
+    extractor.Run();
+    return extractor.succeeded();
+  }
+
+  ScopedVector<EntryExtractor> extractors;
+  base::DelegateSimpleThreadPool pool("PackageExtractor", thread_count);
+  for (int i = 0; i < thread_count; ++i) {
+    extractors.push_back(
+        new EntryExtractor(zip_path, target_path, i, thread_count));
+    pool.AddWork(extractors.back());
+  }
+  pool.Start();
+  pool.JoinAll();
+
+  for (const EntryExtractor* extractor : extractors) {
+    if (!extractor->succeeded())
+      return false;
+  }
+  return true;
+}
+
+}  // namespace
+
 Package::Package(const base::FilePath& source_path,
     Manifest::Type manifest_type)
     : is_valid_(false),
@@ -55,7 +170,7 @@ bool Package::ExtractToTemporaryDir(base::FilePath* target_path) {
     return false;
   }
 
-  if (!zip::Unzip(source_path_, temp_dir_.path())) {
+  if (!ExtractPackage(source_path_, temp_dir_.path())) {
     LOG(ERROR) << "An error occurred during package extraction";
     return false;
   }
@@ -77,7 +192,7 @@ bool Package::ExtractTo(const base::FilePath& target_path) {
                << "is not empty.";
     return false;
   }
-  if (!zip::Unzip(source_path_, target_path)) {
+  if (!ExtractPackage(source_path_, target_path)) {
     LOG(ERROR) << "An error occurred during package extraction";
     return false;
   }
@@ -85,6 +200,99 @@ bool Package::ExtractTo(const base::FilePath& target_path) {
   return true;
 }
 
+bool Package::ExtractToCache(const base::FilePath& cache_path,
+                             base::FilePath* target_path) {
+  if (!IsValid() || id_.empty() || hash().empty())
+    return false;
+
+  base::FilePath package_path = cache_path.AppendASCII(id_);
+  base::FilePath extracted_path = package_path.AppendASCII(hash_);
+  if (base::DirectoryExists(extracted_path)) {
+    *target_path = extracted_path;
+    return true;
+  }
+
+  // Extract next to the final folder and rename it once complete, so that
+  // a partial extraction is never reused.
+  base::FilePath temp_path;
+  if (!base::CreateDirectory(package_path) ||
+      !base::CreateTemporaryDirInDir(package_path,
+                                     FILE_PATH_LITERAL("tmp"),
+                                     &temp_path)) {
+    LOG(ERROR) << "Can't create a directory for extracting the package "
+               << "content in " << cache_path.MaybeAsASCII();
+    return false;
+  }
+
+  if (!ExtractPackage(source_path_, temp_path)) {
+    LOG(ERROR) << "An error occurred during package extraction";
+    base::DeleteFile(temp_path, true);
+    return false;
+  }
+
+  if (!base::Move(temp_path, extracted_path)) {
+    base::DeleteFile(temp_path, true);
+    // Someone else extracted the same package meanwhile.
+    if (!base::DirectoryExists(extracted_path))
+      return false;
+  }
+
+  *target_path = extracted_path;
+  return true;
+}
+
+// static
+void Package::DeleteUnusedExtractions(
+    const base::FilePath& cache_path,
+    const std::string& app_id,
+    const std::set<base::FilePath>& paths_in_use) {
+  base::FileEnumerator extractions(cache_path.AppendASCII(app_id), false,
+                                   base::FileEnumerator::DIRECTORIES);
+  for (base::FilePath path = extractions.Next(); !path.empty();
+       path = extractions.Next()) {
+    // Extractions in progress are renamed once complete.
+    if (base::StartsWith(path.BaseName().MaybeAsASCII(), "tmp",
+                         base::CompareCase::SENSITIVE))
+      continue;
+    if (ContainsKey(paths_in_use, path))
+      continue;
+    LOG(INFO) << "Deleting the unused package extraction "
+              << path.AsUTF8Unsafe();
+    base::DeleteFile(path, true);
+    base::DeleteFile(path.AddExtension(kManifestCacheExtension), false);
+  }
+}
+
+const std::string& Package::hash() {
+  if (hash_.empty())
+    ReadPackage(ReadCallback());
+  return hash_;
+}
+
+bool Package::ReadPackage(const ReadCallback& callback) {
+  if (!file_ || !file_->get() || fseek(file_->get(), 0, SEEK_SET))
+    return false;
+
+  std::unique_ptr<crypto::SecureHash> hash(
+      crypto::SecureHash::Create(crypto::SecureHash::SHA256));
+  std::vector<char> buffer(kReadBufferSize);
+  int64_t offset = 0;
+  size_t len = 0;
+  while ((len = fread(&buffer.front(), 1, buffer.size(), file_->get())) > 0) {
+    hash->Update(&buffer.front(), len);
+    if (!callback.is_null())
+      callback.Run(offset, &buffer.front(), len);
+    offset += len;
+  }
+  if (ferror(file_->get()))
+    return false;
+
+  uint8_t digest[crypto::kSHA256Length];
+  hash->Finish(digest, sizeof(digest));
+  hash_ = base::ToLowerASCII(base::HexEncode(digest, sizeof(digest)));
+  return true;
+}
+
 // Create a temporary directory to decompress the zipped package file.
 // As the package information might already exists under data_path,
 // it's safer to extract the XPK/WGT file into a temporary directory first.
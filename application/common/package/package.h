@@ -6,8 +6,10 @@
 #define XWALK_APPLICATION_COMMON_PACKAGE_PACKAGE_H_
 
 #include <memory>
+#include <set>
 #include <string>
 
+#include "base/callback.h"
 #include "base/files/file_path.h"
 #include "base/files/scoped_file.h"
 #include "base/files/scoped_temp_dir.h"
@@ -35,11 +37,34 @@ class Package {
   virtual bool ExtractToTemporaryDir(base::FilePath* result_path);
   // The function will unzip the XPK/WGT file to the given folder.
   virtual bool ExtractTo(const base::FilePath& target_path);
+  // The function will unzip the XPK/WGT file to |cache_path|/id/hash and
+  // return that folder by the parameter |target_path|. Nothing is extracted
+  // if the same package was already extracted there. Older extractions are
+  // kept, see DeleteUnusedExtractions().
+  virtual bool ExtractToCache(const base::FilePath& cache_path,
+                              base::FilePath* target_path);
+  // Deletes the extractions of the application |app_id| in |cache_path| but
+  // |paths_in_use| and the ones in progress, with their manifest caches.
+  // Does file IO.
+  static void DeleteUnusedExtractions(
+      const base::FilePath& cache_path,
+      const std::string& app_id,
+      const std::set<base::FilePath>& paths_in_use);
+  // The SHA-256 of the whole package file as lowercase hex, computed on
+  // first use. Empty if the file can't be read.
+  const std::string& hash();
 
  protected:
+  // Called with each consecutive chunk of the package file and its offset.
+  typedef base::Callback<void(int64_t offset, const char* data, size_t size)>
+      ReadCallback;
+
   Package(const base::FilePath& source_path, Manifest::Type manifest_type);
   // Unzipping of the zipped file happens in a temporary directory
   bool CreateTempDirectory();
+  // Reads the package file once from the beginning, computing |hash_| and
+  // passing the data to |callback| if it's not null.
+  bool ReadPackage(const ReadCallback& callback);
   std::unique_ptr<base::ScopedFILE> file_;
 
   bool is_valid_;
@@ -50,6 +75,7 @@ class Package {
   base::ScopedTempDir temp_dir_;
   // Represent if the package has been extracted.
   bool is_extracted_;
+  std::string hash_;
   Manifest::Type manifest_type_;
 };
 
@@ -0,0 +1,312 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/package/package_archive.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "base/files/file_util.h"
+#include "base/logging.h"
+#include "third_party/zlib/zlib.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+// See the .ZIP File Format Specification, sections 4.3.7, 4.3.12 and 4.3.16.
+const uint32_t kLocalHeaderSignature = 0x04034b50;
+const uint32_t kCentralHeaderSignature = 0x02014b50;
+const uint32_t kEndOfCentralDirectorySignature = 0x06054b50;
+const size_t kLocalHeaderSize = 30;
+const size_t kCentralHeaderSize = 46;
+const size_t kEndOfCentralDirectorySize = 22;
+const size_t kMaxCommentSize = 0xffff;
+
+const uint16_t kMethodStored = 0;
+const uint16_t kMethodDeflated = 8;
+const uint16_t kFlagEncrypted = 1;
+
+const int kSkipBufferSize = 1 << 14;
+
+uint16_t ReadUInt16(const uint8_t* data) {
+  return data[0] | (data[1] << 8);
+}
+
+uint32_t ReadUInt32(const uint8_t* data) {
+  return data[0] | (data[1] << 8) | (data[2] << 16) |
+      (static_cast<uint32_t>(data[3]) << 24);
+}
+
+// Returns the path as stored in zip files, or an empty string if it is
+// absolute or goes up to a parent folder.
+std::string GetEntryName(const base::FilePath& relative_path) {
+  if (relative_path.IsAbsolute())
+    return std::string();
+
+  std::vector<base::FilePath::StringType> components;
+  relative_path.GetComponents(&components);
+  std::string name;
+  for (const base::FilePath::StringType& component : components) {
+    if (component == base::FilePath::kCurrentDirectory)
+      continue;
+    if (component == base::FilePath::kParentDirectory)
+      return std::string();
+    if (!name.empty())
+      name.push_back('/');
+    name.append(base::FilePath(component).AsUTF8Unsafe());
+  }
+  return name;
+}
+
+}  // namespace
+
+struct PackageArchive::EntryReader::InflateStream {
+  z_stream stream;
+};
+
+PackageArchive::EntryReader::EntryReader(
+    scoped_refptr<PackageArchive> archive, const Entry& entry)
+    : archive_(archive),
+      entry_(entry),
+      failed_(false),
+      position_(0),
+      skip_(0) {
+  if (!entry_.deflated)
+    return;
+
+  inflate_.reset(new InflateStream);
+  z_stream* stream = &inflate_->stream;
+  memset(stream, 0, sizeof(z_stream));
+  stream->next_in = const_cast<Bytef*>(archive_->data() + entry_.data_offset);
+  stream->avail_in = entry_.compressed_size;
+  // Zip files contain raw deflate data, without zlib header.
+  if (inflateInit2(stream, -MAX_WBITS) != Z_OK) {
+    inflate_.reset();
+    failed_ = true;
+  }
+}
+
+PackageArchive::EntryReader::~EntryReader() {
+  if (inflate_)
+    inflateEnd(&inflate_->stream);
+}
+
+void PackageArchive::EntryReader::Skip(uint32_t offset) {
+  DCHECK_EQ(0U, position_);
+  skip_ = std::min(offset, entry_.size);
+}
+
+int PackageArchive::EntryReader::Read(char* buffer, int size) {
+  if (!entry_.deflated) {
+    position_ += skip_;
+    skip_ = 0;
+  }
+
+  // Deflated data has to be inflated up to the requested offset.
+  while (skip_ > 0) {
+    char discarded[kSkipBufferSize];
+    int read = ReadData(discarded,
+                        std::min<uint32_t>(skip_, sizeof(discarded)));
+    if (read <= 0)
+      return read;
+    skip_ -= read;
+  }
+
+  return ReadData(buffer, size);
+}
+
+int PackageArchive::EntryReader::ReadData(char* buffer, int size) {
+  if (failed_)
+    return -1;
+
+  uint32_t remaining = entry_.size - position_;
+  if (!remaining || size <= 0)
+    return 0;
+  size = std::min<uint32_t>(size, remaining);
+
+  if (!entry_.deflated) {
+    memcpy(buffer, archive_->data() + entry_.data_offset + position_, size);
+    position_ += size;
+    return size;
+  }
+
+  z_stream* stream = &inflate_->stream;
+  stream->next_out = reinterpret_cast<Bytef*>(buffer);
+  stream->avail_out = size;
+  int result = inflate(stream, Z_SYNC_FLUSH);
+  int read = size - stream->avail_out;
+  if ((result != Z_OK && result != Z_STREAM_END) || !read) {
+    LOG(ERROR) << "Corrupted entry in " << archive_->path().AsUTF8Unsafe();
+    failed_ = true;
+    return -1;
+  }
+  position_ += read;
+  return read;
+}
+
+// static
+scoped_refptr<PackageArchive> PackageArchive::Open(
+    const base::FilePath& path) {
+  scoped_refptr<PackageArchive> archive(new PackageArchive(path));
+  if (!archive->Init())
+    return NULL;
+  return archive;
+}
+
+PackageArchive::PackageArchive(const base::FilePath& path)
+    : path_(path) {
+}
+
+PackageArchive::~PackageArchive() {
+}
+
+const PackageArchive::Entry* PackageArchive::FindEntry(
+    const base::FilePath& relative_path) const {
+  std::string name = GetEntryName(relative_path);
+  if (name.empty())
+    return NULL;
+  EntryMap::const_iterator it = entries_.find(name);
+  return it != entries_.end() ? &it->second : NULL;
+}
+
+std::vector<base::FilePath> PackageArchive::GetFilePaths() const {
+  std::vector<base::FilePath> paths;
+  paths.reserve(entries_.size());
+  for (const auto& entry : entries_)
+    paths.push_back(base::FilePath::FromUTF8Unsafe(entry.first));
+  return paths;
+}
+
+bool PackageArchive::ReadEntry(const base::FilePath& relative_path,
+                               std::string* output) {
+  const Entry* entry = FindEntry(relative_path);
+  if (!entry)
+    return false;
+
+  output->resize(entry->size);
+  EntryReader reader(this, *entry);
+  size_t position = 0;
+  while (position < output->size()) {
+    int read = reader.Read(&(*output)[position],
+                           output->size() - position);
+    if (read <= 0)
+      return false;
+    position += read;
+  }
+  return true;
+}
+
+bool PackageArchive::Init() {
+  if (!file_.Initialize(path_)) {
+    LOG(ERROR) << "Unable to map the package " << path_.AsUTF8Unsafe();
+    return false;
+  }
+  base::File::Info info;
+  if (base::GetFileInfo(path_, &info))
+    last_modified_ = info.last_modified;
+  if (length() < kEndOfCentralDirectorySize)
+    return false;
+
+  // The end of central directory record is followed by a comment of
+  // unknown size.
+  size_t end = length() - kEndOfCentralDirectorySize;
+  size_t min = end > kMaxCommentSize ? end - kMaxCommentSize : 0;
+  size_t position = end;
+  while (ReadUInt32(data() + position) != kEndOfCentralDirectorySignature) {
+    if (position == min) {
+      LOG(ERROR) << path_.AsUTF8Unsafe() << " is not a zip file.";
+      return false;
+    }
+    --position;
+  }
+
+  const uint8_t* record = data() + position;
+  uint16_t disk = ReadUInt16(record + 4);
+  uint16_t directory_disk = ReadUInt16(record + 6);
+  uint16_t disk_count = ReadUInt16(record + 8);
+  uint16_t count = ReadUInt16(record + 10);
+  uint32_t directory_size = ReadUInt32(record + 12);
+  uint32_t directory_offset = ReadUInt32(record + 16);
+  if (disk || directory_disk || disk_count != count ||
+      count == 0xffff || directory_offset == 0xffffffff) {
+    LOG(ERROR) << "Multi-disk and zip64 archives are not supported.";
+    return false;
+  }
+
+  // XPK packages start with their header, so offsets in the zip file are
+  // relative to where the central directory was expected to be.
+  uint64_t directory_end =
+      static_cast<uint64_t>(directory_offset) + directory_size;
+  if (directory_end > position)
+    return false;
+  size_t base = position - directory_end;
+  return ReadCentralDirectory(base + directory_offset, directory_size,
+                              count, base);
+}
+
+bool PackageArchive::ReadCentralDirectory(size_t offset, size_t size,
+                                          size_t count, size_t base) {
+  size_t end = offset + size;
+  for (size_t i = 0; i < count; ++i) {
+    if (end - offset < kCentralHeaderSize)
+      return false;
+    const uint8_t* header = data() + offset;
+    if (ReadUInt32(header) != kCentralHeaderSignature)
+      return false;
+
+    uint16_t flags = ReadUInt16(header + 8);
+    uint16_t method = ReadUInt16(header + 10);
+    uint32_t crc32 = ReadUInt32(header + 16);
+    uint32_t compressed_size = ReadUInt32(header + 20);
+    uint32_t uncompressed_size = ReadUInt32(header + 24);
+    uint16_t name_size = ReadUInt16(header + 28);
+    uint64_t local_header = static_cast<uint64_t>(base) +
+        ReadUInt32(header + 42);
+    size_t header_size = kCentralHeaderSize + name_size +
+        ReadUInt16(header + 30) + ReadUInt16(header + 32);
+    if (end - offset < header_size)
+      return false;
+    std::string name(reinterpret_cast<const char*>(header) +
+                     kCentralHeaderSize, name_size);
+    offset += header_size;
+
+    // Folders are implicit.
+    if (name.empty() || name[name.size() - 1] == '/')
+      continue;
+    if (compressed_size == 0xffffffff || uncompressed_size == 0xffffffff)
+      return false;
+    if ((flags & kFlagEncrypted) ||
+        (method != kMethodStored && method != kMethodDeflated) ||
+        (method == kMethodStored && compressed_size != uncompressed_size)) {
+      LOG(WARNING) << "Unsupported entry " << name << " is ignored.";
+      continue;
+    }
+
+    // The local header may have a different extra field.
+    if (local_header + kLocalHeaderSize > length())
+      return false;
+    const uint8_t* local = data() + local_header;
+    if (ReadUInt32(local) != kLocalHeaderSignature)
+      return false;
+    uint64_t data_offset = local_header + kLocalHeaderSize +
+        ReadUInt16(local + 26) + ReadUInt16(local + 28);
+    if (data_offset + compressed_size > length())
+      return false;
+
+    Entry& entry = entries_[name];
+    entry.data_offset = data_offset;
+    entry.compressed_size = compressed_size;
+    entry.size = uncompressed_size;
+    entry.crc32 = crc32;
+    entry.deflated = method == kMethodDeflated;
+  }
+  return true;
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -0,0 +1,117 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_APPLICATION_COMMON_PACKAGE_PACKAGE_ARCHIVE_H_
+#define XWALK_APPLICATION_COMMON_PACKAGE_PACKAGE_ARCHIVE_H_
+
+#include <stdint.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/files/memory_mapped_file.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/time/time.h"
+
+namespace xwalk {
+namespace application {
+
+// Gives access to the files of a .wgt/.xpk package without extracting it.
+// The package is memory mapped and its zip central directory is indexed when
+// opened; entries are then read straight from the mapping, stored ones are
+// copied as is and deflated ones are inflated in chunks. Zip64 archives and
+// encrypted entries are not supported.
+// Reading may cause disk access, so it must not happen on the IO thread.
+class PackageArchive : public base::RefCountedThreadSafe<PackageArchive> {
+ public:
+  struct Entry {
+    // Offset of the entry data in the mapped file.
+    size_t data_offset;
+    uint32_t compressed_size;
+    uint32_t size;
+    // CRC-32 of the uncompressed data.
+    uint32_t crc32;
+    bool deflated;
+  };
+
+  // Reads one entry sequentially.
+  class EntryReader {
+   public:
+    EntryReader(scoped_refptr<PackageArchive> archive, const Entry& entry);
+    ~EntryReader();
+
+    // Makes the next Read() start at |offset| in the uncompressed data.
+    // Must be called before reading.
+    void Skip(uint32_t offset);
+
+    // Reads up to |size| bytes into |buffer|. Returns the number of bytes
+    // read, 0 at the end of the entry or -1 if the data is corrupted.
+    int Read(char* buffer, int size);
+
+   private:
+    struct InflateStream;
+
+    int ReadData(char* buffer, int size);
+
+    scoped_refptr<PackageArchive> archive_;
+    Entry entry_;
+    bool failed_;
+    uint32_t position_;
+    uint32_t skip_;
+    std::unique_ptr<InflateStream> inflate_;
+
+    DISALLOW_COPY_AND_ASSIGN(EntryReader);
+  };
+
+  // Returns NULL if |path| is not a zip file this class supports. For XPK
+  // packages the data in front of the zip file is skipped.
+  static scoped_refptr<PackageArchive> Open(const base::FilePath& path);
+
+  const base::FilePath& path() const { return path_; }
+  // When the package file was last modified, as of Open().
+  base::Time last_modified() const { return last_modified_; }
+
+  // Returns the file at |relative_path|, or NULL if there is none. Paths
+  // going outside of the package are never found.
+  const Entry* FindEntry(const base::FilePath& relative_path) const;
+
+  // Returns the relative paths of all the files of the package.
+  std::vector<base::FilePath> GetFilePaths() const;
+
+  // Reads a whole entry into |output|. Meant for small files, like the
+  // manifest.
+  bool ReadEntry(const base::FilePath& relative_path, std::string* output);
+
+ private:
+  friend class base::RefCountedThreadSafe<PackageArchive>;
+
+  typedef std::map<std::string, Entry> EntryMap;
+
+  explicit PackageArchive(const base::FilePath& path);
+  ~PackageArchive();
+
+  bool Init();
+  bool ReadCentralDirectory(size_t offset, size_t size, size_t count,
+                            size_t base);
+
+  const uint8_t* data() const { return file_.data(); }
+  size_t length() const { return file_.length(); }
+
+  base::FilePath path_;
+  base::MemoryMappedFile file_;
+  base::Time last_modified_;
+  // Keyed by the path in the zip file, with '/' separators.
+  EntryMap entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(PackageArchive);
+};
+
+}  // namespace application
+}  // namespace xwalk
+
+#endif  // XWALK_APPLICATION_COMMON_PACKAGE_PACKAGE_ARCHIVE_H_
@@ -0,0 +1,172 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/package/package_archive.h"
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/files/file_enumerator.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/path_service.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/zlib/google/zip.h"
+#include "xwalk/application/common/application_resource.h"
+#include "xwalk/application/common/package/package.h"
+
+namespace xwalk {
+namespace application {
+
+class PackageArchiveTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+  }
+
+  // Zips the given files, keyed by relative path, into a .wgt file.
+  scoped_refptr<PackageArchive> CreateArchive(
+      const std::map<std::string, std::string>& files) {
+    base::FilePath source = temp_dir_.path().AppendASCII("source");
+    for (const auto& file : files) {
+      base::FilePath path = source.AppendASCII(file.first);
+      EXPECT_TRUE(base::CreateDirectory(path.DirName()));
+      EXPECT_EQ(static_cast<int>(file.second.size()),
+                base::WriteFile(path, file.second.data(), file.second.size()));
+    }
+    base::FilePath zip_path = temp_dir_.path().AppendASCII("test.wgt");
+    EXPECT_TRUE(zip::Zip(source, zip_path, false));
+    return PackageArchive::Open(zip_path);
+  }
+
+  std::string ReadAll(PackageArchive* archive, const std::string& path,
+                      uint32_t offset, int chunk_size) {
+    const PackageArchive::Entry* entry =
+        archive->FindEntry(base::FilePath::FromUTF8Unsafe(path));
+    EXPECT_TRUE(entry);
+    if (!entry)
+      return std::string();
+
+    PackageArchive::EntryReader reader(archive, *entry);
+    reader.Skip(offset);
+    std::string output;
+    std::vector<char> buffer(chunk_size);
+    int read;
+    while ((read = reader.Read(&buffer.front(), chunk_size)) > 0)
+      output.append(&buffer.front(), read);
+    EXPECT_EQ(0, read);
+    return output;
+  }
+
+  base::ScopedTempDir temp_dir_;
+};
+
+TEST_F(PackageArchiveTest, ReadEntries) {
+  std::string big(100000, 'x');
+  for (size_t i = 0; i < big.size(); i += 7)
+    big[i] = 'a' + i % 26;
+  std::map<std::string, std::string> files;
+  files["index.html"] = "<html></html>";
+  files["js/big.js"] = big;
+  files["empty.txt"] = "";
+  scoped_refptr<PackageArchive> archive = CreateArchive(files);
+  ASSERT_TRUE(archive.get());
+
+  EXPECT_EQ(3U, archive->GetFilePaths().size());
+  EXPECT_EQ("<html></html>", ReadAll(archive.get(), "index.html", 0, 4));
+  EXPECT_EQ(big, ReadAll(archive.get(), "js/big.js", 0, 4096));
+  EXPECT_EQ(big.substr(54321), ReadAll(archive.get(), "js/big.js", 54321, 100));
+  EXPECT_EQ("", ReadAll(archive.get(), "empty.txt", 0, 16));
+
+  std::string content;
+  EXPECT_TRUE(archive->ReadEntry(base::FilePath::FromUTF8Unsafe("./js/big.js"),
+                                 &content));
+  EXPECT_EQ(big, content);
+}
+
+TEST_F(PackageArchiveTest, FindEntry) {
+  std::map<std::string, std::string> files;
+  files["index.html"] = "index";
+  files["js/app.js"] = "app";
+  scoped_refptr<PackageArchive> archive = CreateArchive(files);
+  ASSERT_TRUE(archive.get());
+
+  EXPECT_TRUE(archive->FindEntry(base::FilePath::FromUTF8Unsafe("js/app.js")));
+  EXPECT_FALSE(archive->FindEntry(base::FilePath::FromUTF8Unsafe("js")));
+  EXPECT_FALSE(archive->FindEntry(base::FilePath::FromUTF8Unsafe("app.js")));
+  EXPECT_FALSE(archive->FindEntry(
+      base::FilePath::FromUTF8Unsafe("js/../index.html")));
+  EXPECT_FALSE(archive->FindEntry(
+      base::FilePath::FromUTF8Unsafe("../test.wgt")));
+}
+
+TEST_F(PackageArchiveTest, LocalizedResource) {
+  std::map<std::string, std::string> files;
+  files["index.html"] = "default";
+  files["locales/en/index.html"] = "en";
+  files["locales/en-us/style.css"] = "en-us";
+  scoped_refptr<PackageArchive> archive = CreateArchive(files);
+  ASSERT_TRUE(archive.get());
+
+  std::list<std::string> locales;
+  locales.push_back("en-us");
+  locales.push_back("en");
+
+  ApplicationResource index("id", archive->path(),
+                            base::FilePath::FromUTF8Unsafe("index.html"));
+  index.SetLocales(locales);
+  EXPECT_EQ(base::FilePath::FromUTF8Unsafe("locales/en/index.html").value(),
+            index.GetArchivePath(archive.get()).value());
+
+  ApplicationResource style("id", archive->path(),
+                            base::FilePath::FromUTF8Unsafe("style.css"));
+  style.SetLocales(locales);
+  EXPECT_EQ(base::FilePath::FromUTF8Unsafe("locales/en-us/style.css").value(),
+            style.GetArchivePath(archive.get()).value());
+
+  ApplicationResource missing("id", archive->path(),
+                              base::FilePath::FromUTF8Unsafe("missing.js"));
+  missing.SetLocales(locales);
+  EXPECT_TRUE(missing.GetArchivePath(archive.get()).empty());
+}
+
+TEST_F(PackageArchiveTest, XPKPackage) {
+  base::FilePath xpk_path;
+  ASSERT_TRUE(PathService::Get(base::DIR_SOURCE_ROOT, &xpk_path));
+  xpk_path = xpk_path.AppendASCII("xwalk").AppendASCII("application")
+      .AppendASCII("test").AppendASCII("unpacker").AppendASCII("good.xpk");
+
+  // The header in front of the zip file is skipped.
+  scoped_refptr<PackageArchive> archive = PackageArchive::Open(xpk_path);
+  ASSERT_TRUE(archive.get());
+  std::unique_ptr<Package> package = Package::Create(xpk_path);
+  base::FilePath extracted_path;
+  ASSERT_TRUE(package->ExtractToTemporaryDir(&extracted_path));
+
+  base::FileEnumerator files(extracted_path, true,
+                             base::FileEnumerator::FILES);
+  size_t count = 0;
+  for (base::FilePath path = files.Next(); !path.empty();
+       path = files.Next(), ++count) {
+    base::FilePath relative_path;
+    ASSERT_TRUE(extracted_path.AppendRelativePath(path, &relative_path));
+    std::string expected, content;
+    ASSERT_TRUE(base::ReadFileToString(path, &expected));
+    ASSERT_TRUE(archive->ReadEntry(relative_path, &content))
+        << relative_path.value();
+    EXPECT_EQ(expected, content);
+  }
+  EXPECT_EQ(count, archive->GetFilePaths().size());
+}
+
+TEST_F(PackageArchiveTest, NotAZipFile) {
+  base::FilePath path = temp_dir_.path().AppendASCII("garbage.wgt");
+  ASSERT_EQ(7, base::WriteFile(path, "garbage", 7));
+  EXPECT_FALSE(PackageArchive::Open(path).get());
+}
+
+}  // namespace application
+}  // namespace xwalk
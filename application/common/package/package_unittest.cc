@@ -4,10 +4,13 @@
 
 #include "xwalk/application/common/package/package.h"
 
+#include <set>
+
 #include "base/files/file_util.h"
 #include "base/files/scoped_temp_dir.h"
 #include "base/path_service.h"
 #include "testing/gtest/include/gtest/gtest.h"
+#include "xwalk/application/common/constants.h"
 
 namespace xwalk {
 namespace application {
@@ -42,6 +45,68 @@ TEST_F(PackageTest, Good) {
   EXPECT_TRUE(temp_dir_.Set(path));
 }
 
+TEST_F(PackageTest, ExtractToCache) {
+  SetupPackage("good.xpk");
+  ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+  EXPECT_FALSE(package_->hash().empty());
+
+  base::FilePath path;
+  ASSERT_TRUE(package_->ExtractToCache(temp_dir_.path(), &path));
+  EXPECT_EQ(temp_dir_.path().AppendASCII(package_->Id()), path.DirName());
+  EXPECT_EQ(package_->hash(), path.BaseName().MaybeAsASCII());
+  EXPECT_FALSE(base::IsDirectoryEmpty(path));
+
+  // An unchanged package is not extracted again.
+  base::FilePath marker = path.AppendASCII("marker");
+  ASSERT_EQ(0, base::WriteFile(marker, "", 0));
+  std::string hash = package_->hash();
+  SetupPackage("good.xpk");
+  EXPECT_EQ(hash, package_->hash());
+  base::FilePath cached_path;
+  ASSERT_TRUE(package_->ExtractToCache(temp_dir_.path(), &cached_path));
+  EXPECT_EQ(path, cached_path);
+  EXPECT_TRUE(base::PathExists(marker));
+}
+
+TEST_F(PackageTest, DeleteUnusedExtractions) {
+  ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+  base::FilePath app_path = temp_dir_.path().AppendASCII("app");
+  base::FilePath old_path = app_path.AppendASCII("old");
+  base::FilePath used_path = app_path.AppendASCII("used");
+  base::FilePath extracting_path = app_path.AppendASCII("tmp123");
+  base::FilePath other_path =
+      temp_dir_.path().AppendASCII("other").AppendASCII("old");
+  ASSERT_TRUE(base::CreateDirectory(old_path));
+  ASSERT_TRUE(base::CreateDirectory(used_path));
+  ASSERT_TRUE(base::CreateDirectory(extracting_path));
+  ASSERT_TRUE(base::CreateDirectory(other_path));
+  base::FilePath old_cache_path =
+      old_path.AddExtension(kManifestCacheExtension);
+  base::FilePath used_cache_path =
+      used_path.AddExtension(kManifestCacheExtension);
+  ASSERT_EQ(0, base::WriteFile(old_cache_path, "", 0));
+  ASSERT_EQ(0, base::WriteFile(used_cache_path, "", 0));
+
+  std::set<base::FilePath> paths_in_use;
+  paths_in_use.insert(used_path);
+  Package::DeleteUnusedExtractions(temp_dir_.path(), "app", paths_in_use);
+  EXPECT_FALSE(base::PathExists(old_path));
+  EXPECT_FALSE(base::PathExists(old_cache_path));
+  EXPECT_TRUE(base::DirectoryExists(used_path));
+  EXPECT_TRUE(base::PathExists(used_cache_path));
+  EXPECT_TRUE(base::DirectoryExists(extracting_path));
+  // Other applications are left alone.
+  EXPECT_TRUE(base::DirectoryExists(other_path));
+}
+
+TEST_F(PackageTest, BadSignatureIsNotCached) {
+  SetupPackage("bad_signature.xpk");
+  ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+  base::FilePath path;
+  EXPECT_FALSE(package_->ExtractToCache(temp_dir_.path(), &path));
+  EXPECT_TRUE(base::IsDirectoryEmpty(temp_dir_.path()));
+}
+
 TEST_F(PackageTest, BadMagicString) {
   SetupPackage("bad_magic.xpk");
   base::FilePath path;
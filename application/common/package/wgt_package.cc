@@ -8,6 +8,7 @@
 #include "base/files/file_util.h"
 #include "base/files/scoped_file.h"
 #include "third_party/libxml/chromium/libxml_utils.h"
+#include "third_party/zlib/google/zip_reader.h"
 #include "xwalk/application/common/id_util.h"
 
 namespace xwalk {
@@ -16,6 +17,9 @@ namespace application {
 namespace {
 
 const char kIdNodeName[] = "widget";
+const char kConfigFileName[] = "config.xml";
+// config.xml is read into memory, bigger ones are not valid.
+const size_t kMaxConfigFileSize = 1 << 20;
 
 }  // namespace
 
@@ -26,14 +30,19 @@ WGTPackage::WGTPackage(const base::FilePath& path)
     : Package(path, Manifest::TYPE_WIDGET) {
   if (!base::PathExists(path))
     return;
-  base::FilePath extracted_path;
-  // FIXME : we should not call 'extract' here!
-  if (!ExtractToTemporaryDir(&extracted_path))
+  // Only config.xml is needed here, the package is extracted later.
+  std::string config;
+  zip::ZipReader reader;
+  if (!reader.Open(path) ||
+      !reader.LocateAndOpenEntry(base::FilePath::FromUTF8Unsafe(
+          kConfigFileName)) ||
+      !reader.ExtractCurrentEntryToString(kMaxConfigFileSize, &config)) {
+    LOG(ERROR) << "Unable to read WGT package config.xml file.";
     return;
+  }
 
   XmlReader xml;
-  if (!xml.LoadFile(extracted_path.Append(FILE_PATH_LITERAL("config.xml"))
-                    .MaybeAsASCII())) {
+  if (!xml.Load(config)) {
     LOG(ERROR) << "Unable to load WGT package config.xml file.";
     return;
   }
@@ -4,8 +4,10 @@
 
 #include "xwalk/application/common/package/xpk_package.h"
 
+#include <algorithm>
 #include <string>
 
+#include "base/bind.h"
 #include "base/files/file_util.h"
 #include "base/files/scoped_file.h"
 #include "base/numerics/safe_conversions.h"
@@ -15,6 +17,24 @@
 namespace xwalk {
 namespace application {
 
+namespace {
+
+// Only the zip file behind the header, public key and signature is signed.
+void UpdateVerifier(crypto::SignatureVerifier* verifier,
+                    int64_t zip_addr,
+                    int64_t offset,
+                    const char* data,
+                    size_t size) {
+  int64_t end = offset + static_cast<int64_t>(size);
+  if (end <= zip_addr)
+    return;
+  int64_t skip = std::max<int64_t>(zip_addr - offset, 0);
+  verifier->VerifyUpdate(reinterpret_cast<const uint8_t*>(data) + skip,
+                         base::checked_cast<int>(size - skip));
+}
+
+}  // namespace
+
 const char XPKPackage::kXPKPackageHeaderMagic[] = "CrWk";
 
 XPKPackage::~XPKPackage() {
@@ -67,10 +87,6 @@ XPKPackage::XPKPackage(const base::FilePath& path)
 }
 
 bool XPKPackage::VerifySignature() {
-// Set the file read position to the beginning of compressed resource file,
-// which is behind the magic header, public key and signature key.
-  if (fseek(file_->get(), zip_addr_, SEEK_SET))
-    return false;
   crypto::SignatureVerifier verifier;
   if (!verifier.VerifyInit(crypto::SignatureVerifier::RSA_PKCS1_SHA1,
                            &signature_.front(),
@@ -78,10 +94,10 @@ bool XPKPackage::VerifySignature() {
                            &key_.front(),
                            base::checked_cast<int>(key_.size())))
     return false;
-  unsigned char buf[1 << 12];
-  size_t len = 0;
-  while ((len = fread(buf, 1, sizeof(buf), file_->get())) > 0)
-    verifier.VerifyUpdate(buf, base::checked_cast<int>(len));
+  // The package hash is computed in the same pass, so that extracting to
+  // the cache doesn't read the file again.
+  if (!ReadPackage(base::Bind(&UpdateVerifier, &verifier, zip_addr_)))
+    return false;
   if (!verifier.VerifyFinal())
     return false;
 
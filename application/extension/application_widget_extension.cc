@@ -95,27 +95,38 @@ ApplicationWidgetExtension::ApplicationWidgetExtension(
       IDR_XWALK_APPLICATION_WIDGET_API).as_string());
 }
 
+ApplicationWidgetExtension::~ApplicationWidgetExtension() {
+  // The extension goes away with the application, write back what is left.
+  if (widget_storage_)
+    widget_storage_->Flush();
+}
+
 XWalkExtensionInstance* ApplicationWidgetExtension::CreateInstance() {
-  return new AppWidgetExtensionInstance(application_);
+  if (!widget_storage_) {
+    content::RenderProcessHost* rph = content::RenderProcessHost::FromID(
+        application_->GetRenderProcessHostID());
+    CHECK(rph);
+    content::StoragePartition* partition = rph->GetStoragePartition();
+    CHECK(partition);
+    base::FilePath path = partition->GetPath().Append(
+        FILE_PATH_LITERAL("WidgetStorage"));
+    widget_storage_ = AppWidgetStorage::Create(application_, path);
+  }
+  return new AppWidgetExtensionInstance(application_, widget_storage_);
 }
 
 AppWidgetExtensionInstance::AppWidgetExtensionInstance(
-    Application* application)
-  : application_(application) {
+    Application* application,
+    scoped_refptr<AppWidgetStorage> widget_storage)
+  : application_(application),
+    widget_storage_(widget_storage) {
   DCHECK(application_);
-  base::ThreadRestrictions::SetIOAllowed(true);
-
-  content::RenderProcessHost* rph =
-      content::RenderProcessHost::FromID(application->GetRenderProcessHostID());
-  CHECK(rph);
-  content::StoragePartition* partition = rph->GetStoragePartition();
-  CHECK(partition);
-  base::FilePath path = partition->GetPath().Append(
-      FILE_PATH_LITERAL("WidgetStorage"));
-  widget_storage_.reset(new AppWidgetStorage(application_, path));
+  DCHECK(widget_storage_);
 }
 
-AppWidgetExtensionInstance::~AppWidgetExtensionInstance() {}
+AppWidgetExtensionInstance::~AppWidgetExtensionInstance() {
+  widget_storage_->Flush();
+}
 
 void AppWidgetExtensionInstance::HandleMessage(std::unique_ptr<base::Value> msg) {
 }
@@ -7,11 +7,13 @@
 
 #include <string>
 
+#include "base/memory/ref_counted.h"
 #include "xwalk/extensions/common/xwalk_extension.h"
 
 namespace xwalk {
 namespace application {
 class Application;
+class AppWidgetStorage;
 
 using extensions::XWalkExtension;
 using extensions::XWalkExtensionInstance;
@@ -19,17 +21,22 @@ using extensions::XWalkExtensionInstance;
 class ApplicationWidgetExtension : public XWalkExtension {
  public:
   explicit ApplicationWidgetExtension(Application* application);
+  ~ApplicationWidgetExtension() override;
 
   // XWalkExtension implementation.
   XWalkExtensionInstance* CreateInstance() override;
 
  private:
   Application* application_;
+  // Shared by all the instances, so that every frame sees the same
+  // preferences. Created with the first instance.
+  scoped_refptr<AppWidgetStorage> widget_storage_;
 };
 
 class AppWidgetExtensionInstance : public XWalkExtensionInstance {
  public:
-  explicit AppWidgetExtensionInstance(Application* application);
+  AppWidgetExtensionInstance(Application* application,
+                             scoped_refptr<AppWidgetStorage> widget_storage);
   ~AppWidgetExtensionInstance() override;
 
   void HandleMessage(std::unique_ptr<base::Value> msg) override;
@@ -49,7 +56,7 @@ class AppWidgetExtensionInstance : public XWalkExtensionInstance {
   void PostMessageToOtherFrames(std::unique_ptr<base::DictionaryValue> msg);
 
   Application* application_;
-  std::unique_ptr<class AppWidgetStorage> widget_storage_;
+  scoped_refptr<AppWidgetStorage> widget_storage_;
 };
 
 }  // namespace application
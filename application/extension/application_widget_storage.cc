@@ -6,8 +6,11 @@
 
 #include <string>
 
+#include "base/bind.h"
 #include "base/files/file_util.h"
 #include "base/strings/utf_string_conversions.h"
+#include "base/threading/sequenced_worker_pool.h"
+#include "content/public/browser/browser_thread.h"
 #include "sql/statement.h"
 #include "sql/transaction.h"
 #include "xwalk/application/common/application_manifest_constants.h"
@@ -33,67 +36,132 @@ const char kCreateStorageTableOp[] =
 const char kClearStorageTableWithBindOp[] =
     "DELETE FROM widget_storage WHERE read_only = ? ";
 
-const char kInsertItemWithBindOp[] =
-    "INSERT INTO widget_storage (value, read_only, key) "
+const char kInsertOrReplaceItemWithBindOp[] =
+    "INSERT OR REPLACE INTO widget_storage (value, read_only, key) "
     "VALUES(?,?,?)";
 
-const char kUpdateItemWithBindOp[] =
-    "UPDATE widget_storage SET value = ? , read_only = ? "
-    "WHERE key = ?";
-
 const char kRemoveItemWithBindOp[] =
     "DELETE FROM widget_storage WHERE key = ?";
 
-const char kSelectCountWithBindOp[] =
-    "SELECT count(*) FROM widget_storage "
-    "WHERE key = ?";
-
 const char kSelectAllItem[] =
-    "SELECT key, value FROM widget_storage ";
+    "SELECT key, value, read_only FROM widget_storage ";
+
+// Changes made within this delay are written in the same transaction.
+const int kCommitDelayMs = 500;
 
-const char kSelectValueWithBindOp[] =
-    "SELECT value FROM widget_storage "
-    "WHERE key = ?";
+// Writes failing this many times in a row, e.g. on a full disk, are only
+// retried by the next Flush().
+const int kMaxFailedCommits = 5;
+
+const base::Value* GetPreferences(xwalk::application::Application* app) {
+  xwalk::application::WidgetInfo* info =
+      static_cast<xwalk::application::WidgetInfo*>(
+      app->data()->GetManifestData(widget_keys::kWidgetKey));
+  base::DictionaryValue* widget_info = info->GetWidgetInfo();
+  if (!widget_info) {
+    LOG(ERROR) << "Fail to get parsed widget information.";
+    return NULL;
+  }
+
+  base::Value* pref_value = NULL;
+  widget_info->Get(kPreferences, &pref_value);
+  return pref_value;
+}
 
-const char kSelectReadOnlyWithBindOp[] =
-    "SELECT read_only FROM widget_storage "
-    "WHERE key = ?";
 }  // namespace
 
 namespace xwalk {
 namespace application {
 
-AppWidgetStorage::AppWidgetStorage(Application* application,
-                                   const base::FilePath& data_dir)
-    : application_(application),
-      data_path_(data_dir) ,
-      db_initialized_(false) {
-  sqlite_db_.reset(new sql::Connection);
+// static
+void AppWidgetStorageTraits::Destruct(const AppWidgetStorage* storage) {
+  if (storage->db_task_runner_->RunsTasksOnCurrentThread())
+    delete storage;
+  else
+    storage->db_task_runner_->DeleteSoon(FROM_HERE, storage);
+}
 
-  if (!Init()) {
-    LOG(ERROR) << "Initialize widget storage failed.";
-    return;
-  }
+// static
+scoped_refptr<AppWidgetStorage> AppWidgetStorage::Create(
+    Application* application, const base::FilePath& data_dir) {
+  base::SequencedWorkerPool* pool = content::BrowserThread::GetBlockingPool();
+  return Create(
+      data_dir, GetPreferences(application),
+      pool->GetSequencedTaskRunnerWithShutdownBehavior(
+          pool->GetSequenceToken(), base::SequencedWorkerPool::BLOCK_SHUTDOWN),
+      base::TimeDelta::FromMilliseconds(kCommitDelayMs));
+}
+
+// static
+scoped_refptr<AppWidgetStorage> AppWidgetStorage::Create(
+    const base::FilePath& data_path,
+    const base::Value* preferences,
+    scoped_refptr<base::SequencedTaskRunner> db_task_runner,
+    base::TimeDelta commit_delay) {
+  scoped_refptr<AppWidgetStorage> storage(new AppWidgetStorage(
+      data_path, preferences, db_task_runner, commit_delay));
+  // Not done by the constructor, the task takes a reference.
+  db_task_runner->PostTask(FROM_HERE,
+                           base::Bind(&AppWidgetStorage::Init, storage));
+  return storage;
+}
+
+AppWidgetStorage::AppWidgetStorage(
+    const base::FilePath& data_path,
+    const base::Value* preferences,
+    scoped_refptr<base::SequencedTaskRunner> db_task_runner,
+    base::TimeDelta commit_delay)
+    : data_path_(data_path),
+      preferences_(preferences ? preferences->DeepCopy() : NULL),
+      db_task_runner_(db_task_runner),
+      commit_delay_(commit_delay),
+      loaded_(base::WaitableEvent::ResetPolicy::MANUAL,
+              base::WaitableEvent::InitialState::NOT_SIGNALED),
+      db_initialized_(false),
+      clear_pending_(false),
+      commit_scheduled_(false),
+      failed_commits_(0) {
 }
 
 AppWidgetStorage::~AppWidgetStorage() {
+  DCHECK(db_task_runner_->RunsTasksOnCurrentThread());
+  WritePendingChanges();
 }
 
-bool AppWidgetStorage::Init() {
+void AppWidgetStorage::Init() {
+  DCHECK(db_task_runner_->RunsTasksOnCurrentThread());
+  sqlite_db_.reset(new sql::Connection);
   if (!sqlite_db_->Open(data_path_)) {
     LOG(ERROR) << "Unable to open widget storage DB.";
-    return false;
+  } else {
+    sqlite_db_->Preload();
+    if (!InitStorageTable())
+      LOG(ERROR) << "Unable to init widget storage table.";
   }
-  sqlite_db_->Preload();
+  preferences_.reset();
+  loaded_.Signal();
+}
 
-  if (!InitStorageTable()) {
-     LOG(ERROR) << "Unable to init widget storage table.";
-     return false;
-  }
+bool AppWidgetStorage::WaitForInit() const {
+  // Only blocks the first call, the entries are needed to answer it, which
+  // used to load them right there.
+  loaded_.Wait();
   return db_initialized_;
 }
 
-bool AppWidgetStorage::SaveConfigInfoItem(base::DictionaryValue* dict) {
+bool AppWidgetStorage::LoadEntries() {
+  sql::Statement stmt(sqlite_db_->GetUniqueStatement(kSelectAllItem));
+  base::AutoLock lock(lock_);
+  while (stmt.Step()) {
+    Entry& entry = entries_[stmt.ColumnString(0)];
+    entry.value = stmt.ColumnString(1);
+    // read_only column can be NULL.
+    entry.read_only = stmt.ColumnBool(2);
+  }
+  return stmt.Succeeded();
+}
+
+bool AppWidgetStorage::SaveConfigInfoItem(const base::DictionaryValue* dict) {
   DCHECK(dict);
   std::string key;
   std::string value;
@@ -102,48 +170,41 @@ bool AppWidgetStorage::SaveConfigInfoItem(base::DictionaryValue* dict) {
     bool read_only = false;
     // read_only column can be NULL.
     dict->GetBoolean(kPreferencesReadonly, &read_only);
-    return AddEntry(key, value, read_only);
+    base::AutoLock lock(lock_);
+    Entry& entry = entries_[key];
+    entry.value = value;
+    entry.read_only = read_only;
+    dirty_keys_.insert(key);
+    return true;
   }
   return false;
 }
 
-bool AppWidgetStorage::SaveConfigInfoInDB() {
-  WidgetInfo* info =
-      static_cast<WidgetInfo*>(
-      application_->data()->GetManifestData(widget_keys::kWidgetKey));
-  base::DictionaryValue* widget_info = info->GetWidgetInfo();
-  if (!widget_info) {
-    LOG(ERROR) << "Fail to get parsed widget information.";
-    return false;
-  }
-
-  base::Value* pref_value = NULL;
-  widget_info->Get(kPreferences, &pref_value);
-
-  if (pref_value && pref_value->IsType(base::Value::TYPE_DICTIONARY)) {
-    base::DictionaryValue* dict;
-    pref_value->GetAsDictionary(&dict);
-    return SaveConfigInfoItem(dict);
-  } else if (pref_value && pref_value->IsType(base::Value::TYPE_LIST)) {
-    base::ListValue* list;
-    pref_value->GetAsList(&list);
-
-    for (base::ListValue::iterator it = list->begin();
+bool AppWidgetStorage::SaveConfigInfo(const base::Value* preferences) {
+  const base::DictionaryValue* dict;
+  const base::ListValue* list;
+  if (preferences && preferences->GetAsDictionary(&dict)) {
+    if (!SaveConfigInfoItem(dict))
+      return false;
+  } else if (preferences && preferences->GetAsList(&list)) {
+    for (base::ListValue::const_iterator it = list->begin();
          it != list->end(); ++it) {
-      base::DictionaryValue* dict;
-      (*it)->GetAsDictionary(&dict);
-      if (!SaveConfigInfoItem(dict))
+      if (!(*it)->GetAsDictionary(&dict) || !SaveConfigInfoItem(dict))
         return false;
     }
   } else {
     LOG(INFO) << "No widget preferences or preference type is not supported.";
   }
 
+  // Written right away, the storage may not be used before the next launch.
+  Commit();
   return true;
 }
 
 bool AppWidgetStorage::InitStorageTable() {
   if (sqlite_db_->DoesTableExist(kStorageTableName)) {
+    if (!LoadEntries())
+      return false;
     db_initialized_ = (sqlite_db_ && sqlite_db_->is_open());
     return true;
   }
@@ -157,167 +218,229 @@ bool AppWidgetStorage::InitStorageTable() {
     return false;
 
   db_initialized_ = (sqlite_db_ && sqlite_db_->is_open());
-  SaveConfigInfoInDB();
+  SaveConfigInfo(preferences_.get());
 
   return true;
 }
 
 bool AppWidgetStorage::EntryExists(const std::string& key) const {
-  sql::Transaction transaction(sqlite_db_.get());
-  if (!transaction.Begin())
-    return false;
-
-  sql::Statement stmt(sqlite_db_->GetUniqueStatement(
-      kSelectCountWithBindOp));
-  stmt.BindString(0, key);
-  if (!stmt.Step()) {
-    LOG(ERROR) << "There is no item in current DB.";
-    return false;
-  }
-
-  if (!transaction.Commit())
+  if (!WaitForInit())
     return false;
 
-  int exist = stmt.ColumnInt(0);
-  return exist > 0;
+  base::AutoLock lock(lock_);
+  return entries_.find(key) != entries_.end();
 }
 
 bool AppWidgetStorage::IsReadOnly(const std::string& key) {
-  sql::Transaction transaction(sqlite_db_.get());
-  if (!transaction.Begin())
-    return false;
-
-  sql::Statement stmt(sqlite_db_->GetUniqueStatement(
-      kSelectReadOnlyWithBindOp));
-  stmt.BindString(0, key);
-  if (!stmt.Step()) {
-    LOG(WARNING) << "The key doesn't exist or there is an error in current DB.";
-    return false;
-  }
-
-  if (!transaction.Commit())
-    return false;
-
-  return stmt.ColumnBool(0);
+  base::AutoLock lock(lock_);
+  EntryMap::const_iterator it = entries_.find(key);
+  return it != entries_.end() && it->second.read_only;
 }
 
 bool AppWidgetStorage::AddEntry(const std::string& key,
                                const std::string& value,
                                bool read_only) {
-  if (!db_initialized_ && !Init())
+  if (!WaitForInit())
     return false;
 
-  std::string operation;
-  if (!EntryExists(key)) {
-    operation = kInsertItemWithBindOp;
-  } else if (!IsReadOnly(key)) {
-    operation = kUpdateItemWithBindOp;
-  } else {
+  base::AutoLock lock(lock_);
+  EntryMap::iterator it = entries_.find(key);
+  if (it != entries_.end() && it->second.read_only) {
     LOG(ERROR) << "Could not set read only item " << key;
     return false;
   }
 
-  sql::Transaction transaction(sqlite_db_.get());
-  if (!transaction.Begin())
-    return false;
-
-  sql::Statement stmt(sqlite_db_->GetUniqueStatement(
-    operation.c_str()));
-  stmt.BindString(0, value);
-  stmt.BindBool(1, read_only);
-  stmt.BindString(2, key);
-  if (!stmt.Run()) {
-    LOG(ERROR) << "An error occured when set item into DB.";
-    return false;
-  }
-
-  return transaction.Commit();
+  Entry& entry = entries_[key];
+  entry.value = value;
+  entry.read_only = read_only;
+  ScheduleCommit(key);
+  return true;
 }
 
 bool AppWidgetStorage::GetValueByKey(const std::string& key,
                                      std::string* value) {
-  if (!db_initialized_ && !Init())
+  if (!WaitForInit())
     return false;
 
-  sql::Transaction transaction(sqlite_db_.get());
-  if (!transaction.Begin())
+  base::AutoLock lock(lock_);
+  EntryMap::const_iterator it = entries_.find(key);
+  if (it == entries_.end())
     return false;
 
-  sql::Statement stmt(sqlite_db_->GetUniqueStatement(
-      kSelectValueWithBindOp));
-  stmt.BindString(0, key);
-  if (!stmt.Step()) {
-    LOG(WARNING) << "The key doesn't exit or there is an error in current DB.";
-    return false;
-  }
-
-  if (!transaction.Commit())
-    return false;
-
-  *value = stmt.ColumnString(0);
+  *value = it->second.value;
   return true;
 }
 
 bool AppWidgetStorage::RemoveEntry(const std::string& key) {
-  if (!db_initialized_ && !Init())
+  if (!WaitForInit())
     return false;
 
-  if (IsReadOnly(key)) {
+  base::AutoLock lock(lock_);
+  EntryMap::iterator it = entries_.find(key);
+  if (it == entries_.end() || it->second.read_only) {
     LOG(ERROR) << "The key is readonly or it doesn't exist." << key;
     return false;
   }
 
-  sql::Transaction transaction(sqlite_db_.get());
-  if (!transaction.Begin())
-    return false;
-
-  sql::Statement stmt(sqlite_db_->GetUniqueStatement(
-      kRemoveItemWithBindOp));
-  stmt.BindString(0, key);
+  entries_.erase(it);
+  ScheduleCommit(key);
+  return true;
+}
 
-  if (!stmt.Run()) {
-    LOG(ERROR) << "An error occured when removing item into DB.";
+bool AppWidgetStorage::Clear() {
+  if (!WaitForInit())
     return false;
+
+  base::AutoLock lock(lock_);
+  for (EntryMap::iterator it = entries_.begin(); it != entries_.end();) {
+    if (it->second.read_only)
+      ++it;
+    else
+      entries_.erase(it++);
   }
 
-  return transaction.Commit();
+  // The whole table is cleared first, the keys marked dirty are
+  // written or removed after that.
+  clear_pending_ = true;
+  ScheduleCommit(std::string());
+  return true;
 }
 
-bool AppWidgetStorage::Clear() {
-  if (!db_initialized_ && !Init())
-    return false;
+bool AppWidgetStorage::GetAllEntries(base::DictionaryValue* result) {
+  DCHECK(result);
 
-  sql::Transaction transaction(sqlite_db_.get());
-  if (!transaction.Begin())
+  if (!WaitForInit())
     return false;
 
-  sql::Statement stmt(sqlite_db_->GetUniqueStatement(
-      kClearStorageTableWithBindOp));
-  stmt.BindBool(0, false);
+  base::AutoLock lock(lock_);
+  for (EntryMap::const_iterator it = entries_.begin(); it != entries_.end();
+       ++it)
+    result->SetString(it->first, it->second.value);
 
-  if (!stmt.Run()) {
-    LOG(ERROR) << "An error occured when removing item into DB.";
-    return false;
+  return true;
+}
+
+void AppWidgetStorage::Flush() {
+  {
+    base::AutoLock lock(lock_);
+    failed_commits_ = 0;
   }
+  db_task_runner_->PostTask(FROM_HERE,
+                            base::Bind(&AppWidgetStorage::Commit, this));
+}
+
+void AppWidgetStorage::ScheduleCommit(const std::string& key) {
+  lock_.AssertAcquired();
+  if (!key.empty())
+    dirty_keys_.insert(key);
+  if (commit_scheduled_ || failed_commits_ >= kMaxFailedCommits)
+    return;
 
-  return transaction.Commit();
+  // Delayed tasks are skipped on shutdown, Flush() takes care of that.
+  commit_scheduled_ = true;
+  db_task_runner_->PostDelayedTask(
+      FROM_HERE,
+      base::Bind(&AppWidgetStorage::Commit, this),
+      commit_delay_ * (1 << failed_commits_));
 }
 
-bool AppWidgetStorage::GetAllEntries(base::DictionaryValue* result) {
-  std::string key;
-  std::string value;
-  DCHECK(result);
+void AppWidgetStorage::Commit() {
+  DCHECK(db_task_runner_->RunsTasksOnCurrentThread());
+  bool written = WritePendingChanges();
+
+  base::AutoLock lock(lock_);
+  if (written) {
+    failed_commits_ = 0;
+    return;
+  }
+
+  if (++failed_commits_ == kMaxFailedCommits)
+    LOG(ERROR) << "Keeping widget storage changes in memory until the next "
+               << "flush.";
+  ScheduleCommit(std::string());
+}
+
+bool AppWidgetStorage::WritePendingChanges() {
+  EntryMap changed;
+  std::set<std::string> removed;
+  bool clear = false;
+  {
+    base::AutoLock lock(lock_);
+    commit_scheduled_ = false;
+    if (!db_initialized_)
+      return true;
+    clear = clear_pending_;
+    clear_pending_ = false;
+    for (const std::string& key : dirty_keys_) {
+      EntryMap::const_iterator it = entries_.find(key);
+      if (it != entries_.end())
+        changed.insert(*it);
+      else
+        removed.insert(key);
+    }
+    dirty_keys_.clear();
+  }
+
+  if (!clear && changed.empty() && removed.empty())
+    return true;
+
+  if (WriteChanges(clear, changed, removed))
+    return true;
 
-  if (!db_initialized_ && !Init())
+  // Keys changed again since are written with their current entry.
+  base::AutoLock lock(lock_);
+  clear_pending_ |= clear;
+  for (const auto& entry : changed)
+    dirty_keys_.insert(entry.first);
+  dirty_keys_.insert(removed.begin(), removed.end());
+  return false;
+}
+
+bool AppWidgetStorage::WriteChanges(bool clear, const EntryMap& changed,
+                                    const std::set<std::string>& removed) {
+  sql::Transaction transaction(sqlite_db_.get());
+  if (!transaction.Begin()) {
+    LOG(ERROR) << "Unable to write widget storage changes.";
     return false;
+  }
 
-  sql::Statement stmt(sqlite_db_->GetUniqueStatement(kSelectAllItem));
-  while (stmt.Step()) {
-    key = stmt.ColumnString(0);
-    value = stmt.ColumnString(1);
-    result->SetString(key, value);
+  if (clear) {
+    sql::Statement stmt(sqlite_db_->GetCachedStatement(
+        SQL_FROM_HERE, kClearStorageTableWithBindOp));
+    stmt.BindBool(0, false);
+    if (!stmt.Run()) {
+      LOG(ERROR) << "An error occured when removing item into DB.";
+      return false;
+    }
   }
 
+  for (const std::string& key : removed) {
+    sql::Statement stmt(sqlite_db_->GetCachedStatement(
+        SQL_FROM_HERE, kRemoveItemWithBindOp));
+    stmt.BindString(0, key);
+    if (!stmt.Run()) {
+      LOG(ERROR) << "An error occured when removing item into DB.";
+      return false;
+    }
+  }
+
+  for (EntryMap::const_iterator it = changed.begin(); it != changed.end();
+       ++it) {
+    sql::Statement stmt(sqlite_db_->GetCachedStatement(
+        SQL_FROM_HERE, kInsertOrReplaceItemWithBindOp));
+    stmt.BindString(0, it->second.value);
+    stmt.BindBool(1, it->second.read_only);
+    stmt.BindString(2, it->first);
+    if (!stmt.Run()) {
+      LOG(ERROR) << "An error occured when set item into DB.";
+      return false;
+    }
+  }
+
+  if (!transaction.Commit()) {
+    LOG(ERROR) << "Unable to write widget storage changes.";
+    return false;
+  }
   return true;
 }
 
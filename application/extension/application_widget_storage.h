@@ -6,21 +6,52 @@
 #define XWALK_APPLICATION_EXTENSION_APPLICATION_WIDGET_STORAGE_H_
 
 #include <map>
+#include <memory>
+#include <set>
 #include <string>
 
-#include "base/values.h"
 #include "base/files/file_path.h"
+#include "base/memory/ref_counted.h"
+#include "base/sequenced_task_runner.h"
+#include "base/synchronization/lock.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/time/time.h"
+#include "base/values.h"
 #include "sql/connection.h"
 #include "xwalk/application/browser/application.h"
 
 namespace xwalk {
 namespace application {
 
-class AppWidgetStorage {
+class AppWidgetStorage;
+
+// Destroys the storage on its database sequence, see ~AppWidgetStorage().
+struct AppWidgetStorageTraits {
+  static void Destruct(const AppWidgetStorage* storage);
+};
+
+// Keeps the widget preferences in memory, loaded once from the database
+// when created. Reads never touch the database; changes are written back
+// in batches, in a single transaction, on a background sequence, the only
+// one using the database. Flush() writes the pending changes right away,
+// what is left is written when the storage goes away. All the methods but
+// Flush() must be called on the same thread, the first one waits for the
+// entries to be loaded.
+class AppWidgetStorage
+    : public base::RefCountedThreadSafe<AppWidgetStorage,
+                                        AppWidgetStorageTraits> {
  public:
-  AppWidgetStorage(Application* application,
-                   const base::FilePath& data_dir);
-  ~AppWidgetStorage();
+  static scoped_refptr<AppWidgetStorage> Create(
+      Application* application, const base::FilePath& data_dir);
+
+  // |preferences| is the widget "preferences" manifest value, a dictionary
+  // or a list of them, stored when the database is created. Changes made
+  // within |commit_delay| are written in the same transaction.
+  static scoped_refptr<AppWidgetStorage> Create(
+      const base::FilePath& data_path,
+      const base::Value* preferences,
+      scoped_refptr<base::SequencedTaskRunner> db_task_runner,
+      base::TimeDelta commit_delay);
 
   // Adds or replaces entry (if not readonly);
   // returns true on success.
@@ -33,17 +64,70 @@ class AppWidgetStorage {
   bool EntryExists(const std::string& key) const;
   bool GetValueByKey(const std::string& key, std::string* value);
 
+  // Writes the pending changes without waiting for the next batch. The
+  // write is completed before the browser shuts down. Also retries the
+  // changes given up on after repeated write failures.
+  void Flush();
+
  private:
-  bool Init();
+  friend class base::DeleteHelper<AppWidgetStorage>;
+  friend struct AppWidgetStorageTraits;
+
+  struct Entry {
+    std::string value;
+    bool read_only;
+  };
+  typedef std::map<std::string, Entry> EntryMap;
+
+  AppWidgetStorage(const base::FilePath& data_path,
+                   const base::Value* preferences,
+                   scoped_refptr<base::SequencedTaskRunner> db_task_runner,
+                   base::TimeDelta commit_delay);
+  // Writes what is still pending, e.g. when the last batch was skipped on
+  // shutdown.
+  ~AppWidgetStorage();
+
+  // Runs on |db_task_runner_|, signals |loaded_| when done.
+  void Init();
+  // Waits for Init(), returns false if the database couldn't be loaded.
+  bool WaitForInit() const;
   bool IsReadOnly(const std::string& key);
   bool InitStorageTable();
-  bool SaveConfigInfoInDB();
-  bool SaveConfigInfoItem(base::DictionaryValue* dict);
+  bool LoadEntries();
+  bool SaveConfigInfo(const base::Value* preferences);
+  bool SaveConfigInfoItem(const base::DictionaryValue* dict);
+
+  // Marks |key| to be written back. Must be called with |lock_| held.
+  void ScheduleCommit(const std::string& key);
+  // Runs on |db_task_runner_|. Failed changes are retried with a growing
+  // delay, and left for the next Flush() after kMaxFailedCommits attempts.
+  void Commit();
+  // Returns false if the changes couldn't be written, they are marked dirty
+  // again.
+  bool WritePendingChanges();
+  bool WriteChanges(bool clear, const EntryMap& changed,
+                    const std::set<std::string>& removed);
 
-  Application* application_;
   std::unique_ptr<sql::Connection> sqlite_db_;
   base::FilePath data_path_;
+  // Only used by Init().
+  std::unique_ptr<base::Value> preferences_;
+  scoped_refptr<base::SequencedTaskRunner> db_task_runner_;
+  base::TimeDelta commit_delay_;
+  mutable base::WaitableEvent loaded_;
+  // Set by Init(), read after |loaded_| is signaled.
   bool db_initialized_;
+
+  // Guards the members below, which are also read by Commit().
+  mutable base::Lock lock_;
+  EntryMap entries_;
+  std::set<std::string> dirty_keys_;
+  bool clear_pending_;
+  bool commit_scheduled_;
+  // Consecutive failed commits, doubles the delay of the next one.
+  int failed_commits_;
+
+  DISALLOW_COPY_AND_ASSIGN(AppWidgetStorage);
 };
 
 }  // namespace application
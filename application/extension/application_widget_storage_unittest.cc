@@ -0,0 +1,226 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/extension/application_widget_storage.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/test/test_mock_time_task_runner.h"
+#include "base/threading/thread.h"
+#include "base/time/time.h"
+#include "base/values.h"
+#include "sql/connection.h"
+#include "sql/statement.h"
+#include "sql/test/scoped_error_ignorer.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/sqlite/sqlite3.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+typedef std::map<std::string, std::string> Rows;
+
+// Long enough for a batch to never be written before the test flushes it.
+const int kNeverCommitDays = 1;
+
+const int kCommitDelayMs = 500;
+
+std::unique_ptr<base::Value> CreatePreferences() {
+  std::unique_ptr<base::ListValue> preferences(new base::ListValue);
+  std::unique_ptr<base::DictionaryValue> fixed(new base::DictionaryValue);
+  fixed->SetString("name", "fixed");
+  fixed->SetString("value", "manifest");
+  fixed->SetBoolean("readonly", true);
+  preferences->Append(std::move(fixed));
+  std::unique_ptr<base::DictionaryValue> color(new base::DictionaryValue);
+  color->SetString("name", "color");
+  color->SetString("value", "red");
+  preferences->Append(std::move(color));
+  return std::move(preferences);
+}
+
+class AppWidgetStorageTest : public testing::Test {
+ protected:
+  AppWidgetStorageTest() : db_thread_("WidgetStorageDBThread") {}
+
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    db_path_ = temp_dir_.path().AppendASCII("WidgetStorage");
+    ASSERT_TRUE(db_thread_.Start());
+  }
+
+  scoped_refptr<AppWidgetStorage> CreateStorage() {
+    std::unique_ptr<base::Value> preferences = CreatePreferences();
+    return AppWidgetStorage::Create(
+        db_path_, preferences.get(), db_thread_.task_runner(),
+        base::TimeDelta::FromDays(kNeverCommitDays));
+  }
+
+  // Waits for the tasks posted to the database thread so far.
+  void WaitForDBThread() {
+    base::WaitableEvent done(base::WaitableEvent::ResetPolicy::MANUAL,
+                             base::WaitableEvent::InitialState::NOT_SIGNALED);
+    db_thread_.task_runner()->PostTask(
+        FROM_HERE,
+        base::Bind(&base::WaitableEvent::Signal, base::Unretained(&done)));
+    done.Wait();
+  }
+
+  // Makes the writes to the storage table fail, like on a full disk.
+  void SetWritesFail(bool fail) {
+    sql::Connection db;
+    ASSERT_TRUE(db.Open(db_path_));
+    ASSERT_TRUE(db.Execute(fail ?
+        "CREATE TRIGGER fail_writes BEFORE INSERT ON widget_storage "
+        "BEGIN SELECT RAISE(ABORT, 'disk full'); END" :
+        "DROP TRIGGER fail_writes"));
+  }
+
+  Rows ReadRows() {
+    Rows rows;
+    sql::Connection db;
+    EXPECT_TRUE(db.Open(db_path_));
+    sql::Statement stmt(db.GetUniqueStatement(
+        "SELECT key, value FROM widget_storage"));
+    while (stmt.Step())
+      rows[stmt.ColumnString(0)] = stmt.ColumnString(1);
+    EXPECT_TRUE(stmt.Succeeded());
+    return rows;
+  }
+
+  base::ScopedTempDir temp_dir_;
+  base::FilePath db_path_;
+  base::Thread db_thread_;
+};
+
+}  // namespace
+
+TEST_F(AppWidgetStorageTest, StoresManifestPreferences) {
+  scoped_refptr<AppWidgetStorage> storage = CreateStorage();
+  std::string value;
+  EXPECT_TRUE(storage->GetValueByKey("color", &value));
+  EXPECT_EQ("red", value);
+  EXPECT_FALSE(storage->AddEntry("fixed", "changed", false));
+  EXPECT_FALSE(storage->RemoveEntry("fixed"));
+
+  WaitForDBThread();
+  Rows rows = ReadRows();
+  EXPECT_EQ(2u, rows.size());
+  EXPECT_EQ("manifest", rows["fixed"]);
+  EXPECT_EQ("red", rows["color"]);
+}
+
+TEST_F(AppWidgetStorageTest, BatchesChangesUntilFlushed) {
+  scoped_refptr<AppWidgetStorage> storage = CreateStorage();
+  EXPECT_TRUE(storage->AddEntry("color", "blue", false));
+  EXPECT_TRUE(storage->AddEntry("size", "10", false));
+  EXPECT_TRUE(storage->AddEntry("shape", "round", false));
+  EXPECT_TRUE(storage->RemoveEntry("shape"));
+
+  // Reads are served from memory, nothing is written yet.
+  std::string value;
+  EXPECT_TRUE(storage->GetValueByKey("size", &value));
+  EXPECT_EQ("10", value);
+  EXPECT_FALSE(storage->EntryExists("shape"));
+  WaitForDBThread();
+  Rows rows = ReadRows();
+  EXPECT_EQ("red", rows["color"]);
+  EXPECT_EQ(0u, rows.count("size"));
+
+  storage->Flush();
+  WaitForDBThread();
+  rows = ReadRows();
+  EXPECT_EQ(3u, rows.size());
+  EXPECT_EQ("blue", rows["color"]);
+  EXPECT_EQ("10", rows["size"]);
+  EXPECT_EQ(0u, rows.count("shape"));
+
+  // Clear() keeps the read only entries.
+  EXPECT_TRUE(storage->Clear());
+  storage->Flush();
+  WaitForDBThread();
+  rows = ReadRows();
+  EXPECT_EQ(1u, rows.size());
+  EXPECT_EQ("manifest", rows["fixed"]);
+}
+
+TEST_F(AppWidgetStorageTest, WritesPendingChangesWhenDestroyed) {
+  scoped_refptr<AppWidgetStorage> storage = CreateStorage();
+  EXPECT_TRUE(storage->AddEntry("color", "green", false));
+  EXPECT_TRUE(storage->RemoveEntry("color"));
+  EXPECT_TRUE(storage->AddEntry("size", "12", false));
+
+  // The pending batch holds the last reference, it's dropped with the
+  // thread, like the delayed batches skipped on shutdown.
+  storage = NULL;
+  db_thread_.Stop();
+  Rows rows = ReadRows();
+  EXPECT_EQ(2u, rows.size());
+  EXPECT_EQ(0u, rows.count("color"));
+  EXPECT_EQ("12", rows["size"]);
+
+  // The next launch loads what was written.
+  ASSERT_TRUE(db_thread_.Start());
+  storage = CreateStorage();
+  std::string value;
+  EXPECT_TRUE(storage->GetValueByKey("size", &value));
+  EXPECT_EQ("12", value);
+  EXPECT_FALSE(storage->EntryExists("color"));
+}
+
+TEST_F(AppWidgetStorageTest, StopsRetryingFailedWritesUntilFlushed) {
+  // Runs the database tasks on this thread, without waiting for the delays.
+  scoped_refptr<base::TestMockTimeTaskRunner> db_runner(
+      new base::TestMockTimeTaskRunner);
+  std::unique_ptr<base::Value> preferences = CreatePreferences();
+  scoped_refptr<AppWidgetStorage> storage = AppWidgetStorage::Create(
+      db_path_, preferences.get(), db_runner,
+      base::TimeDelta::FromMilliseconds(kCommitDelayMs));
+  db_runner->RunUntilIdle();
+
+  sql::ScopedErrorIgnorer ignore_errors;
+  ignore_errors.IgnoreError(SQLITE_CONSTRAINT);
+  SetWritesFail(true);
+  EXPECT_TRUE(storage->AddEntry("color", "blue", false));
+
+  // Each attempt waits twice as long as the previous one, until it gives up.
+  std::vector<base::TimeDelta> delays;
+  while (db_runner->HasPendingTask() && delays.size() < 10) {
+    delays.push_back(db_runner->NextPendingTaskDelay());
+    db_runner->FastForwardBy(delays.back());
+  }
+  EXPECT_FALSE(db_runner->HasPendingTask());
+  ASSERT_LT(2u, delays.size());
+  EXPECT_EQ(base::TimeDelta::FromMilliseconds(kCommitDelayMs), delays[0]);
+  for (size_t i = 1; i < delays.size(); ++i)
+    EXPECT_EQ(delays[i - 1] * 2, delays[i]);
+
+  // The changes are kept in memory, later ones wait for the next flush.
+  std::string value;
+  EXPECT_TRUE(storage->GetValueByKey("color", &value));
+  EXPECT_EQ("blue", value);
+  EXPECT_TRUE(storage->AddEntry("size", "10", false));
+  EXPECT_FALSE(db_runner->HasPendingTask());
+  EXPECT_TRUE(ignore_errors.CheckIgnoredErrors());
+
+  SetWritesFail(false);
+  storage->Flush();
+  db_runner->RunUntilIdle();
+  Rows rows = ReadRows();
+  EXPECT_EQ("blue", rows["color"]);
+  EXPECT_EQ("10", rows["size"]);
+  EXPECT_FALSE(db_runner->HasPendingTask());
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -85,3 +85,15 @@ IN_PROC_BROWSER_TEST_F(ApplicationTest, TestWebStartURL) {
       manifest_path, Manifest::TYPE_MANIFEST);
   ASSERT_TRUE(app);
 }
+
+IN_PROC_BROWSER_TEST_F(ApplicationTest, TestCacheHeaders) {
+  // The checks are done by main.html, through XMLHttpRequest.
+  base::FilePath manifest_path = GetManifestPath(
+      test_data_dir_.Append(FILE_PATH_LITERAL("cache_headers")),
+      Manifest::TYPE_MANIFEST);
+  Application* app = application_sevice()->LaunchFromManifestPath(
+      manifest_path, Manifest::TYPE_MANIFEST);
+  ASSERT_TRUE(app);
+  test_runner_->WaitForTestNotification();
+  EXPECT_EQ(test_runner_->GetTestsResult(), ApiTestRunner::PASS);
+}
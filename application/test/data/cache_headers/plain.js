@@ -0,0 +1 @@
+var resource = "plain";
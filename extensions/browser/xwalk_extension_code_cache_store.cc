@@ -0,0 +1,193 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/browser/xwalk_extension_code_cache_store.h"
+
+#include "base/bind.h"
+#include "base/files/file_enumerator.h"
+#include "base/files/file_util.h"
+#include "base/files/important_file_writer.h"
+#include "base/pickle.h"
+#include "base/strings/string_util.h"
+#include "content/public/browser/browser_thread.h"
+#include "xwalk/extensions/common/xwalk_extension_messages.h"
+
+using content::BrowserThread;
+
+namespace xwalk {
+namespace extensions {
+
+namespace {
+
+const base::FilePath::CharType kEntryExtension[] =
+    FILE_PATH_LITERAL(".jscache");
+
+// Bumped whenever the format of the files changes.
+const int kEntryVersion = 1;
+
+// The code cache of the extensions shipped with Crosswalk is a few tens of
+// KB, this only protects against a misbehaving renderer filling the disk.
+const size_t kMaxEntrySize = 1024 * 1024;
+const size_t kCodeHashSize = 40;
+
+// Extension names are used as file names, so only allow what is valid in a
+// JavaScript namespace.
+bool IsValidExtensionName(const std::string& name) {
+  if (name.empty() || name[0] == '.')
+    return false;
+  for (char c : name) {
+    if (!base::IsAsciiAlpha(c) && !base::IsAsciiDigit(c) &&
+        c != '.' && c != '_')
+      return false;
+  }
+  return true;
+}
+
+bool IsValidEntry(const std::string& name, const std::string& code_hash,
+                  const std::string& data) {
+  return IsValidExtensionName(name) && code_hash.size() == kCodeHashSize &&
+      !data.empty() && data.size() <= kMaxEntrySize;
+}
+
+}  // namespace
+
+XWalkExtensionCodeCacheStore::XWalkExtensionCodeCacheStore(
+    const base::FilePath& cache_dir)
+    : cache_dir_(cache_dir),
+      loaded_(false) {}
+
+XWalkExtensionCodeCacheStore::~XWalkExtensionCodeCacheStore() {}
+
+void XWalkExtensionCodeCacheStore::GetEntries(
+    std::vector<XWalkExtensionMsg_CodeCacheEntry>* entries) {
+  DCHECK_CURRENTLY_ON(BrowserThread::FILE);
+  LoadIfNeeded();
+  for (const auto& entry : entries_) {
+    XWalkExtensionMsg_CodeCacheEntry params;
+    params.name = entry.first;
+    params.code_hash = entry.second.code_hash;
+    params.data = entry.second.data;
+    entries->push_back(params);
+  }
+}
+
+void XWalkExtensionCodeCacheStore::StoreEntry(
+    const std::string& extension_name,
+    const std::string& code_hash,
+    const std::string& data) {
+  DCHECK_CURRENTLY_ON(BrowserThread::FILE);
+  if (!IsValidEntry(extension_name, code_hash, data)) {
+    LOG(WARNING) << "Ignoring invalid code cache for extension "
+                 << extension_name;
+    return;
+  }
+
+  LoadIfNeeded();
+  // Every renderer produces the entries it misses, don't write them more
+  // than once per launch. The data is compared too: after a V8 upgrade or a
+  // flags change, V8 rejects the stored entry and renderers produce a new
+  // one for the same code.
+  Entry& entry = entries_[extension_name];
+  if (entry.code_hash == code_hash && entry.data == data)
+    return;
+  entry.code_hash = code_hash;
+  entry.data = data;
+
+  if (!base::CreateDirectory(cache_dir_)) {
+    LOG(WARNING) << "Couldn't create code cache directory "
+                 << cache_dir_.value();
+    return;
+  }
+
+  base::Pickle pickle;
+  pickle.WriteInt(kEntryVersion);
+  pickle.WriteString(code_hash);
+  pickle.WriteString(data);
+  base::ImportantFileWriter::WriteFileAtomically(
+      GetEntryPath(extension_name),
+      base::StringPiece(static_cast<const char*>(pickle.data()),
+                        pickle.size()));
+}
+
+void XWalkExtensionCodeCacheStore::LoadIfNeeded() {
+  if (loaded_)
+    return;
+  loaded_ = true;
+
+  base::FileEnumerator files(cache_dir_, false, base::FileEnumerator::FILES,
+                             FILE_PATH_LITERAL("*.jscache"));
+  for (base::FilePath path = files.Next(); !path.empty();
+       path = files.Next()) {
+    std::string name = path.BaseName().RemoveExtension().MaybeAsASCII();
+    std::string contents;
+    if (!base::ReadFileToStringWithMaxSize(path, &contents,
+                                           kMaxEntrySize + 1024)) {
+      base::DeleteFile(path, false);
+      continue;
+    }
+
+    base::Pickle pickle(contents.data(), contents.size());
+    base::PickleIterator iter(pickle);
+    int version;
+    Entry entry;
+    if (!iter.ReadInt(&version) || version != kEntryVersion ||
+        !iter.ReadString(&entry.code_hash) || !iter.ReadString(&entry.data) ||
+        !IsValidEntry(name, entry.code_hash, entry.data)) {
+      base::DeleteFile(path, false);
+      continue;
+    }
+    entries_[name] = entry;
+  }
+}
+
+base::FilePath XWalkExtensionCodeCacheStore::GetEntryPath(
+    const std::string& extension_name) const {
+  return cache_dir_.AppendASCII(extension_name).AddExtension(kEntryExtension);
+}
+
+XWalkExtensionCodeCacheFilter::XWalkExtensionCodeCacheFilter(
+    scoped_refptr<XWalkExtensionCodeCacheStore> store)
+    : BrowserMessageFilter(XWalkExtensionMsgStart),
+      store_(store) {}
+
+XWalkExtensionCodeCacheFilter::~XWalkExtensionCodeCacheFilter() {}
+
+void XWalkExtensionCodeCacheFilter::OnChannelConnected(int32_t peer_pid) {
+  BrowserThread::PostTask(BrowserThread::FILE, FROM_HERE,
+      base::Bind(&XWalkExtensionCodeCacheFilter::SendEntries, this));
+}
+
+void XWalkExtensionCodeCacheFilter::OverrideThreadForMessage(
+    const IPC::Message& message,
+    BrowserThread::ID* thread) {
+  if (message.type() == XWalkExtensionHostMsg_StoreCodeCache::ID)
+    *thread = BrowserThread::FILE;
+}
+
+bool XWalkExtensionCodeCacheFilter::OnMessageReceived(
+    const IPC::Message& message) {
+  bool handled = true;
+  IPC_BEGIN_MESSAGE_MAP(XWalkExtensionCodeCacheFilter, message)
+    IPC_MESSAGE_HANDLER(XWalkExtensionHostMsg_StoreCodeCache, OnStoreCodeCache)
+    IPC_MESSAGE_UNHANDLED(handled = false)
+  IPC_END_MESSAGE_MAP()
+  return handled;
+}
+
+void XWalkExtensionCodeCacheFilter::SendEntries() {
+  std::vector<XWalkExtensionMsg_CodeCacheEntry> entries;
+  store_->GetEntries(&entries);
+  if (!entries.empty())
+    Send(new XWalkExtensionMsg_SetCodeCache(entries));
+}
+
+void XWalkExtensionCodeCacheFilter::OnStoreCodeCache(
+    const std::string& extension_name,
+    const std::string& code_hash,
+    const std::string& data) {
+  store_->StoreEntry(extension_name, code_hash, data);
+}
+
+}  // namespace extensions
+}  // namespace xwalk
@@ -0,0 +1,91 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_BROWSER_XWALK_EXTENSION_CODE_CACHE_STORE_H_
+#define XWALK_EXTENSIONS_BROWSER_XWALK_EXTENSION_CODE_CACHE_STORE_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/memory/ref_counted.h"
+#include "content/public/browser/browser_message_filter.h"
+
+struct XWalkExtensionMsg_CodeCacheEntry;
+
+namespace xwalk {
+namespace extensions {
+
+// Persists the V8 code cache produced by the renderers for the extensions
+// JavaScript API code, so the following launches don't need to fully compile
+// it again. Renderers are sandboxed and can't write to disk, so they send the
+// entries here, see XWalkExtensionCodeCache.
+//
+// There is one file per extension in |cache_dir|. All the disk access
+// happens in the FILE thread.
+class XWalkExtensionCodeCacheStore
+    : public base::RefCountedThreadSafe<XWalkExtensionCodeCacheStore> {
+ public:
+  explicit XWalkExtensionCodeCacheStore(const base::FilePath& cache_dir);
+
+  // Returns the entries of all the extensions, loading them from disk the
+  // first time it is called.
+  void GetEntries(std::vector<XWalkExtensionMsg_CodeCacheEntry>* entries);
+
+  void StoreEntry(const std::string& extension_name,
+                  const std::string& code_hash,
+                  const std::string& data);
+
+ private:
+  friend class base::RefCountedThreadSafe<XWalkExtensionCodeCacheStore>;
+  ~XWalkExtensionCodeCacheStore();
+
+  void LoadIfNeeded();
+  base::FilePath GetEntryPath(const std::string& extension_name) const;
+
+  struct Entry {
+    std::string code_hash;
+    std::string data;
+  };
+
+  base::FilePath cache_dir_;
+  bool loaded_;
+
+  typedef std::map<std::string, Entry> EntryMap;
+  EntryMap entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(XWalkExtensionCodeCacheStore);
+};
+
+// Sends the persisted code cache to a render process once its channel is
+// connected, and stores the entries it produces.
+class XWalkExtensionCodeCacheFilter : public content::BrowserMessageFilter {
+ public:
+  explicit XWalkExtensionCodeCacheFilter(
+      scoped_refptr<XWalkExtensionCodeCacheStore> store);
+
+  // content::BrowserMessageFilter implementation.
+  void OnChannelConnected(int32_t peer_pid) override;
+  void OverrideThreadForMessage(const IPC::Message& message,
+                                content::BrowserThread::ID* thread) override;
+  bool OnMessageReceived(const IPC::Message& message) override;
+
+ private:
+  ~XWalkExtensionCodeCacheFilter() override;
+
+  void SendEntries();
+  void OnStoreCodeCache(const std::string& extension_name,
+                        const std::string& code_hash,
+                        const std::string& data);
+
+  scoped_refptr<XWalkExtensionCodeCacheStore> store_;
+
+  DISALLOW_COPY_AND_ASSIGN(XWalkExtensionCodeCacheFilter);
+};
+
+}  // namespace extensions
+}  // namespace xwalk
+
+#endif  // XWALK_EXTENSIONS_BROWSER_XWALK_EXTENSION_CODE_CACHE_STORE_H_
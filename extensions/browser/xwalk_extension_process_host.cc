@@ -9,6 +9,7 @@
 #include "base/command_line.h"
 #include "base/logging.h"
 #include "base/files/file_path.h"
+#include "base/json/json_writer.h"
 #include "content/public/browser/browser_child_process_host.h"
 #include "content/public/browser/browser_thread.h"
 #include "content/public/browser/render_process_host.h"
@@ -34,15 +35,18 @@ namespace extensions {
 class XWalkExtensionProcessHost::RenderProcessMessageFilter
     : public IPC::MessageFilter {
  public:
-  explicit RenderProcessMessageFilter(XWalkExtensionProcessHost* eph)
-      : eph_(eph) {}
+  RenderProcessMessageFilter(XWalkExtensionProcessHost* eph,
+                             content::RenderProcessHost* render_process_host)
+      : eph_(eph),
+        render_process_host_(render_process_host),
+        render_process_id_(render_process_host->GetID()) {}
 
   // This exists to fulfill the requirement for delayed reply handling, since it
   // needs to send a message back if the parameters couldn't be correctly read
   // from the original message received. See DispatchDealyReplyWithSendParams().
   bool Send(IPC::Message* message) {
     if (eph_)
-      return eph_->render_process_host_->Send(message);
+      return render_process_host_->Send(message);
     delete message;
     return false;
   }
@@ -67,12 +71,15 @@ class XWalkExtensionProcessHost::RenderProcessMessageFilter
   void OnGetExtensionProcessChannel(IPC::Message* reply) {
     std::unique_ptr<IPC::Message> scoped_reply(reply);
     if (eph_)
-      eph_->OnGetExtensionProcessChannel(std::move(scoped_reply));
+      eph_->OnGetExtensionProcessChannel(render_process_id_,
+                                         std::move(scoped_reply));
   }
 
   ~RenderProcessMessageFilter() override {}
 
   XWalkExtensionProcessHost* eph_;
+  content::RenderProcessHost* render_process_host_;
+  int render_process_id_;
 };
 
 class ExtensionSandboxedProcessLauncherDelegate
@@ -111,20 +118,34 @@ bool XWalkExtensionProcessHost::Delegate::OnRegisterPermissions(
   return false;
 }
 
+XWalkExtensionProcessHost::RenderProcess::RenderProcess()
+    : host(NULL),
+      channel_handle(""),
+      is_channel_ready(false) {}
+
+XWalkExtensionProcessHost::RenderProcess::~RenderProcess() {
+  filter->Invalidate();
+}
+
 XWalkExtensionProcessHost::XWalkExtensionProcessHost(
     content::RenderProcessHost* render_process_host,
     const base::FilePath& external_extensions_path,
     XWalkExtensionProcessHost::Delegate* delegate,
     std::unique_ptr<base::DictionaryValue::Storage> runtime_variables)
-    : ep_rp_channel_handle_(""),
-      render_process_host_(render_process_host),
-      render_process_message_filter_(new RenderProcessMessageFilter(this)),
+    : XWalkExtensionProcessHost(external_extensions_path, delegate,
+                                std::move(runtime_variables)) {
+  AddRenderProcess(render_process_host);
+}
+
+XWalkExtensionProcessHost::XWalkExtensionProcessHost(
+    const base::FilePath& external_extensions_path,
+    XWalkExtensionProcessHost::Delegate* delegate,
+    std::unique_ptr<base::DictionaryValue::Storage> runtime_variables)
+    : render_process_id_(content::ChildProcessHost::kInvalidUniqueID),
       external_extensions_path_(external_extensions_path),
-      is_extension_process_channel_ready_(false),
       delegate_(delegate),
-      runtime_variables_(std::move(runtime_variables)) {
-  render_process_host_->GetChannel()->AddFilter(
-      render_process_message_filter_.get());
+      runtime_variables_(std::move(runtime_variables)),
+      runtime_variables_key_(GetRuntimeVariablesKey(*runtime_variables_)) {
   BrowserThread::PostTask(BrowserThread::IO, FROM_HERE,
       base::Bind(&XWalkExtensionProcessHost::StartProcess,
       base::Unretained(this)));
@@ -132,10 +153,81 @@ XWalkExtensionProcessHost::XWalkExtensionProcessHost(
 
 XWalkExtensionProcessHost::~XWalkExtensionProcessHost() {
   DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
-  render_process_message_filter_->Invalidate();
+  render_processes_.clear();
   StopProcess();
 }
 
+// static
+std::string XWalkExtensionProcessHost::GetRuntimeVariablesKey(
+    const base::DictionaryValue::Storage& runtime_variables) {
+  base::DictionaryValue dv;
+  for (const auto& variable : runtime_variables)
+    dv.SetWithoutPathExpansion(variable.first, variable.second->DeepCopy());
+  std::string key;
+  base::JSONWriter::Write(dv, &key);
+  return key;
+}
+
+std::vector<int> XWalkExtensionProcessHost::render_process_ids() const {
+  DCHECK_CURRENTLY_ON(BrowserThread::IO);
+  std::vector<int> ids;
+  for (const auto& render_process : render_processes_)
+    ids.push_back(render_process.first);
+  return ids;
+}
+
+void XWalkExtensionProcessHost::AddRenderProcess(
+    content::RenderProcessHost* render_process_host) {
+  DCHECK_CURRENTLY_ON(BrowserThread::UI);
+  scoped_refptr<RenderProcessMessageFilter> filter(
+      new RenderProcessMessageFilter(this, render_process_host));
+  render_process_host->GetChannel()->AddFilter(filter.get());
+  BrowserThread::PostTask(BrowserThread::IO, FROM_HERE,
+      base::Bind(&XWalkExtensionProcessHost::AddRenderProcessOnIOThread,
+                 base::Unretained(this), render_process_host->GetID(),
+                 render_process_host, filter));
+}
+
+void XWalkExtensionProcessHost::RemoveRenderProcess(int render_process_id) {
+  DCHECK_CURRENTLY_ON(BrowserThread::UI);
+  BrowserThread::PostTask(BrowserThread::IO, FROM_HERE,
+      base::Bind(&XWalkExtensionProcessHost::RemoveRenderProcessOnIOThread,
+                 base::Unretained(this), render_process_id));
+}
+
+void XWalkExtensionProcessHost::AddRenderProcessOnIOThread(
+    int render_process_id,
+    content::RenderProcessHost* render_process_host,
+    scoped_refptr<RenderProcessMessageFilter> filter) {
+  DCHECK_CURRENTLY_ON(BrowserThread::IO);
+  if (render_process_id_ == content::ChildProcessHost::kInvalidUniqueID)
+    render_process_id_ = render_process_id;
+
+  std::unique_ptr<RenderProcess> render_process(new RenderProcess);
+  render_process->host = render_process_host;
+  render_process->filter = filter;
+  render_processes_[render_process_id] = std::move(render_process);
+
+  // StartProcess() always runs first, so the extensions are registered by
+  // the time the channel is created.
+  Send(new XWalkExtensionProcessMsg_CreateRenderProcessChannel(
+      render_process_id));
+}
+
+void XWalkExtensionProcessHost::RemoveRenderProcessOnIOThread(
+    int render_process_id) {
+  DCHECK_CURRENTLY_ON(BrowserThread::IO);
+  if (!render_processes_.erase(render_process_id))
+    return;
+  if (render_process_id == render_process_id_) {
+    render_process_id_ = render_processes_.empty() ?
+        content::ChildProcessHost::kInvalidUniqueID :
+        render_processes_.begin()->first;
+  }
+  Send(new XWalkExtensionProcessMsg_CloseRenderProcessChannel(
+      render_process_id));
+}
+
 namespace {
 
 void ToListValue(base::DictionaryValue::Storage* vm, base::ListValue* lv) {
@@ -184,6 +276,17 @@ void XWalkExtensionProcessHost::StartProcess() {
   cmd_line->AppendSwitchASCII(switches::kProcessType,
                                 switches::kXWalkExtensionProcess);
   cmd_line->AppendSwitchASCII(switches::kProcessChannelID, channel_id);
+
+  // The extension process has its own server, which also needs to know
+  // whether messages should be batched, and loads the extensions.
+  static const char* const kSwitchNames[] = {
+    switches::kXWalkExtensionMessageBatchWindow,
+    switches::kXWalkExtensionMessageBatchSize,
+    switches::kXWalkExtensionLoadThreads,
+  };
+  cmd_line->CopySwitchesFrom(*base::CommandLine::ForCurrentProcess(),
+                             kSwitchNames, arraysize(kSwitchNames));
+
   if (!extension_cmd_prefix.empty())
     cmd_line->PrependWrapper(extension_cmd_prefix);
 
@@ -206,9 +309,12 @@ void XWalkExtensionProcessHost::StopProcess() {
 }
 
 void XWalkExtensionProcessHost::OnGetExtensionProcessChannel(
-    std::unique_ptr<IPC::Message> reply) {
-  pending_reply_for_render_process_ = std::move(reply);
-  ReplyChannelHandleToRenderProcess();
+    int render_process_id, std::unique_ptr<IPC::Message> reply) {
+  RenderProcessMap::iterator it = render_processes_.find(render_process_id);
+  if (it == render_processes_.end())
+    return;
+  it->second->pending_reply = std::move(reply);
+  ReplyChannelHandleToRenderProcess(it->second.get());
 }
 
 bool XWalkExtensionProcessHost::OnMessageReceived(const IPC::Message& message) {
@@ -217,6 +323,9 @@ bool XWalkExtensionProcessHost::OnMessageReceived(const IPC::Message& message) {
     IPC_MESSAGE_HANDLER(
         XWalkExtensionProcessHostMsg_RenderProcessChannelCreated,
         OnRenderChannelCreated)
+    IPC_MESSAGE_HANDLER(
+        XWalkExtensionProcessHostMsg_ExtensionsRegistered,
+        OnExtensionsRegistered)
     IPC_MESSAGE_HANDLER_DELAY_REPLY(
         XWalkExtensionProcessHostMsg_CheckAPIAccessControl,
         OnCheckAPIAccessControl)
@@ -239,7 +348,7 @@ void XWalkExtensionProcessHost::OnChannelError() {
 
   VLOG(1) << "\n\nExtensionProcess crashed";
   if (delegate_)
-    delegate_->OnExtensionProcessDied(this, render_process_host_->GetID());
+    delegate_->OnExtensionProcessDied(this, render_process_id_);
 }
 
 void XWalkExtensionProcessHost::OnProcessLaunched() {
@@ -247,29 +356,40 @@ void XWalkExtensionProcessHost::OnProcessLaunched() {
 }
 
 void XWalkExtensionProcessHost::OnRenderChannelCreated(
-    const IPC::ChannelHandle& handle) {
-  is_extension_process_channel_ready_ = true;
-  ep_rp_channel_handle_ = handle;
-  ReplyChannelHandleToRenderProcess();
+    int render_process_id, const IPC::ChannelHandle& handle) {
+  RenderProcessMap::iterator it = render_processes_.find(render_process_id);
+  if (it == render_processes_.end())
+    return;
+  RenderProcess* render_process = it->second.get();
+  render_process->is_channel_ready = true;
+  render_process->channel_handle = handle;
+  ReplyChannelHandleToRenderProcess(render_process);
+  if (delegate_)
+    delegate_->OnRenderChannelCreated(render_process_id);
+}
+
+void XWalkExtensionProcessHost::OnExtensionsRegistered(
+    const std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams>&
+        extensions) {
   if (delegate_)
-    delegate_->OnRenderChannelCreated(render_process_host_->GetID());
+    delegate_->OnExtensionsRegistered(runtime_variables_key_, extensions);
 }
 
-void XWalkExtensionProcessHost::ReplyChannelHandleToRenderProcess() {
+void XWalkExtensionProcessHost::ReplyChannelHandleToRenderProcess(
+    RenderProcess* render_process) {
   // Replying the channel handle to RP depends on two events:
   // - EP already notified EPH that new channel was created (for RP<->EP).
   // - RP already asked for the channel handle.
   //
   // The order for this events is not determined, so we call this function from
   // both, and the second execution will send the reply.
-  if (!is_extension_process_channel_ready_
-      || !pending_reply_for_render_process_)
+  if (!render_process->is_channel_ready || !render_process->pending_reply)
     return;
 
   XWalkExtensionProcessHostMsg_GetExtensionProcessChannel::WriteReplyParams(
-      pending_reply_for_render_process_.get(), ep_rp_channel_handle_);
+      render_process->pending_reply.get(), render_process->channel_handle);
 
-  render_process_host_->Send(pending_reply_for_render_process_.release());
+  render_process->host->Send(render_process->pending_reply.release());
 }
 
 void XWalkExtensionProcessHost::ReplyAccessControlToExtension(
@@ -284,7 +404,7 @@ void XWalkExtensionProcessHost::OnCheckAPIAccessControl(
     const std::string& extension_name,
     const std::string& api_name, IPC::Message* reply_msg) {
   CHECK(delegate_);
-  delegate_->OnCheckAPIAccessControl(render_process_host_->GetID(),
+  delegate_->OnCheckAPIAccessControl(render_process_id_,
                                      extension_name, api_name,
       base::Bind(&XWalkExtensionProcessHost::ReplyAccessControlToExtension,
                  base::Unretained(this),
@@ -296,7 +416,7 @@ void XWalkExtensionProcessHost::OnRegisterPermissions(
     const std::string& perm_table, bool* result) {
   CHECK(delegate_);
   *result = delegate_->OnRegisterPermissions(
-      render_process_host_->GetID(), extension_name, perm_table);
+      render_process_id_, extension_name, perm_table);
 }
 
 bool XWalkExtensionProcessHost::Send(IPC::Message* msg) {
@@ -304,6 +424,7 @@ bool XWalkExtensionProcessHost::Send(IPC::Message* msg) {
     return process_->GetHost()->Send(msg);
   if (channel_)
     return channel_->Send(msg);
+  delete msg;
   return false;
 }
 
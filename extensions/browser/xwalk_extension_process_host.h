@@ -5,8 +5,10 @@
 #ifndef XWALK_EXTENSIONS_BROWSER_XWALK_EXTENSION_PROCESS_HOST_H_
 #define XWALK_EXTENSIONS_BROWSER_XWALK_EXTENSION_PROCESS_HOST_H_
 
+#include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "base/files/file_path.h"
 #include "base/memory/ref_counted.h"
@@ -17,6 +19,8 @@
 #include "ipc/ipc_sender.h"
 #include "xwalk/extensions/common/xwalk_extension_permission_types.h"
 
+struct XWalkExtensionServerMsg_ExtensionRegisterParams;
+
 namespace content {
 class BrowserChildProcessHost;
 class RenderProcessHost;
@@ -28,6 +32,12 @@ namespace extensions {
 // This class represents the browser side of the browser <-> extension process
 // communication channel. It has to run some operations in IO thread for
 // creating the extra process.
+//
+// The extension process is launched for the render process given to the
+// constructor, others can be added when it is shared, see
+// --xwalk-shared-extension-process. Each render process gets its own channel
+// to the extension process. It can also be launched before any render process
+// needs it, see --xwalk-prewarm-extension-process.
 class XWalkExtensionProcessHost
     : public content::BrowserChildProcessHostDelegate,
       public IPC::Sender {
@@ -46,6 +56,13 @@ class XWalkExtensionProcessHost
                                        const std::string& extension_name,
                                        const std::string& perm_table);
     virtual void OnRenderChannelCreated(int render_process_id) {}
+    // Called in the IO thread once the extension process loaded the external
+    // extensions with the runtime variables identified by
+    // |runtime_variables_key|.
+    virtual void OnExtensionsRegistered(
+        const std::string& runtime_variables_key,
+        const std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams>&
+            extensions) {}
 
    protected:
     ~Delegate() {}
@@ -55,20 +72,77 @@ class XWalkExtensionProcessHost
                             const base::FilePath& external_extensions_path,
                             XWalkExtensionProcessHost::Delegate* delegate,
                             std::unique_ptr<base::DictionaryValue::Storage> runtime_variables);
+  // Launches the extension process without any render process, they are
+  // added later with AddRenderProcess().
+  XWalkExtensionProcessHost(const base::FilePath& external_extensions_path,
+                            XWalkExtensionProcessHost::Delegate* delegate,
+                            std::unique_ptr<base::DictionaryValue::Storage> runtime_variables);
   ~XWalkExtensionProcessHost() override;
 
+  // Returns a string identifying |runtime_variables|, equal for equal
+  // variables.
+  static std::string GetRuntimeVariablesKey(
+      const base::DictionaryValue::Storage& runtime_variables);
+
   // IPC::Sender implementation
   bool Send(IPC::Message* msg) override;
 
+  // Makes the extension process also serve |render_process_host|. Called in
+  // the UI thread.
+  void AddRenderProcess(content::RenderProcessHost* render_process_host);
+
+  // Releases the channel and the instances of |render_process_id| in the
+  // extension process. Called in the UI thread.
+  void RemoveRenderProcess(int render_process_id);
+
+  // Number of render processes using the extension process. Called in the IO
+  // thread.
+  size_t render_process_count() const { return render_processes_.size(); }
+
+  // Ids of the render processes using the extension process. Called in the
+  // IO thread.
+  std::vector<int> render_process_ids() const;
+
+  const std::string& runtime_variables_key() const {
+    return runtime_variables_key_;
+  }
+
  private:
   class RenderProcessMessageFilter;
 
+  // State of a render process served by the extension process, only
+  // accessed in the IO thread.
+  struct RenderProcess {
+    RenderProcess();
+    ~RenderProcess();
+
+    content::RenderProcessHost* host;
+    IPC::ChannelHandle channel_handle;
+    bool is_channel_ready;
+    std::unique_ptr<IPC::Message> pending_reply;
+
+    // We use this filter to know when RP asked for the extension process
+    // channel. We keep the reference to invalidate the filter once we don't
+    // need it anymore.
+    //
+    // TODO(cmarcelo): Avoid having an extra filter, see if we can embed this
+    // handling in the existing filter we have in ExtensionData struct.
+    scoped_refptr<RenderProcessMessageFilter> filter;
+  };
+
   void StartProcess();
   void StopProcess();
 
+  void AddRenderProcessOnIOThread(
+      int render_process_id,
+      content::RenderProcessHost* render_process_host,
+      scoped_refptr<RenderProcessMessageFilter> filter);
+  void RemoveRenderProcessOnIOThread(int render_process_id);
+
   // Handler for message from Render Process host, it is a synchronous message,
   // that will be replied only when the extension process channel is created.
-  void OnGetExtensionProcessChannel(std::unique_ptr<IPC::Message> reply);
+  void OnGetExtensionProcessChannel(int render_process_id,
+                                    std::unique_ptr<IPC::Message> reply);
 
   // content::BrowserChildProcessHostDelegate implementation.
   bool OnMessageReceived(const IPC::Message& message) override;
@@ -76,9 +150,13 @@ class XWalkExtensionProcessHost
   void OnProcessLaunched() override;
 
   // Message Handlers.
-  void OnRenderChannelCreated(const IPC::ChannelHandle& channel_id);
+  void OnRenderChannelCreated(int render_process_id,
+                              const IPC::ChannelHandle& channel_id);
+  void OnExtensionsRegistered(
+      const std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams>&
+          extensions);
 
-  void ReplyChannelHandleToRenderProcess();
+  void ReplyChannelHandleToRenderProcess(RenderProcess* render_process);
 
   void OnCheckAPIAccessControl(const std::string& extension_name,
       const std::string& api_name, IPC::Message* reply_msg);
@@ -88,25 +166,23 @@ class XWalkExtensionProcessHost
       const std::string& perm_table, bool* result);
 
   std::unique_ptr<content::BrowserChildProcessHost> process_;
-  IPC::ChannelHandle ep_rp_channel_handle_;
-  content::RenderProcessHost* render_process_host_;
-  std::unique_ptr<IPC::Message> pending_reply_for_render_process_;
-
-  // We use this filter to know when RP asked for the extension process channel.
-  // We keep the reference to invalidate the filter once we don't need it
-  // anymore.
-  //
-  // TODO(cmarcelo): Avoid having an extra filter, see if we can embed this
-  // handling in the existing filter we have in ExtensionData struct.
-  scoped_refptr<RenderProcessMessageFilter> render_process_message_filter_;
 
-  base::FilePath external_extensions_path_;
+  // One of the render processes using the extension process, the first one
+  // added until it goes away. The permission requests from the extension
+  // process are checked against it, which is right because a shared process
+  // only serves render processes with the same runtime variables, i.e. of
+  // the same application.
+  int render_process_id_;
+
+  typedef std::map<int, std::unique_ptr<RenderProcess>> RenderProcessMap;
+  RenderProcessMap render_processes_;
 
-  bool is_extension_process_channel_ready_;
+  base::FilePath external_extensions_path_;
 
   XWalkExtensionProcessHost::Delegate* delegate_;
 
   std::unique_ptr<base::DictionaryValue::Storage> runtime_variables_;
+  std::string runtime_variables_key_;
 
   // IPC channel for launcher to communicate with BP in service mode.
   std::unique_ptr<IPC::Channel> channel_;
@@ -0,0 +1,240 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/browser/xwalk_extension_registry_snapshot.h"
+
+#include <algorithm>
+
+#include "base/files/file_enumerator.h"
+#include "base/files/file_util.h"
+#include "base/files/important_file_writer.h"
+#include "base/native_library.h"
+#include "base/pickle.h"
+#include "base/strings/utf_string_conversions.h"
+
+namespace xwalk {
+namespace extensions {
+
+namespace {
+
+// Bumped whenever the format of the file changes.
+const int kSnapshotVersion = 1;
+
+const size_t kMaxSnapshotSize = 4 * 1024 * 1024;
+
+base::FilePath::StringType GetNativeLibraryPattern() {
+  const std::string library_pattern = base::GetNativeLibraryName("*");
+#if defined(OS_WIN)
+  return base::UTF8ToUTF16(library_pattern);
+#else
+  return library_pattern;
+#endif
+}
+
+bool ReadExtension(base::PickleIterator* iter,
+                   XWalkExtensionServerMsg_ExtensionRegisterParams* extension) {
+  int entry_points_count;
+  if (!iter->ReadString(&extension->name) ||
+      !iter->ReadString(&extension->js_api) ||
+      !iter->ReadInt(&entry_points_count) || entry_points_count < 0)
+    return false;
+  for (int i = 0; i < entry_points_count; ++i) {
+    std::string entry_point;
+    if (!iter->ReadString(&entry_point))
+      return false;
+    extension->entry_points.push_back(entry_point);
+  }
+  return true;
+}
+
+void WriteExtension(
+    const XWalkExtensionServerMsg_ExtensionRegisterParams& extension,
+    base::Pickle* pickle) {
+  pickle->WriteString(extension.name);
+  pickle->WriteString(extension.js_api);
+  pickle->WriteInt(extension.entry_points.size());
+  for (const std::string& entry_point : extension.entry_points)
+    pickle->WriteString(entry_point);
+}
+
+bool ExtensionListsEqual(
+    const XWalkExtensionRegistrySnapshot::ExtensionList& a,
+    const XWalkExtensionRegistrySnapshot::ExtensionList& b) {
+  if (a.size() != b.size())
+    return false;
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (a[i].name != b[i].name || a[i].js_api != b[i].js_api ||
+        a[i].entry_points != b[i].entry_points)
+      return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+XWalkExtensionRegistrySnapshot::XWalkExtensionRegistrySnapshot(
+    const base::FilePath& snapshot_path,
+    const base::FilePath& extensions_path)
+    : snapshot_path_(snapshot_path),
+      extensions_path_(extensions_path),
+      valid_(false) {}
+
+XWalkExtensionRegistrySnapshot::~XWalkExtensionRegistrySnapshot() {}
+
+void XWalkExtensionRegistrySnapshot::Load() {
+  std::string contents;
+  if (!base::ReadFileToStringWithMaxSize(snapshot_path_, &contents,
+                                         kMaxSnapshotSize))
+    return;
+
+  base::Pickle pickle(contents.data(), contents.size());
+  base::PickleIterator iter(pickle);
+  int version;
+  std::string extensions_path;
+  std::string runtime_variables_key;
+  int count;
+  if (!iter.ReadInt(&version) || version != kSnapshotVersion ||
+      !iter.ReadString(&extensions_path) ||
+      extensions_path != extensions_path_.AsUTF8Unsafe() ||
+      !iter.ReadString(&runtime_variables_key) ||
+      !iter.ReadInt(&count) || count < 0) {
+    base::DeleteFile(snapshot_path_, false);
+    return;
+  }
+
+  std::vector<Library> libraries(count);
+  for (Library& library : libraries) {
+    if (!iter.ReadString(&library.name) || !iter.ReadInt64(&library.size) ||
+        !iter.ReadInt64(&library.last_modified)) {
+      base::DeleteFile(snapshot_path_, false);
+      return;
+    }
+  }
+
+  ExtensionList extensions;
+  if (!iter.ReadInt(&count) || count < 0) {
+    base::DeleteFile(snapshot_path_, false);
+    return;
+  }
+  for (int i = 0; i < count; ++i) {
+    XWalkExtensionServerMsg_ExtensionRegisterParams extension;
+    if (!ReadExtension(&iter, &extension)) {
+      base::DeleteFile(snapshot_path_, false);
+      return;
+    }
+    extensions.push_back(extension);
+  }
+
+  // Stale snapshots are kept, Update() replaces them once the extension
+  // process loaded the libraries.
+  bool valid = libraries == GetLibraries();
+
+  base::AutoLock lock(lock_);
+  valid_ = valid;
+  runtime_variables_key_ = runtime_variables_key;
+  libraries_.swap(libraries);
+  extensions_.swap(extensions);
+}
+
+bool XWalkExtensionRegistrySnapshot::GetExtensions(
+    const std::string& runtime_variables_key,
+    ExtensionList* extensions) const {
+  base::AutoLock lock(lock_);
+  if (!valid_ || runtime_variables_key != runtime_variables_key_)
+    return false;
+  *extensions = extensions_;
+  return true;
+}
+
+void XWalkExtensionRegistrySnapshot::Update(
+    const std::string& runtime_variables_key,
+    const ExtensionList& extensions) {
+  std::vector<Library> libraries = GetLibraries();
+  {
+    base::AutoLock lock(lock_);
+    if (valid_ && runtime_variables_key == runtime_variables_key_ &&
+        libraries == libraries_ && ExtensionListsEqual(extensions, extensions_))
+      return;
+    valid_ = true;
+    runtime_variables_key_ = runtime_variables_key;
+    libraries_ = libraries;
+    extensions_ = extensions;
+  }
+
+  base::Pickle pickle;
+  pickle.WriteInt(kSnapshotVersion);
+  pickle.WriteString(extensions_path_.AsUTF8Unsafe());
+  pickle.WriteString(runtime_variables_key);
+  pickle.WriteInt(libraries.size());
+  for (const Library& library : libraries) {
+    pickle.WriteString(library.name);
+    pickle.WriteInt64(library.size);
+    pickle.WriteInt64(library.last_modified);
+  }
+  pickle.WriteInt(extensions.size());
+  for (const auto& extension : extensions)
+    WriteExtension(extension, &pickle);
+
+  if (!base::CreateDirectory(snapshot_path_.DirName())) {
+    LOG(WARNING) << "Couldn't create directory for "
+                 << snapshot_path_.value();
+    return;
+  }
+  base::ImportantFileWriter::WriteFileAtomically(
+      snapshot_path_,
+      base::StringPiece(static_cast<const char*>(pickle.data()),
+                        pickle.size()));
+}
+
+std::vector<XWalkExtensionRegistrySnapshot::Library>
+XWalkExtensionRegistrySnapshot::GetLibraries() const {
+  std::vector<Library> libraries;
+  base::FileEnumerator files(extensions_path_, false,
+                             base::FileEnumerator::FILES,
+                             GetNativeLibraryPattern());
+  for (base::FilePath path = files.Next(); !path.empty();
+       path = files.Next()) {
+    base::FileEnumerator::FileInfo info = files.GetInfo();
+    Library library;
+    library.name = path.BaseName().AsUTF8Unsafe();
+    library.size = info.GetSize();
+    library.last_modified = info.GetLastModifiedTime().ToInternalValue();
+    libraries.push_back(library);
+  }
+
+  // The enumeration order depends on the file system.
+  std::sort(libraries.begin(), libraries.end(),
+            [](const Library& a, const Library& b) { return a.name < b.name; });
+  return libraries;
+}
+
+XWalkExtensionRegistrySnapshotFilter::XWalkExtensionRegistrySnapshotFilter(
+    scoped_refptr<XWalkExtensionRegistrySnapshot> snapshot,
+    const std::string& runtime_variables_key)
+    : BrowserMessageFilter(XWalkExtensionMsgStart),
+      snapshot_(snapshot),
+      runtime_variables_key_(runtime_variables_key) {}
+
+XWalkExtensionRegistrySnapshotFilter::~XWalkExtensionRegistrySnapshotFilter() {
+}
+
+bool XWalkExtensionRegistrySnapshotFilter::OnMessageReceived(
+    const IPC::Message& message) {
+  bool handled = true;
+  IPC_BEGIN_MESSAGE_MAP(XWalkExtensionRegistrySnapshotFilter, message)
+    IPC_MESSAGE_HANDLER(XWalkExtensionHostMsg_GetExternalExtensionsSnapshot,
+                        OnGetExternalExtensionsSnapshot)
+    IPC_MESSAGE_UNHANDLED(handled = false)
+  IPC_END_MESSAGE_MAP()
+  return handled;
+}
+
+void XWalkExtensionRegistrySnapshotFilter::OnGetExternalExtensionsSnapshot(
+    XWalkExtensionRegistrySnapshot::ExtensionList* extensions) {
+  if (snapshot_ && !snapshot_->GetExtensions(runtime_variables_key_, extensions))
+    extensions->clear();
+}
+
+}  // namespace extensions
+}  // namespace xwalk
@@ -0,0 +1,109 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_BROWSER_XWALK_EXTENSION_REGISTRY_SNAPSHOT_H_
+#define XWALK_EXTENSIONS_BROWSER_XWALK_EXTENSION_REGISTRY_SNAPSHOT_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/memory/ref_counted.h"
+#include "base/synchronization/lock.h"
+#include "content/public/browser/browser_message_filter.h"
+#include "xwalk/extensions/common/xwalk_extension_messages.h"
+
+namespace xwalk {
+namespace extensions {
+
+// Keeps on disk the external extensions registered by the extension process,
+// with the size and modification time of the libraries in the extensions
+// directory at that moment. On the next launches the render processes get
+// them from here without waiting for the extension process to load the
+// libraries, see XWalkExtensionHostMsg_GetExternalExtensionsSnapshot.
+//
+// The JavaScript API of an extension may depend on the runtime variables, so
+// a snapshot is only valid for the runtime variables it was taken with.
+//
+// Load() and Update() access the disk, the service calls them in the FILE
+// thread. GetExtensions() can be called from any thread.
+class XWalkExtensionRegistrySnapshot
+    : public base::RefCountedThreadSafe<XWalkExtensionRegistrySnapshot> {
+ public:
+  typedef std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams>
+      ExtensionList;
+
+  XWalkExtensionRegistrySnapshot(const base::FilePath& snapshot_path,
+                                 const base::FilePath& extensions_path);
+
+  // Reads the snapshot, discarding it if a library was added, removed or
+  // changed since it was taken.
+  void Load();
+
+  // Returns false if there's no valid snapshot for |runtime_variables_key|.
+  bool GetExtensions(const std::string& runtime_variables_key,
+                     ExtensionList* extensions) const;
+
+  // Replaces the snapshot and writes it, unless nothing changed.
+  void Update(const std::string& runtime_variables_key,
+              const ExtensionList& extensions);
+
+ private:
+  friend class base::RefCountedThreadSafe<XWalkExtensionRegistrySnapshot>;
+  ~XWalkExtensionRegistrySnapshot();
+
+  struct Library {
+    std::string name;
+    int64_t size;
+    int64_t last_modified;
+
+    bool operator==(const Library& other) const {
+      return name == other.name && size == other.size &&
+          last_modified == other.last_modified;
+    }
+  };
+
+  std::vector<Library> GetLibraries() const;
+
+  base::FilePath snapshot_path_;
+  base::FilePath extensions_path_;
+
+  mutable base::Lock lock_;
+  bool valid_;
+  std::string runtime_variables_key_;
+  std::vector<Library> libraries_;
+  ExtensionList extensions_;
+
+  DISALLOW_COPY_AND_ASSIGN(XWalkExtensionRegistrySnapshot);
+};
+
+// Replies the snapshot to a render process, an empty list if there's no
+// valid one for its runtime variables. |snapshot| can be NULL.
+class XWalkExtensionRegistrySnapshotFilter
+    : public content::BrowserMessageFilter {
+ public:
+  XWalkExtensionRegistrySnapshotFilter(
+      scoped_refptr<XWalkExtensionRegistrySnapshot> snapshot,
+      const std::string& runtime_variables_key);
+
+  // content::BrowserMessageFilter implementation.
+  bool OnMessageReceived(const IPC::Message& message) override;
+
+ private:
+  ~XWalkExtensionRegistrySnapshotFilter() override;
+
+  void OnGetExternalExtensionsSnapshot(
+      XWalkExtensionRegistrySnapshot::ExtensionList* extensions);
+
+  scoped_refptr<XWalkExtensionRegistrySnapshot> snapshot_;
+  std::string runtime_variables_key_;
+
+  DISALLOW_COPY_AND_ASSIGN(XWalkExtensionRegistrySnapshotFilter);
+};
+
+}  // namespace extensions
+}  // namespace xwalk
+
+#endif  // XWALK_EXTENSIONS_BROWSER_XWALK_EXTENSION_REGISTRY_SNAPSHOT_H_
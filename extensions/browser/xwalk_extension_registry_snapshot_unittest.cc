@@ -0,0 +1,109 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/browser/xwalk_extension_registry_snapshot.h"
+
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/native_library.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using xwalk::extensions::XWalkExtensionRegistrySnapshot;
+
+namespace {
+
+const char kRuntimeVariablesKey[] = "{\"app_id\":\"test\"}";
+
+class XWalkExtensionRegistrySnapshotTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    extensions_path_ = temp_dir_.path().AppendASCII("extensions");
+    ASSERT_TRUE(base::CreateDirectory(extensions_path_));
+    snapshot_path_ = temp_dir_.path().AppendASCII("ExtensionRegistry");
+    WriteLibrary("echo", "library");
+
+    XWalkExtensionServerMsg_ExtensionRegisterParams extension;
+    extension.name = "echo";
+    extension.js_api = "exports.echo = function() {};";
+    extension.entry_points.push_back("Echo");
+    extensions_.push_back(extension);
+  }
+
+  void WriteLibrary(const std::string& name, const std::string& contents) {
+    base::FilePath path = extensions_path_.AppendASCII(
+        base::GetNativeLibraryName(name));
+    ASSERT_EQ(static_cast<int>(contents.size()),
+              base::WriteFile(path, contents.data(), contents.size()));
+  }
+
+  scoped_refptr<XWalkExtensionRegistrySnapshot> LoadSnapshot() {
+    scoped_refptr<XWalkExtensionRegistrySnapshot> snapshot(
+        new XWalkExtensionRegistrySnapshot(snapshot_path_, extensions_path_));
+    snapshot->Load();
+    return snapshot;
+  }
+
+  base::ScopedTempDir temp_dir_;
+  base::FilePath extensions_path_;
+  base::FilePath snapshot_path_;
+  XWalkExtensionRegistrySnapshot::ExtensionList extensions_;
+};
+
+}  // namespace
+
+TEST_F(XWalkExtensionRegistrySnapshotTest, EmptyWithoutFile) {
+  XWalkExtensionRegistrySnapshot::ExtensionList extensions;
+  EXPECT_FALSE(LoadSnapshot()->GetExtensions(kRuntimeVariablesKey,
+                                             &extensions));
+}
+
+TEST_F(XWalkExtensionRegistrySnapshotTest, UpdateAndLoad) {
+  LoadSnapshot()->Update(kRuntimeVariablesKey, extensions_);
+  ASSERT_TRUE(base::PathExists(snapshot_path_));
+
+  XWalkExtensionRegistrySnapshot::ExtensionList extensions;
+  ASSERT_TRUE(LoadSnapshot()->GetExtensions(kRuntimeVariablesKey,
+                                            &extensions));
+  ASSERT_EQ(1U, extensions.size());
+  EXPECT_EQ(extensions_[0].name, extensions[0].name);
+  EXPECT_EQ(extensions_[0].js_api, extensions[0].js_api);
+  EXPECT_EQ(extensions_[0].entry_points, extensions[0].entry_points);
+}
+
+TEST_F(XWalkExtensionRegistrySnapshotTest, OnlyValidForSameRuntimeVariables) {
+  LoadSnapshot()->Update(kRuntimeVariablesKey, extensions_);
+
+  XWalkExtensionRegistrySnapshot::ExtensionList extensions;
+  EXPECT_FALSE(LoadSnapshot()->GetExtensions("{\"app_id\":\"other\"}",
+                                             &extensions));
+}
+
+TEST_F(XWalkExtensionRegistrySnapshotTest, InvalidatedByLibraryChanges) {
+  LoadSnapshot()->Update(kRuntimeVariablesKey, extensions_);
+
+  XWalkExtensionRegistrySnapshot::ExtensionList extensions;
+  WriteLibrary("echo", "a bigger library");
+  EXPECT_FALSE(LoadSnapshot()->GetExtensions(kRuntimeVariablesKey,
+                                             &extensions));
+
+  LoadSnapshot()->Update(kRuntimeVariablesKey, extensions_);
+  EXPECT_TRUE(LoadSnapshot()->GetExtensions(kRuntimeVariablesKey,
+                                            &extensions));
+
+  WriteLibrary("other", "library");
+  EXPECT_FALSE(LoadSnapshot()->GetExtensions(kRuntimeVariablesKey,
+                                             &extensions));
+}
+
+TEST_F(XWalkExtensionRegistrySnapshotTest, CorruptedFileIsDiscarded) {
+  const char kGarbage[] = "garbage";
+  ASSERT_EQ(static_cast<int>(sizeof(kGarbage)),
+            base::WriteFile(snapshot_path_, kGarbage, sizeof(kGarbage)));
+
+  XWalkExtensionRegistrySnapshot::ExtensionList extensions;
+  EXPECT_FALSE(LoadSnapshot()->GetExtensions(kRuntimeVariablesKey,
+                                             &extensions));
+  EXPECT_FALSE(base::PathExists(snapshot_path_));
+}
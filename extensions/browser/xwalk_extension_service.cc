@@ -7,6 +7,7 @@
 #include <set>
 #include <vector>
 #include "base/callback.h"
+#include "base/macros.h"
 #include "base/command_line.h"
 #include "base/memory/ptr_util.h"
 #include "base/pickle.h"
@@ -17,8 +18,10 @@
 #include "content/public/browser/notification_service.h"
 #include "content/public/browser/render_process_host.h"
 #include "ipc/ipc_message_macros.h"
+#include "xwalk/extensions/browser/xwalk_extension_code_cache_store.h"
 #include "xwalk/extensions/browser/xwalk_extension_data.h"
 #include "xwalk/extensions/browser/xwalk_extension_process_host.h"
+#include "xwalk/extensions/browser/xwalk_extension_registry_snapshot.h"
 #include "xwalk/extensions/common/xwalk_extension.h"
 #include "xwalk/extensions/common/xwalk_extension_server.h"
 #include "xwalk/extensions/common/xwalk_extension_switches.h"
@@ -208,11 +211,42 @@ XWalkExtensionService::~XWalkExtensionService() {
   // extension thread.
   if (!extension_data_map_.empty())
     VLOG(1) << "The ExtensionData map is not empty!";
+
+  for (auto& shared_host : shared_extension_process_hosts_) {
+    BrowserThread::DeleteSoon(BrowserThread::IO, FROM_HERE,
+                              shared_host.second.release());
+  }
+  if (prewarmed_extension_process_host_) {
+    BrowserThread::DeleteSoon(BrowserThread::IO, FROM_HERE,
+                              prewarmed_extension_process_host_.release());
+  }
 }
 
 void XWalkExtensionService::RegisterExternalExtensionsForPath(
     const base::FilePath& path) {
   external_extensions_path_ = path;
+  CreateRegistrySnapshotIfNeeded();
+}
+
+void XWalkExtensionService::SetCodeCachePath(const base::FilePath& path) {
+  code_cache_store_ = new XWalkExtensionCodeCacheStore(path);
+}
+
+void XWalkExtensionService::SetRegistrySnapshotPath(
+    const base::FilePath& path) {
+  registry_snapshot_path_ = path;
+  CreateRegistrySnapshotIfNeeded();
+}
+
+void XWalkExtensionService::CreateRegistrySnapshotIfNeeded() {
+  if (registry_snapshot_path_.empty() || external_extensions_path_.empty())
+    return;
+  // Render processes launched before the snapshot is loaded wait for the
+  // extension process as usual.
+  registry_snapshot_ = new XWalkExtensionRegistrySnapshot(
+      registry_snapshot_path_, external_extensions_path_);
+  BrowserThread::PostTask(BrowserThread::FILE, FROM_HERE,
+      base::Bind(&XWalkExtensionRegistrySnapshot::Load, registry_snapshot_));
 }
 
 void XWalkExtensionService::OnRenderProcessHostCreatedInternal(
@@ -223,11 +257,19 @@ void XWalkExtensionService::OnRenderProcessHostCreatedInternal(
   XWalkExtensionData* data = new XWalkExtensionData;
   data->set_render_process_host(host);
 
+  if (code_cache_store_)
+    host->AddFilter(new XWalkExtensionCodeCacheFilter(code_cache_store_));
+
   CreateInProcessExtensionServers(host, data, ui_thread_extensions,
                                   extension_thread_extensions);
 
   base::CommandLine* cmd_line = base::CommandLine::ForCurrentProcess();
   if (!cmd_line->HasSwitch(switches::kXWalkDisableExtensionProcess)) {
+    // Always added, the render process asks for the snapshot even if there's
+    // none.
+    host->AddFilter(new XWalkExtensionRegistrySnapshotFilter(
+        registry_snapshot_,
+        XWalkExtensionProcessHost::GetRuntimeVariablesKey(*runtime_variables)));
     CreateExtensionProcessHost(host, data, std::move(runtime_variables));
   } else if (!external_extensions_path_.empty()) {
     BrowserThread::PostTask(BrowserThread::FILE, FROM_HERE, base::Bind(
@@ -302,6 +344,8 @@ void XWalkExtensionService::OnRenderProcessHostClosed(
   if (it == extension_data_map_.end())
     return;
 
+  RemoveFromSharedExtensionProcess(host);
+
   XWalkExtensionData* data = it->second;
   extension_data_map_.erase(it);
   delete data;
@@ -336,7 +380,7 @@ void XWalkExtensionService::CreateInProcessExtensionServers(
 
   IPC::ChannelProxy* channel = host->GetChannel();
 
-  extension_thread_server->Initialize(channel);
+  extension_thread_server->Initialize(channel, extension_thread_.task_runner());
   ui_thread_server->Initialize(channel);
 
   RegisterExtensionsIntoServer(extension_thread_extensions,
@@ -373,9 +417,60 @@ void XWalkExtensionService::CreateInProcessExtensionServers(
 void XWalkExtensionService::CreateExtensionProcessHost(
     content::RenderProcessHost* host, XWalkExtensionData* data,
     std::unique_ptr<base::DictionaryValue::Storage> runtime_variables) {
-  data->set_extension_process_host(base::WrapUnique(
-      new XWalkExtensionProcessHost(host, external_extensions_path_, this,
-                                    std::move(runtime_variables))));
+  base::CommandLine* cmd_line = base::CommandLine::ForCurrentProcess();
+  if (cmd_line->HasSwitch(switches::kXWalkSharedExtensionProcess)) {
+    // The extensions are loaded with the runtime variables of the render
+    // process the extension process is launched for, and the permissions
+    // of the application are checked against one of its render processes.
+    // So only render processes with the same variables, which include the
+    // app id, share an extension process.
+    std::string key =
+        XWalkExtensionProcessHost::GetRuntimeVariablesKey(*runtime_variables);
+    std::unique_ptr<XWalkExtensionProcessHost>& shared_host =
+        shared_extension_process_hosts_[key];
+    if (shared_host) {
+      shared_host->AddRenderProcess(host);
+    } else {
+      shared_host.reset(new XWalkExtensionProcessHost(
+          host, external_extensions_path_, this,
+          std::move(runtime_variables)));
+    }
+    shared_extension_process_keys_[host->GetID()] = key;
+    return;
+  }
+
+  std::unique_ptr<XWalkExtensionProcessHost> eph;
+  if (prewarmed_extension_process_host_) {
+    eph = std::move(prewarmed_extension_process_host_);
+    if (eph->runtime_variables_key() ==
+        XWalkExtensionProcessHost::GetRuntimeVariablesKey(*runtime_variables)) {
+      eph->AddRenderProcess(host);
+    } else {
+      BrowserThread::DeleteSoon(BrowserThread::IO, FROM_HERE, eph.release());
+    }
+  }
+
+  if (cmd_line->HasSwitch(switches::kXWalkPrewarmExtensionProcess))
+    PrewarmExtensionProcess(*runtime_variables);
+
+  if (!eph) {
+    eph.reset(new XWalkExtensionProcessHost(host, external_extensions_path_,
+                                            this,
+                                            std::move(runtime_variables)));
+  }
+  data->set_extension_process_host(std::move(eph));
+}
+
+void XWalkExtensionService::PrewarmExtensionProcess(
+    const base::DictionaryValue::Storage& runtime_variables) {
+  // Apps usually launch their render processes with the same runtime
+  // variables, so the next one will most likely be able to use it.
+  std::unique_ptr<base::DictionaryValue::Storage> variables(
+      new base::DictionaryValue::Storage);
+  for (const auto& variable : runtime_variables)
+    (*variables)[variable.first] = base::WrapUnique(variable.second->DeepCopy());
+  prewarmed_extension_process_host_.reset(new XWalkExtensionProcessHost(
+      external_extensions_path_, this, std::move(variables)));
 }
 
 void XWalkExtensionService::OnExtensionProcessDied(
@@ -385,18 +480,47 @@ void XWalkExtensionService::OnExtensionProcessDied(
   // segfault when trying to delete it within
   // XWalkExtensionService::OnRenderProcessHostClosed();
 
+  if (eph == prewarmed_extension_process_host_.get()) {
+    ignore_result(prewarmed_extension_process_host_.release());
+    return;
+  }
+
+  for (SharedExtensionProcessHostMap::iterator shared_host =
+           shared_extension_process_hosts_.begin();
+       shared_host != shared_extension_process_hosts_.end(); ++shared_host) {
+    if (shared_host->second.get() != eph)
+      continue;
+    // Only the render processes it served lose their extensions, the others
+    // use another extension process.
+    std::vector<int> render_process_ids = eph->render_process_ids();
+    ignore_result(shared_host->second.release());
+    shared_extension_process_hosts_.erase(shared_host);
+    for (int id : render_process_ids) {
+      shared_extension_process_keys_.erase(id);
+      RenderProcessToExtensionDataMap::iterator it =
+          extension_data_map_.find(id);
+      if (it != extension_data_map_.end())
+        ShutdownRenderProcessWithoutExtensionProcess(it);
+    }
+    return;
+  }
+
   RenderProcessToExtensionDataMap::iterator it =
       extension_data_map_.find(render_process_id);
 
   if (it == extension_data_map_.end())
     return;
 
-  XWalkExtensionData* data = it->second;
-
   XWalkExtensionProcessHost* stored_eph =
-      data->extension_process_host().release();
+      it->second->extension_process_host().release();
   CHECK_EQ(stored_eph, eph);
 
+  ShutdownRenderProcessWithoutExtensionProcess(it);
+}
+
+void XWalkExtensionService::ShutdownRenderProcessWithoutExtensionProcess(
+    RenderProcessToExtensionDataMap::iterator it) {
+  XWalkExtensionData* data = it->second;
   content::RenderProcessHost* rph = data->render_process_host();
   if (rph) {
     BrowserThread::PostTask(BrowserThread::UI, FROM_HERE, base::Bind(
@@ -416,12 +540,37 @@ void XWalkExtensionService::OnRenderProcessDied(
   if (it == extension_data_map_.end())
     return;
 
+  RemoveFromSharedExtensionProcess(host);
+
   XWalkExtensionData* data = it->second;
 
   extension_data_map_.erase(it);
   delete data;
 }
 
+void XWalkExtensionService::RemoveFromSharedExtensionProcess(
+    content::RenderProcessHost* host) {
+  std::map<int, std::string>::iterator key =
+      shared_extension_process_keys_.find(host->GetID());
+  if (key == shared_extension_process_keys_.end())
+    return;
+  SharedExtensionProcessHostMap::iterator shared_host =
+      shared_extension_process_hosts_.find(key->second);
+  shared_extension_process_keys_.erase(key);
+  if (shared_host == shared_extension_process_hosts_.end())
+    return;
+
+  shared_host->second->RemoveRenderProcess(host->GetID());
+  for (const auto& entry : shared_extension_process_keys_) {
+    if (entry.second == shared_host->first)
+      return;
+  }
+  // The application has no render process left.
+  BrowserThread::DeleteSoon(BrowserThread::IO, FROM_HERE,
+                            shared_host->second.release());
+  shared_extension_process_hosts_.erase(shared_host);
+}
+
 void XWalkExtensionService::OnExtensionProcessCreated(
       int render_process_id,
       const IPC::ChannelHandle channel_handle) {
@@ -429,6 +578,17 @@ void XWalkExtensionService::OnExtensionProcessCreated(
   delegate_->ExtensionProcessCreated(render_process_id, channel_handle);
 }
 
+void XWalkExtensionService::OnExtensionsRegistered(
+    const std::string& runtime_variables_key,
+    const std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams>&
+        extensions) {
+  if (!registry_snapshot_)
+    return;
+  BrowserThread::PostTask(BrowserThread::FILE, FROM_HERE,
+      base::Bind(&XWalkExtensionRegistrySnapshot::Update, registry_snapshot_,
+                 runtime_variables_key, extensions));
+}
+
 void XWalkExtensionService::OnCheckAPIAccessControl(
     int render_process_id,
     const std::string& extension_name,
@@ -32,7 +32,9 @@ namespace xwalk {
 namespace extensions {
 
 class XWalkExtension;
+class XWalkExtensionCodeCacheStore;
 class XWalkExtensionData;
+class XWalkExtensionRegistrySnapshot;
 class XWalkExtensionServer;
 
 // This is the entry point for Crosswalk extensions. Its responsible for keeping
@@ -65,6 +67,15 @@ class XWalkExtensionService : public content::NotificationObserver,
 
   void RegisterExternalExtensionsForPath(const base::FilePath& path);
 
+  // Persists the compiled JS API code of the extensions in |path|, so the
+  // render processes of later launches can reuse it.
+  void SetCodeCachePath(const base::FilePath& path);
+
+  // Keeps in |path| the external extensions registered by the extension
+  // process, so the render processes of later launches can install them
+  // before the extension process finished loading.
+  void SetRegistrySnapshotPath(const base::FilePath& path);
+
   // To be called when a new RenderProcessHost is created, will plug the
   // extension system to that render process. See
   // XWalkContentBrowserClient::RenderProcessWillLaunch().
@@ -94,6 +105,8 @@ class XWalkExtensionService : public content::NotificationObserver,
   static void SetExternalExtensionsPathForTesting(const base::FilePath& path);
 
  private:
+  typedef std::map<int, XWalkExtensionData*> RenderProcessToExtensionDataMap;
+
   void OnRenderProcessHostCreatedInternal(
       content::RenderProcessHost* host,
       XWalkExtensionVector* ui_thread_extensions,
@@ -108,6 +121,11 @@ class XWalkExtensionService : public content::NotificationObserver,
       int render_process_id,
       const IPC::ChannelHandle handle) override;
 
+  void OnExtensionsRegistered(
+      const std::string& runtime_variables_key,
+      const std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams>&
+          extensions) override;
+
   void OnCheckAPIAccessControl(
       int render_process_id,
       const std::string& extension_name,
@@ -132,6 +150,20 @@ class XWalkExtensionService : public content::NotificationObserver,
   void CreateExtensionProcessHost(content::RenderProcessHost* host,
       XWalkExtensionData* data, std::unique_ptr<base::DictionaryValue::Storage> runtime_variables);
 
+  void RemoveFromSharedExtensionProcess(content::RenderProcessHost* host);
+
+  // Shuts down the render process of |it| once its extension process is
+  // gone, as it can't use its external extensions anymore.
+  void ShutdownRenderProcessWithoutExtensionProcess(
+      RenderProcessToExtensionDataMap::iterator it);
+
+  // Launches an extension process with |runtime_variables| before a render
+  // process needs it, see --xwalk-prewarm-extension-process.
+  void PrewarmExtensionProcess(
+      const base::DictionaryValue::Storage& runtime_variables);
+
+  void CreateRegistrySnapshotIfNeeded();
+
   // The server that handles in process extensions will live in the
   // extension_thread_.
   base::Thread extension_thread_;
@@ -142,7 +174,26 @@ class XWalkExtensionService : public content::NotificationObserver,
 
   base::FilePath external_extensions_path_;
 
-  typedef std::map<int, XWalkExtensionData*> RenderProcessToExtensionDataMap;
+  scoped_refptr<XWalkExtensionCodeCacheStore> code_cache_store_;
+
+  base::FilePath registry_snapshot_path_;
+  scoped_refptr<XWalkExtensionRegistrySnapshot> registry_snapshot_;
+
+  // When the extension process is shared, one serves all the render
+  // processes with the same runtime variables, i.e. of the same application.
+  // Keyed by XWalkExtensionProcessHost::GetRuntimeVariablesKey(), created
+  // with the first render process and deleted in the IO thread once the last
+  // one is gone.
+  typedef std::map<std::string, std::unique_ptr<XWalkExtensionProcessHost>>
+      SharedExtensionProcessHostMap;
+  SharedExtensionProcessHostMap shared_extension_process_hosts_;
+  // The key of the shared extension process of each render process.
+  std::map<int, std::string> shared_extension_process_keys_;
+
+  // Handed to the next render process whose runtime variables match the ones
+  // it was launched with. Deleted in the IO thread.
+  std::unique_ptr<XWalkExtensionProcessHost> prewarmed_extension_process_host_;
+
   RenderProcessToExtensionDataMap extension_data_map_;
 
   DISALLOW_COPY_AND_ASSIGN(XWalkExtensionService);
@@ -55,10 +55,41 @@ void XWalkExtensionInstance::SetSendSyncReplyCallback(
   send_sync_reply_ = callback;
 }
 
+void XWalkExtensionInstance::SetSendReplyCallback(
+    const SendReplyCallback& callback) {
+  send_reply_ = callback;
+}
+
+void XWalkExtensionInstance::SetPostSharedBufferCallback(
+    const PostSharedBufferCallback& callback) {
+  post_shared_buffer_ = callback;
+}
+
+void XWalkExtensionInstance::SetDropSharedBufferCallback(
+    const DropSharedBufferCallback& callback) {
+  drop_shared_buffer_ = callback;
+}
+
 void XWalkExtensionInstance::HandleSyncMessage(
     std::unique_ptr<base::Value> msg) {
   LOG(FATAL) << "Sending sync message to extension which doesn't support it!";
 }
 
+void XWalkExtensionInstance::HandleMessageWithReply(
+    int32_t request_id, std::unique_ptr<base::Value> msg) {
+  LOG(WARNING) << "Sending message with reply to extension which doesn't "
+               << "support it!";
+  SendReplyToJS(request_id, nullptr);
+}
+
+void XWalkExtensionInstance::HandleEncodedMessage(
+    const std::vector<char>& msg) {
+  LOG(WARNING) << "Sending encoded message to extension which doesn't "
+               << "support it!";
+}
+
+void XWalkExtensionInstance::HandleSharedBufferReleased(int32_t buffer_id) {
+}
+
 }  // namespace extensions
 }  // namespace xwalk
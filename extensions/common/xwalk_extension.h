@@ -5,11 +5,16 @@
 #ifndef XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_H_
 #define XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_H_
 
+#include <stdint.h>
 #include <string>
 #include <vector>
 #include "base/callback.h"
 #include "base/values.h"
 
+namespace base {
+class SharedMemory;
+}
+
 namespace xwalk {
 namespace extensions {
 
@@ -110,15 +115,41 @@ class XWalkExtensionInstance {
   // can be sent after HandleSyncMessage() function returns.
   virtual void HandleSyncMessage(std::unique_ptr<base::Value> msg);
 
+  // Allow to handle messages sent from JavaScript code that expect a reply,
+  // without blocking the renderer. Many requests can be pending at the same
+  // time, each one must eventually be answered by calling SendReplyToJS()
+  // with its |request_id|. The default implementation fails the request.
+  virtual void HandleMessageWithReply(int32_t request_id,
+                                      std::unique_ptr<base::Value> msg);
+
+  // Allow to handle messages posted with extension.postEncodedMessage(), in
+  // the format described in XW_Extension_EncodedMessage.h. The default
+  // implementation drops them.
+  virtual void HandleEncodedMessage(const std::vector<char>& msg);
+
+  // Called when JavaScript drops the last reference to a shared buffer posted
+  // with PostSharedBufferToJS(), so the buffer can be reused.
+  virtual void HandleSharedBufferReleased(int32_t buffer_id);
+
   // Callbacks used by extension instance to communicate back to JS. These are
   // set by the extension system. Callbacks will take the ownership of the
   // message.
   typedef base::Callback<void(std::unique_ptr<base::Value> msg)> PostMessageCallback;
   typedef base::Callback<void(std::unique_ptr<base::Value> msg)>
       SendSyncReplyCallback;
+  typedef base::Callback<void(int32_t request_id,
+                              std::unique_ptr<base::Value> reply)>
+      SendReplyCallback;
+  typedef base::Callback<void(int32_t buffer_id,
+                              base::SharedMemory* unshared_memory,
+                              size_t size)> PostSharedBufferCallback;
+  typedef base::Callback<void(int32_t buffer_id)> DropSharedBufferCallback;
 
   void SetPostMessageCallback(const PostMessageCallback& callback);
   void SetSendSyncReplyCallback(const SendSyncReplyCallback& callback);
+  void SetSendReplyCallback(const SendReplyCallback& callback);
+  void SetPostSharedBufferCallback(const PostSharedBufferCallback& callback);
+  void SetDropSharedBufferCallback(const DropSharedBufferCallback& callback);
 
   // Function to be used by extensions Instances to post messages back to
   // JavaScript in the renderer process. This function will take the ownership
@@ -135,9 +166,33 @@ class XWalkExtensionInstance {
     send_sync_reply_.Run(std::move(reply));
   }
 
+  // Settles the Promise of a message received by HandleMessageWithReply().
+  // A NULL |reply| rejects it. Can be called from any thread.
+  void SendReplyToJS(int32_t request_id, std::unique_ptr<base::Value> reply) {
+    send_reply_.Run(request_id, std::move(reply));
+  }
+
+  // Hands the first |size| bytes of a shared buffer to JavaScript without
+  // copying. |unshared_memory| must be set the first time a buffer is posted,
+  // so its handle can be sent to the renderer, and be NULL afterwards.
+  void PostSharedBufferToJS(int32_t buffer_id,
+                            base::SharedMemory* unshared_memory,
+                            size_t size) {
+    post_shared_buffer_.Run(buffer_id, unshared_memory, size);
+  }
+
+  // Tells the renderer that a shared buffer won't be posted anymore, so it
+  // can release its mapping.
+  void DropSharedBufferFromJS(int32_t buffer_id) {
+    drop_shared_buffer_.Run(buffer_id);
+  }
+
  private:
   PostMessageCallback post_message_;
   SendSyncReplyCallback send_sync_reply_;
+  SendReplyCallback send_reply_;
+  PostSharedBufferCallback post_shared_buffer_;
+  DropSharedBufferCallback drop_shared_buffer_;
 
   DISALLOW_COPY_AND_ASSIGN(XWalkExtensionInstance);
 };
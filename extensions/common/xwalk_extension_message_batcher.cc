@@ -0,0 +1,108 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_extension_message_batcher.h"
+
+#include <utility>
+
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/metrics/histogram.h"
+#include "base/trace_event/trace_event.h"
+
+namespace xwalk {
+namespace extensions {
+
+XWalkExtensionMessageBatcher::Batch::Batch()
+    : generation(0) {}
+
+XWalkExtensionMessageBatcher::Batch::~Batch() {}
+
+XWalkExtensionMessageBatcher::XWalkExtensionMessageBatcher(
+    scoped_refptr<base::SingleThreadTaskRunner> task_runner,
+    base::TimeDelta window, size_t max_messages,
+    const FlushCallback& flush_callback)
+    : task_runner_(task_runner),
+      window_(window),
+      max_messages_(max_messages),
+      flush_callback_(flush_callback) {
+  DCHECK_GT(max_messages_, 0u);
+}
+
+XWalkExtensionMessageBatcher::~XWalkExtensionMessageBatcher() {}
+
+void XWalkExtensionMessageBatcher::AddMessage(
+    int64_t instance_id, std::unique_ptr<base::Value> msg) {
+  base::AutoLock l(lock_);
+  if (flush_callback_.is_null())
+    return;
+
+  Batch& batch = batches_[instance_id];
+  bool was_empty = batch.messages.empty();
+  if (was_empty)
+    batch.first_message_time = base::TimeTicks::Now();
+  batch.messages.Append(msg.release());
+
+  if (batch.messages.GetSize() >= max_messages_) {
+    FlushLocked(instance_id, &batch);
+    return;
+  }
+
+  if (was_empty) {
+    task_runner_->PostDelayedTask(
+        FROM_HERE,
+        base::Bind(&XWalkExtensionMessageBatcher::OnWindowExpired,
+                   this, instance_id, batch.generation),
+        window_);
+  }
+}
+
+void XWalkExtensionMessageBatcher::Flush(int64_t instance_id) {
+  base::AutoLock l(lock_);
+  std::map<int64_t, Batch>::iterator it = batches_.find(instance_id);
+  if (it != batches_.end())
+    FlushLocked(instance_id, &it->second);
+}
+
+void XWalkExtensionMessageBatcher::Discard(int64_t instance_id) {
+  base::AutoLock l(lock_);
+  batches_.erase(instance_id);
+}
+
+void XWalkExtensionMessageBatcher::Invalidate() {
+  base::AutoLock l(lock_);
+  flush_callback_.Reset();
+  batches_.clear();
+}
+
+void XWalkExtensionMessageBatcher::OnWindowExpired(int64_t instance_id,
+                                                   uint32_t generation) {
+  base::AutoLock l(lock_);
+  std::map<int64_t, Batch>::iterator it = batches_.find(instance_id);
+  if (it == batches_.end() || it->second.generation != generation)
+    return;
+  FlushLocked(instance_id, &it->second);
+}
+
+void XWalkExtensionMessageBatcher::FlushLocked(int64_t instance_id,
+                                               Batch* batch) {
+  lock_.AssertAcquired();
+  if (batch->messages.empty() || flush_callback_.is_null())
+    return;
+
+  size_t batch_size = batch->messages.GetSize();
+  base::TimeDelta delay = base::TimeTicks::Now() - batch->first_message_time;
+  UMA_HISTOGRAM_COUNTS_1000("XWalk.Extensions.MessageBatchSize", batch_size);
+  UMA_HISTOGRAM_TIMES("XWalk.Extensions.MessageBatchDelay", delay);
+  TRACE_EVENT2("xwalk", "XWalkExtensionMessageBatcher::Flush",
+               "messages", batch_size,
+               "delay_us", delay.InMicroseconds());
+
+  flush_callback_.Run(instance_id, batch->messages);
+  batch->messages.Clear();
+  batch->generation++;
+}
+
+}  // namespace extensions
+}  // namespace xwalk
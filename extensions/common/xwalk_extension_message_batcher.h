@@ -0,0 +1,85 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_MESSAGE_BATCHER_H_
+#define XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_MESSAGE_BATCHER_H_
+
+#include <stdint.h>
+#include <map>
+#include <memory>
+
+#include "base/callback.h"
+#include "base/memory/ref_counted.h"
+#include "base/single_thread_task_runner.h"
+#include "base/synchronization/lock.h"
+#include "base/time/time.h"
+#include "base/values.h"
+
+namespace xwalk {
+namespace extensions {
+
+// Coalesces the messages each instance posts to JS during a time window into
+// a single batch, so chatty extensions pay for one IPC and one trip into V8
+// per batch instead of per message. A batch is flushed when the window
+// expires, when it reaches |max_messages|, or when Flush() is called to keep
+// ordering with messages that are not batched.
+//
+// Messages can be added from any thread. The flush callback is run with the
+// internal lock held, which guarantees batches are sent in order.
+class XWalkExtensionMessageBatcher
+    : public base::RefCountedThreadSafe<XWalkExtensionMessageBatcher> {
+ public:
+  typedef base::Callback<void(int64_t instance_id,
+                              const base::ListValue& messages)> FlushCallback;
+
+  XWalkExtensionMessageBatcher(
+      scoped_refptr<base::SingleThreadTaskRunner> task_runner,
+      base::TimeDelta window, size_t max_messages,
+      const FlushCallback& flush_callback);
+
+  void AddMessage(int64_t instance_id, std::unique_ptr<base::Value> msg);
+
+  // Sends the pending messages of |instance_id| right away.
+  void Flush(int64_t instance_id);
+
+  // Drops the pending messages of |instance_id|.
+  void Discard(int64_t instance_id);
+
+  // Stops calling the flush callback. Pending messages are dropped.
+  void Invalidate();
+
+ private:
+  friend class base::RefCountedThreadSafe<XWalkExtensionMessageBatcher>;
+
+  struct Batch {
+    Batch();
+    ~Batch();
+
+    base::ListValue messages;
+    base::TimeTicks first_message_time;
+    // Bumped on every flush, so a pending window task knows whether it
+    // still refers to the current batch.
+    uint32_t generation;
+  };
+
+  ~XWalkExtensionMessageBatcher();
+
+  void OnWindowExpired(int64_t instance_id, uint32_t generation);
+  void FlushLocked(int64_t instance_id, Batch* batch);
+
+  scoped_refptr<base::SingleThreadTaskRunner> task_runner_;
+  base::TimeDelta window_;
+  size_t max_messages_;
+
+  base::Lock lock_;
+  FlushCallback flush_callback_;
+  std::map<int64_t, Batch> batches_;
+
+  DISALLOW_COPY_AND_ASSIGN(XWalkExtensionMessageBatcher);
+};
+
+}  // namespace extensions
+}  // namespace xwalk
+
+#endif  // XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_MESSAGE_BATCHER_H_
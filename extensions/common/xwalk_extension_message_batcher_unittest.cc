@@ -0,0 +1,99 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_extension_message_batcher.h"
+
+#include <vector>
+
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/memory/ptr_util.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using xwalk::extensions::XWalkExtensionMessageBatcher;
+
+namespace {
+
+struct Flushed {
+  int64_t instance_id;
+  std::vector<int> messages;
+};
+
+void RecordBatch(std::vector<Flushed>* batches, int64_t instance_id,
+                 const base::ListValue& messages) {
+  Flushed flushed;
+  flushed.instance_id = instance_id;
+  for (size_t i = 0; i < messages.GetSize(); ++i) {
+    int value;
+    EXPECT_TRUE(messages.GetInteger(i, &value));
+    flushed.messages.push_back(value);
+  }
+  batches->push_back(flushed);
+}
+
+std::unique_ptr<base::Value> Message(int value) {
+  return base::WrapUnique(new base::FundamentalValue(value));
+}
+
+}  // namespace
+
+TEST(XWalkExtensionMessageBatcherTest, FlushesFullBatches) {
+  base::MessageLoop loop;
+  std::vector<Flushed> batches;
+  scoped_refptr<XWalkExtensionMessageBatcher> batcher(
+      new XWalkExtensionMessageBatcher(
+          base::ThreadTaskRunnerHandle::Get(), base::TimeDelta::FromDays(1), 2,
+          base::Bind(&RecordBatch, &batches)));
+
+  batcher->AddMessage(1, Message(1));
+  batcher->AddMessage(2, Message(10));
+  EXPECT_TRUE(batches.empty());
+
+  batcher->AddMessage(1, Message(2));
+  ASSERT_EQ(1u, batches.size());
+  EXPECT_EQ(1, batches[0].instance_id);
+  EXPECT_EQ(std::vector<int>({1, 2}), batches[0].messages);
+
+  // Explicit flushes only send the given instance.
+  batcher->Flush(2);
+  ASSERT_EQ(2u, batches.size());
+  EXPECT_EQ(2, batches[1].instance_id);
+  EXPECT_EQ(std::vector<int>({10}), batches[1].messages);
+
+  batcher->Flush(1);
+  EXPECT_EQ(2u, batches.size());
+}
+
+TEST(XWalkExtensionMessageBatcherTest, FlushesWhenWindowExpires) {
+  base::MessageLoop loop;
+  std::vector<Flushed> batches;
+  scoped_refptr<XWalkExtensionMessageBatcher> batcher(
+      new XWalkExtensionMessageBatcher(
+          base::ThreadTaskRunnerHandle::Get(),
+          base::TimeDelta::FromMilliseconds(1), 100,
+          base::Bind(&RecordBatch, &batches)));
+
+  batcher->AddMessage(1, Message(1));
+  batcher->AddMessage(1, Message(2));
+  batcher->AddMessage(3, Message(3));
+  batcher->Discard(3);
+
+  base::RunLoop run_loop;
+  base::ThreadTaskRunnerHandle::Get()->PostDelayedTask(
+      FROM_HERE, run_loop.QuitClosure(), base::TimeDelta::FromMilliseconds(20));
+  run_loop.Run();
+
+  ASSERT_EQ(1u, batches.size());
+  EXPECT_EQ(1, batches[0].instance_id);
+  EXPECT_EQ(std::vector<int>({1, 2}), batches[0].messages);
+
+  // Nothing is sent once invalidated.
+  batcher->AddMessage(1, Message(4));
+  batcher->Invalidate();
+  batcher->Flush(1);
+  EXPECT_EQ(1u, batches.size());
+}
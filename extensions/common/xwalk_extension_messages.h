@@ -26,21 +26,50 @@ enum {
 
 #define IPC_MESSAGE_START XWalkExtensionMsgStart
 
+IPC_STRUCT_BEGIN(XWalkExtensionServerMsg_ExtensionRegisterParams)
+  IPC_STRUCT_MEMBER(std::string, name)
+  IPC_STRUCT_MEMBER(std::string, js_api)
+  IPC_STRUCT_MEMBER(std::vector<std::string>, entry_points)
+IPC_STRUCT_END()
+
 IPC_MESSAGE_CONTROL2(XWalkExtensionProcessMsg_RegisterExtensions,  // NOLINT(*)
                      base::FilePath /* extensions path */,
                      base::ListValue /* browser variables */)
 
+// Asks the Extension Process for a channel to serve a Render Process. Sent
+// after RegisterExtensions, once per Render Process using the Extension
+// Process, which can be more than one when it is shared.
+IPC_MESSAGE_CONTROL1(XWalkExtensionProcessMsg_CreateRenderProcessChannel,  // NOLINT(*)
+                     int /* render process id */)
+
+// The Render Process is gone, its channel and instances can be destroyed.
+IPC_MESSAGE_CONTROL1(XWalkExtensionProcessMsg_CloseRenderProcessChannel,  // NOLINT(*)
+                     int /* render process id */)
+
 // This implies that extensions are all loaded and Extension Process
-// is ready to be used.
-IPC_MESSAGE_CONTROL1(XWalkExtensionProcessHostMsg_RenderProcessChannelCreated, // NOLINT(*)
+// is ready to be used by the Render Process.
+IPC_MESSAGE_CONTROL2(XWalkExtensionProcessHostMsg_RenderProcessChannelCreated, // NOLINT(*)
+                     int /* render process id */,
                      IPC::ChannelHandle /* channel id */)
 
+// Sent by the Extension Process once the external extensions are loaded, so
+// the Browser Process can keep a snapshot of them for the next launches.
+IPC_MESSAGE_CONTROL1(XWalkExtensionProcessHostMsg_ExtensionsRegistered,  // NOLINT(*)
+                     std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams>) // NOLINT(*)
+
 // Message from Render Process to Browser Process. This message needs
 // to be synchronous because Render Process cannot load anything without having
 // collected the extensions loaded in Extension Process.
 IPC_SYNC_MESSAGE_CONTROL0_1(XWalkExtensionProcessHostMsg_GetExtensionProcessChannel,  // NOLINT(*)
                             IPC::ChannelHandle /* channel id */)
 
+// Message from Render Process to Browser Process asking for the external
+// extensions registered by a previous launch, replied right away. When the
+// reply isn't empty the Render Process only asks for the Extension Process
+// channel when an external extension is first used.
+IPC_SYNC_MESSAGE_CONTROL0_1(XWalkExtensionHostMsg_GetExternalExtensionsSnapshot,  // NOLINT(*)
+                            std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams>) // NOLINT(*)
+
 // Message from Extension Process to Browser Process
 IPC_ENUM_TRAITS_MAX_VALUE(xwalk::extensions::RuntimePermission,
                           xwalk::extensions::UNDEFINED_RUNTIME_PERM)
@@ -53,17 +82,31 @@ IPC_SYNC_MESSAGE_CONTROL2_1(XWalkExtensionProcessHostMsg_RegisterPermissions, //
                             std::string,
                             bool)
 
+// V8 code cache of the JS API code of an extension, see
+// XWalkExtensionCodeCache.
+IPC_STRUCT_BEGIN(XWalkExtensionMsg_CodeCacheEntry)
+  IPC_STRUCT_MEMBER(std::string, name)
+  IPC_STRUCT_MEMBER(std::string, code_hash)
+  IPC_STRUCT_MEMBER(std::string, data)
+IPC_STRUCT_END()
+
+// Message from Browser Process to Render Process with the code cache
+// persisted by previous launches.
+IPC_MESSAGE_CONTROL1(XWalkExtensionMsg_SetCodeCache,  // NOLINT(*)
+                     std::vector<XWalkExtensionMsg_CodeCacheEntry>)
+
+// Message from Render Process to Browser Process when code cache was
+// produced for an extension, so it can be persisted.
+IPC_MESSAGE_CONTROL3(XWalkExtensionHostMsg_StoreCodeCache,  // NOLINT(*)
+                     std::string /* extension name */,
+                     std::string /* code hash */,
+                     std::string /* data */)
+
 // We use a separated message class for Client<->Server communication
 // to ease filtering.
 #undef IPC_MESSAGE_START
 #define IPC_MESSAGE_START XWalkExtensionClientServerMsgStart
 
-IPC_STRUCT_BEGIN(XWalkExtensionServerMsg_ExtensionRegisterParams)
-  IPC_STRUCT_MEMBER(std::string, name)
-  IPC_STRUCT_MEMBER(std::string, js_api)
-  IPC_STRUCT_MEMBER(std::vector<std::string>, entry_points)
-IPC_STRUCT_END()
-
 IPC_MESSAGE_CONTROL2(XWalkExtensionServerMsg_CreateInstance,  // NOLINT(*)
                      int64_t /* instance id */,
                      std::string /* extension name */)
@@ -72,14 +115,76 @@ IPC_MESSAGE_CONTROL2(XWalkExtensionServerMsg_PostMessageToNative,  // NOLINT(*)
                      int64_t /* instance id */,
                      base::ListValue /* contents */)
 
+// Message posted with extension.postEncodedMessage(), see
+// XW_Extension_EncodedMessage.h. It has its own message so the native side
+// never confuses it with an ArrayBuffer posted with PostMessageToNative.
+IPC_MESSAGE_CONTROL2(XWalkExtensionServerMsg_PostEncodedMessageToNative,  // NOLINT(*)
+                     int64_t /* instance id */,
+                     std::vector<char> /* encoded contents */)
+
 IPC_MESSAGE_CONTROL2(XWalkExtensionClientMsg_PostMessageToJS,  // NOLINT(*)
                      int64_t /* instance id */,
                      base::ListValue /* contents */)
 
+// Messages posted by an instance within the batch window, in posting order.
+// Only sent when batching is enabled, see XWalkExtensionMessageBatcher.
+IPC_MESSAGE_CONTROL2(XWalkExtensionClientMsg_PostMessageBatchToJS,  // NOLINT(*)
+                     int64_t /* instance id */,
+                     base::ListValue /* messages */)
+
 IPC_MESSAGE_CONTROL2(XWalkExtensionClientMsg_PostOutOfLineMessageToJS,  // NOLINT(*)
                      base::SharedMemoryHandle /* message buffer */,
                      uint64_t /* buffer size */)
 
+// Out of line message carried by a segment of the server's pool. As with
+// shared buffers, the handle is only valid the first time a segment is used.
+// The client acknowledges the message with ReleaseOutOfLineSegment once it
+// was dispatched, so the segment can be filled again.
+IPC_MESSAGE_CONTROL5(XWalkExtensionClientMsg_PostPooledOutOfLineMessageToJS,  // NOLINT(*)
+                     int64_t /* instance id */,
+                     int32_t /* segment id */,
+                     base::SharedMemoryHandle /* segment handle */,
+                     uint64_t /* segment capacity */,
+                     uint64_t /* message size */)
+
+IPC_MESSAGE_CONTROL1(XWalkExtensionClientMsg_DropOutOfLineSegment,  // NOLINT(*)
+                     int32_t /* segment id */)
+
+IPC_MESSAGE_CONTROL2(XWalkExtensionServerMsg_ReleaseOutOfLineSegment,  // NOLINT(*)
+                     int64_t /* instance id */,
+                     int32_t /* segment id */)
+
+// Hands a buffer from an instance's shared buffer pool to JS. The handle is
+// only valid the first time a given buffer id is posted, afterwards the
+// renderer reuses the mapping it already has.
+IPC_MESSAGE_CONTROL5(XWalkExtensionClientMsg_PostSharedBufferToJS,  // NOLINT(*)
+                     int64_t /* instance id */,
+                     int32_t /* buffer id */,
+                     base::SharedMemoryHandle /* buffer handle */,
+                     uint64_t /* buffer capacity */,
+                     uint64_t /* message size */)
+
+IPC_MESSAGE_CONTROL2(XWalkExtensionClientMsg_DropSharedBuffer,  // NOLINT(*)
+                     int64_t /* instance id */,
+                     int32_t /* buffer id */)
+
+IPC_MESSAGE_CONTROL2(XWalkExtensionServerMsg_ReleaseSharedBuffer,  // NOLINT(*)
+                     int64_t /* instance id */,
+                     int32_t /* buffer id */)
+
+// Asynchronous counterpart of SendSyncMessageToNative. The renderer picks
+// |request id|, unique per instance, and the reply carries it back. An empty
+// reply means the request failed.
+IPC_MESSAGE_CONTROL3(XWalkExtensionServerMsg_SendMessageWithReplyToNative,  // NOLINT(*)
+                     int64_t /* instance id */,
+                     int32_t /* request id */,
+                     base::ListValue /* contents */)
+
+IPC_MESSAGE_CONTROL3(XWalkExtensionClientMsg_ReplyToJS,  // NOLINT(*)
+                     int64_t /* instance id */,
+                     int32_t /* request id */,
+                     base::ListValue /* reply */)
+
 IPC_SYNC_MESSAGE_CONTROL2_1(XWalkExtensionServerMsg_SendSyncMessageToNative,  // NOLINT(*)
                             int64_t /* instance id */,
                             base::ListValue /* input contents */,
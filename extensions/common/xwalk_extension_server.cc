@@ -4,17 +4,30 @@
 
 #include "xwalk/extensions/common/xwalk_extension_server.h"
 
+#include <algorithm>
+#include <deque>
+
+#include "base/command_line.h"
 #include "base/files/file_enumerator.h"
 #include "base/files/file_path.h"
 #include "base/files/file_util.h"
+#include "base/memory/ptr_util.h"
 #include "base/memory/shared_memory.h"
 #include "base/strings/string16.h"
+#include "base/strings/string_number_conversions.h"
 #include "base/strings/utf_string_conversions.h"
 #include "base/stl_util.h"
+#include "base/sys_info.h"
+#include "base/synchronization/condition_variable.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/simple_thread.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "base/time/time.h"
 #include "content/public/browser/render_process_host.h"
 #include "ipc/ipc_message.h"
 #include "ipc/ipc_sender.h"
 #include "xwalk/extensions/common/xwalk_extension_messages.h"
+#include "xwalk/extensions/common/xwalk_extension_switches.h"
 #include "xwalk/extensions/common/xwalk_external_extension.h"
 
 namespace xwalk {
@@ -23,13 +36,26 @@ namespace extensions {
 // Threshold to determine using shared memory or message
 const size_t kInlineMessageMaxSize = 256 * 1024;
 
+// Out of line messages are usually sent one after the other, a few segments
+// are enough to keep the client busy while the next message is being copied.
+const size_t kMaxOutOfLineSegments = 4;
+const size_t kMaxIdleOutOfLineSegments = 2;
+
+// Default for --xwalk-extension-message-batch-size.
+const size_t kDefaultMessageBatchSize = 64;
+
 XWalkExtensionServer::XWalkExtensionServer()
     : channel_proxy_(NULL),
-      permissions_delegate_(NULL) {}
+      owns_extensions_(true),
+      permissions_delegate_(NULL),
+      out_of_line_pool_(kMaxOutOfLineSegments, kMaxIdleOutOfLineSegments) {}
 
 XWalkExtensionServer::~XWalkExtensionServer() {
+  if (message_batcher_)
+    message_batcher_->Invalidate();
   DeleteInstanceMap();
-  STLDeleteValues(&extensions_);
+  if (owns_extensions_)
+    STLDeleteValues(&extensions_);
 }
 
 bool XWalkExtensionServer::OnMessageReceived(const IPC::Message& message) {
@@ -41,11 +67,19 @@ bool XWalkExtensionServer::OnMessageReceived(const IPC::Message& message) {
         OnDestroyInstance)
     IPC_MESSAGE_HANDLER(XWalkExtensionServerMsg_PostMessageToNative,
         OnPostMessageToNative)
+    IPC_MESSAGE_HANDLER(XWalkExtensionServerMsg_PostEncodedMessageToNative,
+        OnPostEncodedMessageToNative)
     IPC_MESSAGE_HANDLER_DELAY_REPLY(
         XWalkExtensionServerMsg_SendSyncMessageToNative,
         OnSendSyncMessageToNative)
+    IPC_MESSAGE_HANDLER(XWalkExtensionServerMsg_SendMessageWithReplyToNative,
+        OnSendMessageWithReplyToNative)
     IPC_MESSAGE_HANDLER(XWalkExtensionServerMsg_GetExtensions,
         OnGetExtensions)
+    IPC_MESSAGE_HANDLER(XWalkExtensionServerMsg_ReleaseSharedBuffer,
+        OnReleaseSharedBuffer)
+    IPC_MESSAGE_HANDLER(XWalkExtensionServerMsg_ReleaseOutOfLineSegment,
+        OnReleaseOutOfLineSegment)
     IPC_MESSAGE_UNHANDLED(handled = false)
   IPC_END_MESSAGE_MAP()
 
@@ -77,6 +111,18 @@ void XWalkExtensionServer::OnCreateInstance(int64_t instance_id,
       base::Bind(&XWalkExtensionServer::SendSyncReplyToJSCallback,
                  base::Unretained(this), instance_id));
 
+  instance->SetSendReplyCallback(
+      base::Bind(&XWalkExtensionServer::SendReplyToJSCallback,
+                 base::Unretained(this), instance_id));
+
+  instance->SetPostSharedBufferCallback(
+      base::Bind(&XWalkExtensionServer::PostSharedBufferToJSCallback,
+                 base::Unretained(this), instance_id));
+
+  instance->SetDropSharedBufferCallback(
+      base::Bind(&XWalkExtensionServer::DropSharedBufferCallback,
+                 base::Unretained(this), instance_id));
+
   InstanceExecutionData data;
   data.instance = instance;
   data.pending_reply = NULL;
@@ -106,10 +152,50 @@ void XWalkExtensionServer::OnPostMessageToNative(int64_t instance_id,
   data.instance->HandleMessage(std::move(value));
 }
 
+void XWalkExtensionServer::OnPostEncodedMessageToNative(
+    int64_t instance_id, const std::vector<char>& msg) {
+  InstanceMap::const_iterator it = instances_.find(instance_id);
+  if (it == instances_.end()) {
+    LOG(WARNING) << "Can't PostEncodedMessage to invalid Extension instance "
+                 << "id: " << instance_id;
+    return;
+  }
+
+  it->second.instance->HandleEncodedMessage(msg);
+}
+
 void XWalkExtensionServer::Initialize(IPC::ChannelProxy* channelProxy) {
+  Initialize(channelProxy, base::ThreadTaskRunnerHandle::Get());
+}
+
+void XWalkExtensionServer::Initialize(
+    IPC::ChannelProxy* channelProxy,
+    scoped_refptr<base::SingleThreadTaskRunner> task_runner) {
   base::AutoLock l(channel_proxy_lock_);
   DCHECK(!channel_proxy_);
   channel_proxy_ = channelProxy;
+
+  const base::CommandLine& cmd_line = *base::CommandLine::ForCurrentProcess();
+  int window_ms;
+  if (!cmd_line.HasSwitch(switches::kXWalkExtensionMessageBatchWindow) ||
+      !base::StringToInt(cmd_line.GetSwitchValueASCII(
+          switches::kXWalkExtensionMessageBatchWindow), &window_ms) ||
+      window_ms <= 0)
+    return;
+
+  unsigned max_messages;
+  if (!base::StringToUint(cmd_line.GetSwitchValueASCII(
+          switches::kXWalkExtensionMessageBatchSize), &max_messages) ||
+      max_messages == 0)
+    max_messages = kDefaultMessageBatchSize;
+
+  // Batches are flushed from the server's own thread, whatever thread
+  // initialized it.
+  message_batcher_ = new XWalkExtensionMessageBatcher(
+      task_runner,
+      base::TimeDelta::FromMilliseconds(window_ms), max_messages,
+      base::Bind(&XWalkExtensionServer::PostMessageBatchToJS,
+                 base::Unretained(this)));
 }
 
 bool XWalkExtensionServer::Send(IPC::Message* msg) {
@@ -154,6 +240,7 @@ bool ValidateExtensionIdentifier(const std::string& name) {
 
 bool XWalkExtensionServer::RegisterExtension(
     std::unique_ptr<XWalkExtension> extension) {
+  DCHECK(owns_extensions_);
   if (!ValidateExtensionIdentifier(extension->name())) {
     LOG(WARNING) << "Ignoring extension with invalid name: "
                  << extension->name();
@@ -189,18 +276,46 @@ bool XWalkExtensionServer::ContainsExtension(
   return ContainsKey(extensions_, extension_name);
 }
 
+void XWalkExtensionServer::UseExtensionsFrom(
+    const XWalkExtensionServer& other) {
+  DCHECK(extensions_.empty());
+  extensions_ = other.extensions_;
+  extension_symbols_ = other.extension_symbols_;
+  owns_extensions_ = false;
+}
+
 void XWalkExtensionServer::PostMessageToJSCallback(
     int64_t instance_id, std::unique_ptr<base::Value> msg) {
+  if (message_batcher_) {
+    message_batcher_->AddMessage(instance_id, std::move(msg));
+    return;
+  }
+
   base::ListValue wrapped_msg;
   wrapped_msg.Append(msg.release());
+  SendToJS(instance_id, base::WrapUnique(
+      new XWalkExtensionClientMsg_PostMessageToJS(instance_id, wrapped_msg)));
+}
 
-  std::unique_ptr<IPC::Message> message(
-      new XWalkExtensionClientMsg_PostMessageToJS(instance_id, wrapped_msg));
+void XWalkExtensionServer::PostMessageBatchToJS(
+    int64_t instance_id, const base::ListValue& messages) {
+  SendToJS(instance_id, base::WrapUnique(
+      new XWalkExtensionClientMsg_PostMessageBatchToJS(instance_id,
+                                                       messages)));
+}
+
+void XWalkExtensionServer::SendToJS(int64_t instance_id,
+                                    std::unique_ptr<IPC::Message> message) {
   if (message->size() <= kInlineMessageMaxSize) {
     Send(message.release());
     return;
   }
 
+  if (PostPooledOutOfLineMessage(instance_id, *message))
+    return;
+
+  // Every segment is still in use by the client, fallback to a one-shot
+  // shared memory.
   base::SharedMemoryCreateOptions options;
   options.size = message->size();
   options.share_read_only = true;
@@ -214,10 +329,7 @@ void XWalkExtensionServer::PostMessageToJSCallback(
   memcpy(shared_memory.memory(), message->data(), message->size());
 
   base::SharedMemoryHandle handle;
-  base::Process process =
-      base::Process::OpenWithExtraPrivileges(channel_proxy_->GetPeerPID());
-  CHECK(process.IsValid());
-  if (!shared_memory.GiveReadOnlyToProcess(process.Handle(), &handle)) {
+  if (!ShareMemoryWithPeer(&shared_memory, true, &handle)) {
     LOG(WARNING) << "Can't share memory handle to send out of line message";
     return;
   }
@@ -226,6 +338,82 @@ void XWalkExtensionServer::PostMessageToJSCallback(
                                                             message->size()));
 }
 
+bool XWalkExtensionServer::PostPooledOutOfLineMessage(
+    int64_t instance_id, const IPC::Message& message) {
+  int32_t dropped_id;
+  int32_t segment_id = out_of_line_pool_.Acquire(message.size(), &dropped_id);
+  if (dropped_id)
+    Send(new XWalkExtensionClientMsg_DropOutOfLineSegment(dropped_id));
+  if (!segment_id)
+    return false;
+
+  memcpy(out_of_line_pool_.GetMemory(segment_id), message.data(),
+         message.size());
+
+  base::SharedMemoryHandle handle = base::SharedMemory::NULLHandle();
+  size_t capacity = 0;
+  base::SharedMemory* unshared_memory =
+      out_of_line_pool_.TakeUnsharedMemory(segment_id);
+  if (unshared_memory) {
+    if (!ShareMemoryWithPeer(unshared_memory, true, &handle)) {
+      out_of_line_pool_.Destroy(segment_id);
+      return false;
+    }
+    capacity = unshared_memory->mapped_size();
+  }
+
+  Send(new XWalkExtensionClientMsg_PostPooledOutOfLineMessageToJS(
+      instance_id, segment_id, handle, capacity, message.size()));
+  return true;
+}
+
+void XWalkExtensionServer::PostSharedBufferToJSCallback(
+    int64_t instance_id, int32_t buffer_id,
+    base::SharedMemory* unshared_memory, size_t size) {
+  if (message_batcher_)
+    message_batcher_->Flush(instance_id);
+
+  base::SharedMemoryHandle handle = base::SharedMemory::NULLHandle();
+  size_t capacity = 0;
+
+  // The buffer is mapped writable on the renderer, so the ArrayBuffer handed
+  // to JS behaves like any other. The extension only touches the buffer
+  // again after the renderer released it.
+  if (unshared_memory) {
+    if (!ShareMemoryWithPeer(unshared_memory, false, &handle)) {
+      LOG(WARNING) << "Can't share memory handle to post shared buffer";
+      return;
+    }
+    capacity = unshared_memory->mapped_size();
+  }
+
+  Send(new XWalkExtensionClientMsg_PostSharedBufferToJS(
+      instance_id, buffer_id, handle, capacity, size));
+}
+
+void XWalkExtensionServer::DropSharedBufferCallback(int64_t instance_id,
+                                                    int32_t buffer_id) {
+  Send(new XWalkExtensionClientMsg_DropSharedBuffer(instance_id, buffer_id));
+}
+
+bool XWalkExtensionServer::ShareMemoryWithPeer(
+    base::SharedMemory* shared_memory, bool read_only,
+    base::SharedMemoryHandle* handle) {
+  base::ProcessId peer_pid;
+  {
+    base::AutoLock l(channel_proxy_lock_);
+    if (!channel_proxy_)
+      return false;
+    peer_pid = channel_proxy_->GetPeerPID();
+  }
+
+  base::Process process = base::Process::OpenWithExtraPrivileges(peer_pid);
+  CHECK(process.IsValid());
+  if (read_only)
+    return shared_memory->ShareReadOnlyToProcess(process.Handle(), handle);
+  return shared_memory->ShareToProcess(process.Handle(), handle);
+}
+
 void XWalkExtensionServer::SendSyncReplyToJSCallback(
     int64_t instance_id, std::unique_ptr<base::Value> reply) {
 
@@ -243,6 +431,9 @@ void XWalkExtensionServer::SendSyncReplyToJSCallback(
     return;
   }
 
+  if (message_batcher_)
+    message_batcher_->Flush(instance_id);
+
   base::ListValue wrapped_reply;
   wrapped_reply.Append(reply.release());
   XWalkExtensionServerMsg_SendSyncMessageToNative::WriteReplyParams(
@@ -252,6 +443,19 @@ void XWalkExtensionServer::SendSyncReplyToJSCallback(
   data.pending_reply = NULL;
 }
 
+void XWalkExtensionServer::SendReplyToJSCallback(
+    int64_t instance_id, int32_t request_id,
+    std::unique_ptr<base::Value> reply) {
+  if (message_batcher_)
+    message_batcher_->Flush(instance_id);
+
+  base::ListValue wrapped_reply;
+  if (reply)
+    wrapped_reply.Append(reply.release());
+  SendToJS(instance_id, base::WrapUnique(new XWalkExtensionClientMsg_ReplyToJS(
+      instance_id, request_id, wrapped_reply)));
+}
+
 void XWalkExtensionServer::DeleteInstanceMap() {
   InstanceMap::iterator it = instances_.begin();
   int pending_replies_left = 0;
@@ -294,6 +498,10 @@ void XWalkExtensionServer::OnSendSyncMessageToNative(int64_t instance_id,
   if (it == instances_.end()) {
     LOG(WARNING) << "Can't SendSyncMessage to invalid Extension instance id: "
                  << instance_id;
+    // Reply anyway, the renderer is blocked until it gets one.
+    XWalkExtensionServerMsg_SendSyncMessageToNative::WriteReplyParams(
+        ipc_reply, base::ListValue());
+    Send(ipc_reply);
     return;
   }
 
@@ -301,6 +509,9 @@ void XWalkExtensionServer::OnSendSyncMessageToNative(int64_t instance_id,
   if (data.pending_reply) {
     LOG(WARNING) << "There's already a pending Sync Message for "
                  << "Extension instance id: " << instance_id;
+    XWalkExtensionServerMsg_SendSyncMessageToNative::WriteReplyParams(
+        ipc_reply, base::ListValue());
+    Send(ipc_reply);
     return;
   }
 
@@ -319,6 +530,43 @@ void XWalkExtensionServer::OnSendSyncMessageToNative(int64_t instance_id,
   instance->HandleSyncMessage(std::move(value));
 }
 
+void XWalkExtensionServer::OnSendMessageWithReplyToNative(
+    int64_t instance_id, int32_t request_id, const base::ListValue& msg) {
+  InstanceMap::const_iterator it = instances_.find(instance_id);
+  if (it == instances_.end()) {
+    LOG(WARNING) << "Can't SendMessageWithReply to invalid Extension instance "
+                 << "id: " << instance_id;
+    Send(new XWalkExtensionClientMsg_ReplyToJS(instance_id, request_id,
+                                               base::ListValue()));
+    return;
+  }
+
+  // See OnPostMessageToNative() about the const_cast.
+  std::unique_ptr<base::Value> value;
+  const_cast<base::ListValue*>(&msg)->Remove(0, &value);
+  it->second.instance->HandleMessageWithReply(request_id, std::move(value));
+}
+
+void XWalkExtensionServer::OnReleaseSharedBuffer(int64_t instance_id,
+                                                 int32_t buffer_id) {
+  InstanceMap::const_iterator it = instances_.find(instance_id);
+  if (it == instances_.end()) {
+    LOG(WARNING) << "Can't release shared buffer of invalid Extension "
+                 << "instance id: " << instance_id;
+    return;
+  }
+
+  it->second.instance->HandleSharedBufferReleased(buffer_id);
+}
+
+void XWalkExtensionServer::OnReleaseOutOfLineSegment(int64_t instance_id,
+                                                     int32_t segment_id) {
+  // The segment belongs to the server, not to the instance, so it is fine if
+  // the instance is already gone.
+  if (out_of_line_pool_.Release(segment_id))
+    Send(new XWalkExtensionClientMsg_DropOutOfLineSegment(segment_id));
+}
+
 void XWalkExtensionServer::OnDestroyInstance(int64_t instance_id) {
   InstanceMap::iterator it = instances_.find(instance_id);
   if (it == instances_.end()) {
@@ -331,6 +579,9 @@ void XWalkExtensionServer::OnDestroyInstance(int64_t instance_id) {
   delete data.instance;
   instances_.erase(it);
 
+  if (message_batcher_)
+    message_batcher_->Discard(instance_id);
+
   Send(new XWalkExtensionClientMsg_InstanceDestroyed(instance_id));
 }
 
@@ -367,6 +618,166 @@ base::FilePath::StringType GetNativeLibraryPattern() {
   return library_pattern;
 #endif
 }
+
+// Loading a library mostly waits for the disk and for whatever XW_Initialize
+// does, more threads than this don't pay off.
+const size_t kMaxLoadThreads = 4;
+
+size_t GetLoadThreadCount(size_t library_count) {
+  size_t threads = std::min(
+      static_cast<size_t>(base::SysInfo::NumberOfProcessors()),
+      kMaxLoadThreads);
+  base::CommandLine* cmd_line = base::CommandLine::ForCurrentProcess();
+  if (cmd_line->HasSwitch(switches::kXWalkExtensionLoadThreads)) {
+    size_t value;
+    if (base::StringToSizeT(cmd_line->GetSwitchValueASCII(
+            switches::kXWalkExtensionLoadThreads), &value) && value > 0)
+      threads = value;
+  }
+  return std::min(threads, library_count);
+}
+
+// Forwards the permission requests extensions make from XW_Initialize() on
+// the loading pool threads to the thread that loads the extensions. The
+// extension process delegate sends sync IPC messages, which it can only do
+// from the thread of its channel.
+class PermissionsRelay : public XWalkExtension::PermissionsDelegate {
+ public:
+  PermissionsRelay(XWalkExtension::PermissionsDelegate* delegate,
+                   size_t loader_count)
+      : delegate_(delegate),
+        changed_(&lock_),
+        pending_loaders_(loader_count) {}
+
+  // XWalkExtension::PermissionsDelegate implementation.
+  bool CheckAPIAccessControl(const std::string& extension_name,
+                             const std::string& api_name) override {
+    return Relay(false, extension_name, api_name);
+  }
+  bool RegisterPermissions(const std::string& extension_name,
+                           const std::string& perm_table) override {
+    return Relay(true, extension_name, perm_table);
+  }
+
+  // Called on a pool thread by each loader when it's done.
+  void LoaderDone() {
+    base::AutoLock lock(lock_);
+    --pending_loaders_;
+    changed_.Broadcast();
+  }
+
+  // Runs the requests on the calling thread until every loader is done.
+  void ServeUntilLoadersDone() {
+    base::AutoLock lock(lock_);
+    while (pending_loaders_ > 0 || !requests_.empty()) {
+      if (requests_.empty()) {
+        changed_.Wait();
+        continue;
+      }
+      Request* request = requests_.front();
+      requests_.pop_front();
+      bool result;
+      {
+        base::AutoUnlock unlock(lock_);
+        result = request->register_permissions ?
+            delegate_->RegisterPermissions(*request->extension_name,
+                                           *request->argument) :
+            delegate_->CheckAPIAccessControl(*request->extension_name,
+                                             *request->argument);
+      }
+      request->result = result;
+      request->done = true;
+      changed_.Broadcast();
+    }
+  }
+
+ private:
+  struct Request {
+    bool register_permissions;
+    const std::string* extension_name;
+    const std::string* argument;
+    bool done;
+    bool result;
+  };
+
+  bool Relay(bool register_permissions, const std::string& extension_name,
+             const std::string& argument) {
+    Request request = {
+        register_permissions, &extension_name, &argument, false, false };
+    base::AutoLock lock(lock_);
+    requests_.push_back(&request);
+    changed_.Broadcast();
+    while (!request.done)
+      changed_.Wait();
+    return request.result;
+  }
+
+  XWalkExtension::PermissionsDelegate* delegate_;
+  base::Lock lock_;
+  base::ConditionVariable changed_;
+  std::deque<Request*> requests_;
+  size_t pending_loaders_;
+
+  DISALLOW_COPY_AND_ASSIGN(PermissionsRelay);
+};
+
+// Loads and initializes the extension in one library, possibly in a thread
+// of the loading pool.
+class ExternalExtensionLoader : public base::DelegateSimpleThread::Delegate {
+ public:
+  ExternalExtensionLoader(
+      const base::FilePath& path,
+      std::unique_ptr<base::DictionaryValue::Storage> runtime_variables)
+      : path_(path),
+        runtime_variables_(std::move(runtime_variables)),
+        permissions_delegate_(NULL),
+        relay_(NULL) {}
+
+  void set_permissions_delegate(
+      XWalkExtension::PermissionsDelegate* delegate) {
+    permissions_delegate_ = delegate;
+  }
+  // Makes the extension go through |relay| while initializing.
+  void set_relay(PermissionsRelay* relay) { relay_ = relay; }
+
+  // base::DelegateSimpleThread::Delegate implementation.
+  void Run() override {
+    base::TimeTicks start_time = base::TimeTicks::Now();
+    extension_.reset(new XWalkExternalExtension(path_));
+    extension_->set_runtime_variables(runtime_variables_.get());
+    if (relay_)
+      extension_->set_permissions_delegate(relay_);
+    else if (permissions_delegate_)
+      extension_->set_permissions_delegate(permissions_delegate_);
+    if (!extension_->Initialize())
+      extension_.reset();
+    init_time_ = base::TimeTicks::Now() - start_time;
+    if (relay_)
+      relay_->LoaderDone();
+  }
+
+  const base::FilePath& path() const { return path_; }
+  base::TimeDelta init_time() const { return init_time_; }
+
+  // NULL if the extension failed to initialize.
+  std::unique_ptr<XWalkExternalExtension> TakeExtension() {
+    // The relay doesn't outlive the loading.
+    if (extension_ && relay_)
+      extension_->set_permissions_delegate(permissions_delegate_);
+    return std::move(extension_);
+  }
+
+ private:
+  base::FilePath path_;
+  std::unique_ptr<base::DictionaryValue::Storage> runtime_variables_;
+  XWalkExtension::PermissionsDelegate* permissions_delegate_;
+  PermissionsRelay* relay_;
+  std::unique_ptr<XWalkExternalExtension> extension_;
+  base::TimeDelta init_time_;
+
+  DISALLOW_COPY_AND_ASSIGN(ExternalExtensionLoader);
+};
+
 }  // namespace
 
 std::vector<std::string> RegisterExternalExtensionsInDirectory(
@@ -384,27 +795,63 @@ std::vector<std::string> RegisterExternalExtensionsInDirectory(
 
   base::FileEnumerator libraries(
       dir, false, base::FileEnumerator::FILES, GetNativeLibraryPattern());
-
+  std::vector<base::FilePath> extension_paths;
   for (base::FilePath extension_path = libraries.Next();
-        !extension_path.empty(); extension_path = libraries.Next()) {
-    std::unique_ptr<XWalkExternalExtension> extension(
-        new XWalkExternalExtension(extension_path));
+        !extension_path.empty(); extension_path = libraries.Next())
+    extension_paths.push_back(extension_path);
+  // The enumeration order depends on the file system.
+  std::sort(extension_paths.begin(), extension_paths.end());
+
+  std::vector<std::unique_ptr<ExternalExtensionLoader>> loaders;
+  for (const base::FilePath& extension_path : extension_paths) {
+    std::unique_ptr<base::DictionaryValue::Storage> variables(
+        new base::DictionaryValue::Storage);
+    for (const auto& variable : *runtime_variables)
+      (*variables)[variable.first] =
+          base::WrapUnique(variable.second->DeepCopy());
 
     // Let the extension know about its own path, so it can be used
     // as an identifier in case you have symlinks to extensions to force it
     // load multiple times.
-    (*runtime_variables)["extension_path"] = base::WrapUnique(
+    (*variables)["extension_path"] = base::WrapUnique(
         new base::StringValue(extension_path.AsUTF8Unsafe()));
 
-    extension->set_runtime_variables(runtime_variables.get());
+    loaders.push_back(base::WrapUnique(new ExternalExtensionLoader(
+        extension_path, std::move(variables))));
+    loaders.back()->set_permissions_delegate(server->permissions_delegate());
+  }
+
+  size_t thread_count = GetLoadThreadCount(loaders.size());
+  if (thread_count > 1) {
+    std::unique_ptr<PermissionsRelay> relay;
     if (server->permissions_delegate())
-      extension->set_permissions_delegate(server->permissions_delegate());
-    if (extension->Initialize()) {
-      registered_extensions.push_back(extension->name());
-      server->RegisterExtension(std::move(extension));
+      relay.reset(new PermissionsRelay(server->permissions_delegate(),
+                                       loaders.size()));
+    base::DelegateSimpleThreadPool pool("XWalkExtensionLoader", thread_count);
+    for (const auto& loader : loaders) {
+      loader->set_relay(relay.get());
+      pool.AddWork(loader.get());
+    }
+    pool.Start();
+    if (relay)
+      relay->ServeUntilLoadersDone();
+    pool.JoinAll();
+  } else {
+    for (const auto& loader : loaders)
+      loader->Run();
+  }
+
+  for (const auto& loader : loaders) {
+    VLOG(1) << "Loading extension " << loader->path().AsUTF8Unsafe()
+            << " took " << loader->init_time().InMilliseconds() << " ms.";
+    std::unique_ptr<XWalkExternalExtension> extension = loader->TakeExtension();
+    if (extension) {
+      std::string name = extension->name();
+      if (server->RegisterExtension(std::move(extension)))
+        registered_extensions.push_back(name);
     } else {
       LOG(WARNING) << "Failed to initialize extension: "
-                   << extension_path.AsUTF8Unsafe();
+                   << loader->path().AsUTF8Unsafe();
     }
   }
 
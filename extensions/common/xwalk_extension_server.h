@@ -11,14 +11,18 @@
 #include <string>
 #include <vector>
 
+#include "base/memory/ref_counted.h"
 #include "base/memory/shared_memory.h"
 #include "base/memory/weak_ptr.h"
+#include "base/single_thread_task_runner.h"
 #include "base/synchronization/lock.h"
 #include "base/values.h"
 #include "ipc/ipc_channel_proxy.h"
 #include "ipc/ipc_listener.h"
 #include "xwalk/extensions/common/xwalk_extension.h"
+#include "xwalk/extensions/common/xwalk_extension_message_batcher.h"
 #include "xwalk/extensions/common/xwalk_external_extension.h"
+#include "xwalk/extensions/common/xwalk_shared_buffer_pool.h"
 
 struct XWalkExtensionServerMsg_ExtensionRegisterParams;
 
@@ -59,12 +63,24 @@ class XWalkExtensionServer : public IPC::Listener,
   // IPC; For in-process extensions running in extension thread, we will
   // give a delegate that will do an async method call and for UI thread
   // extensions, doing synchronous request is not allowed.
+  //
+  // The server's timers, e.g. the message batching window, run on the
+  // current thread, so it must be the one the server handles messages on.
   void Initialize(IPC::ChannelProxy* channelProxy);
+  // Like above, for a server initialized on another thread than the one of
+  // |task_runner|, on which it handles messages.
+  void Initialize(IPC::ChannelProxy* channelProxy,
+                  scoped_refptr<base::SingleThreadTaskRunner> task_runner);
   bool Send(IPC::Message* msg);
 
   bool RegisterExtension(std::unique_ptr<XWalkExtension> extension);
   bool ContainsExtension(const std::string& extension_name) const;
 
+  // Serves the extensions registered in |other| instead of its own, so
+  // several clients can use the same extensions, each with its own set of
+  // instances. |other| keeps the ownership and must outlive this server.
+  void UseExtensionsFrom(const XWalkExtensionServer& other);
+
   void Invalidate();
 
   void set_permissions_delegate(XWalkExtension::PermissionsDelegate* delegate) {
@@ -89,15 +105,47 @@ class XWalkExtensionServer : public IPC::Listener,
   // Message Handlers
   void OnDestroyInstance(int64_t instance_id);
   void OnPostMessageToNative(int64_t instance_id, const base::ListValue& msg);
+  void OnPostEncodedMessageToNative(int64_t instance_id,
+                                    const std::vector<char>& msg);
   void OnSendSyncMessageToNative(int64_t instance_id,
       const base::ListValue& msg, IPC::Message* ipc_reply);
+  void OnSendMessageWithReplyToNative(int64_t instance_id, int32_t request_id,
+                                      const base::ListValue& msg);
+  void OnReleaseSharedBuffer(int64_t instance_id, int32_t buffer_id);
+  void OnReleaseOutOfLineSegment(int64_t instance_id, int32_t segment_id);
 
   void PostMessageToJSCallback(int64_t instance_id,
                                std::unique_ptr<base::Value> msg);
 
+  // Called by |message_batcher_| when a batch is ready to be sent.
+  void PostMessageBatchToJS(int64_t instance_id,
+                            const base::ListValue& messages);
+
+  // Sends |message| inline if it is small enough, otherwise out of line.
+  void SendToJS(int64_t instance_id, std::unique_ptr<IPC::Message> message);
+
+  // Sends a message too big to be inlined through a segment of
+  // |out_of_line_pool_|. Returns false if no segment is available.
+  bool PostPooledOutOfLineMessage(int64_t instance_id,
+                                  const IPC::Message& message);
+
+  void PostSharedBufferToJSCallback(int64_t instance_id, int32_t buffer_id,
+                                    base::SharedMemory* unshared_memory,
+                                    size_t size);
+
+  void DropSharedBufferCallback(int64_t instance_id, int32_t buffer_id);
+
+  // Duplicates a handle of |shared_memory| into the process on the other side
+  // of the channel.
+  bool ShareMemoryWithPeer(base::SharedMemory* shared_memory, bool read_only,
+                           base::SharedMemoryHandle* handle);
+
   void SendSyncReplyToJSCallback(int64_t instance_id,
                                  std::unique_ptr<base::Value> reply);
 
+  void SendReplyToJSCallback(int64_t instance_id, int32_t request_id,
+                             std::unique_ptr<base::Value> reply);
+
   void DeleteInstanceMap();
 
   bool ValidateExtensionEntryPoints(
@@ -108,6 +156,7 @@ class XWalkExtensionServer : public IPC::Listener,
 
   typedef std::map<std::string, XWalkExtension*> ExtensionMap;
   ExtensionMap extensions_;
+  bool owns_extensions_;
 
   typedef std::map<int64_t, InstanceExecutionData> InstanceMap;
   InstanceMap instances_;
@@ -117,8 +166,22 @@ class XWalkExtensionServer : public IPC::Listener,
   ExtensionSymbolsSet extension_symbols_;
 
   XWalkExtension::PermissionsDelegate* permissions_delegate_;
+
+  // Segments already shared with the client, reused for out of line messages
+  // so that big messages only cost a memcpy instead of creating, mapping and
+  // duplicating new shared memory every time.
+  XWalkSharedBufferPool out_of_line_pool_;
+
+  // Only set when message batching is enabled from the command line. Pending
+  // messages of an instance are flushed before anything else is sent for it,
+  // so batching never reorders messages.
+  scoped_refptr<XWalkExtensionMessageBatcher> message_batcher_;
 };
 
+// Loads the libraries in |dir| in parallel, see
+// --xwalk-extension-load-threads, and registers them in |server| in file name
+// order, so name and entry point conflicts are always resolved the same way.
+// Each extension gets its own copy of |runtime_variables|.
 std::vector<std::string> RegisterExternalExtensionsInDirectory(
     XWalkExtensionServer* server, const base::FilePath& dir,
     std::unique_ptr<base::DictionaryValue::Storage> runtime_variables);
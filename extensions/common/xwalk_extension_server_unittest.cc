@@ -4,9 +4,39 @@
 
 #include "xwalk/extensions/common/xwalk_extension_server.h"
 
+#include "base/memory/ptr_util.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
 using xwalk::extensions::ValidateExtensionNameForTesting;
+using xwalk::extensions::XWalkExtension;
+using xwalk::extensions::XWalkExtensionInstance;
+using xwalk::extensions::XWalkExtensionServer;
+
+namespace {
+
+int g_instances = 0;
+int g_extensions = 0;
+
+class CountingInstance : public XWalkExtensionInstance {
+ public:
+  CountingInstance() { g_instances++; }
+  ~CountingInstance() override { g_instances--; }
+  void HandleMessage(std::unique_ptr<base::Value> msg) override {}
+};
+
+class CountingExtension : public XWalkExtension {
+ public:
+  CountingExtension() {
+    set_name("counting");
+    g_extensions++;
+  }
+  ~CountingExtension() override { g_extensions--; }
+  XWalkExtensionInstance* CreateInstance() override {
+    return new CountingInstance;
+  }
+};
+
+}  // namespace
 
 TEST(XWalkExtensionServerTest, ValidateExtensionName) {
   const std::string valid_names[] = {
@@ -41,3 +71,29 @@ TEST(XWalkExtensionServerTest, ValidateExtensionName) {
         << "Extension name should be invalid: " << invalid_names[i];
   }
 }
+
+TEST(XWalkExtensionServerTest, UseExtensionsFrom) {
+  std::unique_ptr<XWalkExtensionServer> registry(new XWalkExtensionServer);
+  ASSERT_TRUE(registry->RegisterExtension(
+      base::WrapUnique(new CountingExtension)));
+
+  {
+    XWalkExtensionServer first;
+    XWalkExtensionServer second;
+    first.UseExtensionsFrom(*registry);
+    second.UseExtensionsFrom(*registry);
+    EXPECT_TRUE(first.ContainsExtension("counting"));
+    EXPECT_TRUE(second.ContainsExtension("counting"));
+
+    // Each server has its own instance ids.
+    first.OnCreateInstance(0, "counting");
+    second.OnCreateInstance(0, "counting");
+    EXPECT_EQ(2, g_instances);
+  }
+
+  // Instances go away with their servers, but not the extension.
+  EXPECT_EQ(0, g_instances);
+  EXPECT_EQ(1, g_extensions);
+  registry.reset();
+  EXPECT_EQ(0, g_extensions);
+}
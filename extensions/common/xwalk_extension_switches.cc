@@ -26,4 +26,29 @@ const char kXWalkExtensionCmdPrefix[] = "xwalk-extension-cmd-prefix";
 // Disable XWalkExtensionSystem and all extensions
 const char kXWalkDisableExtensions[] = "disable-xwalk-extensions";
 
+// Batches the messages each extension instance posts to JS within the given
+// number of milliseconds, so they are delivered with a single IPC.
+const char kXWalkExtensionMessageBatchWindow[] =
+    "xwalk-extension-message-batch-window";
+
+// Maximum number of messages in a batch, a full batch is sent right away.
+// Only used together with --xwalk-extension-message-batch-window.
+const char kXWalkExtensionMessageBatchSize[] =
+    "xwalk-extension-message-batch-size";
+
+// Use a single extension process for all the render processes, instead of one
+// per render process. External extensions are loaded only once, but the
+// permission requests are all checked against the first render process.
+const char kXWalkSharedExtensionProcess[] = "xwalk-shared-extension-process";
+
+// Keep an extension process launched ahead of time for the next render
+// process, so it doesn't wait for the external extensions to load. Ignored
+// when the extension process is shared.
+const char kXWalkPrewarmExtensionProcess[] =
+    "xwalk-prewarm-extension-process";
+
+// Number of threads loading and initializing the external extensions. With 1
+// they are loaded one after the other in the registering thread.
+const char kXWalkExtensionLoadThreads[] = "xwalk-extension-load-threads";
+
 }  // namespace switches
@@ -13,6 +13,11 @@ extern const char kXWalkExtensionProcess[];
 extern const char kXWalkExternalExtensionsPath[];
 extern const char kXWalkExtensionCmdPrefix[];
 extern const char kXWalkDisableExtensions[];
+extern const char kXWalkExtensionMessageBatchWindow[];
+extern const char kXWalkExtensionMessageBatchSize[];
+extern const char kXWalkSharedExtensionProcess[];
+extern const char kXWalkPrewarmExtensionProcess[];
+extern const char kXWalkExtensionLoadThreads[];
 
 }  // namespace switches
 
@@ -21,15 +21,18 @@ XWalkExternalAdapter* XWalkExternalAdapter::GetInstance() {
 }
 
 XW_Extension XWalkExternalAdapter::GetNextXWExtension() {
+  base::AutoLock lock(lock_);
   return next_xw_extension_++;
 }
 
 XW_Instance XWalkExternalAdapter::GetNextXWInstance() {
+  base::AutoLock lock(lock_);
   return next_xw_instance_++;
 }
 
 void XWalkExternalAdapter::RegisterExtension(
     XWalkExternalExtension* extension) {
+  base::AutoLock lock(lock_);
   XW_Extension xw_extension = extension->xw_extension_;
   CHECK(IsValidXWExtension(xw_extension));
   CHECK(!ContainsKey(extension_map_, xw_extension));
@@ -38,6 +41,7 @@ void XWalkExternalAdapter::RegisterExtension(
 
 void XWalkExternalAdapter::UnregisterExtension(
     XWalkExternalExtension* extension) {
+  base::AutoLock lock(lock_);
   XW_Extension xw_extension = extension->xw_extension_;
   CHECK(IsValidXWExtension(xw_extension));
   CHECK(ContainsKey(extension_map_, xw_extension));
@@ -45,6 +49,7 @@ void XWalkExternalAdapter::UnregisterExtension(
 }
 
 void XWalkExternalAdapter::RegisterInstance(XWalkExternalInstance* context) {
+  base::AutoLock lock(lock_);
   XW_Instance xw_instance = context->xw_instance_;
   CHECK(IsValidXWInstance(xw_instance));
   CHECK(!ContainsKey(instance_map_, xw_instance));
@@ -52,6 +57,7 @@ void XWalkExternalAdapter::RegisterInstance(XWalkExternalInstance* context) {
 }
 
 void XWalkExternalAdapter::UnregisterInstance(XWalkExternalInstance* context) {
+  base::AutoLock lock(lock_);
   XW_Instance xw_instance = context->xw_instance_;
   CHECK(IsValidXWInstance(xw_instance));
   CHECK(ContainsKey(instance_map_, xw_instance));
@@ -89,6 +95,26 @@ const void* XWalkExternalAdapter::GetInterface(const char* name) {
     return &messagingInterface2;
   }
 
+  if (!strcmp(name, XW_MESSAGING_INTERFACE_3)) {
+    static const XW_MessagingInterface_3 messagingInterface3 = {
+      MessagingRegister,
+      MessagingPostMessage,
+      MessagingRegisterBinaryMessageCallback,
+      MessagingPostBinaryMessage,
+      MessagingAllocateBuffer,
+      MessagingPostBuffer,
+      MessagingDiscardBuffer
+    };
+    return &messagingInterface3;
+  }
+
+  if (!strcmp(name, XW_ENCODED_MESSAGING_INTERFACE_1)) {
+    static const XW_EncodedMessagingInterface_1 encodedMessagingInterface1 = {
+      EncodedMessagingRegister
+    };
+    return &encodedMessagingInterface1;
+  }
+
   if (!strcmp(name, XW_INTERNAL_SYNC_MESSAGING_INTERFACE_1)) {
     static const XW_Internal_SyncMessagingInterface_1
         syncMessagingInterface1 = {
@@ -98,6 +124,14 @@ const void* XWalkExternalAdapter::GetInterface(const char* name) {
     return &syncMessagingInterface1;
   }
 
+  if (!strcmp(name, XW_MESSAGE_WITH_REPLY_INTERFACE_1)) {
+    static const XW_MessageWithReplyInterface_1 messageWithReplyInterface1 = {
+      ReplyMessagingRegister,
+      ReplyMessagingReply
+    };
+    return &messageWithReplyInterface1;
+  }
+
   if (!strcmp(name, XW_INTERNAL_ENTRY_POINTS_INTERFACE_1)) {
     static const XW_Internal_EntryPointsInterface_1 entryPointsInterface1 = {
       EntryPointsSetExtraJSEntryPoints
@@ -135,6 +169,7 @@ bool XWalkExternalAdapter::IsValidXWInstance(XW_Instance xw_instance) {
 XWalkExternalExtension* XWalkExternalAdapter::GetExtension(
     XW_Extension xw_extension) {
   XWalkExternalAdapter* adapter = XWalkExternalAdapter::GetInstance();
+  base::AutoLock lock(adapter->lock_);
   ExtensionMap::iterator it = adapter->extension_map_.find(xw_extension);
   if (it == adapter->extension_map_.end())
     return NULL;
@@ -144,6 +179,7 @@ XWalkExternalExtension* XWalkExternalAdapter::GetExtension(
 XWalkExternalInstance* XWalkExternalAdapter::GetInstance(
     XW_Instance xw_instance) {
   XWalkExternalAdapter* adapter = XWalkExternalAdapter::GetInstance();
+  base::AutoLock lock(adapter->lock_);
   InstanceMap::iterator it = adapter->instance_map_.find(xw_instance);
   if (it == adapter->instance_map_.end())
     return NULL;
@@ -158,6 +194,16 @@ void XWalkExternalAdapter::LogInvalidCall(
                << " as it received wrong XW_" << type << "=" << value << ".";
 }
 
+void* XWalkExternalAdapter::MessagingAllocateBuffer(XW_Instance xw,
+    size_t size, XW_Buffer* buffer) {
+  XWalkExternalInstance* ptr = GetInstance(xw);
+  if (!ptr || !buffer) {
+    LogInvalidCall(xw, "Instance", "Messaging", "AllocateBuffer");
+    return NULL;
+  }
+  return ptr->MessagingAllocateBuffer(size, buffer);
+}
+
 int XWalkExternalAdapter::PermissionsCheckAPIAccessControl(XW_Extension xw,
     const char* api_name) {
   XWalkExtension* ptr = GetExtension(xw);
@@ -7,8 +7,12 @@
 
 #include <map>
 #include "base/memory/singleton.h"
+#include "base/synchronization/lock.h"
 #include "xwalk/extensions/public/XW_Extension.h"
+#include "xwalk/extensions/public/XW_Extension_EncodedMessage.h"
 #include "xwalk/extensions/public/XW_Extension_Message_2.h"
+#include "xwalk/extensions/public/XW_Extension_Message_3.h"
+#include "xwalk/extensions/public/XW_Extension_MessageWithReply.h"
 #include "xwalk/extensions/public/XW_Extension_SyncMessage.h"
 #include "xwalk/extensions/public/XW_Extension_EntryPoints.h"
 #include "xwalk/extensions/public/XW_Extension_Permissions.h"
@@ -65,7 +69,9 @@ class XWalkExternalInstance;
 // Provides the "C Interfaces" defined in XW_Extension.h and maps the
 // functions from external extension to their implementations in
 // XWalkExternalExtension and XWalkExternalInstance. We have only one
-// adapter per process.
+// adapter per process. Extensions may be initialized from several threads at
+// once, see RegisterExternalExtensionsInDirectory(), so the mappings are
+// guarded by a lock.
 class XWalkExternalAdapter {
  public:
   static XWalkExternalAdapter* GetInstance();
@@ -131,15 +137,32 @@ class XWalkExternalAdapter {
   DEFINE_FUNCTION_2(Instance, Messaging, PostBinaryMessage, const char*,
                     size_t);
 
+  // XW_MessagingInterface_3 from XW_Extension_Message_3.h.
+  static void* MessagingAllocateBuffer(XW_Instance xw, size_t size,
+                                       XW_Buffer* buffer);
+  DEFINE_FUNCTION_2(Instance, Messaging, PostBuffer, XW_Buffer, size_t);
+  DEFINE_FUNCTION_1(Instance, Messaging, DiscardBuffer, XW_Buffer);
+
+  // XW_EncodedMessagingInterface_1 from XW_Extension_EncodedMessage.h.
+  DEFINE_FUNCTION_1(Extension, EncodedMessaging, Register,
+                    XW_HandleEncodedMessageCallback);
+
   // XW_Internal_SyncMessaging_1 from XW_Extension_SyncMessage.h.
   DEFINE_FUNCTION_1(Extension, SyncMessaging, Register,
                     XW_HandleSyncMessageCallback);
   DEFINE_FUNCTION_1(Instance, SyncMessaging, SetSyncReply, const char*);
 
+  // XW_MessageWithReplyInterface_1 from XW_Extension_MessageWithReply.h.
+  DEFINE_FUNCTION_1(Extension, ReplyMessaging, Register,
+                    XW_HandleMessageWithReplyCallback);
+  DEFINE_FUNCTION_2(Instance, ReplyMessaging, Reply, XW_Request, const char*);
+
   // XW_Internal_Runtime_1 from XW_Extension_Runtime.h
   DEFINE_FUNCTION_3(Extension, Runtime, GetStringVariable, const char *,
                     char*, size_t);
 
+  base::Lock lock_;
+
   typedef std::map<XW_Extension, XWalkExternalExtension*> ExtensionMap;
   ExtensionMap extension_map_;
 
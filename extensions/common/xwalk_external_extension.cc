@@ -10,6 +10,7 @@
 #include "base/json/json_writer.h"
 #include "base/lazy_instance.h"
 #include "base/logging.h"
+#include "base/trace_event/trace_event.h"
 #include "base/values.h"
 #include "xwalk/extensions/common/xwalk_external_adapter.h"
 
@@ -24,7 +25,9 @@ XWalkExternalExtension::XWalkExternalExtension(const base::FilePath& path)
       shutdown_callback_(NULL),
       handle_msg_callback_(NULL),
       handle_sync_msg_callback_(NULL),
+      handle_msg_with_reply_callback_(NULL),
       handle_binary_msg_callback_(NULL),
+      handle_encoded_msg_callback_(NULL),
       initialized_(false) {
 }
 
@@ -41,6 +44,8 @@ bool XWalkExternalExtension::Initialize() {
   if (initialized_)
     return true;
 
+  TRACE_EVENT1("xwalk", "XWalkExternalExtension::Initialize", "library",
+               TRACE_STR_COPY(library_path_.BaseName().AsUTF8Unsafe().c_str()));
   base::NativeLibraryLoadError error;
   base::ScopedNativeLibrary library(
       base::LoadNativeLibrary(library_path_, &error));
@@ -69,6 +74,7 @@ bool XWalkExternalExtension::Initialize() {
     LOG(WARNING) << "Error loading extension '"
                  << library_path_.AsUTF8Unsafe() << "': "
                  << "XW_Initialize function returned error value.";
+    external_adapter->UnregisterExtension(this);
     return false;
   }
   library_.Reset(library.Release());
@@ -126,12 +132,24 @@ void XWalkExternalExtension::MessagingRegisterBinaryMessageCallback(
   handle_binary_msg_callback_ = callback;
 }
 
+void XWalkExternalExtension::EncodedMessagingRegister(
+    XW_HandleEncodedMessageCallback callback) {
+  RETURN_IF_INITIALIZED("Register from EncodedMessagingInterface");
+  handle_encoded_msg_callback_ = callback;
+}
+
 void XWalkExternalExtension::SyncMessagingRegister(
     XW_HandleSyncMessageCallback callback) {
   RETURN_IF_INITIALIZED("Register from Internal_SyncMessagingInterface");
   handle_sync_msg_callback_ = callback;
 }
 
+void XWalkExternalExtension::ReplyMessagingRegister(
+    XW_HandleMessageWithReplyCallback callback) {
+  RETURN_IF_INITIALIZED("Register from MessageWithReplyInterface");
+  handle_msg_with_reply_callback_ = callback;
+}
+
 void XWalkExternalExtension::EntryPointsSetExtraJSEntryPoints(
     const char** entry_points) {
   RETURN_IF_INITIALIZED("SetExtraJSEntryPoints from EntryPoints");
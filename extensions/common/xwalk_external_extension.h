@@ -11,7 +11,9 @@
 #include "base/scoped_native_library.h"
 #include "xwalk/extensions/common/xwalk_extension.h"
 #include "xwalk/extensions/public/XW_Extension.h"
+#include "xwalk/extensions/public/XW_Extension_EncodedMessage.h"
 #include "xwalk/extensions/public/XW_Extension_Message_2.h"
+#include "xwalk/extensions/public/XW_Extension_MessageWithReply.h"
 #include "xwalk/extensions/public/XW_Extension_SyncMessage.h"
 #include "base/memory/ptr_util.h"
 
@@ -72,9 +74,17 @@ class XWalkExternalExtension : public XWalkExtension {
   void MessagingRegisterBinaryMessageCallback(
       XW_HandleBinaryMessageCallback callback);
 
+  // XW_EncodedMessagingInterface_1 (from XW_Extension_EncodedMessage.h)
+  // implementation.
+  void EncodedMessagingRegister(XW_HandleEncodedMessageCallback callback);
+
   // XW_Internal_SyncMessagingInterface_1 (from XW_Extension.h) implementation.
   void SyncMessagingRegister(XW_HandleSyncMessageCallback callback);
 
+  // XW_MessageWithReplyInterface_1 (from XW_Extension_MessageWithReply.h)
+  // implementation.
+  void ReplyMessagingRegister(XW_HandleMessageWithReplyCallback callback);
+
   // XW_Internal_BrowserInterface_1 (from XW_Browser.h) implementation.
   void RuntimeGetStringVariable(const char* key, char* value, size_t value_len);
 
@@ -87,7 +97,9 @@ class XWalkExternalExtension : public XWalkExtension {
   XW_ShutdownCallback shutdown_callback_;
   XW_HandleMessageCallback handle_msg_callback_;
   XW_HandleSyncMessageCallback handle_sync_msg_callback_;
+  XW_HandleMessageWithReplyCallback handle_msg_with_reply_callback_;
   XW_HandleBinaryMessageCallback handle_binary_msg_callback_;
+  XW_HandleEncodedMessageCallback handle_encoded_msg_callback_;
 
   bool initialized_;
 
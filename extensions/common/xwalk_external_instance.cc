@@ -12,12 +12,23 @@
 namespace xwalk {
 namespace extensions {
 
+namespace {
+
+// Limits how many shared buffers an instance may have at the same time. When
+// JavaScript holds on to all of them, AllocateBuffer() fails and the extension
+// is expected to drop or delay data.
+const size_t kMaxSharedBuffers = 16;
+const size_t kMaxIdleSharedBuffers = 4;
+
+}  // namespace
+
 XWalkExternalInstance::XWalkExternalInstance(
     XWalkExternalExtension* extension, XW_Instance xw_instance)
     : xw_instance_(xw_instance),
       extension_(extension),
       instance_data_(NULL),
-      is_handling_sync_msg_(false) {
+      is_handling_sync_msg_(false),
+      buffer_pool_(kMaxSharedBuffers, kMaxIdleSharedBuffers) {
   XWalkExternalAdapter::GetInstance()->RegisterInstance(this);
   XW_CreatedInstanceCallback callback = extension_->created_instance_callback_;
   if (callback)
@@ -72,6 +83,45 @@ void XWalkExternalInstance::HandleSyncMessage(std::unique_ptr<base::Value> msg)
   callback(xw_instance_, string_msg.c_str());
 }
 
+void XWalkExternalInstance::HandleMessageWithReply(
+    int32_t request_id, std::unique_ptr<base::Value> msg) {
+  XW_HandleMessageWithReplyCallback callback =
+      extension_->handle_msg_with_reply_callback_;
+  if (!callback) {
+    LOG(WARNING) << "Ignoring message with reply sent for external extension '"
+                 << extension_->name() << "' which doesn't support it.";
+    SendReplyToJS(request_id, nullptr);
+    return;
+  }
+
+  std::string string_msg;
+  if (!msg->GetAsString(&string_msg)) {
+    LOG(WARNING) << "Failed to retrieve the message with reply's value.";
+    SendReplyToJS(request_id, nullptr);
+    return;
+  }
+
+  callback(xw_instance_, request_id, string_msg.c_str());
+}
+
+void XWalkExternalInstance::HandleEncodedMessage(
+    const std::vector<char>& msg) {
+  XW_HandleEncodedMessageCallback callback =
+      extension_->handle_encoded_msg_callback_;
+  if (!callback) {
+    LOG(WARNING) << "Ignoring encoded message sent for external extension '"
+                 << extension_->name() << "' which doesn't support it.";
+    return;
+  }
+
+  callback(xw_instance_, msg.empty() ? NULL : &msg[0], msg.size());
+}
+
+void XWalkExternalInstance::HandleSharedBufferReleased(int32_t buffer_id) {
+  if (buffer_pool_.Release(buffer_id))
+    DropSharedBufferFromJS(buffer_id);
+}
+
 void XWalkExternalInstance::CoreSetInstanceData(void* data) {
   instance_data_ = data;
 }
@@ -90,9 +140,50 @@ void XWalkExternalInstance::MessagingPostBinaryMessage(const char* msg,
       base::BinaryValue::CreateWithCopiedBuffer(msg, size)));
 }
 
+void* XWalkExternalInstance::MessagingAllocateBuffer(size_t size,
+                                                     XW_Buffer* buffer) {
+  int32_t dropped_id;
+  int32_t id = buffer_pool_.Acquire(size, &dropped_id);
+  if (dropped_id)
+    DropSharedBufferFromJS(dropped_id);
+  if (!id) {
+    LOG(WARNING) << "No shared buffer available for external extension '"
+                 << extension_->name() << "'.";
+    return NULL;
+  }
+
+  *buffer = id;
+  return buffer_pool_.GetMemory(id);
+}
+
+void XWalkExternalInstance::MessagingPostBuffer(XW_Buffer buffer,
+                                                size_t size) {
+  // Posting the same buffer twice would hand JS a second ArrayBuffer over
+  // memory the first one may still be using.
+  if (!buffer_pool_.MarkPosted(buffer)) {
+    LOG(WARNING) << "Ignoring post of invalid or already posted shared "
+                 << "buffer: " << buffer;
+    return;
+  }
+
+  PostSharedBufferToJS(buffer, buffer_pool_.TakeUnsharedMemory(buffer), size);
+}
+
+void XWalkExternalInstance::MessagingDiscardBuffer(XW_Buffer buffer) {
+  // Posted buffers are only given back by JS, see HandleSharedBufferReleased().
+  if (buffer_pool_.Discard(buffer))
+    DropSharedBufferFromJS(buffer);
+}
+
 void XWalkExternalInstance::SyncMessagingSetSyncReply(const char* reply) {
   SendSyncReplyToJS(std::unique_ptr<base::Value>(new base::StringValue(reply)));
 }
 
+void XWalkExternalInstance::ReplyMessagingReply(XW_Request request,
+                                                const char* reply) {
+  SendReplyToJS(request,
+                std::unique_ptr<base::Value>(new base::StringValue(reply)));
+}
+
 }  // namespace extensions
 }  // namespace xwalk
@@ -6,9 +6,13 @@
 #define XWALK_EXTENSIONS_COMMON_XWALK_EXTERNAL_INSTANCE_H_
 
 #include <string>
+#include <vector>
 #include "xwalk/extensions/common/xwalk_extension.h"
+#include "xwalk/extensions/common/xwalk_shared_buffer_pool.h"
 #include "xwalk/extensions/public/XW_Extension.h"
 #include "xwalk/extensions/public/XW_Extension_Message_2.h"
+#include "xwalk/extensions/public/XW_Extension_Message_3.h"
+#include "xwalk/extensions/public/XW_Extension_MessageWithReply.h"
 #include "xwalk/extensions/public/XW_Extension_SyncMessage.h"
 
 namespace xwalk {
@@ -40,6 +44,10 @@ class XWalkExternalInstance : public XWalkExtensionInstance {
   // XWalkExtensionInstance implementation.
   void HandleMessage(std::unique_ptr<base::Value> msg) override;
   void HandleSyncMessage(std::unique_ptr<base::Value> msg) override;
+  void HandleMessageWithReply(int32_t request_id,
+                              std::unique_ptr<base::Value> msg) override;
+  void HandleEncodedMessage(const std::vector<char>& msg) override;
+  void HandleSharedBufferReleased(int32_t buffer_id) override;
 
   // XW_CoreInterface_1 (from XW_Extension.h) implementation.
   void CoreSetInstanceData(void* data);
@@ -51,15 +59,25 @@ class XWalkExternalInstance : public XWalkExtensionInstance {
   // XW_MessagingInterface_2 (from XW_Extension_Message_2.h) implementation.
   void MessagingPostBinaryMessage(const char* msg, const size_t size);
 
+  // XW_MessagingInterface_3 (from XW_Extension_Message_3.h) implementation.
+  void* MessagingAllocateBuffer(size_t size, XW_Buffer* buffer);
+  void MessagingPostBuffer(XW_Buffer buffer, size_t size);
+  void MessagingDiscardBuffer(XW_Buffer buffer);
+
   // XW_Internal_SyncMessagingInterface_1 (from XW_Extension_SyncMessage.h)
   // implementation.
   void SyncMessagingSetSyncReply(const char* reply);
 
+  // XW_MessageWithReplyInterface_1 (from XW_Extension_MessageWithReply.h)
+  // implementation.
+  void ReplyMessagingReply(XW_Request request, const char* reply);
+
   XW_Instance xw_instance_;
   std::string sync_reply_;
   XWalkExternalExtension* extension_;
   InstanceData instance_data_;
   bool is_handling_sync_msg_;
+  XWalkSharedBufferPool buffer_pool_;
 
   DISALLOW_COPY_AND_ASSIGN(XWalkExternalInstance);
 };
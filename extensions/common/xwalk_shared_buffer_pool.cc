@@ -0,0 +1,203 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_shared_buffer_pool.h"
+
+#include <utility>
+
+#include "base/atomic_sequence_num.h"
+#include "base/logging.h"
+
+namespace xwalk {
+namespace extensions {
+
+namespace {
+
+// Ids are unique in the whole process, so a peer talking to more than one
+// pool through the same channel (e.g. the in-process servers) can tell their
+// buffers apart.
+base::StaticAtomicSequenceNumber g_next_buffer_id;
+
+// Buffers are allocated in power of two sizes, so messages of similar sizes
+// (e.g. video frames) can share buffers even if they don't match exactly.
+const size_t kMinBufferSize = 4 * 1024;
+
+size_t RoundUpBufferSize(size_t size) {
+  size_t capacity = kMinBufferSize;
+  while (capacity < size && capacity <= (SIZE_MAX >> 1))
+    capacity <<= 1;
+  return capacity < size ? size : capacity;
+}
+
+int32_t GetNextBufferId() {
+  // Zero is never used for a valid buffer.
+  return g_next_buffer_id.GetNext() + 1;
+}
+
+}  // namespace
+
+XWalkSharedBufferPool::Buffer::Buffer()
+    : capacity(0),
+      in_use(false),
+      posted(false),
+      shared(false) {}
+
+XWalkSharedBufferPool::Buffer::~Buffer() {}
+
+XWalkSharedBufferPool::XWalkSharedBufferPool(size_t max_buffers,
+                                             size_t max_idle_buffers)
+    : max_buffers_(max_buffers),
+      max_idle_buffers_(max_idle_buffers),
+      idle_count_(0) {
+  DCHECK_LE(max_idle_buffers_, max_buffers_);
+}
+
+XWalkSharedBufferPool::~XWalkSharedBufferPool() {}
+
+int32_t XWalkSharedBufferPool::Acquire(size_t size, int32_t* dropped_id) {
+  base::AutoLock l(lock_);
+  *dropped_id = 0;
+
+  // Look for the smallest idle buffer that can hold the message.
+  Buffer* best = NULL;
+  int32_t best_id = 0;
+  for (const auto& entry : buffers_) {
+    Buffer* buffer = entry.second.get();
+    if (buffer->in_use || buffer->capacity < size)
+      continue;
+    if (!best || buffer->capacity < best->capacity) {
+      best = buffer;
+      best_id = entry.first;
+    }
+  }
+
+  if (best) {
+    best->in_use = true;
+    best->posted = false;
+    idle_count_--;
+    return best_id;
+  }
+
+  // When the pool is full, make room by dropping an idle buffer that is too
+  // small. Every buffer in use is still referenced by the peer, so there's
+  // nothing else we can do but fail.
+  if (buffers_.size() >= max_buffers_) {
+    BufferMap::iterator it = buffers_.begin();
+    while (it != buffers_.end() && it->second->in_use)
+      ++it;
+    if (it == buffers_.end())
+      return 0;
+    *dropped_id = it->first;
+    buffers_.erase(it);
+    idle_count_--;
+  }
+
+  std::unique_ptr<Buffer> buffer(new Buffer);
+  buffer->capacity = RoundUpBufferSize(size);
+  buffer->memory.reset(new base::SharedMemory);
+
+  // Allow the segment to be shared read-only, for when the peer only needs to
+  // read from it.
+  base::SharedMemoryCreateOptions options;
+  options.size = buffer->capacity;
+  options.share_read_only = true;
+  if (!buffer->memory->Create(options) ||
+      !buffer->memory->Map(buffer->capacity)) {
+    LOG(WARNING) << "Can't create shared buffer of " << buffer->capacity
+                 << " bytes.";
+    return 0;
+  }
+  buffer->in_use = true;
+
+  int32_t id = GetNextBufferId();
+  buffers_[id] = std::move(buffer);
+  return id;
+}
+
+void* XWalkSharedBufferPool::GetMemory(int32_t id) {
+  base::AutoLock l(lock_);
+  BufferMap::iterator it = buffers_.find(id);
+  if (it == buffers_.end() || !it->second->in_use)
+    return NULL;
+  return it->second->memory->memory();
+}
+
+base::SharedMemory* XWalkSharedBufferPool::TakeUnsharedMemory(int32_t id) {
+  base::AutoLock l(lock_);
+  BufferMap::iterator it = buffers_.find(id);
+  if (it == buffers_.end() || it->second->shared)
+    return NULL;
+  it->second->shared = true;
+  return it->second->memory.get();
+}
+
+bool XWalkSharedBufferPool::MarkPosted(int32_t id) {
+  base::AutoLock l(lock_);
+  BufferMap::iterator it = buffers_.find(id);
+  if (it == buffers_.end() || !it->second->in_use || it->second->posted)
+    return false;
+  it->second->posted = true;
+  return true;
+}
+
+bool XWalkSharedBufferPool::Release(int32_t id) {
+  base::AutoLock l(lock_);
+  BufferMap::iterator it = buffers_.find(id);
+  if (it == buffers_.end() || !it->second->in_use) {
+    LOG(WARNING) << "Trying to release invalid shared buffer: " << id;
+    return false;
+  }
+  return ReleaseLocked(it);
+}
+
+bool XWalkSharedBufferPool::Discard(int32_t id) {
+  base::AutoLock l(lock_);
+  BufferMap::iterator it = buffers_.find(id);
+  if (it == buffers_.end() || !it->second->in_use) {
+    LOG(WARNING) << "Trying to discard invalid shared buffer: " << id;
+    return false;
+  }
+  // The peer may still be reading it, it comes back through Release().
+  if (it->second->posted) {
+    LOG(WARNING) << "Ignoring discard of posted shared buffer: " << id;
+    return false;
+  }
+  return ReleaseLocked(it);
+}
+
+void XWalkSharedBufferPool::Destroy(int32_t id) {
+  base::AutoLock l(lock_);
+  BufferMap::iterator it = buffers_.find(id);
+  if (it == buffers_.end())
+    return;
+  if (!it->second->in_use)
+    idle_count_--;
+  buffers_.erase(it);
+}
+
+bool XWalkSharedBufferPool::ReleaseLocked(BufferMap::iterator it) {
+  lock_.AssertAcquired();
+  if (idle_count_ >= max_idle_buffers_) {
+    buffers_.erase(it);
+    return true;
+  }
+
+  it->second->in_use = false;
+  it->second->posted = false;
+  idle_count_++;
+  return false;
+}
+
+size_t XWalkSharedBufferPool::buffer_count() const {
+  base::AutoLock l(lock_);
+  return buffers_.size();
+}
+
+size_t XWalkSharedBufferPool::idle_buffer_count() const {
+  base::AutoLock l(lock_);
+  return idle_count_;
+}
+
+}  // namespace extensions
+}  // namespace xwalk
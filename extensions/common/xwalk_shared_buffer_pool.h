@@ -0,0 +1,100 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_COMMON_XWALK_SHARED_BUFFER_POOL_H_
+#define XWALK_EXTENSIONS_COMMON_XWALK_SHARED_BUFFER_POOL_H_
+
+#include <stdint.h>
+#include <map>
+#include <memory>
+
+#include "base/macros.h"
+#include "base/memory/shared_memory.h"
+#include "base/synchronization/lock.h"
+
+namespace xwalk {
+namespace extensions {
+
+// Keeps a set of shared memory segments that are handed to the peer process
+// only once and then recycled across messages. A buffer is "in use" from
+// Acquire() until the peer is done with it and Release() is called, after
+// that it stays idle in the pool until it fits a new request. A buffer in use
+// can be marked as posted once it was handed to the peer, after which only
+// the peer can give it back.
+//
+// Buffer ids are never reused and are unique across all pools of the process,
+// so the peer can safely cache its mapping of a buffer until it is told the
+// buffer was dropped.
+//
+// All methods are thread-safe.
+class XWalkSharedBufferPool {
+ public:
+  XWalkSharedBufferPool(size_t max_buffers, size_t max_idle_buffers);
+  ~XWalkSharedBufferPool();
+
+  // Returns the id of a buffer able to hold at least |size| bytes, reusing the
+  // smallest idle buffer that fits. Returns 0 if |max_buffers| are in use or
+  // the shared memory couldn't be created. If an idle buffer had to be
+  // destroyed to make room, its id is stored in |dropped_id| (otherwise 0), so
+  // the peer can drop its mapping.
+  int32_t Acquire(size_t size, int32_t* dropped_id);
+
+  // Returns the writable mapping of buffer |id|, or NULL for unknown ids.
+  void* GetMemory(int32_t id);
+
+  // Returns the segment backing buffer |id| if its handle was never sent to
+  // the peer and marks it as sent. Returns NULL if the peer already has the
+  // segment mapped or for unknown ids.
+  base::SharedMemory* TakeUnsharedMemory(int32_t id);
+
+  // Marks buffer |id| as handed to the peer. Returns false, and leaves the
+  // buffer untouched, for unknown, idle or already posted buffers.
+  bool MarkPosted(int32_t id);
+
+  // Gives buffer |id| back to the pool once the peer is done with it. Returns
+  // true if the buffer was destroyed instead of being kept idle, in which
+  // case the peer should drop its mapping if it has one.
+  bool Release(int32_t id);
+
+  // Like Release(), for a buffer that was acquired but never posted. Posted
+  // buffers are still referenced by the peer, so they are left alone.
+  bool Discard(int32_t id);
+
+  // Destroys buffer |id| whatever its state, e.g. when handing it to the peer
+  // failed.
+  void Destroy(int32_t id);
+
+  size_t buffer_count() const;
+  size_t idle_buffer_count() const;
+
+ private:
+  struct Buffer {
+    Buffer();
+    ~Buffer();
+
+    std::unique_ptr<base::SharedMemory> memory;
+    size_t capacity;
+    bool in_use;
+    bool posted;
+    bool shared;
+  };
+
+  typedef std::map<int32_t, std::unique_ptr<Buffer>> BufferMap;
+
+  // Must be called with |lock_| held.
+  bool ReleaseLocked(BufferMap::iterator it);
+
+  mutable base::Lock lock_;
+  BufferMap buffers_;
+  size_t max_buffers_;
+  size_t max_idle_buffers_;
+  size_t idle_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(XWalkSharedBufferPool);
+};
+
+}  // namespace extensions
+}  // namespace xwalk
+
+#endif  // XWALK_EXTENSIONS_COMMON_XWALK_SHARED_BUFFER_POOL_H_
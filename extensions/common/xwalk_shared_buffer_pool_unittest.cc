@@ -0,0 +1,98 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_shared_buffer_pool.h"
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+using xwalk::extensions::XWalkSharedBufferPool;
+
+TEST(XWalkSharedBufferPoolTest, ReusesReleasedBuffers) {
+  XWalkSharedBufferPool pool(4, 2);
+  int32_t dropped;
+
+  int32_t id = pool.Acquire(1000, &dropped);
+  ASSERT_NE(0, id);
+  EXPECT_EQ(0, dropped);
+  EXPECT_TRUE(pool.GetMemory(id));
+
+  // The handle is only handed out once.
+  EXPECT_TRUE(pool.TakeUnsharedMemory(id));
+  EXPECT_FALSE(pool.TakeUnsharedMemory(id));
+
+  EXPECT_FALSE(pool.Release(id));
+  EXPECT_FALSE(pool.GetMemory(id));
+  EXPECT_EQ(1u, pool.idle_buffer_count());
+
+  // A similar size fits in the same buffer, which is already shared.
+  EXPECT_EQ(id, pool.Acquire(2000, &dropped));
+  EXPECT_FALSE(pool.TakeUnsharedMemory(id));
+  EXPECT_EQ(0u, pool.idle_buffer_count());
+
+  // A bigger one doesn't.
+  int32_t big_id = pool.Acquire(1024 * 1024, &dropped);
+  EXPECT_NE(0, big_id);
+  EXPECT_NE(id, big_id);
+  EXPECT_EQ(2u, pool.buffer_count());
+}
+
+TEST(XWalkSharedBufferPoolTest, LimitsBuffers) {
+  XWalkSharedBufferPool pool(2, 1);
+  int32_t dropped;
+
+  int32_t first = pool.Acquire(10, &dropped);
+  int32_t second = pool.Acquire(10, &dropped);
+  ASSERT_NE(0, first);
+  ASSERT_NE(0, second);
+
+  // Every buffer is in use.
+  EXPECT_EQ(0, pool.Acquire(10, &dropped));
+
+  // Only one buffer is kept idle, the other is destroyed.
+  EXPECT_FALSE(pool.Release(first));
+  EXPECT_TRUE(pool.Release(second));
+  EXPECT_EQ(1u, pool.buffer_count());
+
+  // Releasing twice is an error.
+  EXPECT_FALSE(pool.Release(second));
+
+  // When the pool is full, an idle buffer that is too small gets replaced.
+  int32_t third = pool.Acquire(8 * 1024, &dropped);
+  EXPECT_NE(0, third);
+  EXPECT_EQ(0, dropped);
+  int32_t fourth = pool.Acquire(1024 * 1024, &dropped);
+  EXPECT_NE(0, fourth);
+  EXPECT_EQ(first, dropped);
+  EXPECT_EQ(2u, pool.buffer_count());
+}
+
+TEST(XWalkSharedBufferPoolTest, PostedBuffersAreOnlyReleasedByThePeer) {
+  XWalkSharedBufferPool pool(4, 2);
+  int32_t dropped;
+
+  int32_t discarded = pool.Acquire(10, &dropped);
+  ASSERT_NE(0, discarded);
+  EXPECT_FALSE(pool.Discard(discarded));
+  EXPECT_EQ(1u, pool.idle_buffer_count());
+  // Idle buffers can't be posted.
+  EXPECT_FALSE(pool.MarkPosted(discarded));
+
+  int32_t id = pool.Acquire(10, &dropped);
+  ASSERT_EQ(discarded, id);
+  EXPECT_TRUE(pool.MarkPosted(id));
+  // Posting twice would hand the peer a buffer it may still be reading.
+  EXPECT_FALSE(pool.MarkPosted(id));
+
+  // The peer still references the buffer, so it must stay in use.
+  EXPECT_FALSE(pool.Discard(id));
+  EXPECT_TRUE(pool.GetMemory(id));
+  EXPECT_EQ(0u, pool.idle_buffer_count());
+
+  EXPECT_FALSE(pool.Release(id));
+  EXPECT_EQ(1u, pool.idle_buffer_count());
+
+  // Reusing the buffer makes it postable again.
+  EXPECT_EQ(id, pool.Acquire(10, &dropped));
+  EXPECT_TRUE(pool.MarkPosted(id));
+}
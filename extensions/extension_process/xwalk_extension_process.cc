@@ -5,10 +5,12 @@
 #include "xwalk/extensions/extension_process/xwalk_extension_process.h"
 
 #include <string>
+#include <vector>
 
 #include "base/command_line.h"
 #include "base/files/file_path.h"
 #include "base/message_loop/message_loop.h"
+#include "base/stl_util.h"
 #include "ipc/attachment_broker_privileged.h"
 #include "ipc/ipc_switches.h"
 #include "ipc/ipc_message_macros.h"
@@ -30,10 +32,15 @@ XWalkExtensionProcess::XWalkExtensionProcess(
   CreateBrowserProcessChannel(channel_handle);
 }
 
+XWalkExtensionProcess::RenderProcessConnection::RenderProcessConnection() {}
+
+XWalkExtensionProcess::RenderProcessConnection::~RenderProcessConnection() {}
+
 XWalkExtensionProcess::~XWalkExtensionProcess() {
   // FIXME(jeez): Move this to OnChannelClosing/Error/Disconnected when we have
   // our MessageFilter set.
-  extensions_server_.Invalidate();
+  for (const auto& connection : render_process_connections_)
+    connection.second->server.Invalidate();
 
   shutdown_event_.Signal();
   io_thread_.Stop();
@@ -44,6 +51,10 @@ bool XWalkExtensionProcess::OnMessageReceived(const IPC::Message& message) {
   IPC_BEGIN_MESSAGE_MAP(XWalkExtensionProcess, message)
     IPC_MESSAGE_HANDLER(XWalkExtensionProcessMsg_RegisterExtensions,
                         OnRegisterExtensions)
+    IPC_MESSAGE_HANDLER(XWalkExtensionProcessMsg_CreateRenderProcessChannel,
+                        OnCreateRenderProcessChannel)
+    IPC_MESSAGE_HANDLER(XWalkExtensionProcessMsg_CloseRenderProcessChannel,
+                        OnCloseRenderProcessChannel)
     IPC_MESSAGE_UNHANDLED(handled = false)
   IPC_END_MESSAGE_MAP()
   return handled;
@@ -78,7 +89,11 @@ void XWalkExtensionProcess::OnRegisterExtensions(
     RegisterExternalExtensionsInDirectory(&extensions_server_, path,
                                           std::move(browser_variables));
   }
-  CreateRenderProcessChannel();
+
+  std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams> extensions;
+  extensions_server_.OnGetExtensions(&extensions);
+  browser_process_channel_->Send(
+      new XWalkExtensionProcessHostMsg_ExtensionsRegistered(extensions));
 }
 
 void XWalkExtensionProcess::CreateBrowserProcessChannel(
@@ -100,33 +115,55 @@ void XWalkExtensionProcess::CreateBrowserProcessChannel(
   }
 }
 
-void XWalkExtensionProcess::CreateRenderProcessChannel() {
+void XWalkExtensionProcess::OnCreateRenderProcessChannel(
+    int render_process_id) {
+  if (ContainsKey(render_process_connections_, render_process_id)) {
+    LOG(WARNING) << "There's already a channel for render process "
+                 << render_process_id;
+    return;
+  }
+
+  std::unique_ptr<RenderProcessConnection> connection(
+      new RenderProcessConnection);
+  connection->server.UseExtensionsFrom(extensions_server_);
+
   IPC::ChannelHandle handle(IPC::Channel::GenerateVerifiedChannelID(
       std::string()));
-  rp_channel_handle_ = handle;
-
-  render_process_channel_ = IPC::SyncChannel::Create(rp_channel_handle_,
-      IPC::Channel::MODE_SERVER, &extensions_server_,
+  connection->channel = IPC::SyncChannel::Create(handle,
+      IPC::Channel::MODE_SERVER, &connection->server,
       io_thread_.task_runner(), true, &shutdown_event_);
 
 #if defined(OS_POSIX)
     // On POSIX, pass the server-side file descriptor. We use
     // TakeClientFileDescriptor() instead of GetClientFileDescriptor()
     // since the client-side channel will take ownership of the fd.
-    rp_channel_handle_.socket = base::FileDescriptor(
-      render_process_channel_->TakeClientFileDescriptor());
+    handle.socket = base::FileDescriptor(
+      connection->channel->TakeClientFileDescriptor());
 #endif
 
-  extensions_server_.Initialize(render_process_channel_.get());
+  connection->server.Initialize(connection->channel.get());
+  render_process_connections_[render_process_id] = std::move(connection);
 
   browser_process_channel_->Send(
       new XWalkExtensionProcessHostMsg_RenderProcessChannelCreated(
-          rp_channel_handle_));
+          render_process_id, handle));
+}
+
+void XWalkExtensionProcess::OnCloseRenderProcessChannel(
+    int render_process_id) {
+  RenderProcessConnectionMap::iterator it =
+      render_process_connections_.find(render_process_id);
+  if (it == render_process_connections_.end())
+    return;
+
+  it->second->server.Invalidate();
+  render_process_connections_.erase(it);
 }
 
 bool XWalkExtensionProcess::CheckAPIAccessControl(
     const std::string& extension_name,
     const std::string& api_name) {
+  base::AutoLock lock(permissions_lock_);
   PermissionCacheType::iterator iter =
       permission_cache_.find(extension_name + api_name);
   if (iter != permission_cache_.end())
@@ -152,6 +189,7 @@ bool XWalkExtensionProcess::CheckAPIAccessControl(
 bool XWalkExtensionProcess::RegisterPermissions(
     const std::string& extension_name,
     const std::string& perm_table) {
+  base::AutoLock lock(permissions_lock_);
   bool result = false;
   browser_process_channel_->Send(
       new XWalkExtensionProcessHostMsg_RegisterPermissions(
@@ -6,9 +6,11 @@
 #define XWALK_EXTENSIONS_EXTENSION_PROCESS_XWALK_EXTENSION_PROCESS_H_
 
 #include <map>
+#include <memory>
 #include <string>
 
 #include "base/values.h"
+#include "base/synchronization/lock.h"
 #include "base/synchronization/waitable_event.h"
 #include "base/threading/thread.h"
 #include "ipc/ipc_channel_handle.h"
@@ -34,9 +36,12 @@ class XWalkExtensionRunner;
 // This class represents the Extension Process itself.
 // It not only represents the extension side of the browser <->
 // extension process communication channel, but also the extension side
-// of the extension <-> render process channel.
+// of the extension <-> render process channels.
 // It will be responsible for handling the native side (instances) of
-// External extensions through its XWalkExtensionServer.
+// External extensions through its XWalkExtensionServers. The extensions are
+// loaded once, and each render process using this process gets its own
+// channel and server, so the instance ids of different render processes
+// don't clash.
 class XWalkExtensionProcess : public IPC::Listener,
                               public XWalkExtension::PermissionsDelegate {
  public:
@@ -56,17 +61,33 @@ class XWalkExtensionProcess : public IPC::Listener,
   // Handlers for IPC messages from XWalkExtensionProcessHost.
   void OnRegisterExtensions(const base::FilePath& extension_path,
                             const base::ListValue& browser_variables);
+  void OnCreateRenderProcessChannel(int render_process_id);
+  void OnCloseRenderProcessChannel(int render_process_id);
 
   void CreateBrowserProcessChannel(const IPC::ChannelHandle& channel_handle);
 
-  void CreateRenderProcessChannel();
+  struct RenderProcessConnection {
+    RenderProcessConnection();
+    ~RenderProcessConnection();
+
+    // Declared first so it is destroyed after the channel.
+    XWalkExtensionServer server;
+    std::unique_ptr<IPC::SyncChannel> channel;
+  };
 
   base::WaitableEvent shutdown_event_;
   base::Thread io_thread_;
   std::unique_ptr<IPC::SyncChannel> browser_process_channel_;
+
+  // Owns the loaded extensions, never connected to a render process.
   XWalkExtensionServer extensions_server_;
-  std::unique_ptr<IPC::SyncChannel> render_process_channel_;
-  IPC::ChannelHandle rp_channel_handle_;
+
+  typedef std::map<int, std::unique_ptr<RenderProcessConnection>>
+      RenderProcessConnectionMap;
+  RenderProcessConnectionMap render_process_connections_;
+  // Extensions can ask for permissions from several loading threads at once,
+  // while only one sync message can be pending on the browser channel.
+  base::Lock permissions_lock_;
   typedef std::map<std::string, RuntimePermission> PermissionCacheType;
   PermissionCacheType permission_cache_;
 
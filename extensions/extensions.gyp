@@ -18,12 +18,16 @@
         '../../build/filename_rules.gypi',
       ],
       'sources': [
+        'browser/xwalk_extension_code_cache_store.cc',
+        'browser/xwalk_extension_code_cache_store.h',
         'browser/xwalk_extension_data.cc',
         'browser/xwalk_extension_data.h',
         'browser/xwalk_extension_function_handler.cc',
         'browser/xwalk_extension_function_handler.h',
         'browser/xwalk_extension_process_host.cc',
         'browser/xwalk_extension_process_host.h',
+        'browser/xwalk_extension_registry_snapshot.cc',
+        'browser/xwalk_extension_registry_snapshot.h',
         'browser/xwalk_extension_service.cc',
         'browser/xwalk_extension_service.h',
         'common/android/xwalk_extension_android.cc',
@@ -32,6 +36,8 @@
         'common/android/xwalk_native_extension_loader_android.h',
         'common/xwalk_extension.cc',
         'common/xwalk_extension.h',
+        'common/xwalk_extension_message_batcher.cc',
+        'common/xwalk_extension_message_batcher.h',
         'common/xwalk_extension_messages.cc',
         'common/xwalk_extension_messages.h',
         'common/xwalk_extension_server.cc',
@@ -45,6 +51,8 @@
         'common/xwalk_external_extension.h',
         'common/xwalk_external_instance.cc',
         'common/xwalk_external_instance.h',
+        'common/xwalk_shared_buffer_pool.cc',
+        'common/xwalk_shared_buffer_pool.h',
         'common/xwalk_extension_permission_types.h',
         'extension_process/xwalk_extension_process_main.cc',
         'extension_process/xwalk_extension_process_main.h',
@@ -53,11 +61,16 @@
         'extension_process/xwalk_extension_process_main.cc',
         'extension_process/xwalk_extension_process_main.h',
         'public/XW_Extension.h',
+        'public/XW_Extension_EncodedMessage.h',
         'public/XW_Extension_Message_2.h',
+        'public/XW_Extension_Message_3.h',
+        'public/XW_Extension_MessageWithReply.h',
         'public/XW_Extension_Permissions.h',
         'public/XW_Extension_SyncMessage.h',
         'renderer/xwalk_extension_client.cc',
         'renderer/xwalk_extension_client.h',
+        'renderer/xwalk_extension_code_cache.cc',
+        'renderer/xwalk_extension_code_cache.h',
         'renderer/xwalk_extension_module.cc',
         'renderer/xwalk_extension_module.h',
         'renderer/xwalk_extension_renderer_controller.cc',
@@ -69,6 +82,8 @@
         'renderer/xwalk_module_system.h',
         'renderer/xwalk_v8_utils.cc',
         'renderer/xwalk_v8_utils.h',
+        'renderer/xwalk_v8_value_encoder.cc',
+        'renderer/xwalk_v8_value_encoder.h',
         'renderer/xwalk_v8tools_module.cc',
         'renderer/xwalk_v8tools_module.h',
       ],
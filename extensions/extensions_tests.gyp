@@ -11,7 +11,10 @@
       ],
       'sources': [
         'browser/xwalk_extension_function_handler_unittest.cc',
+        'browser/xwalk_extension_registry_snapshot_unittest.cc',
+        'common/xwalk_extension_message_batcher_unittest.cc',
         'common/xwalk_extension_server_unittest.cc',
+        'common/xwalk_shared_buffer_pool_unittest.cc',
       ],
     },
     {
@@ -24,6 +27,7 @@
         '../../net/net.gyp:net',
         '../../skia/skia.gyp:skia',
         '../../testing/gtest.gyp:gtest',
+        '../../testing/perf/perf_test.gyp:perf_test',
         '../test/base/base.gyp:xwalk_test_base',
         '../xwalk.gyp:xwalk_runtime',
         'extensions.gyp:xwalk_extensions',
@@ -45,6 +45,57 @@
         }],
       ],
     },
+    {
+      'target_name': 'echo_extension_messaging_3',
+      'type': 'loadable_module',
+      'variables': {
+        'mac_strip': 0,
+      },
+      'sources': [
+        'test/echo_extension_messaging_3.c',
+      ],
+      'conditions': [
+        ['OS=="win"', {
+          'product_dir': '<(PRODUCT_DIR)\\tests\\extension\\echo_extension\\'
+        }, {
+          'product_dir': '<(PRODUCT_DIR)/tests/extension/echo_extension/'
+        }],
+      ],
+    },
+    {
+      'target_name': 'echo_extension_encoded_message',
+      'type': 'loadable_module',
+      'variables': {
+        'mac_strip': 0,
+      },
+      'sources': [
+        'test/echo_extension_encoded_message.c',
+      ],
+      'conditions': [
+        ['OS=="win"', {
+          'product_dir': '<(PRODUCT_DIR)\\tests\\extension\\echo_extension\\'
+        }, {
+          'product_dir': '<(PRODUCT_DIR)/tests/extension/echo_extension/'
+        }],
+      ],
+    },
+    {
+      'target_name': 'echo_extension_with_reply',
+      'type': 'loadable_module',
+      'variables': {
+        'mac_strip': 0,
+      },
+      'sources': [
+        'test/echo_extension_with_reply.c',
+      ],
+      'conditions': [
+        ['OS=="win"', {
+          'product_dir': '<(PRODUCT_DIR)\\tests\\extension\\echo_extension\\'
+        }, {
+          'product_dir': '<(PRODUCT_DIR)/tests/extension/echo_extension/'
+        }],
+      ],
+    },
     {
       'target_name': 'bad_extension',
       'type': 'loadable_module',
@@ -130,5 +181,22 @@
         }],
       ],
     },
+    {
+      'target_name': 'ipc_benchmark_extension',
+      'type': 'loadable_module',
+      'variables': {
+        'mac_strip': 0,
+      },
+      'sources': [
+        'test/ipc_benchmark_extension.c',
+      ],
+      'conditions': [
+        ['OS=="win"', {
+          'product_dir': '<(PRODUCT_DIR)\\tests\\extension\\ipc_benchmark_extension\\'
+        }, {
+          'product_dir': '<(PRODUCT_DIR)/tests/extension/ipc_benchmark_extension/'
+        }],
+      ],
+    },
   ],
 }
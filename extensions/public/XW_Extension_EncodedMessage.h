@@ -0,0 +1,222 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_ENCODEDMESSAGE_H_
+#define XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_ENCODEDMESSAGE_H_
+
+#ifndef XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_H_
+#error "You should include XW_Extension.h before this file"
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// XW_ENCODED_MESSAGING_INTERFACE: receive the messages posted with
+// extension.postEncodedMessage(). The JavaScript value is written straight
+// into a compact binary buffer instead of being converted into a tree of
+// intermediate objects, which is much cheaper for big arrays and objects.
+// Encoded messages have their own callback, so they are never mixed up with
+// ArrayBuffers posted with extension.postMessage(), which still go to the
+// binary callback of XW_MessagingInterface_2. The buffer can be walked with
+// the functions below without any allocation.
+//
+// JavaScript values are mapped as follows:
+//   - null and undefined: XW_VALUE_NULL.
+//   - booleans: XW_VALUE_BOOLEAN.
+//   - numbers: XW_VALUE_INT if they fit in an int32_t, XW_VALUE_DOUBLE
+//     otherwise. Dates are sent as their time value.
+//   - strings: XW_VALUE_STRING, UTF-8 encoded.
+//   - ArrayBuffer and its views: XW_VALUE_BINARY.
+//   - arrays: XW_VALUE_ARRAY, functions and symbols in them become null.
+//   - other objects: XW_VALUE_OBJECT with their own enumerable properties.
+//     Properties with functions, symbols or undefined are left out.
+// Values nested deeper than XW_ENCODED_MESSAGE_MAX_DEPTH, like those with
+// cycles, can't be posted.
+//
+// The format, for reference: a 4 bytes header "XWE" followed by the version,
+// then the value. Each value is a type byte followed by:
+//   - XW_VALUE_NULL: nothing.
+//   - XW_VALUE_BOOLEAN: one byte, 0 or 1.
+//   - XW_VALUE_INT: the zigzag encoded value as a varint.
+//   - XW_VALUE_DOUBLE: 8 bytes, in the byte order of the host.
+//   - XW_VALUE_STRING, XW_VALUE_BINARY: the size as a varint, then the bytes.
+//   - XW_VALUE_ARRAY: the number of elements as a varint, then the elements.
+//   - XW_VALUE_OBJECT: the number of members as a varint, then for each
+//     member the key size as a varint, the key bytes and the value.
+// Varints are unsigned LEB128, at most 5 bytes long.
+//
+
+#define XW_ENCODED_MESSAGING_INTERFACE_1 "XW_EncodedMessagingInterface_1"
+#define XW_ENCODED_MESSAGING_INTERFACE XW_ENCODED_MESSAGING_INTERFACE_1
+
+#define XW_ENCODED_MESSAGE_VERSION 1
+#define XW_ENCODED_MESSAGE_MAX_DEPTH 100
+
+typedef void (*XW_HandleEncodedMessageCallback)(XW_Instance instance,
+                                                const char* message,
+                                                const size_t size);
+
+struct XW_EncodedMessagingInterface_1 {
+  // Register the callback called for every message posted with
+  // extension.postEncodedMessage(). |message| is only valid during the call.
+  void (*Register)(XW_Extension extension,
+                   XW_HandleEncodedMessageCallback handle_message);
+};
+
+typedef struct XW_EncodedMessagingInterface_1 XW_EncodedMessagingInterface;
+
+typedef enum {
+  XW_VALUE_NULL = 0,
+  XW_VALUE_BOOLEAN = 1,
+  XW_VALUE_INT = 2,
+  XW_VALUE_DOUBLE = 3,
+  XW_VALUE_STRING = 4,
+  XW_VALUE_BINARY = 5,
+  XW_VALUE_ARRAY = 6,
+  XW_VALUE_OBJECT = 7
+} XW_ValueType;
+
+typedef struct XW_ValueReader {
+  const unsigned char* position;
+  const unsigned char* end;
+} XW_ValueReader;
+
+typedef struct XW_Value {
+  XW_ValueType type;
+  int boolean_value;
+  int32_t int_value;
+  double double_value;
+  // XW_VALUE_STRING and XW_VALUE_BINARY. Points into the message and is not
+  // NUL terminated.
+  const char* data;
+  size_t size;
+  // XW_VALUE_ARRAY and XW_VALUE_OBJECT. The elements or members follow, and
+  // must be read or skipped before the next value.
+  uint32_t count;
+} XW_Value;
+
+static inline int XW_ValueReader_ReadVarint(XW_ValueReader* reader,
+                                            uint32_t* value) {
+  uint32_t result = 0;
+  int shift;
+  for (shift = 0; shift < 35; shift += 7) {
+    unsigned char byte;
+    if (reader->position == reader->end)
+      return 0;
+    byte = *reader->position++;
+    result |= (uint32_t)(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) {
+      *value = result;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static inline int XW_ValueReader_ReadBytes(XW_ValueReader* reader,
+                                           const char** data, size_t* size) {
+  uint32_t length;
+  if (!XW_ValueReader_ReadVarint(reader, &length) ||
+      length > (size_t)(reader->end - reader->position))
+    return 0;
+  *data = (const char*)reader->position;
+  *size = length;
+  reader->position += length;
+  return 1;
+}
+
+// Returns 0 if |message| was encoded with an unsupported format version.
+static inline int XW_ValueReader_Init(XW_ValueReader* reader,
+                                      const char* message, size_t size) {
+  if (size < 4 || memcmp(message, "XWE", 3) != 0 ||
+      message[3] != XW_ENCODED_MESSAGE_VERSION)
+    return 0;
+  reader->position = (const unsigned char*)message + 4;
+  reader->end = (const unsigned char*)message + size;
+  return 1;
+}
+
+static inline int XW_ValueReader_AtEnd(const XW_ValueReader* reader) {
+  return reader->position == reader->end;
+}
+
+// Reads the next value. Returns 0 if the message is malformed.
+static inline int XW_ValueReader_ReadValue(XW_ValueReader* reader,
+                                           XW_Value* value) {
+  uint32_t number;
+  if (reader->position == reader->end)
+    return 0;
+  value->type = (XW_ValueType)*reader->position++;
+  switch (value->type) {
+    case XW_VALUE_NULL:
+      return 1;
+    case XW_VALUE_BOOLEAN:
+      if (reader->position == reader->end)
+        return 0;
+      value->boolean_value = *reader->position++ != 0;
+      return 1;
+    case XW_VALUE_INT:
+      if (!XW_ValueReader_ReadVarint(reader, &number))
+        return 0;
+      value->int_value = (int32_t)((number >> 1) ^ (~(number & 1) + 1));
+      return 1;
+    case XW_VALUE_DOUBLE:
+      if (reader->end - reader->position < (ptrdiff_t)sizeof(double))
+        return 0;
+      memcpy(&value->double_value, reader->position, sizeof(double));
+      reader->position += sizeof(double);
+      return 1;
+    case XW_VALUE_STRING:
+    case XW_VALUE_BINARY:
+      return XW_ValueReader_ReadBytes(reader, &value->data, &value->size);
+    case XW_VALUE_ARRAY:
+    case XW_VALUE_OBJECT:
+      return XW_ValueReader_ReadVarint(reader, &value->count);
+  }
+  return 0;
+}
+
+// Reads the key of the next member of an object.
+static inline int XW_ValueReader_ReadKey(XW_ValueReader* reader,
+                                         const char** key, size_t* size) {
+  return XW_ValueReader_ReadBytes(reader, key, size);
+}
+
+static inline int XW_ValueReader_SkipValueWithDepth(XW_ValueReader* reader,
+                                                    int depth) {
+  XW_Value value;
+  uint32_t i;
+  if (depth > XW_ENCODED_MESSAGE_MAX_DEPTH ||
+      !XW_ValueReader_ReadValue(reader, &value))
+    return 0;
+  if (value.type != XW_VALUE_ARRAY && value.type != XW_VALUE_OBJECT)
+    return 1;
+  for (i = 0; i < value.count; ++i) {
+    const char* key;
+    size_t key_size;
+    if (value.type == XW_VALUE_OBJECT &&
+        !XW_ValueReader_ReadKey(reader, &key, &key_size))
+      return 0;
+    if (!XW_ValueReader_SkipValueWithDepth(reader, depth + 1))
+      return 0;
+  }
+  return 1;
+}
+
+// Skips the next value, with all its elements or members.
+static inline int XW_ValueReader_SkipValue(XW_ValueReader* reader) {
+  return XW_ValueReader_SkipValueWithDepth(reader, 0);
+}
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_ENCODEDMESSAGE_H_
@@ -0,0 +1,56 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_MESSAGEWITHREPLY_H_
+#define XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_MESSAGEWITHREPLY_H_
+
+#ifndef XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_H_
+#error "You should include XW_Extension.h before this file"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// XW_MESSAGE_WITH_REPLY_INTERFACE: allow JavaScript code to send a message
+// and get the reply asynchronously, via the Promise returned by
+// extension.sendMessageWithReply(). Unlike sync messages, many requests can
+// be in flight at the same time for the same instance, and the web content
+// doesn't block while waiting for them.
+//
+
+#define XW_MESSAGE_WITH_REPLY_INTERFACE_1 "XW_MessageWithReplyInterface_1"
+#define XW_MESSAGE_WITH_REPLY_INTERFACE XW_MESSAGE_WITH_REPLY_INTERFACE_1
+
+// XW_Request identifies a message waiting for a reply. It is only unique
+// within the instance that received the message.
+typedef int32_t XW_Request;
+
+typedef void (*XW_HandleMessageWithReplyCallback)(XW_Instance instance,
+                                                  XW_Request request,
+                                                  const char* message);
+
+struct XW_MessageWithReplyInterface_1 {
+  // Register the callback called for every message sent with
+  // extension.sendMessageWithReply().
+  void (*Register)(XW_Extension extension,
+                   XW_HandleMessageWithReplyCallback handle_message);
+
+  // Resolve the Promise associated with |request| with |reply|. Every request
+  // must be replied exactly once, but not necessarily from the context of the
+  // callback nor in the order they were received.
+  //
+  // This function is thread-safe and can be called until the instance is
+  // destroyed.
+  void (*Reply)(XW_Instance instance, XW_Request request, const char* reply);
+};
+
+typedef struct XW_MessageWithReplyInterface_1 XW_MessageWithReplyInterface;
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_MESSAGEWITHREPLY_H_
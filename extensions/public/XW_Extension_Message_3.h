@@ -0,0 +1,75 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_MESSAGE_3_H_
+#define XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_MESSAGE_3_H_
+
+#ifndef XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_H_
+#error "You should include XW_Extension.h before this file"
+#endif
+
+#include "XW_Extension_Message_2.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define XW_MESSAGING_INTERFACE_3 "XW_MessagingInterface_3"
+
+// XW_Buffer identifies a shared memory buffer allocated for an instance. As
+// with XW_Instance, the zero value is never used by Crosswalk.
+typedef int32_t XW_Buffer;
+
+struct XW_MessagingInterface_3 {
+  // The first four functions behave exactly like the ones with the same name
+  // in XW_MessagingInterface_2.
+  void (*Register)(XW_Extension extension,
+                   XW_HandleMessageCallback handle_message);
+  void (*PostMessage)(XW_Instance instance, const char* message);
+  void (*RegisterBinaryMessageCallback)(
+      XW_Extension extension,
+      XW_HandleBinaryMessageCallback handle_message);
+  void (*PostBinaryMessage)(XW_Instance instance,
+                            const char* message, size_t size);
+
+  // Allocate a buffer of at least |size| bytes that is shared with the web
+  // content associated with the instance. Returns a pointer to writable
+  // memory and stores the buffer identifier in |buffer|. Returns NULL if no
+  // buffer is available, which happens when too many buffers are still being
+  // referenced by JavaScript.
+  //
+  // The buffer can be filled in place and then handed to JavaScript with
+  // PostBuffer() without any copies, or given back with DiscardBuffer().
+  //
+  // This function is thread-safe and can be called until the instance is
+  // destroyed.
+  void* (*AllocateBuffer)(XW_Instance instance, size_t size,
+                          XW_Buffer* buffer);
+
+  // Post the first |size| bytes of |buffer| to the web content. The message
+  // listener set with extension.setMessageListener() receives an ArrayBuffer
+  // object backed directly by the shared memory. The buffer must not be
+  // touched after this call: it is recycled by Crosswalk once JavaScript
+  // drops every reference to the ArrayBuffer.
+  //
+  // This function is thread-safe and can be called until the instance is
+  // destroyed.
+  void (*PostBuffer)(XW_Instance instance, XW_Buffer buffer, size_t size);
+
+  // Give back a buffer that was allocated but won't be posted. Buffers that
+  // were already posted are ignored, they are only recycled once JavaScript
+  // is done with them.
+  //
+  // This function is thread-safe and can be called until the instance is
+  // destroyed.
+  void (*DiscardBuffer)(XW_Instance instance, XW_Buffer buffer);
+};
+
+typedef struct XW_MessagingInterface_3 XW_MessagingInterface3;
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_MESSAGE_3_H_
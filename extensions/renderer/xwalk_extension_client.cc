@@ -4,6 +4,8 @@
 
 #include "xwalk/extensions/renderer/xwalk_extension_client.h"
 
+#include <limits>
+
 #include "base/values.h"
 #include "base/numerics/safe_conversions.h"
 #include "base/stl_util.h"
@@ -22,8 +24,38 @@ XWalkExtensionClient::~XWalkExtensionClient() {
   STLDeleteValues(&extension_apis_);
 }
 
+bool XWalkExtensionClient::EnsureConnected() {
+  if (!sender_ && !connect_callback_.is_null()) {
+    sender_ = connect_callback_.Run();
+    connect_callback_.Reset();
+    if (sender_)
+      CheckRegisteredExtensions();
+  }
+  return sender_ != NULL;
+}
+
+void XWalkExtensionClient::CheckRegisteredExtensions() {
+  // The extensions were installed from what a previous launch registered,
+  // one may have failed to register this time. No instance of those is ever
+  // created, so calls to them fail instead of waiting for a reply.
+  std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams> extensions;
+  sender_->Send(new XWalkExtensionServerMsg_GetExtensions(&extensions));
+  std::set<std::string> registered;
+  for (const auto& extension : extensions)
+    registered.insert(extension.name);
+  for (const auto& api : extension_apis_) {
+    if (ContainsKey(registered, api.first))
+      continue;
+    LOG(WARNING) << "Extension " << api.first << " is not registered anymore.";
+    unregistered_extensions_.insert(api.first);
+  }
+}
+
 bool XWalkExtensionClient::Send(IPC::Message* msg) {
-  DCHECK(sender_);
+  if (!EnsureConnected()) {
+    delete msg;
+    return false;
+  }
 
   return sender_->Send(msg);
 }
@@ -32,6 +64,9 @@ int64_t XWalkExtensionClient::CreateInstance(
     const std::string& extension_name,
     InstanceHandler* handler) {
   CHECK(handler);
+  if (!EnsureConnected() ||
+      ContainsKey(unregistered_extensions_, extension_name))
+    return 0;
   if (!Send(new XWalkExtensionServerMsg_CreateInstance(next_instance_id_,
                                                        extension_name))) {
     return 0;
@@ -45,8 +80,19 @@ bool XWalkExtensionClient::OnMessageReceived(const IPC::Message& message) {
   IPC_BEGIN_MESSAGE_MAP(XWalkExtensionClient, message)
     IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_PostMessageToJS,
         OnPostMessageToJS)
+    IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_PostMessageBatchToJS,
+        OnPostMessageBatchToJS)
+    IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_ReplyToJS, OnReplyToJS)
     IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_PostOutOfLineMessageToJS,
         OnPostOutOfLineMessageToJS)
+    IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_PostPooledOutOfLineMessageToJS,
+        OnPostPooledOutOfLineMessageToJS)
+    IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_DropOutOfLineSegment,
+        OnDropOutOfLineSegment)
+    IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_PostSharedBufferToJS,
+        OnPostSharedBufferToJS)
+    IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_DropSharedBuffer,
+        OnDropSharedBuffer)
     IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_InstanceDestroyed,
         OnInstanceDestroyed)
     IPC_MESSAGE_UNHANDLED(handled = false)
@@ -55,6 +101,12 @@ bool XWalkExtensionClient::OnMessageReceived(const IPC::Message& message) {
   return handled;
 }
 
+XWalkExtensionClient::SharedBuffer::SharedBuffer()
+    : in_use(false),
+      dropped(false) {}
+
+XWalkExtensionClient::SharedBuffer::~SharedBuffer() {}
+
 XWalkExtensionClient::ExtensionCodePoints::ExtensionCodePoints() {
 }
 
@@ -80,6 +132,41 @@ void XWalkExtensionClient::OnPostMessageToJS(int64_t instance_id,
   it->second->HandleMessageFromNative(*value);
 }
 
+void XWalkExtensionClient::OnPostMessageBatchToJS(
+    int64_t instance_id, const base::ListValue& messages) {
+  HandlerMap::const_iterator it = handlers_.find(instance_id);
+  if (it == handlers_.end()) {
+    LOG(WARNING) << "Can't PostMessage to invalid Extension instance id: "
+                 << instance_id;
+    return;
+  }
+
+  // See comment in DestroyInstance() about two step destruction.
+  if (!it->second)
+    return;
+
+  it->second->HandleMessageBatchFromNative(messages);
+}
+
+void XWalkExtensionClient::OnReplyToJS(int64_t instance_id,
+                                       int32_t request_id,
+                                       const base::ListValue& reply) {
+  HandlerMap::const_iterator it = handlers_.find(instance_id);
+  if (it == handlers_.end()) {
+    LOG(WARNING) << "Can't reply to invalid Extension instance id: "
+                 << instance_id;
+    return;
+  }
+
+  // See comment in DestroyInstance() about two step destruction.
+  if (!it->second)
+    return;
+
+  const base::Value* value = NULL;
+  reply.Get(0, &value);
+  it->second->HandleReplyFromNative(request_id, value);
+}
+
 void XWalkExtensionClient::OnPostOutOfLineMessageToJS(
     base::SharedMemoryHandle handle, size_t size) {
   CHECK(base::SharedMemory::IsHandleValid(handle));
@@ -93,6 +180,117 @@ void XWalkExtensionClient::OnPostOutOfLineMessageToJS(
   OnMessageReceived(message);
 }
 
+void XWalkExtensionClient::OnPostPooledOutOfLineMessageToJS(
+    int64_t instance_id, int32_t segment_id, base::SharedMemoryHandle handle,
+    uint64_t capacity, uint64_t size) {
+  std::unique_ptr<base::SharedMemory>& shared_memory =
+      out_of_line_segments_[segment_id];
+
+  if (base::SharedMemory::IsHandleValid(handle)) {
+    shared_memory.reset(new base::SharedMemory(handle, true));
+    if (!shared_memory->Map(base::checked_cast<size_t>(capacity))) {
+      LOG(WARNING) << "Can't map out of line segment " << segment_id;
+      out_of_line_segments_.erase(segment_id);
+      return;
+    }
+  }
+
+  if (!shared_memory || size > shared_memory->mapped_size()) {
+    LOG(WARNING) << "Got invalid out of line segment " << segment_id;
+    out_of_line_segments_.erase(segment_id);
+    return;
+  }
+
+  // The message reads straight from the segment, so it must be dispatched
+  // before the segment is released.
+  {
+    IPC::Message message(static_cast<char*>(shared_memory->memory()),
+                         base::checked_cast<int>(size));
+    OnMessageReceived(message);
+  }
+
+  Send(new XWalkExtensionServerMsg_ReleaseOutOfLineSegment(instance_id,
+                                                           segment_id));
+}
+
+void XWalkExtensionClient::OnDropOutOfLineSegment(int32_t segment_id) {
+  out_of_line_segments_.erase(segment_id);
+}
+
+void XWalkExtensionClient::OnPostSharedBufferToJS(
+    int64_t instance_id, int32_t buffer_id, base::SharedMemoryHandle handle,
+    uint64_t capacity, uint64_t size) {
+  SharedBufferKey key(instance_id, buffer_id);
+  SharedBuffer& buffer = shared_buffers_[key];
+  // The server never posts a buffer again before JS released it, so this
+  // would point a second ArrayBuffer at memory the first one still uses.
+  if (buffer.in_use) {
+    LOG(WARNING) << "Got shared buffer " << buffer_id
+                 << " that is still in use for Extension instance id: "
+                 << instance_id;
+    return;
+  }
+  std::unique_ptr<base::SharedMemory>& shared_memory = buffer.memory;
+
+  if (base::SharedMemory::IsHandleValid(handle)) {
+    shared_memory.reset(new base::SharedMemory(handle, false));
+    if (!shared_memory->Map(base::checked_cast<size_t>(capacity))) {
+      LOG(WARNING) << "Can't map shared buffer " << buffer_id
+                   << " for Extension instance id: " << instance_id;
+      shared_buffers_.erase(key);
+      return;
+    }
+  }
+
+  if (!shared_memory || size > shared_memory->mapped_size()) {
+    LOG(WARNING) << "Got invalid shared buffer " << buffer_id
+                 << " for Extension instance id: " << instance_id;
+    shared_buffers_.erase(key);
+    return;
+  }
+
+  HandlerMap::const_iterator it = handlers_.find(instance_id);
+  // See comment in DestroyInstance() about two step destruction.
+  if (it == handlers_.end() || !it->second)
+    return;
+
+  // The handler may release the buffer right away, so mark it first.
+  buffer.in_use = true;
+  it->second->HandleSharedBufferFromNative(
+      buffer_id, shared_memory->memory(), base::checked_cast<size_t>(size));
+}
+
+void XWalkExtensionClient::OnDropSharedBuffer(int64_t instance_id,
+                                              int32_t buffer_id) {
+  SharedBufferMap::iterator it =
+      shared_buffers_.find(SharedBufferKey(instance_id, buffer_id));
+  if (it == shared_buffers_.end())
+    return;
+  // Unmapping now would leave the ArrayBuffer pointing to nothing.
+  if (it->second.in_use) {
+    LOG(WARNING) << "Shared buffer " << buffer_id << " dropped while in use "
+                 << "by JS, unmapping it once released.";
+    it->second.dropped = true;
+    return;
+  }
+  shared_buffers_.erase(it);
+}
+
+void XWalkExtensionClient::ReleaseSharedBuffer(int64_t instance_id,
+                                               int32_t buffer_id) {
+  SharedBufferMap::iterator it =
+      shared_buffers_.find(SharedBufferKey(instance_id, buffer_id));
+  if (it != shared_buffers_.end()) {
+    it->second.in_use = false;
+    if (it->second.dropped) {
+      shared_buffers_.erase(it);
+      return;
+    }
+  }
+  Send(new XWalkExtensionServerMsg_ReleaseSharedBuffer(instance_id,
+                                                       buffer_id));
+}
+
 void XWalkExtensionClient::DestroyInstance(int64_t instance_id) {
   HandlerMap::iterator it = handlers_.find(instance_id);
   if (it == handlers_.end() || !it->second) {
@@ -121,6 +319,13 @@ void XWalkExtensionClient::OnInstanceDestroyed(int64_t instance_id) {
   // instances.
   DCHECK(!it->second);
   handlers_.erase(it);
+
+  // The handler is gone together with any JS object using the buffers, so
+  // the mappings can be released.
+  shared_buffers_.erase(
+      shared_buffers_.lower_bound(SharedBufferKey(instance_id, 0)),
+      shared_buffers_.upper_bound(
+          SharedBufferKey(instance_id, std::numeric_limits<int32_t>::max())));
 }
 
 namespace {
@@ -147,6 +352,12 @@ void XWalkExtensionClient::PostMessageToNative(int64_t instance_id,
   Send(new XWalkExtensionServerMsg_PostMessageToNative(instance_id, *list_msg));
 }
 
+void XWalkExtensionClient::PostEncodedMessageToNative(
+    int64_t instance_id, const std::string& encoded) {
+  Send(new XWalkExtensionServerMsg_PostEncodedMessageToNative(
+      instance_id, std::vector<char>(encoded.begin(), encoded.end())));
+}
+
 std::unique_ptr<base::Value> XWalkExtensionClient::SendSyncMessageToNative(
     int64_t instance_id, std::unique_ptr<base::Value> msg) {
   std::unique_ptr<base::ListValue> wrapped_msg = WrapValueInList(std::move(msg));
@@ -159,17 +370,36 @@ std::unique_ptr<base::Value> XWalkExtensionClient::SendSyncMessageToNative(
   return reply;
 }
 
+void XWalkExtensionClient::SendMessageWithReplyToNative(
+    int64_t instance_id, int32_t request_id,
+    std::unique_ptr<base::Value> msg) {
+  std::unique_ptr<base::ListValue> list_msg = WrapValueInList(std::move(msg));
+  Send(new XWalkExtensionServerMsg_SendMessageWithReplyToNative(
+      instance_id, request_id, *list_msg));
+}
+
 void XWalkExtensionClient::Initialize(IPC::Sender* sender) {
   sender_ = sender;
 
   std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams> extensions;
   Send(new XWalkExtensionServerMsg_GetExtensions(&extensions));
+  SetExtensions(extensions);
+}
 
-  if (extensions.empty())
-    return;
+void XWalkExtensionClient::InitializeWithExtensions(
+    const std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams>&
+        extensions,
+    const ConnectCallback& connect_callback) {
+  DCHECK(!sender_);
+  connect_callback_ = connect_callback;
+  SetExtensions(extensions);
+}
 
-  std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams>::iterator it =
-      extensions.begin();
+void XWalkExtensionClient::SetExtensions(
+    const std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams>&
+        extensions) {
+  std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams>::const_iterator
+      it = extensions.begin();
   for (; it != extensions.end(); ++it) {
     ExtensionCodePoints* codepoint = new ExtensionCodePoints;
     codepoint->api = (*it).js_api;
@@ -8,9 +8,12 @@
 #include <stdint.h>
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "base/callback.h"
 #include "base/memory/shared_memory.h"
 #include "base/values.h"
 #include "ipc/ipc_listener.h"
@@ -23,6 +26,8 @@ namespace IPC {
 class Sender;
 }
 
+struct XWalkExtensionServerMsg_ExtensionRegisterParams;
+
 namespace xwalk {
 namespace extensions {
 
@@ -37,6 +42,17 @@ class XWalkExtensionClient : public IPC::Listener {
  public:
   struct InstanceHandler {
     virtual void HandleMessageFromNative(const base::Value& msg) = 0;
+    // |messages| are handled in order, as if each was received on its own.
+    virtual void HandleMessageBatchFromNative(
+        const base::ListValue& messages) = 0;
+    // |data| stays mapped until ReleaseSharedBuffer() is called or the
+    // instance is destroyed.
+    virtual void HandleSharedBufferFromNative(int32_t buffer_id, void* data,
+                                              size_t size) = 0;
+    // |reply| is NULL if the request failed, e.g. the extension doesn't
+    // support replies or the instance is gone.
+    virtual void HandleReplyFromNative(int32_t request_id,
+                                       const base::Value* reply) = 0;
    protected:
     virtual ~InstanceHandler() {}
   };
@@ -49,11 +65,32 @@ class XWalkExtensionClient : public IPC::Listener {
   void DestroyInstance(int64_t instance_id);
 
   void PostMessageToNative(int64_t instance_id, std::unique_ptr<base::Value> msg);
+  // |encoded| is a message encoded with EncodeV8Value().
+  void PostEncodedMessageToNative(int64_t instance_id,
+                                  const std::string& encoded);
   std::unique_ptr<base::Value> SendSyncMessageToNative(int64_t instance_id,
       std::unique_ptr<base::Value> msg);
+  // The reply is delivered to the instance handler with the same
+  // |request_id|, which is chosen by the caller.
+  void SendMessageWithReplyToNative(int64_t instance_id, int32_t request_id,
+                                    std::unique_ptr<base::Value> msg);
+
+  // Tells the native side that JS is done with a buffer received via
+  // HandleSharedBufferFromNative(), so it can be filled again.
+  void ReleaseSharedBuffer(int64_t instance_id, int32_t buffer_id);
 
   void Initialize(IPC::Sender* sender);
 
+  // Uses |extensions| instead of asking the server for them, so the client
+  // can be used before the server is reachable. |connect_callback| is run the
+  // first time a message is sent and returns the sender to use from then on,
+  // NULL if it couldn't connect.
+  typedef base::Callback<IPC::Sender*()> ConnectCallback;
+  void InitializeWithExtensions(
+      const std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams>&
+          extensions,
+      const ConnectCallback& connect_callback);
+
   // IPC::Listener Implementation.
   bool OnMessageReceived(const IPC::Message& message) override;
 
@@ -70,19 +107,65 @@ class XWalkExtensionClient : public IPC::Listener {
 
  private:
   bool Send(IPC::Message* msg);
+  // Connects to the server with |connect_callback_| if not done yet.
+  // Returns false if there's no server to talk to.
+  bool EnsureConnected();
+  void CheckRegisteredExtensions();
+  void SetExtensions(
+      const std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams>&
+          extensions);
 
   // Message Handlers.
   void OnInstanceDestroyed(int64_t instance_id);
   void OnPostMessageToJS(int64_t instance_id, const base::ListValue& msg);
+  void OnPostMessageBatchToJS(int64_t instance_id,
+                              const base::ListValue& messages);
   void OnPostOutOfLineMessageToJS(base::SharedMemoryHandle handle,
                                   size_t size);
+  void OnPostPooledOutOfLineMessageToJS(int64_t instance_id,
+                                        int32_t segment_id,
+                                        base::SharedMemoryHandle handle,
+                                        uint64_t capacity, uint64_t size);
+  void OnDropOutOfLineSegment(int32_t segment_id);
+  void OnPostSharedBufferToJS(int64_t instance_id, int32_t buffer_id,
+                              base::SharedMemoryHandle handle,
+                              uint64_t capacity, uint64_t size);
+  void OnDropSharedBuffer(int64_t instance_id, int32_t buffer_id);
+  void OnReplyToJS(int64_t instance_id, int32_t request_id,
+                   const base::ListValue& reply);
 
   IPC::Sender* sender_;
+  ConnectCallback connect_callback_;
   ExtensionAPIMap extension_apis_;
+  // Extensions given to InitializeWithExtensions() that the server didn't
+  // register.
+  std::set<std::string> unregistered_extensions_;
 
   typedef std::map<int64_t, InstanceHandler*> HandlerMap;
   HandlerMap handlers_;
 
+  // Shared buffers are mapped once and reused every time the native side
+  // posts the same buffer id again.
+  struct SharedBuffer {
+    SharedBuffer();
+    ~SharedBuffer();
+
+    std::unique_ptr<base::SharedMemory> memory;
+    // True while an ArrayBuffer handed to JS may point into |memory|.
+    bool in_use;
+    // The native side dropped the buffer while it was in use, so |memory| is
+    // unmapped once JS releases it.
+    bool dropped;
+  };
+  typedef std::pair<int64_t, int32_t> SharedBufferKey;
+  typedef std::map<SharedBufferKey, SharedBuffer> SharedBufferMap;
+  SharedBufferMap shared_buffers_;
+
+  // Mappings of the segments used by the server for out of line messages.
+  typedef std::map<int32_t, std::unique_ptr<base::SharedMemory>>
+      OutOfLineSegmentMap;
+  OutOfLineSegmentMap out_of_line_segments_;
+
   int64_t next_instance_id_;
 };
 
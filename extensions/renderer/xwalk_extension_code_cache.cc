@@ -0,0 +1,115 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/renderer/xwalk_extension_code_cache.h"
+
+#include "base/logging.h"
+#include "base/metrics/histogram.h"
+#include "base/sha1.h"
+#include "base/strings/string_number_conversions.h"
+#include "ipc/ipc_sender.h"
+#include "xwalk/extensions/common/xwalk_extension_messages.h"
+
+namespace xwalk {
+namespace extensions {
+
+namespace {
+
+// Recorded in XWalk.Extensions.CodeCacheResult, don't reorder.
+enum CodeCacheResult {
+  CODE_CACHE_HIT,
+  CODE_CACHE_MISS,
+  CODE_CACHE_REJECTED,
+  CODE_CACHE_RESULT_MAX
+};
+
+void RecordResult(CodeCacheResult result) {
+  UMA_HISTOGRAM_ENUMERATION("XWalk.Extensions.CodeCacheResult", result,
+                            CODE_CACHE_RESULT_MAX);
+}
+
+}  // namespace
+
+XWalkExtensionCodeCache::XWalkExtensionCodeCache(IPC::Sender* sender)
+    : sender_(sender) {}
+
+XWalkExtensionCodeCache::~XWalkExtensionCodeCache() {}
+
+v8::MaybeLocal<v8::Script> XWalkExtensionCodeCache::Compile(
+    v8::Local<v8::Context> context, const std::string& extension_name,
+    const std::string& code) {
+  v8::Isolate* isolate = context->GetIsolate();
+  v8::Local<v8::String> v8_code;
+  if (!v8::String::NewFromUtf8(isolate, code.c_str(),
+                               v8::NewStringType::kNormal,
+                               code.size()).ToLocal(&v8_code)) {
+    return v8::MaybeLocal<v8::Script>();
+  }
+
+  const std::string& code_hash = GetCodeHash(extension_name, code);
+  EntryMap::iterator it = entries_.find(extension_name);
+  if (it != entries_.end() && it->second.code_hash == code_hash) {
+    const std::string& data = it->second.data;
+    v8::ScriptCompiler::Source source(
+        v8_code, new v8::ScriptCompiler::CachedData(
+            reinterpret_cast<const uint8_t*>(data.data()),
+            static_cast<int>(data.size())));
+    v8::MaybeLocal<v8::Script> script = v8::ScriptCompiler::Compile(
+        context, &source, v8::ScriptCompiler::kConsumeCodeCache);
+
+    // V8 rejects data produced by another version or with different flags,
+    // the entry will be produced again by the next context.
+    if (source.GetCachedData()->rejected) {
+      RecordResult(CODE_CACHE_REJECTED);
+      entries_.erase(it);
+    } else {
+      RecordResult(CODE_CACHE_HIT);
+    }
+    return script;
+  }
+
+  RecordResult(CODE_CACHE_MISS);
+  v8::ScriptCompiler::Source source(v8_code);
+  v8::MaybeLocal<v8::Script> script = v8::ScriptCompiler::Compile(
+      context, &source, v8::ScriptCompiler::kProduceCodeCache);
+
+  const v8::ScriptCompiler::CachedData* cached_data = source.GetCachedData();
+  if (script.IsEmpty() || !cached_data || !cached_data->length)
+    return script;
+
+  Entry& entry = entries_[extension_name];
+  entry.code_hash = code_hash;
+  entry.data.assign(reinterpret_cast<const char*>(cached_data->data),
+                    cached_data->length);
+  if (sender_) {
+    sender_->Send(new XWalkExtensionHostMsg_StoreCodeCache(
+        extension_name, entry.code_hash, entry.data));
+  }
+  return script;
+}
+
+void XWalkExtensionCodeCache::AddEntries(
+    const std::vector<XWalkExtensionMsg_CodeCacheEntry>& entries) {
+  for (const XWalkExtensionMsg_CodeCacheEntry& entry : entries) {
+    if (entries_.count(entry.name))
+      continue;
+    Entry& new_entry = entries_[entry.name];
+    new_entry.code_hash = entry.code_hash;
+    new_entry.data = entry.data;
+  }
+}
+
+const std::string& XWalkExtensionCodeCache::GetCodeHash(
+    const std::string& extension_name, const std::string& code) {
+  std::pair<size_t, std::string>& code_hash = code_hashes_[extension_name];
+  if (code_hash.second.empty() || code_hash.first != code.size()) {
+    std::string sha1 = base::SHA1HashString(code);
+    code_hash.first = code.size();
+    code_hash.second = base::HexEncode(sha1.data(), sha1.size());
+  }
+  return code_hash.second;
+}
+
+}  // namespace extensions
+}  // namespace xwalk
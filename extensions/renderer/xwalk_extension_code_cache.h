@@ -0,0 +1,71 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_RENDERER_XWALK_EXTENSION_CODE_CACHE_H_
+#define XWALK_EXTENSIONS_RENDERER_XWALK_EXTENSION_CODE_CACHE_H_
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/macros.h"
+#include "v8/include/v8.h"
+
+struct XWalkExtensionMsg_CodeCacheEntry;
+
+namespace IPC {
+class Sender;
+}
+
+namespace xwalk {
+namespace extensions {
+
+// Keeps the V8 code cache of the extensions JavaScript API code, so it is
+// only fully compiled the first time a renderer loads an extension instead of
+// once per script context. Entries are keyed by extension name and a hash of
+// the code. Newly produced entries are sent to the browser process, which
+// persists them and hands them to the renderers of later launches.
+class XWalkExtensionCodeCache {
+ public:
+  // |sender| is used to send new entries to the browser, can be NULL.
+  explicit XWalkExtensionCodeCache(IPC::Sender* sender);
+  ~XWalkExtensionCodeCache();
+
+  // Compiles |code| for |extension_name| in the current context, consuming
+  // the cached data if there's a matching entry, producing it otherwise.
+  v8::MaybeLocal<v8::Script> Compile(v8::Local<v8::Context> context,
+                                     const std::string& extension_name,
+                                     const std::string& code);
+
+  // Adds the entries loaded by the browser process from disk. Entries
+  // already produced by this renderer are kept.
+  void AddEntries(const std::vector<XWalkExtensionMsg_CodeCacheEntry>& entries);
+
+ private:
+  struct Entry {
+    std::string code_hash;
+    std::string data;
+  };
+
+  const std::string& GetCodeHash(const std::string& extension_name,
+                                 const std::string& code);
+
+  IPC::Sender* sender_;
+
+  typedef std::map<std::string, Entry> EntryMap;
+  EntryMap entries_;
+
+  // The code of an extension doesn't change during the life of the renderer,
+  // so it is only hashed once. Kept with the code size as a sanity check.
+  typedef std::map<std::string, std::pair<size_t, std::string>> CodeHashMap;
+  CodeHashMap code_hashes_;
+
+  DISALLOW_COPY_AND_ASSIGN(XWalkExtensionCodeCache);
+};
+
+}  // namespace extensions
+}  // namespace xwalk
+
+#endif  // XWALK_EXTENSIONS_RENDERER_XWALK_EXTENSION_CODE_CACHE_H_
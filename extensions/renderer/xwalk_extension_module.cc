@@ -5,13 +5,19 @@
 
 #include "xwalk/extensions/renderer/xwalk_extension_module.h"
 
+#include <limits>
+
 #include "base/logging.h"
+#include "base/macros.h"
+#include "base/stl_util.h"
 #include "base/strings/stringprintf.h"
 #include "base/values.h"
 #include "content/public/child/v8_value_converter.h"
 #include "third_party/WebKit/public/web/WebFrame.h"
+#include "xwalk/extensions/renderer/xwalk_extension_code_cache.h"
 #include "xwalk/extensions/renderer/xwalk_module_system.h"
 #include "xwalk/extensions/renderer/xwalk_v8_utils.h"
+#include "xwalk/extensions/renderer/xwalk_v8_value_encoder.h"
 
 namespace xwalk {
 namespace extensions {
@@ -26,6 +32,7 @@ const char* kXWalkExtensionModule = "kXWalkExtensionModule";
 
 XWalkExtensionModule::XWalkExtensionModule(XWalkExtensionClient* client,
                                            XWalkModuleSystem* module_system,
+                                           XWalkExtensionCodeCache* code_cache,
                                            const std::string& extension_name,
                                            const std::string& extension_code)
     : extension_name_(extension_name),
@@ -33,7 +40,11 @@ XWalkExtensionModule::XWalkExtensionModule(XWalkExtensionClient* client,
       converter_(content::V8ValueConverter::create()),
       client_(client),
       module_system_(module_system),
-      instance_id_(0) {
+      code_cache_(code_cache),
+      instance_id_(0),
+      code_loaded_(false),
+      next_request_id_(0),
+      released_external_memory_(0) {
   v8::Isolate* isolate = v8::Isolate::GetCurrent();
   v8::HandleScope handle_scope(isolate);
   v8::Handle<v8::Object> function_data = v8::Object::New(isolate);
@@ -47,10 +58,18 @@ XWalkExtensionModule::XWalkExtensionModule(XWalkExtensionClient* client,
   object_template->Set(
       v8::String::NewFromUtf8(isolate, "postMessage"),
       v8::FunctionTemplate::New(isolate, PostMessageCallback, function_data));
+  object_template->Set(
+      v8::String::NewFromUtf8(isolate, "postEncodedMessage"),
+      v8::FunctionTemplate::New(
+          isolate, PostEncodedMessageCallback, function_data));
   object_template->Set(
       v8::String::NewFromUtf8(isolate, "sendSyncMessage"),
       v8::FunctionTemplate::New(
           isolate, SendSyncMessageCallback, function_data));
+  object_template->Set(
+      v8::String::NewFromUtf8(isolate, "sendMessageWithReply"),
+      v8::FunctionTemplate::New(
+          isolate, SendMessageWithReplyCallback, function_data));
   object_template->Set(
       v8::String::NewFromUtf8(isolate, "setMessageListener"),
       v8::FunctionTemplate::New(
@@ -77,6 +96,25 @@ XWalkExtensionModule::~XWalkExtensionModule() {
   function_data_.Reset();
   message_listener_.Reset();
 
+  // The context is going away, so nobody will be able to observe these
+  // promises anymore.
+  pending_replies_.clear();
+
+  // The shared memory backing these buffers is unmapped once the instance is
+  // destroyed, so make sure JS can't reach it anymore.
+  int64_t external_memory = released_external_memory_;
+  for (const auto& entry : shared_buffers_) {
+    SharedBuffer* buffer = entry.second.get();
+    v8::Local<v8::ArrayBuffer> array_buffer =
+        v8::Local<v8::ArrayBuffer>::New(isolate, buffer->array_buffer);
+    array_buffer->Neuter();
+    buffer->array_buffer.Reset();
+    external_memory += buffer->size;
+  }
+  shared_buffers_.clear();
+  if (external_memory)
+    isolate->AdjustAmountOfExternalAllocatedMemory(-external_memory);
+
   if (instance_id_)
     client_->DestroyInstance(instance_id_);
 }
@@ -118,20 +156,27 @@ std::string WrapAPICode(const std::string& extension_code,
       extension_code.c_str());
 }
 
-v8::Handle<v8::Value> RunString(const std::string& code,
+v8::Handle<v8::Value> RunString(XWalkExtensionCodeCache* code_cache,
+                                const std::string& extension_name,
+                                const std::string& code,
                                 std::string* exception) {
   v8::Isolate* isolate = v8::Isolate::GetCurrent();
   v8::EscapableHandleScope handle_scope(isolate);
-  v8::Handle<v8::String> v8_code(
-      v8::String::NewFromUtf8(isolate, code.c_str()));
 
   v8::MicrotasksScope microtasks(
       isolate, v8::MicrotasksScope::kDoNotRunMicrotasks);
   v8::TryCatch try_catch(isolate);
   try_catch.SetVerbose(true);
 
-  v8::Handle<v8::Script> script(v8::Script::Compile(v8_code));
-  if (try_catch.HasCaught()) {
+  v8::Handle<v8::Script> script;
+  if (code_cache) {
+    code_cache->Compile(isolate->GetCurrentContext(), extension_name, code)
+        .ToLocal(&script);
+  } else {
+    script = v8::Script::Compile(
+        v8::String::NewFromUtf8(isolate, code.c_str()));
+  }
+  if (try_catch.HasCaught() || script.IsEmpty()) {
     *exception = ExceptionToString(try_catch);
     return handle_scope.Escape(
         v8::Local<v8::Primitive>(v8::Undefined(isolate)));
@@ -151,13 +196,13 @@ v8::Handle<v8::Value> RunString(const std::string& code,
 
 void XWalkExtensionModule::LoadExtensionCode(
     v8::Handle<v8::Context> context, v8::Handle<v8::Function> requireNative) {
-  CHECK(!instance_id_);
-  instance_id_ = client_->CreateInstance(extension_name_, this);
+  CHECK(!code_loaded_);
+  code_loaded_ = true;
 
   std::string exception;
   std::string wrapped_api_code = WrapAPICode(extension_code_, extension_name_);
   v8::Handle<v8::Value> result =
-      RunString(wrapped_api_code, &exception);
+      RunString(code_cache_, extension_name_, wrapped_api_code, &exception);
   if (!result->IsFunction()) {
     LOG(WARNING) << "Couldn't load JS API code for " << extension_name_
       << ": " << exception;
@@ -195,19 +240,132 @@ void XWalkExtensionModule::HandleMessageFromNative(const base::Value& msg) {
   v8::Handle<v8::Context> context = module_system_->GetV8Context();
   v8::Context::Scope context_scope(context);
 
-  v8::Handle<v8::Value> v8_value(converter_->ToV8Value(&msg, context));
+  CallMessageListener(context, converter_->ToV8Value(&msg, context));
+}
+
+void XWalkExtensionModule::HandleMessageBatchFromNative(
+    const base::ListValue& messages) {
+  if (message_listener_.IsEmpty())
+    return;
+
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+  v8::HandleScope handle_scope(isolate);
+  v8::Handle<v8::Context> context = module_system_->GetV8Context();
+  v8::Context::Scope context_scope(context);
+
+  for (size_t i = 0; i < messages.GetSize(); ++i) {
+    // The listener might be unset by one of the previous messages.
+    if (message_listener_.IsEmpty())
+      return;
+    const base::Value* msg;
+    if (messages.Get(i, &msg))
+      CallMessageListener(context, converter_->ToV8Value(msg, context));
+  }
+}
+
+void XWalkExtensionModule::HandleSharedBufferFromNative(int32_t buffer_id,
+                                                        void* data,
+                                                        size_t size) {
+  if (ContainsKey(shared_buffers_, buffer_id)) {
+    LOG(WARNING) << "Got shared buffer " << buffer_id
+                 << " that is still in use by JS.";
+    return;
+  }
+
+  if (message_listener_.IsEmpty()) {
+    client_->ReleaseSharedBuffer(instance_id_, buffer_id);
+    return;
+  }
+
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+  v8::HandleScope handle_scope(isolate);
+  v8::Handle<v8::Context> context = module_system_->GetV8Context();
+  v8::Context::Scope context_scope(context);
+
+  // The ArrayBuffer points straight to the shared memory, V8 won't own or
+  // copy it. We report its size so the GC knows how much memory it is
+  // keeping alive, this helps buffers to be recycled in a timely manner.
+  v8::Local<v8::ArrayBuffer> array_buffer =
+      v8::ArrayBuffer::New(isolate, data, size);
+  isolate->AdjustAmountOfExternalAllocatedMemory(
+      static_cast<int64_t>(size) - released_external_memory_);
+  released_external_memory_ = 0;
+
+  std::unique_ptr<SharedBuffer> buffer(new SharedBuffer);
+  buffer->module = this;
+  buffer->id = buffer_id;
+  buffer->size = size;
+  buffer->array_buffer.Reset(isolate, array_buffer);
+  buffer->array_buffer.SetWeak(buffer.get(), &SharedBufferWeakCallback,
+                               v8::WeakCallbackType::kParameter);
+  shared_buffers_[buffer_id] = std::move(buffer);
+
+  CallMessageListener(context, array_buffer);
+}
+
+void XWalkExtensionModule::HandleReplyFromNative(int32_t request_id,
+                                                 const base::Value* reply) {
+  PendingReplyMap::iterator it = pending_replies_.find(request_id);
+  if (it == pending_replies_.end()) {
+    LOG(WARNING) << "Got reply for unknown request " << request_id
+                 << " of extension " << extension_name_;
+    return;
+  }
+
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+  v8::HandleScope handle_scope(isolate);
+  v8::Handle<v8::Context> context = module_system_->GetV8Context();
+  v8::Context::Scope context_scope(context);
+
+  v8::Local<v8::Promise::Resolver> resolver =
+      v8::Local<v8::Promise::Resolver>::New(isolate, it->second);
+  pending_replies_.erase(it);
+
+  // Reactions to the promise run right away, as with any other event
+  // coming from the native side.
+  v8::MicrotasksScope microtasks(
+      isolate, v8::MicrotasksScope::kRunMicrotasks);
+  if (reply) {
+    ignore_result(resolver->Resolve(context,
+                                    converter_->ToV8Value(reply, context)));
+  } else {
+    ignore_result(resolver->Reject(context, v8::Exception::Error(
+        v8::String::NewFromUtf8(isolate, "Extension didn't reply."))));
+  }
+}
+
+void XWalkExtensionModule::CallMessageListener(
+    v8::Handle<v8::Context> context, v8::Handle<v8::Value> value) {
+  v8::Isolate* isolate = context->GetIsolate();
   v8::Handle<v8::Function> message_listener =
-      v8::Local<v8::Function>::New(isolate, message_listener_);;
+      v8::Local<v8::Function>::New(isolate, message_listener_);
 
   v8::MicrotasksScope microtasks(
       isolate, v8::MicrotasksScope::kDoNotRunMicrotasks);
   v8::TryCatch try_catch(isolate);
-  message_listener->Call(context->Global(), 1, &v8_value);
+  message_listener->Call(context->Global(), 1, &value);
   if (try_catch.HasCaught())
     LOG(WARNING) << "Exception when running message listener: "
         << ExceptionToString(try_catch);
 }
 
+// static
+void XWalkExtensionModule::SharedBufferWeakCallback(
+    const v8::WeakCallbackInfo<SharedBuffer>& data) {
+  SharedBuffer* buffer = data.GetParameter();
+  buffer->module->ReleaseSharedBuffer(buffer->id);
+}
+
+void XWalkExtensionModule::ReleaseSharedBuffer(int32_t buffer_id) {
+  SharedBufferMap::iterator it = shared_buffers_.find(buffer_id);
+  DCHECK(it != shared_buffers_.end());
+  it->second->array_buffer.Reset();
+  released_external_memory_ += it->second->size;
+  shared_buffers_.erase(it);
+
+  client_->ReleaseSharedBuffer(instance_id_, buffer_id);
+}
+
 // static
 void XWalkExtensionModule::PostMessageCallback(
     const v8::FunctionCallbackInfo<v8::Value>& info) {
@@ -222,11 +380,34 @@ void XWalkExtensionModule::PostMessageCallback(
   std::unique_ptr<base::Value> value(
       module->converter_->FromV8Value(info[0], context));
 
-  CHECK(module->instance_id_);
+  if (!module->EnsureInstance()) {
+    result.Set(false);
+    return;
+  }
   module->client_->PostMessageToNative(module->instance_id_, std::move(value));
   result.Set(true);
 }
 
+// static
+void XWalkExtensionModule::PostEncodedMessageCallback(
+    const v8::FunctionCallbackInfo<v8::Value>& info) {
+  v8::ReturnValue<v8::Value> result(info.GetReturnValue());
+  XWalkExtensionModule* module = GetExtensionModule(info);
+  if (!module || info.Length() != 1) {
+    result.Set(false);
+    return;
+  }
+
+  std::string encoded;
+  v8::Handle<v8::Context> context = info.GetIsolate()->GetCurrentContext();
+  if (!EncodeV8Value(context, info[0], &encoded) || !module->EnsureInstance()) {
+    result.Set(false);
+    return;
+  }
+  module->client_->PostEncodedMessageToNative(module->instance_id_, encoded);
+  result.Set(true);
+}
+
 // static
 void XWalkExtensionModule::SendSyncMessageCallback(
     const v8::FunctionCallbackInfo<v8::Value>& info) {
@@ -241,7 +422,8 @@ void XWalkExtensionModule::SendSyncMessageCallback(
   std::unique_ptr<base::Value> value(
       module->converter_->FromV8Value(info[0], context));
 
-  CHECK(module->instance_id_);
+  if (!module->EnsureInstance())
+    return;
   std::unique_ptr<base::Value> reply(
       module->client_->SendSyncMessageToNative(module->instance_id_,
                                                std::move(value)));
@@ -252,6 +434,40 @@ void XWalkExtensionModule::SendSyncMessageCallback(
     result.Set(module->converter_->ToV8Value(reply.get(), context));
 }
 
+// static
+void XWalkExtensionModule::SendMessageWithReplyCallback(
+    const v8::FunctionCallbackInfo<v8::Value>& info) {
+  v8::ReturnValue<v8::Value> result(info.GetReturnValue());
+  XWalkExtensionModule* module = GetExtensionModule(info);
+  if (!module || info.Length() != 1) {
+    result.Set(false);
+    return;
+  }
+
+  v8::Isolate* isolate = info.GetIsolate();
+  v8::Handle<v8::Context> context = isolate->GetCurrentContext();
+  v8::Local<v8::Promise::Resolver> resolver;
+  if (!v8::Promise::Resolver::New(context).ToLocal(&resolver)) {
+    result.Set(false);
+    return;
+  }
+
+  std::unique_ptr<base::Value> value(
+      module->converter_->FromV8Value(info[0], context));
+
+  if (!module->EnsureInstance()) {
+    result.Set(false);
+    return;
+  }
+  int32_t request_id = module->next_request_id_;
+  module->next_request_id_ =
+      request_id == std::numeric_limits<int32_t>::max() ? 0 : request_id + 1;
+  module->pending_replies_[request_id].Reset(isolate, resolver);
+  module->client_->SendMessageWithReplyToNative(module->instance_id_,
+                                                request_id, std::move(value));
+  result.Set(resolver->GetPromise());
+}
+
 // static
 void XWalkExtensionModule::SetMessageListenerCallback(
     const v8::FunctionCallbackInfo<v8::Value>& info) {
@@ -269,14 +485,27 @@ void XWalkExtensionModule::SetMessageListenerCallback(
   }
 
   v8::Isolate* isolate = info.GetIsolate();
-  if (info[0]->IsUndefined())
+  if (info[0]->IsUndefined()) {
     module->message_listener_.Reset();
-  else
+  } else {
+    // The instance may post messages on its own, so it needs to exist as
+    // soon as there's someone listening to them.
+    if (!module->EnsureInstance()) {
+      result.Set(false);
+      return;
+    }
     module->message_listener_.Reset(isolate, info[0].As<v8::Function>());
+  }
 
   result.Set(true);
 }
 
+bool XWalkExtensionModule::EnsureInstance() {
+  if (!instance_id_)
+    instance_id_ = client_->CreateInstance(extension_name_, this);
+  return instance_id_ != 0;
+}
+
 // static
 XWalkExtensionModule* XWalkExtensionModule::GetExtensionModule(
     const v8::FunctionCallbackInfo<v8::Value>& info) {
@@ -5,6 +5,8 @@
 #ifndef XWALK_EXTENSIONS_RENDERER_XWALK_EXTENSION_MODULE_H_
 #define XWALK_EXTENSIONS_RENDERER_XWALK_EXTENSION_MODULE_H_
 
+#include <map>
+#include <memory>
 #include <string>
 #include "xwalk/extensions/renderer/xwalk_extension_client.h"
 #include "xwalk/extensions/renderer/xwalk_module_system.h"
@@ -21,6 +23,7 @@ namespace xwalk {
 namespace extensions {
 
 class XWalkExtensionClient;
+class XWalkExtensionCodeCache;
 class XWalkModuleSystem;
 
 // Responsible for running the JS code of a XWalkExtension. This includes
@@ -31,8 +34,11 @@ class XWalkModuleSystem;
 // there'll be a set of different modules per v8::Context.
 class XWalkExtensionModule : public XWalkExtensionClient::InstanceHandler {
  public:
+  // |code_cache| is optional, when set it is used to compile the extension
+  // code and must outlive the module.
   XWalkExtensionModule(XWalkExtensionClient* client,
                        XWalkModuleSystem* module_system,
+                       XWalkExtensionCodeCache* code_cache,
                        const std::string& extension_name,
                        const std::string& extension_code);
   ~XWalkExtensionModule() override;
@@ -44,15 +50,48 @@ class XWalkExtensionModule : public XWalkExtensionClient::InstanceHandler {
 
   std::string extension_name() const { return extension_name_; }
 
+  // The instance in the native side is only created the first time the JS
+  // code uses the 'extension' object, many pages load extensions they never
+  // use. Returns whether the code was loaded but no instance was needed.
+  bool instance_avoided() const { return code_loaded_ && !instance_id_; }
+
  private:
   // XWalkExtensionClient::InstanceHandler implementation.
   void HandleMessageFromNative(const base::Value& msg) override;
+  void HandleMessageBatchFromNative(const base::ListValue& messages) override;
+  void HandleSharedBufferFromNative(int32_t buffer_id, void* data,
+                                    size_t size) override;
+  void HandleReplyFromNative(int32_t request_id,
+                             const base::Value* reply) override;
+
+  void CallMessageListener(v8::Handle<v8::Context> context,
+                           v8::Handle<v8::Value> value);
+
+  // Creates the instance if it wasn't yet, returns false if that failed.
+  bool EnsureInstance();
+
+  // A shared buffer exposed to JS as an externalized ArrayBuffer. The weak
+  // handle lets us know when JS drops the last reference to it.
+  struct SharedBuffer {
+    XWalkExtensionModule* module;
+    int32_t id;
+    size_t size;
+    v8::Persistent<v8::ArrayBuffer> array_buffer;
+  };
+
+  static void SharedBufferWeakCallback(
+      const v8::WeakCallbackInfo<SharedBuffer>& data);
+  void ReleaseSharedBuffer(int32_t buffer_id);
 
   // Callbacks for JS functions available in 'extension' object.
   static void PostMessageCallback(
       const v8::FunctionCallbackInfo<v8::Value>& info);
+  static void PostEncodedMessageCallback(
+      const v8::FunctionCallbackInfo<v8::Value>& info);
   static void SendSyncMessageCallback(
       const v8::FunctionCallbackInfo<v8::Value>& info);
+  static void SendMessageWithReplyCallback(
+      const v8::FunctionCallbackInfo<v8::Value>& info);
   static void SetMessageListenerCallback(
       const v8::FunctionCallbackInfo<v8::Value>& info);
 
@@ -79,7 +118,24 @@ class XWalkExtensionModule : public XWalkExtensionClient::InstanceHandler {
 
   XWalkExtensionClient* client_;
   XWalkModuleSystem* module_system_;
+  XWalkExtensionCodeCache* code_cache_;
   int64_t instance_id_;
+  bool code_loaded_;
+
+  typedef std::map<int32_t, std::unique_ptr<SharedBuffer>> SharedBufferMap;
+  SharedBufferMap shared_buffers_;
+
+  // Promises returned by 'extension.sendMessageWithReply()' still waiting for
+  // the native side to reply, by request id.
+  typedef std::map<int32_t, v8::Global<v8::Promise::Resolver>>
+      PendingReplyMap;
+  PendingReplyMap pending_replies_;
+  int32_t next_request_id_;
+
+  // Memory of released shared buffers not yet reported back to V8. We can't
+  // call into V8 from the weak callback, so it's accounted for the next time
+  // a buffer is received.
+  int64_t released_external_memory_;
 };
 
 }  // namespace extensions
@@ -4,7 +4,10 @@
 
 #include "xwalk/extensions/renderer/xwalk_extension_renderer_controller.h"
 
+#include "base/bind.h"
 #include "base/command_line.h"
+#include "base/metrics/histogram.h"
+#include "base/time/time.h"
 #include "base/values.h"
 #include "content/public/child/v8_value_converter.h"
 #include "content/public/renderer/render_thread.h"
@@ -18,6 +21,7 @@
 #include "xwalk/extensions/common/xwalk_extension_messages.h"
 #include "xwalk/extensions/common/xwalk_extension_switches.h"
 #include "xwalk/extensions/renderer/xwalk_extension_client.h"
+#include "xwalk/extensions/renderer/xwalk_extension_code_cache.h"
 #include "xwalk/extensions/renderer/xwalk_extension_module.h"
 #include "xwalk/extensions/renderer/xwalk_js_module.h"
 #include "xwalk/extensions/renderer/xwalk_module_system.h"
@@ -35,6 +39,7 @@ XWalkExtensionRendererController::XWalkExtensionRendererController(
       delegate_(delegate) {
   content::RenderThread* thread = content::RenderThread::Get();
   thread->AddObserver(this);
+  code_cache_.reset(new XWalkExtensionCodeCache(thread));
   IPC::SyncChannel* browser_channel = thread->GetChannel();
   SetupBrowserProcessClient(browser_channel);
 
@@ -54,7 +59,8 @@ XWalkExtensionRendererController::~XWalkExtensionRendererController() {
 namespace {
 
 void CreateExtensionModules(XWalkExtensionClient* client,
-                            XWalkModuleSystem* module_system) {
+                            XWalkModuleSystem* module_system,
+                            XWalkExtensionCodeCache* code_cache) {
   const XWalkExtensionClient::ExtensionAPIMap& extensions =
       client->extension_apis();
   XWalkExtensionClient::ExtensionAPIMap::const_iterator it = extensions.begin();
@@ -63,7 +69,7 @@ void CreateExtensionModules(XWalkExtensionClient* client,
     if (codepoint->api.empty())
       continue;
     std::unique_ptr<XWalkExtensionModule> module(
-        new XWalkExtensionModule(client, module_system,
+        new XWalkExtensionModule(client, module_system, code_cache,
                                  it->first, codepoint->api));
     module_system->RegisterExtensionModule(std::move(module),
                                            codepoint->entry_points);
@@ -74,6 +80,7 @@ void CreateExtensionModules(XWalkExtensionClient* client,
 
 void XWalkExtensionRendererController::DidCreateScriptContext(
     blink::WebLocalFrame* frame, v8::Handle<v8::Context> context) {
+  base::TimeTicks start_time = base::TimeTicks::Now();
   XWalkModuleSystem* module_system = new XWalkModuleSystem(context);
   XWalkModuleSystem::SetModuleSystemInContext(
       std::unique_ptr<XWalkModuleSystem>(module_system), context);
@@ -91,14 +98,19 @@ void XWalkExtensionRendererController::DidCreateScriptContext(
   delegate_->DidCreateModuleSystem(module_system);
 
   CreateExtensionModules(in_browser_process_extensions_client_.get(),
-                         module_system);
+                         module_system, code_cache_.get());
 
   if (external_extensions_client_) {
     CreateExtensionModules(external_extensions_client_.get(),
-                           module_system);
+                           module_system, code_cache_.get());
   }
 
   module_system->Initialize();
+
+  // Includes compiling and running the JS API code of every extension, which
+  // is what the code cache helps with.
+  UMA_HISTOGRAM_TIMES("XWalk.Extensions.ScriptContextSetupTime",
+                      base::TimeTicks::Now() - start_time);
 }
 
 void XWalkExtensionRendererController::WillReleaseScriptContext(
@@ -109,9 +121,21 @@ void XWalkExtensionRendererController::WillReleaseScriptContext(
 
 bool XWalkExtensionRendererController::OnControlMessageReceived(
     const IPC::Message& message) {
+  bool handled = true;
+  IPC_BEGIN_MESSAGE_MAP(XWalkExtensionRendererController, message)
+    IPC_MESSAGE_HANDLER(XWalkExtensionMsg_SetCodeCache, OnSetCodeCache)
+    IPC_MESSAGE_UNHANDLED(handled = false)
+  IPC_END_MESSAGE_MAP()
+  if (handled)
+    return true;
   return in_browser_process_extensions_client_->OnMessageReceived(message);
 }
 
+void XWalkExtensionRendererController::OnSetCodeCache(
+    const std::vector<XWalkExtensionMsg_CodeCacheEntry>& entries) {
+  code_cache_->AddEntries(entries);
+}
+
 void XWalkExtensionRendererController::OnRenderProcessShutdown() {
   shutdown_event_.Signal();
 }
@@ -124,18 +148,36 @@ void XWalkExtensionRendererController::SetupBrowserProcessClient(
 
 void XWalkExtensionRendererController::SetupExtensionProcessClient(
     IPC::SyncChannel* browser_channel) {
+  std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams> extensions;
+  browser_channel->Send(
+      new XWalkExtensionHostMsg_GetExternalExtensionsSnapshot(&extensions));
+  UMA_HISTOGRAM_BOOLEAN("XWalk.Extensions.RegistrySnapshotUsed",
+                        !extensions.empty());
+
+  external_extensions_client_.reset(new XWalkExtensionClient);
+  if (!extensions.empty()) {
+    external_extensions_client_->InitializeWithExtensions(extensions,
+        base::Bind(&XWalkExtensionRendererController::ConnectToExtensionProcess,
+                   base::Unretained(this), browser_channel));
+    return;
+  }
+
+  external_extensions_client_->Initialize(
+      ConnectToExtensionProcess(browser_channel));
+}
+
+IPC::Sender* XWalkExtensionRendererController::ConnectToExtensionProcess(
+    IPC::SyncChannel* browser_channel) {
   IPC::ChannelHandle handle;
   browser_channel->Send(
       new XWalkExtensionProcessHostMsg_GetExtensionProcessChannel(&handle));
   // FIXME(cmarcelo): Need to account for failure in creating the channel.
 
-  external_extensions_client_.reset(new XWalkExtensionClient);
   extension_process_channel_ = IPC::SyncChannel::Create(handle,
       IPC::Channel::MODE_CLIENT, external_extensions_client_.get(),
       content::RenderThread::Get()->GetIOMessageLoopProxy(), true,
       &shutdown_event_);
-
-  external_extensions_client_->Initialize(extension_process_channel_.get());
+  return extension_process_channel_.get();
 }
 
 
@@ -16,6 +16,8 @@
 #include "third_party/WebKit/public/web/WebFrame.h"
 #include "v8/include/v8.h"
 
+struct XWalkExtensionMsg_CodeCacheEntry;
+
 namespace content {
 class RenderView;
 }
@@ -33,6 +35,7 @@ namespace xwalk {
 namespace extensions {
 
 class XWalkExtensionClient;
+class XWalkExtensionCodeCache;
 class XWalkModuleSystem;
 
 // Renderer controller for XWalk extensions keeps track of the extensions
@@ -65,12 +68,20 @@ class XWalkExtensionRendererController : public content::RenderThreadObserver {
  private:
   void SetupBrowserProcessClient(IPC::SyncChannel* browser_channel);
 
+  void OnSetCodeCache(
+      const std::vector<XWalkExtensionMsg_CodeCacheEntry>& entries);
+
   // We use the browser_channel to ask for the handle to setup the extension
-  // channel and plug the external_extensions_client_ into it.
+  // channel and plug the external_extensions_client_ into it. When the browser
+  // has a snapshot of the external extensions, the channel is only set up
+  // once an external extension is used, so the render process doesn't wait
+  // for the extension process to load them.
   void SetupExtensionProcessClient(IPC::SyncChannel* browser_channel);
+  IPC::Sender* ConnectToExtensionProcess(IPC::SyncChannel* browser_channel);
 
   std::unique_ptr<XWalkExtensionClient> in_browser_process_extensions_client_;
   std::unique_ptr<XWalkExtensionClient> external_extensions_client_;
+  std::unique_ptr<XWalkExtensionCodeCache> code_cache_;
 
   base::WaitableEvent shutdown_event_;
   std::unique_ptr<IPC::SyncChannel> extension_process_channel_;
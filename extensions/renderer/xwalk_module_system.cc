@@ -7,6 +7,7 @@
 #include <algorithm>
 #include "base/command_line.h"
 #include "base/logging.h"
+#include "base/metrics/histogram.h"
 #include "base/stl_util.h"
 #include "base/strings/string_split.h"
 #include "v8/include/v8.h"
@@ -346,10 +347,17 @@ bool XWalkModuleSystem::ContainsEntryPoint(
 }
 
 void XWalkModuleSystem::DeleteExtensionModules() {
+  int instances_avoided = 0;
   for (ExtensionModules::iterator it = extension_modules_.begin();
        it != extension_modules_.end(); ++it) {
+    if (it->module->instance_avoided())
+      instances_avoided++;
     delete it->module;
   }
+  if (!extension_modules_.empty()) {
+    UMA_HISTOGRAM_COUNTS_100("XWalk.Extensions.InstancesAvoided",
+                             instances_avoided);
+  }
   extension_modules_.clear();
 }
 
@@ -0,0 +1,212 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/renderer/xwalk_v8_value_encoder.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <utility>
+#include <vector>
+
+#include "base/macros.h"
+#include "xwalk/extensions/public/XW_Extension.h"
+#include "xwalk/extensions/public/XW_Extension_EncodedMessage.h"
+
+namespace xwalk {
+namespace extensions {
+
+namespace {
+
+class Encoder {
+ public:
+  Encoder(v8::Local<v8::Context> context, std::string* output)
+      : context_(context),
+        isolate_(context->GetIsolate()),
+        output_(output) {}
+
+  bool Encode(v8::Local<v8::Value> value) {
+    static const char kHeader[] = { 'X', 'W', 'E',
+                                    XW_ENCODED_MESSAGE_VERSION };
+    output_->append(kHeader, sizeof(kHeader));
+    return EncodeValue(value, 0);
+  }
+
+ private:
+  void WriteType(XW_ValueType type) {
+    output_->push_back(static_cast<char>(type));
+  }
+
+  void WriteVarint(uint32_t value) {
+    while (value >= 0x80) {
+      output_->push_back(static_cast<char>((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+    output_->push_back(static_cast<char>(value));
+  }
+
+  void WriteBytes(const void* data, size_t size) {
+    WriteVarint(size);
+    output_->append(static_cast<const char*>(data), size);
+  }
+
+  void WriteString(v8::Local<v8::String> string) {
+    // Written in place, so long strings are only copied once.
+    int length = string->Utf8Length();
+    WriteVarint(length);
+    size_t offset = output_->size();
+    output_->resize(offset + length);
+    if (length) {
+      string->WriteUtf8(&(*output_)[offset], length, NULL,
+                        v8::String::NO_NULL_TERMINATION |
+                        v8::String::REPLACE_INVALID_UTF8);
+    }
+  }
+
+  void WriteDouble(double value) {
+    WriteType(XW_VALUE_DOUBLE);
+    char bytes[sizeof(double)];
+    memcpy(bytes, &value, sizeof(double));
+    output_->append(bytes, sizeof(double));
+  }
+
+  static bool IsSkippedInObject(v8::Local<v8::Value> value) {
+    return value->IsFunction() || value->IsSymbol() || value->IsUndefined();
+  }
+
+  bool EncodeValue(v8::Local<v8::Value> value, int depth) {
+    if (depth > XW_ENCODED_MESSAGE_MAX_DEPTH)
+      return false;
+
+    if (value->IsNull() || value->IsUndefined() || value->IsFunction() ||
+        value->IsSymbol()) {
+      WriteType(XW_VALUE_NULL);
+      return true;
+    }
+
+    if (value->IsBoolean()) {
+      WriteType(XW_VALUE_BOOLEAN);
+      output_->push_back(value->IsTrue() ? 1 : 0);
+      return true;
+    }
+
+    if (value->IsInt32()) {
+      int32_t number = value.As<v8::Int32>()->Value();
+      WriteType(XW_VALUE_INT);
+      WriteVarint((static_cast<uint32_t>(number) << 1) ^
+                  static_cast<uint32_t>(number >> 31));
+      return true;
+    }
+
+    if (value->IsNumber()) {
+      WriteDouble(value.As<v8::Number>()->Value());
+      return true;
+    }
+
+    if (value->IsString()) {
+      WriteType(XW_VALUE_STRING);
+      WriteString(value.As<v8::String>());
+      return true;
+    }
+
+    if (value->IsDate()) {
+      WriteDouble(value.As<v8::Date>()->ValueOf());
+      return true;
+    }
+
+    if (value->IsArrayBuffer()) {
+      v8::ArrayBuffer::Contents contents =
+          value.As<v8::ArrayBuffer>()->GetContents();
+      WriteType(XW_VALUE_BINARY);
+      WriteBytes(contents.Data(), contents.ByteLength());
+      return true;
+    }
+
+    if (value->IsArrayBufferView()) {
+      v8::Local<v8::ArrayBufferView> view = value.As<v8::ArrayBufferView>();
+      v8::ArrayBuffer::Contents contents = view->Buffer()->GetContents();
+      WriteType(XW_VALUE_BINARY);
+      WriteBytes(static_cast<const char*>(contents.Data()) + view->ByteOffset(),
+                 view->ByteLength());
+      return true;
+    }
+
+    if (value->IsArray())
+      return EncodeArray(value.As<v8::Array>(), depth);
+
+    if (value->IsObject())
+      return EncodeObject(value.As<v8::Object>(), depth);
+
+    WriteType(XW_VALUE_NULL);
+    return true;
+  }
+
+  bool EncodeArray(v8::Local<v8::Array> array, int depth) {
+    uint32_t length = array->Length();
+    WriteType(XW_VALUE_ARRAY);
+    WriteVarint(length);
+    for (uint32_t i = 0; i < length; ++i) {
+      v8::HandleScope handle_scope(isolate_);
+      v8::Local<v8::Value> element;
+      if (!array->Get(context_, i).ToLocal(&element))
+        return false;
+      if (!EncodeValue(element, depth + 1))
+        return false;
+    }
+    return true;
+  }
+
+  bool EncodeObject(v8::Local<v8::Object> object, int depth) {
+    v8::Local<v8::Array> names;
+    if (!object->GetOwnPropertyNames(context_).ToLocal(&names))
+      return false;
+
+    // The number of members is written first, so the skipped properties
+    // have to be known in advance.
+    uint32_t length = names->Length();
+    std::vector<std::pair<v8::Local<v8::String>, v8::Local<v8::Value>>>
+        members;
+    members.reserve(length);
+    for (uint32_t i = 0; i < length; ++i) {
+      v8::Local<v8::Value> name;
+      v8::Local<v8::String> key;
+      v8::Local<v8::Value> member;
+      if (!names->Get(context_, i).ToLocal(&name) ||
+          !name->ToString(context_).ToLocal(&key) ||
+          !object->Get(context_, name).ToLocal(&member))
+        return false;
+      if (!IsSkippedInObject(member))
+        members.push_back(std::make_pair(key, member));
+    }
+
+    WriteType(XW_VALUE_OBJECT);
+    WriteVarint(members.size());
+    for (const auto& member : members) {
+      WriteString(member.first);
+      if (!EncodeValue(member.second, depth + 1))
+        return false;
+    }
+    return true;
+  }
+
+  v8::Local<v8::Context> context_;
+  v8::Isolate* isolate_;
+  std::string* output_;
+
+  DISALLOW_COPY_AND_ASSIGN(Encoder);
+};
+
+}  // namespace
+
+bool EncodeV8Value(v8::Local<v8::Context> context,
+                   v8::Local<v8::Value> value,
+                   std::string* output) {
+  v8::HandleScope handle_scope(context->GetIsolate());
+  output->clear();
+  Encoder encoder(context, output);
+  return encoder.Encode(value);
+}
+
+}  // namespace extensions
+}  // namespace xwalk
@@ -0,0 +1,26 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_RENDERER_XWALK_V8_VALUE_ENCODER_H_
+#define XWALK_EXTENSIONS_RENDERER_XWALK_V8_VALUE_ENCODER_H_
+
+#include <string>
+
+#include "v8/include/v8.h"
+
+namespace xwalk {
+namespace extensions {
+
+// Writes a JavaScript value in the binary format described in
+// XW_Extension_EncodedMessage.h, used by extension.postEncodedMessage().
+// Unlike content::V8ValueConverter no intermediate base::Value tree is built.
+// Returns false if |value| can't be encoded, e.g. it has cycles.
+bool EncodeV8Value(v8::Local<v8::Context> context,
+                   v8::Local<v8::Value> value,
+                   std::string* output);
+
+}  // namespace extensions
+}  // namespace xwalk
+
+#endif  // XWALK_EXTENSIONS_RENDERER_XWALK_V8_VALUE_ENCODER_H_
@@ -0,0 +1,210 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#if defined(__cplusplus)
+#error "This file is written in C to make sure the C API works as intended."
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "xwalk/extensions/public/XW_Extension.h"
+#include "xwalk/extensions/public/XW_Extension_EncodedMessage.h"
+#include "xwalk/extensions/public/XW_Extension_Message_2.h"
+
+XW_Extension g_extension = 0;
+const XW_CoreInterface* g_core = NULL;
+const XW_MessagingInterface2* g_messaging = NULL;
+const XW_EncodedMessagingInterface* g_encoded_messaging = NULL;
+
+struct Buffer {
+  char* data;
+  size_t size;
+  size_t capacity;
+};
+
+void append(struct Buffer* buffer, const char* data, size_t size) {
+  if (buffer->size + size + 1 > buffer->capacity) {
+    buffer->capacity = (buffer->size + size + 1) * 2;
+    buffer->data = realloc(buffer->data, buffer->capacity);
+  }
+  memcpy(buffer->data + buffer->size, data, size);
+  buffer->size += size;
+  buffer->data[buffer->size] = '\0';
+}
+
+void append_string(struct Buffer* buffer, const char* data, size_t size) {
+  size_t i;
+  append(buffer, "\"", 1);
+  for (i = 0; i < size; ++i) {
+    char escaped[8];
+    unsigned char c = (unsigned char)data[i];
+    if (c == '"' || c == '\\') {
+      snprintf(escaped, sizeof(escaped), "\\%c", c);
+      append(buffer, escaped, 2);
+    } else if (c < 0x20) {
+      snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      append(buffer, escaped, 6);
+    } else {
+      append(buffer, data + i, 1);
+    }
+  }
+  append(buffer, "\"", 1);
+}
+
+// Writes the next value as JSON. Binary values become arrays of bytes.
+int append_value(XW_ValueReader* reader, struct Buffer* buffer) {
+  XW_Value value;
+  char number[32];
+  uint32_t i;
+
+  if (!XW_ValueReader_ReadValue(reader, &value))
+    return 0;
+
+  switch (value.type) {
+    case XW_VALUE_NULL:
+      append(buffer, "null", 4);
+      return 1;
+    case XW_VALUE_BOOLEAN:
+      if (value.boolean_value)
+        append(buffer, "true", 4);
+      else
+        append(buffer, "false", 5);
+      return 1;
+    case XW_VALUE_INT:
+      snprintf(number, sizeof(number), "%d", value.int_value);
+      append(buffer, number, strlen(number));
+      return 1;
+    case XW_VALUE_DOUBLE:
+      snprintf(number, sizeof(number), "%.17g", value.double_value);
+      append(buffer, number, strlen(number));
+      return 1;
+    case XW_VALUE_STRING:
+      append_string(buffer, value.data, value.size);
+      return 1;
+    case XW_VALUE_BINARY:
+      append(buffer, "[", 1);
+      for (i = 0; i < value.size; ++i) {
+        snprintf(number, sizeof(number), i ? ",%u" : "%u",
+                 (unsigned)(unsigned char)value.data[i]);
+        append(buffer, number, strlen(number));
+      }
+      append(buffer, "]", 1);
+      return 1;
+    case XW_VALUE_ARRAY:
+      append(buffer, "[", 1);
+      for (i = 0; i < value.count; ++i) {
+        if (i)
+          append(buffer, ",", 1);
+        if (!append_value(reader, buffer))
+          return 0;
+      }
+      append(buffer, "]", 1);
+      return 1;
+    case XW_VALUE_OBJECT:
+      append(buffer, "{", 1);
+      for (i = 0; i < value.count; ++i) {
+        const char* key;
+        size_t key_size;
+        if (i)
+          append(buffer, ",", 1);
+        if (!XW_ValueReader_ReadKey(reader, &key, &key_size))
+          return 0;
+        append_string(buffer, key, key_size);
+        append(buffer, ":", 1);
+        if (!append_value(reader, buffer))
+          return 0;
+      }
+      append(buffer, "}", 1);
+      return 1;
+  }
+  return 0;
+}
+
+// Messages are [command, payload]. "echo" replies the payload as JSON,
+// "decode" only walks it and replies nothing.
+void handle_encoded_message(XW_Instance instance, const char* message,
+                            const size_t size) {
+  XW_ValueReader reader;
+  XW_Value value;
+  struct Buffer buffer = { NULL, 0, 0 };
+
+  if (!XW_ValueReader_Init(&reader, message, size) ||
+      !XW_ValueReader_ReadValue(&reader, &value) ||
+      value.type != XW_VALUE_ARRAY || value.count != 2 ||
+      !XW_ValueReader_ReadValue(&reader, &value) ||
+      value.type != XW_VALUE_STRING) {
+    g_messaging->PostMessage(instance, "malformed");
+    return;
+  }
+
+  if (value.size == strlen("decode") &&
+      !memcmp(value.data, "decode", value.size)) {
+    if (!XW_ValueReader_SkipValue(&reader) || !XW_ValueReader_AtEnd(&reader))
+      g_messaging->PostMessage(instance, "malformed");
+    return;
+  }
+
+  if (!append_value(&reader, &buffer) || !XW_ValueReader_AtEnd(&reader)) {
+    g_messaging->PostMessage(instance, "malformed");
+  } else {
+    g_messaging->PostMessage(instance, buffer.data);
+  }
+  free(buffer.data);
+}
+
+// Plain messages, used to compare with the JSON and V8ValueConverter paths.
+void handle_message(XW_Instance instance, const char* message) {
+}
+
+// ArrayBuffers posted with extension.postMessage() must never be taken for
+// encoded messages, whatever their contents.
+void handle_binary_message(XW_Instance instance, const char* message,
+                           const size_t size) {
+  g_messaging->PostMessage(instance, "binary");
+}
+
+int32_t XW_Initialize(XW_Extension extension, XW_GetInterface get_interface) {
+  static const char* kAPI =
+      "var listener = null;"
+      "extension.setMessageListener(function(msg) {"
+      "  if (listener) listener(msg);"
+      "});"
+      "exports.echo = function(value, callback) {"
+      "  listener = callback;"
+      "  return extension.postEncodedMessage(['echo', value]);"
+      "};"
+      "exports.postEncoded = function(value) {"
+      "  return extension.postEncodedMessage(['decode', value]);"
+      "};"
+      "exports.echoRaw = function(buffer, callback) {"
+      "  listener = callback;"
+      "  return extension.postMessage(buffer);"
+      "};"
+      "exports.postJSON = function(value) {"
+      "  return extension.postMessage(JSON.stringify(value));"
+      "};"
+      "exports.postValue = function(value) {"
+      "  return extension.postMessage(value);"
+      "};";
+
+  g_extension = extension;
+  g_core = get_interface(XW_CORE_INTERFACE);
+  g_core->SetExtensionName(extension, "encodedEcho");
+  g_core->SetJavaScriptAPI(extension, kAPI);
+
+  g_messaging = get_interface(XW_MESSAGING_INTERFACE_2);
+  if (!g_messaging)
+    return XW_ERROR;
+  g_messaging->Register(extension, handle_message);
+  g_messaging->RegisterBinaryMesssageCallback(extension,
+                                              handle_binary_message);
+
+  g_encoded_messaging = get_interface(XW_ENCODED_MESSAGING_INTERFACE);
+  if (!g_encoded_messaging)
+    return XW_ERROR;
+  g_encoded_messaging->Register(extension, handle_encoded_message);
+
+  return XW_OK;
+}
@@ -0,0 +1,81 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#if defined(__cplusplus)
+#error "This file is written in C to make sure the C API works as intended."
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "xwalk/extensions/public/XW_Extension.h"
+#include "xwalk/extensions/public/XW_Extension_Message_3.h"
+
+XW_Extension g_extension = 0;
+const XW_CoreInterface* g_core = NULL;
+const XW_MessagingInterface3* g_messaging_3 = NULL;
+
+void instance_created(XW_Instance instance) {
+  printf("Instance %d created!\n", instance);
+}
+
+void instance_destroyed(XW_Instance instance) {
+  printf("Instance %d destroyed!\n", instance);
+}
+
+void handle_message(XW_Instance instance, const char* message) {
+  g_messaging_3->PostMessage(instance, message);
+}
+
+// Echoes the binary message back using a shared buffer, so it reaches the
+// JavaScript side without copies. Failures are reported with a string, which
+// the caller of echoBinary() doesn't expect.
+void handle_binary_message(
+    XW_Instance instance, const char* message, const size_t size) {
+  XW_Buffer buffer = 0;
+  void* data = g_messaging_3->AllocateBuffer(instance, size, &buffer);
+  if (data == NULL) {
+    g_messaging_3->PostMessage(instance, "AllocateBuffer failed");
+    return;
+  }
+  memcpy(data, message, size);
+  g_messaging_3->PostBuffer(instance, buffer, size);
+}
+
+void shutdown(XW_Extension extension) {
+  printf("Shutdown\n");
+}
+
+int32_t XW_Initialize(XW_Extension extension, XW_GetInterface get_interface) {
+  static const char* kAPI =
+      "var echoListener = null;"
+      "extension.setMessageListener(function(msg) {"
+      "  if (echoListener instanceof Function)"
+      "    echoListener(msg);"
+      "});"
+      "exports.echo = function(msg, callback) {"
+      "  echoListener = callback;"
+      "  extension.postMessage(msg);"
+      "};"
+      "exports.echoBinary = exports.echo;";
+
+  g_extension = extension;
+  g_core = get_interface(XW_CORE_INTERFACE);
+  if (g_core == NULL)
+    return XW_ERROR;
+  g_core->SetExtensionName(extension, "echo3");
+  g_core->SetJavaScriptAPI(extension, kAPI);
+  g_core->RegisterInstanceCallbacks(
+      extension, instance_created, instance_destroyed);
+  g_core->RegisterShutdownCallback(extension, shutdown);
+
+  g_messaging_3 = get_interface(XW_MESSAGING_INTERFACE_3);
+  if (g_messaging_3 == NULL)
+    return XW_ERROR;
+  g_messaging_3->Register(extension, handle_message);
+  g_messaging_3->RegisterBinaryMessageCallback(
+      extension, handle_binary_message);
+
+  return XW_OK;
+}
@@ -0,0 +1,91 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#if defined(__cplusplus)
+#error "This file is written in C to make sure the C API works as intended."
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "xwalk/extensions/public/XW_Extension.h"
+#include "xwalk/extensions/public/XW_Extension_MessageWithReply.h"
+
+#define MAX_PENDING_REQUESTS 16
+
+XW_Extension g_extension = 0;
+const XW_CoreInterface* g_core = NULL;
+const XW_MessageWithReplyInterface* g_reply = NULL;
+
+// Requests are held until "flush" is received and then replied in reverse
+// order, so the JavaScript side must match replies by request.
+struct PendingRequest {
+  XW_Instance instance;
+  XW_Request request;
+  char* message;
+};
+
+struct PendingRequest g_pending[MAX_PENDING_REQUESTS];
+int g_pending_count = 0;
+
+void instance_created(XW_Instance instance) {
+  printf("Instance %d created!\n", instance);
+}
+
+void instance_destroyed(XW_Instance instance) {
+  printf("Instance %d destroyed!\n", instance);
+}
+
+void handle_message_with_reply(XW_Instance instance, XW_Request request,
+                               const char* message) {
+  if (strcmp(message, "flush") != 0) {
+    if (g_pending_count == MAX_PENDING_REQUESTS) {
+      g_reply->Reply(instance, request, "too many pending requests");
+      return;
+    }
+    g_pending[g_pending_count].instance = instance;
+    g_pending[g_pending_count].request = request;
+    g_pending[g_pending_count].message = strdup(message);
+    g_pending_count++;
+    return;
+  }
+
+  while (g_pending_count > 0) {
+    struct PendingRequest* pending = &g_pending[--g_pending_count];
+    g_reply->Reply(pending->instance, pending->request, pending->message);
+    free(pending->message);
+  }
+  g_reply->Reply(instance, request, "flushed");
+}
+
+void shutdown(XW_Extension extension) {
+  printf("Shutdown\n");
+}
+
+int32_t XW_Initialize(XW_Extension extension, XW_GetInterface get_interface) {
+  static const char* kAPI =
+      "exports.echo = function(msg) {"
+      "  return extension.sendMessageWithReply(msg);"
+      "};"
+      "exports.flush = function() {"
+      "  return extension.sendMessageWithReply('flush');"
+      "};";
+
+  g_extension = extension;
+  g_core = get_interface(XW_CORE_INTERFACE);
+  if (g_core == NULL)
+    return XW_ERROR;
+  g_core->SetExtensionName(extension, "echoWithReply");
+  g_core->SetJavaScriptAPI(extension, kAPI);
+  g_core->RegisterInstanceCallbacks(
+      extension, instance_created, instance_destroyed);
+  g_core->RegisterShutdownCallback(extension, shutdown);
+
+  g_reply = get_interface(XW_MESSAGE_WITH_REPLY_INTERFACE);
+  if (g_reply == NULL)
+    return XW_ERROR;
+  g_reply->Register(extension, handle_message_with_reply);
+
+  return XW_OK;
+}
@@ -21,6 +21,7 @@ namespace {
 
 base::Lock g_count_lock;
 int g_count = 0;
+int g_instances_created = 0;
 
 }
 
@@ -47,6 +48,8 @@ class CounterExtension : public XWalkExtension {
   }
 
   XWalkExtensionInstance* CreateInstance() override {
+    base::AutoLock lock(g_count_lock);
+    g_instances_created++;
     return new CounterExtensionContext();
   }
 };
@@ -69,6 +72,22 @@ IN_PROC_BROWSER_TEST_F(XWalkExtensionsIFrameTest,
   ASSERT_EQ(g_count, 3);
 }
 
+// The extension code is loaded in the three frames, but only the main frame
+// uses it, so there should be a single instance.
+IN_PROC_BROWSER_TEST_F(XWalkExtensionsIFrameTest,
+                       InstancesAreOnlyCreatedWhenUsed) {
+  Runtime* runtime = CreateRuntime();
+  GURL url = GetExtensionsTestURL(base::FilePath(),
+      base::FilePath().AppendASCII("counter_only_in_main_frame.html"));
+  content::TitleWatcher title_watcher(runtime->web_contents(), kPassString);
+  xwalk_test_utils::NavigateToURL(runtime, url);
+  EXPECT_EQ(kPassString, title_watcher.WaitAndGetTitle());
+  SPIN_FOR_1_SECOND_OR_UNTIL_TRUE(g_count == 1);
+  ASSERT_EQ(g_count, 1);
+  base::AutoLock lock(g_count_lock);
+  ASSERT_EQ(g_instances_created, 1);
+}
+
 IN_PROC_BROWSER_TEST_F(XWalkExtensionsIFrameTest,
                        ContextsAreNotCreatedForIFramesWithBlankPages) {
   Runtime* runtime = CreateRuntime();
@@ -2,15 +2,20 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include "base/command_line.h"
 #include "base/native_library.h"
 #include "base/path_service.h"
 #include "base/strings/utf_string_conversions.h"
+#include "base/values.h"
 #include "xwalk/extensions/browser/xwalk_extension_service.h"
+#include "xwalk/extensions/common/xwalk_extension_switches.h"
 #include "xwalk/extensions/test/xwalk_extensions_test_base.h"
 #include "xwalk/runtime/browser/runtime.h"
 #include "xwalk/test/base/xwalk_test_utils.h"
+#include "content/public/common/content_switches.h"
 #include "content/public/test/browser_test_utils.h"
 #include "content/public/test/test_utils.h"
+#include "testing/perf/perf_test.h"
 
 using xwalk::extensions::XWalkExtensionService;
 using xwalk::Runtime;
@@ -24,6 +29,26 @@ class ExternalExtensionTest : public XWalkExtensionsTestBase {
   }
 };
 
+// The echo_extension directory has several libraries, which are otherwise
+// loaded in parallel.
+class SerialLoadingExternalExtensionTest : public ExternalExtensionTest {
+ public:
+  void SetUpCommandLine(base::CommandLine* command_line) override {
+    ExternalExtensionTest::SetUpCommandLine(command_line);
+    command_line->AppendSwitchASCII(switches::kXWalkExtensionLoadThreads, "1");
+  }
+};
+
+// Shared buffers are only recycled once JS objects referencing them are
+// collected, so the test page forces garbage collections.
+class SharedBufferExternalExtensionTest : public ExternalExtensionTest {
+ public:
+  void SetUpCommandLine(base::CommandLine* command_line) override {
+    ExternalExtensionTest::SetUpCommandLine(command_line);
+    command_line->AppendSwitchASCII(switches::kJavaScriptFlags, "--expose-gc");
+  }
+};
+
 class BulkExtensionTest : public XWalkExtensionsTestBase {
  public:
   void SetUp() override {
@@ -88,6 +113,29 @@ IN_PROC_BROWSER_TEST_F(ExternalExtensionTest, ExternalExtensionMessaging2) {
   EXPECT_EQ(kPassString, title_watcher.WaitAndGetTitle());
 }
 
+IN_PROC_BROWSER_TEST_F(SharedBufferExternalExtensionTest,
+                       ExternalExtensionMessaging3) {
+  Runtime* runtime = CreateRuntime();
+  GURL url = GetExtensionsTestURL(
+      base::FilePath(),
+      base::FilePath().AppendASCII("echo_messaging_3.html"));
+  content::TitleWatcher title_watcher(runtime->web_contents(), kPassString);
+  title_watcher.AlsoWaitForTitle(kFailString);
+  xwalk_test_utils::NavigateToURL(runtime, url);
+  EXPECT_EQ(kPassString, title_watcher.WaitAndGetTitle());
+}
+
+IN_PROC_BROWSER_TEST_F(ExternalExtensionTest, ExternalExtensionWithReply) {
+  Runtime* runtime = CreateRuntime();
+  GURL url = GetExtensionsTestURL(
+      base::FilePath(),
+      base::FilePath().AppendASCII("echo_with_reply.html"));
+  content::TitleWatcher title_watcher(runtime->web_contents(), kPassString);
+  title_watcher.AlsoWaitForTitle(kFailString);
+  xwalk_test_utils::NavigateToURL(runtime, url);
+  EXPECT_EQ(kPassString, title_watcher.WaitAndGetTitle());
+}
+
 IN_PROC_BROWSER_TEST_F(ExternalExtensionTest, ExternalExtensionSync) {
   Runtime* runtime = CreateRuntime();
   GURL url = GetExtensionsTestURL(
@@ -99,6 +147,46 @@ IN_PROC_BROWSER_TEST_F(ExternalExtensionTest, ExternalExtensionSync) {
   EXPECT_EQ(kPassString, title_watcher.WaitAndGetTitle());
 }
 
+IN_PROC_BROWSER_TEST_F(ExternalExtensionTest, EncodedMessage) {
+  Runtime* runtime = CreateRuntime();
+  GURL url = GetExtensionsTestURL(
+      base::FilePath(),
+      base::FilePath().AppendASCII("encoded_message.html"));
+  content::TitleWatcher title_watcher(runtime->web_contents(), kPassString);
+  title_watcher.AlsoWaitForTitle(kFailString);
+  xwalk_test_utils::NavigateToURL(runtime, url);
+  EXPECT_EQ(kPassString, title_watcher.WaitAndGetTitle());
+}
+
+IN_PROC_BROWSER_TEST_F(ExternalExtensionTest, EncodedMessageThroughput) {
+  Runtime* runtime = CreateRuntime();
+  GURL url = GetExtensionsTestURL(
+      base::FilePath(),
+      base::FilePath().AppendASCII("encoded_message_perf.html"));
+  std::unique_ptr<base::DictionaryValue> results;
+  ASSERT_TRUE(xwalk_test_utils::RunPerfPage(runtime, url, &results));
+  EXPECT_FALSE(results->empty());
+
+  for (base::DictionaryValue::Iterator it(*results); !it.IsAtEnd();
+       it.Advance()) {
+    double time = 0;
+    ASSERT_TRUE(it.value().GetAsDouble(&time));
+    perf_test::PrintResult("encoded_message_post_time", "", it.key(),
+                           time, "ms", true);
+  }
+}
+
+IN_PROC_BROWSER_TEST_F(SerialLoadingExternalExtensionTest,
+                       ExternalExtension) {
+  Runtime* runtime = CreateRuntime();
+  GURL url = GetExtensionsTestURL(base::FilePath(),
+                                  base::FilePath().AppendASCII("echo.html"));
+  content::TitleWatcher title_watcher(runtime->web_contents(), kPassString);
+  title_watcher.AlsoWaitForTitle(kFailString);
+  xwalk_test_utils::NavigateToURL(runtime, url);
+  EXPECT_EQ(kPassString, title_watcher.WaitAndGetTitle());
+}
+
 IN_PROC_BROWSER_TEST_F(RuntimeInterfaceTest, GetRuntimeVariable) {
   Runtime* runtime = CreateRuntime();
   GURL url = GetExtensionsTestURL(
@@ -153,3 +241,21 @@ title_watcher.AlsoWaitForTitle(kFailString);
 xwalk_test_utils::NavigateToURL(runtime, url);
 EXPECT_EQ(kPassString, title_watcher.WaitAndGetTitle());
 }
+
+IN_PROC_BROWSER_TEST_F(BulkExtensionTest, BulkDataThroughput) {
+  Runtime* runtime = CreateRuntime();
+  GURL url = GetExtensionsTestURL(
+      base::FilePath(),
+      base::FilePath().AppendASCII("bulk_data_benchmark.html"));
+  std::unique_ptr<base::DictionaryValue> results;
+  ASSERT_TRUE(xwalk_test_utils::RunPerfPage(runtime, url, &results));
+  EXPECT_FALSE(results->empty());
+
+  for (base::DictionaryValue::Iterator it(*results); !it.IsAtEnd();
+       it.Advance()) {
+    double throughput = 0;
+    ASSERT_TRUE(it.value().GetAsDouble(&throughput));
+    perf_test::PrintResult("bulk_data_throughput", "", it.key() + "_bytes",
+                           throughput, "MB/s", true);
+  }
+}
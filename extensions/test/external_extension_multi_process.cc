@@ -2,18 +2,36 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <set>
+#include <vector>
+
+#include "base/command_line.h"
 #include "base/native_library.h"
 #include "base/path_service.h"
+#include "base/process/process_metrics.h"
+#include "base/run_loop.h"
+#include "base/strings/string_number_conversions.h"
+#include "xwalk/extensions/browser/xwalk_extension_service.h"
+#include "xwalk/extensions/common/xwalk_extension_switches.h"
 #include "xwalk/extensions/test/xwalk_extensions_test_base.h"
 #include "xwalk/runtime/browser/runtime.h"
 #include "xwalk/runtime/common/xwalk_notification_types.h"
 #include "xwalk/test/base/xwalk_test_utils.h"
+#include "content/public/browser/browser_child_process_host_iterator.h"
+#include "content/public/browser/browser_thread.h"
+#include "content/public/browser/child_process_data.h"
 #include "content/public/browser/notification_service.h"
+#include "content/public/browser/render_process_host.h"
+#include "content/public/browser/web_contents.h"
+#include "content/public/common/process_type.h"
 #include "content/public/test/browser_test_utils.h"
 #include "content/public/test/test_utils.h"
+#include "testing/perf/perf_test.h"
 
+using content::BrowserThread;
 using xwalk::NativeAppWindow;
 using xwalk::Runtime;
+using xwalk::extensions::XWalkExtensionService;
 using xwalk::extensions::XWalkExtensionVector;
 
 class ExternalExtensionMultiProcessTest : public XWalkExtensionsTestBase {
@@ -84,3 +102,105 @@ IN_PROC_BROWSER_TEST_F(ExternalExtensionMultiProcessTest,
   EXPECT_EQ(len + 1, runtimes().size());
   EXPECT_EQ(2, CountRegisterExtensions());
 }
+
+namespace {
+
+void GetExtensionProcessHandles(std::vector<base::ProcessHandle>* handles) {
+  DCHECK_CURRENTLY_ON(BrowserThread::IO);
+  for (content::BrowserChildProcessHostIterator it(
+           content::PROCESS_TYPE_CONTENT_END); !it.Done(); ++it) {
+    handles->push_back(it.GetData().handle);
+  }
+}
+
+}  // namespace
+
+// Compares one extension process per render process with a shared one, see
+// --xwalk-shared-extension-process.
+class ExtensionProcessScalingTest : public XWalkExtensionsTestBase,
+                                    public testing::WithParamInterface<bool> {
+ public:
+  void SetUp() override {
+    XWalkExtensionService::SetExternalExtensionsPathForTesting(
+        GetExternalExtensionTestPath(FILE_PATH_LITERAL("echo_extension")));
+    XWalkExtensionsTestBase::SetUp();
+  }
+
+  void SetUpCommandLine(base::CommandLine* command_line) override {
+    XWalkExtensionsTestBase::SetUpCommandLine(command_line);
+    if (GetParam())
+      command_line->AppendSwitch(switches::kXWalkSharedExtensionProcess);
+  }
+
+  std::vector<base::ProcessHandle> GetExtensionProcesses() {
+    std::vector<base::ProcessHandle> handles;
+    base::RunLoop run_loop;
+    BrowserThread::PostTaskAndReply(BrowserThread::IO, FROM_HERE,
+        base::Bind(&GetExtensionProcessHandles, &handles),
+        run_loop.QuitClosure());
+    run_loop.Run();
+    return handles;
+  }
+
+  // Sum of the resident memory of |handles|, in KB.
+  size_t GetRSS(const std::vector<base::ProcessHandle>& handles) {
+    size_t rss = 0;
+#if !defined(OS_MACOSX)
+    for (base::ProcessHandle handle : handles) {
+      std::unique_ptr<base::ProcessMetrics> metrics(
+          base::ProcessMetrics::CreateProcessMetrics(handle));
+      rss += metrics->GetWorkingSetSize() / 1024;
+    }
+#endif
+    return rss;
+  }
+};
+
+IN_PROC_BROWSER_TEST_P(ExtensionProcessScalingTest, RenderProcessScaling) {
+  GURL url = GetExtensionsTestURL(
+      base::FilePath(), base::FilePath().AppendASCII("echo_timing.html"));
+  const char* trace = GetParam() ? "shared" : "per_render_process";
+  const size_t kRenderProcessCounts[] = { 1, 4, 16 };
+
+  std::set<int> render_process_ids;
+  for (size_t count : kRenderProcessCounts) {
+    double total_time = 0;
+    size_t created = 0;
+    for (; render_process_ids.size() < count; ++created) {
+      Runtime* runtime = CreateRuntime();
+      // Otherwise the numbers are for fewer render processes than reported.
+      ASSERT_TRUE(render_process_ids.insert(
+          runtime->web_contents()->GetRenderProcessHost()->GetID()).second);
+      content::TitleWatcher title_watcher(runtime->web_contents(),
+                                          kPassString);
+      title_watcher.AlsoWaitForTitle(kFailString);
+      xwalk_test_utils::NavigateToURL(runtime, url);
+      ASSERT_EQ(kPassString, title_watcher.WaitAndGetTitle());
+
+      std::string time;
+      ASSERT_TRUE(content::ExecuteScriptAndExtractString(
+          runtime->web_contents(),
+          "window.domAutomationController.send(String(firstMessageTime));",
+          &time));
+      double first_message_time;
+      ASSERT_TRUE(base::StringToDouble(time, &first_message_time));
+      total_time += first_message_time;
+    }
+
+    // The runtimes all belong to the same application, so they share one
+    // extension process in the shared mode.
+    std::vector<base::ProcessHandle> extension_processes =
+        GetExtensionProcesses();
+    ASSERT_EQ(GetParam() ? 1u : count, extension_processes.size());
+
+    std::string renderers = base::SizeTToString(count) + "_renderers";
+    perf_test::PrintResult("time_to_first_message", trace, renderers,
+                           total_time / created, "ms", true);
+    perf_test::PrintResult("extension_process_rss", trace, renderers,
+                           GetRSS(extension_processes), "KB", true);
+  }
+}
+
+INSTANTIATE_TEST_CASE_P(SharedExtensionProcess,
+                        ExtensionProcessScalingTest,
+                        testing::Bool());
@@ -0,0 +1,79 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#if defined(__cplusplus)
+#error "This file is written in C to make sure the C API works as intended."
+#endif
+
+// Echoes every kind of message back, for measuring the extension IPC, see
+// xwalk/extensions/xesh/xesh_ipc_benchmark.js.
+
+#include <stdlib.h>
+#include <string.h>
+#include "xwalk/extensions/public/XW_Extension.h"
+#include "xwalk/extensions/public/XW_Extension_Message_3.h"
+#include "xwalk/extensions/public/XW_Extension_SyncMessage.h"
+
+XW_Extension g_extension = 0;
+const XW_CoreInterface* g_core = NULL;
+const XW_MessagingInterface3* g_messaging_3 = NULL;
+const XW_Internal_SyncMessagingInterface* g_sync_messaging = NULL;
+
+void handle_message(XW_Instance instance, const char* message) {
+  g_messaging_3->PostMessage(instance, message);
+}
+
+void handle_sync_message(XW_Instance instance, const char* message) {
+  g_sync_messaging->SetSyncReply(instance, message);
+}
+
+// Uses a shared buffer when possible, like a well behaved extension would
+// for large payloads.
+void handle_binary_message(
+    XW_Instance instance, const char* message, const size_t size) {
+  XW_Buffer buffer = 0;
+  void* data = g_messaging_3->AllocateBuffer(instance, size, &buffer);
+  if (data == NULL) {
+    g_messaging_3->PostBinaryMessage(instance, message, size);
+    return;
+  }
+  memcpy(data, message, size);
+  g_messaging_3->PostBuffer(instance, buffer, size);
+}
+
+int32_t XW_Initialize(XW_Extension extension, XW_GetInterface get_interface) {
+  static const char* kAPI =
+      "var replyListener = null;"
+      "extension.setMessageListener(function(msg) {"
+      "  if (replyListener instanceof Function)"
+      "    replyListener(msg);"
+      "});"
+      "exports.setReplyListener = function(callback) {"
+      "  replyListener = callback;"
+      "};"
+      "exports.post = function(msg) {"
+      "  extension.postMessage(msg);"
+      "};"
+      "exports.sendSync = function(msg) {"
+      "  return extension.internal.sendSyncMessage(msg);"
+      "};";
+
+  g_extension = extension;
+  g_core = get_interface(XW_CORE_INTERFACE);
+  if (g_core == NULL)
+    return XW_ERROR;
+  g_core->SetExtensionName(extension, "ipcBenchmark");
+  g_core->SetJavaScriptAPI(extension, kAPI);
+
+  g_messaging_3 = get_interface(XW_MESSAGING_INTERFACE_3);
+  g_sync_messaging = get_interface(XW_INTERNAL_SYNC_MESSAGING_INTERFACE);
+  if (g_messaging_3 == NULL || g_sync_messaging == NULL)
+    return XW_ERROR;
+  g_messaging_3->Register(extension, handle_message);
+  g_messaging_3->RegisterBinaryMessageCallback(
+      extension, handle_binary_message);
+  g_sync_messaging->Register(extension, handle_sync_message);
+
+  return XW_OK;
+}
@@ -0,0 +1,124 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Measures the extension IPC against the ipcBenchmark extension, see
+// xwalk/extensions/test/ipc_benchmark_extension.c. Run it through
+// xesh_ipc_benchmark.py, which parses the line starting with "RESULT ", or
+// the one starting with "ERROR " if the benchmark failed.
+
+var kPayloadSizes = [16, 1024, 64 * 1024, 1024 * 1024];
+var kKinds = ['postMessage', 'binary', 'sendSyncMessage'];
+var kLatencyRoundTrips = 200;
+// Bounds the data sent by each throughput run.
+var kBytesPerRun = 16 * 1024 * 1024;
+var kMinMessages = 10;
+var kMaxMessages = 10000;
+
+var results = [];
+
+// XESh only exits on quit(), so any exception must end the benchmark or
+// the runner would wait for it forever.
+function fail(e) {
+  print('ERROR ' + (e && e.stack ? e.stack : e));
+  quit();
+}
+
+// Returns |callback| reporting its exceptions through fail().
+function guard(callback) {
+  return function() {
+    try {
+      return callback.apply(this, arguments);
+    } catch (e) {
+      fail(e);
+    }
+  };
+}
+
+function createPayload(kind, size) {
+  if (kind == 'binary') {
+    var buffer = new ArrayBuffer(size);
+    var view = new Uint8Array(buffer);
+    for (var i = 0; i < size; ++i)
+      view[i] = i & 0xff;
+    return buffer;
+  }
+  return new Array(size + 1).join('x');
+}
+
+function messageCount(size) {
+  var count = Math.floor(kBytesPerRun / size);
+  return Math.max(kMinMessages, Math.min(kMaxMessages, count));
+}
+
+// Sends |count| messages, one after the reply to the previous one when
+// |wait_for_reply| is true, else all at once, and calls |done| with the
+// elapsed time in milliseconds once every reply arrived.
+function run(kind, payload, count, wait_for_reply, done) {
+  var start = now();
+  if (kind == 'sendSyncMessage') {
+    for (var i = 0; i < count; ++i)
+      ipcBenchmark.sendSync(payload);
+    done(now() - start);
+    return;
+  }
+
+  var replies = 0;
+  ipcBenchmark.setReplyListener(guard(function(msg) {
+    ++replies;
+    if (replies == count) {
+      done(now() - start);
+      return;
+    }
+    if (wait_for_reply)
+      ipcBenchmark.post(payload);
+  }));
+  if (wait_for_reply) {
+    ipcBenchmark.post(payload);
+    return;
+  }
+  for (var i = 0; i < count; ++i)
+    ipcBenchmark.post(payload);
+}
+
+function runTest(kind, size, done) {
+  var payload = createPayload(kind, size);
+  run(kind, payload, kLatencyRoundTrips, true, function(latency_ms) {
+    var count = messageCount(size);
+    run(kind, payload, count, false, function(throughput_ms) {
+      var seconds = throughput_ms / 1000;
+      results.push({
+        'kind': kind,
+        'payload_bytes': size,
+        'messages': count,
+        'round_trip_us': latency_ms * 1000 / kLatencyRoundTrips,
+        'messages_per_sec': count / seconds,
+        'mb_per_sec': count * size / (1024 * 1024) / seconds
+      });
+      done();
+    });
+  });
+}
+
+var tests = [];
+kKinds.forEach(function(kind) {
+  kPayloadSizes.forEach(function(size) {
+    tests.push({ 'kind': kind, 'size': size });
+  });
+});
+
+function runNextTest() {
+  var test = tests.shift();
+  if (!test) {
+    print('RESULT ' + JSON.stringify(results));
+    quit();
+    return;
+  }
+  runTest(test.kind, test.size, runNextTest);
+}
+
+guard(function() {
+  if (typeof ipcBenchmark == 'undefined')
+    throw new Error('The ipcBenchmark extension is not loaded.');
+  runNextTest();
+})();
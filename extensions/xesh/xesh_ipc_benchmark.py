@@ -0,0 +1,95 @@
+#!/usr/bin/env python
+# Copyright (c) 2016 Intel Corporation. All rights reserved.
+# Use of this source code is governed by a BSD-style license that can be
+# found in the LICENSE file.
+
+"""Runs xesh_ipc_benchmark.js in XESh with the extension server on each
+supported thread and prints the results as JSON.
+
+Usage: xesh_ipc_benchmark.py [--output=FILE] [--timeout=SECONDS]
+                             PATH_TO_BUILD_DIR
+"""
+
+import json
+import optparse
+import os
+import subprocess
+import sys
+import threading
+
+# The threads XESh can run the extension server on, see --server-thread.
+SERVER_THREADS = ['ui', 'extension']
+RESULT_PREFIX = 'RESULT '
+ERROR_PREFIX = 'ERROR '
+# Generous, a run takes a few seconds on a desktop.
+DEFAULT_TIMEOUT = 300
+
+
+def RunBenchmark(build_dir, script, server_thread, timeout):
+  command = [
+      os.path.join(build_dir, 'xesh'),
+      '--external-extensions-path=' + os.path.join(
+          build_dir, 'tests', 'extension', 'ipc_benchmark_extension'),
+      '--input-file=' + script,
+      '--server-thread=' + server_thread,
+  ]
+  # XESh exits as soon as stdin is closed, so keep it open until the script
+  # quits, which communicate() would not do.
+  process = subprocess.Popen(command, stdin=subprocess.PIPE,
+                             stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+  # Kills XESh if the script neither quits nor fails, e.g. when a reply
+  # never arrives.
+  timer = threading.Timer(timeout, process.kill)
+  timer.start()
+  try:
+    output = process.stdout.read()
+    process.wait()
+  finally:
+    timer.cancel()
+    process.stdin.close()
+  for line in output.splitlines():
+    if line.startswith(RESULT_PREFIX):
+      return json.loads(line[len(RESULT_PREFIX):])
+    if line.startswith(ERROR_PREFIX):
+      break
+  if process.returncode < 0:
+    reason = 'was killed after %d seconds' % timeout
+  else:
+    reason = 'exited with %d' % process.returncode
+  raise Exception('No result for the %s thread server, xesh %s and printed:'
+                  '\n%s' % (server_thread, reason, output))
+
+
+def main():
+  parser = optparse.OptionParser(usage=__doc__)
+  parser.add_option('--output', help='Writes the results to this file.')
+  parser.add_option('--timeout', type='int', default=DEFAULT_TIMEOUT,
+                    help='Seconds after which a run is killed.')
+  options, args = parser.parse_args()
+  if len(args) != 1:
+    parser.error('Expected the build directory.')
+  build_dir = os.path.abspath(args[0])
+  if not os.path.isfile(os.path.join(build_dir, 'xesh')):
+    parser.error('Please make sure XESh is built in %s.' % build_dir)
+
+  script = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                        'xesh_ipc_benchmark.js')
+  benchmarks = []
+  for server_thread in SERVER_THREADS:
+    benchmarks.append({
+        'server': server_thread,
+        'results': RunBenchmark(build_dir, script, server_thread,
+                                options.timeout),
+    })
+  report = json.dumps({'version': 1, 'benchmarks': benchmarks}, indent=2)
+
+  if options.output:
+    with open(options.output, 'w') as output:
+      output.write(report + '\n')
+  else:
+    print report
+  return 0
+
+
+if __name__ == '__main__':
+  sys.exit(main())
@@ -36,6 +36,12 @@ using xwalk::extensions::XWalkExtensionServer;
 // Specifies which file XESh will use as input.
 const char kInputFilePath[] = "input-file";
 
+// Specifies which thread runs the extension server: "ui", the default, for
+// the main thread like the in-process UI thread server of the runtime, or
+// "extension" for a dedicated thread like its extension thread server.
+const char kServerThread[] = "server-thread";
+const char kServerThreadExtension[] = "extension";
+
 namespace {
 
 inline void PrintInitialInfo() {
@@ -180,6 +186,21 @@ class ExtensionManager {
     server_.Initialize(server_channel_.get());
   }
 
+  // Must be called on the thread running the server. Signals |started|
+  // once the server accepts connections, if not NULL.
+  void Start(scoped_refptr<base::SingleThreadTaskRunner> io_task_runner,
+             base::WaitableEvent* started) {
+    LoadExtensions();
+    Initialize(io_task_runner);
+    if (started)
+      started->Signal();
+  }
+
+  // Must be called on the thread running the server.
+  void Shutdown() {
+    server_channel_.reset();
+  }
+
   const IPC::ChannelHandle& ipc_channel_handle() { return handle_; }
 
  private:
@@ -208,8 +229,20 @@ int main(int argc, char* argv[]) {
       base::MessageLoop::TYPE_DEFAULT, 0));
 
   ExtensionManager extension_manager;
-  extension_manager.LoadExtensions();
-  extension_manager.Initialize(io_thread.task_runner());
+  base::Thread extension_thread("XESh_ExtensionThread");
+  if (base::CommandLine::ForCurrentProcess()->GetSwitchValueASCII(
+          kServerThread) == kServerThreadExtension) {
+    extension_thread.Start();
+    base::WaitableEvent started(false, false);
+    extension_thread.task_runner()->PostTask(
+        FROM_HERE, base::Bind(&ExtensionManager::Start,
+                              base::Unretained(&extension_manager),
+                              io_thread.task_runner(),
+                              base::Unretained(&started)));
+    started.Wait();
+  } else {
+    extension_manager.Start(io_thread.task_runner(), NULL);
+  }
 
   XEShV8Runner v8_runner;
   static_cast<base::MessageLoopForIO*>(v8_thread.message_loop())
@@ -232,6 +265,12 @@ int main(int argc, char* argv[]) {
       FROM_HERE, base::Bind(&XEShV8Runner::Shutdown,
       base::Unretained(&v8_runner)));
 
+  if (extension_thread.IsRunning()) {
+    extension_thread.task_runner()->PostTask(
+        FROM_HERE, base::Bind(&ExtensionManager::Shutdown,
+                              base::Unretained(&extension_manager)));
+    extension_thread.Stop();
+  }
   io_thread.Stop();
   v8_thread.Stop();
   return 0;
@@ -11,6 +11,7 @@
 #include <stdlib.h>
 #include "base/logging.h"
 #include "base/strings/stringprintf.h"
+#include "base/time/time.h"
 #include "xwalk/extensions/renderer/xwalk_extension_module.h"
 #include "xwalk/extensions/renderer/xwalk_module_system.h"
 #include "xwalk/extensions/renderer/xwalk_v8tools_module.h"
@@ -155,6 +156,9 @@ void XEShV8Runner::RegisterAccessors() {
   context->Global()->Set(
       v8::String::NewFromUtf8(isolate, "print"),
       v8::FunctionTemplate::New(isolate, PrintCallback)->GetFunction());
+  context->Global()->Set(
+      v8::String::NewFromUtf8(isolate, "now"),
+      v8::FunctionTemplate::New(isolate, NowCallback)->GetFunction());
   context->Global()->SetAccessor(
       v8::String::NewFromUtf8(isolate, "quit"),
       QuitCallback);
@@ -180,6 +184,13 @@ void XEShV8Runner::PrintCallback(
   fflush(stdout);
 }
 
+// static
+void XEShV8Runner::NowCallback(
+    const v8::FunctionCallbackInfo<v8::Value>& args) {
+  args.GetReturnValue().Set(
+      (base::TimeTicks::Now() - base::TimeTicks()).InMillisecondsF());
+}
+
 // static
 void XEShV8Runner::QuitCallback(v8::Local<v8::String> property,
     const v8::PropertyCallbackInfo<v8::Value>& info) {
@@ -217,7 +228,7 @@ void XEShV8Runner::CreateExtensionModules(XWalkModuleSystem* module_system) {
     if (codepoint->api.empty())
       continue;
     std::unique_ptr<XWalkExtensionModule> module(
-        new XWalkExtensionModule(&client_, module_system, it->first,
+        new XWalkExtensionModule(&client_, module_system, NULL, it->first,
                                  codepoint->api));
     module_system->RegisterExtensionModule(std::move(module),
                                            codepoint->entry_points);
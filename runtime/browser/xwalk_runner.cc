@@ -73,9 +73,15 @@ void XWalkRunner::PreMainMessageLoopRun() {
   app_extension_bridge_.reset(new XWalkAppExtensionBridge());
 
   base::CommandLine* cmd_line = base::CommandLine::ForCurrentProcess();
-  if (!cmd_line->HasSwitch(switches::kXWalkDisableExtensions))
+  if (!cmd_line->HasSwitch(switches::kXWalkDisableExtensions)) {
     extension_service_.reset(new extensions::XWalkExtensionService(
         app_extension_bridge_.get()));
+    extension_service_->SetCodeCachePath(browser_context_->GetPath().Append(
+        FILE_PATH_LITERAL("ExtensionCodeCache")));
+    extension_service_->SetRegistrySnapshotPath(
+        browser_context_->GetPath().Append(
+            FILE_PATH_LITERAL("ExtensionRegistry")));
+  }
 
   CreateComponents();
   app_extension_bridge_->SetApplicationSystem(app_component_->app_system());
@@ -5,7 +5,9 @@
 
 // Multiply-included file, no traditional include guard.
 #include <string>
+#include <vector>
 
+#include "base/time/time.h"
 #include "content/public/common/common_param_traits.h"
 #include "ipc/ipc_channel_handle.h"
 #include "ipc/ipc_message_macros.h"
@@ -32,16 +34,27 @@ IPC_ENUM_TRAITS(xwalk::application::ApplicationSecurityPolicy::SecurityMode)
 // RenderView messages
 // These are messages sent from the browser to the renderer process.
 
-IPC_MESSAGE_CONTROL4(ViewMsg_SetAccessWhiteList,  // NOLINT
-                     GURL /* source */,
-                     GURL /* dest */,
-                     std::string /*dest_host*/,
-                     bool /* allow_subdomains */)
-
-IPC_MESSAGE_CONTROL2(ViewMsg_EnableSecurityMode,    // NOLINT
-                     GURL /* application url */,
-                     xwalk::application::ApplicationSecurityPolicy::SecurityMode
-                     /* security mode */)
+IPC_STRUCT_BEGIN(ViewMsg_AccessWhiteListEntry)
+  IPC_STRUCT_MEMBER(GURL, dest)
+  IPC_STRUCT_MEMBER(std::string, dest_host)
+  IPC_STRUCT_MEMBER(bool, allow_subdomains)
+IPC_STRUCT_END()
+
+// The whole security policy of an application, applied at once by the
+// renderer. The whitelist entries all have the application url as source.
+IPC_STRUCT_BEGIN(ViewMsg_SecurityPolicy_Params)
+  // ApplicationSecurityPolicy::kSecurityPolicyVersion.
+  IPC_STRUCT_MEMBER(int, version)
+  IPC_STRUCT_MEMBER(GURL, app_url)
+  IPC_STRUCT_MEMBER(xwalk::application::ApplicationSecurityPolicy::SecurityMode,
+                    mode)
+  IPC_STRUCT_MEMBER(std::vector<ViewMsg_AccessWhiteListEntry>, whitelist)
+  // When the browser sent the policy, for tracing.
+  IPC_STRUCT_MEMBER(base::TimeTicks, send_time)
+IPC_STRUCT_END()
+
+IPC_MESSAGE_CONTROL1(ViewMsg_SetSecurityPolicy,  // NOLINT
+                     ViewMsg_SecurityPolicy_Params)
 
 IPC_MESSAGE_ROUTED1(ViewMsg_HWKeyPressed, int /*keycode*/)  // NOLINT
 
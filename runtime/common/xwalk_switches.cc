@@ -51,6 +51,10 @@ const char kAllowRunningInsecureContent[]   = "allow-running-insecure-content";
 // page. This switch overrides this to block this lesser mixed-content problem.
 const char kNoDisplayingInsecureContent[]   = "no-displaying-insecure-content";
 
+// Serves the resources of packaged applications straight from the .wgt/.xpk
+// file instead of extracting it first.
+const char kServePackagesFromArchive[] = "serve-packages-from-archive";
+
 #if defined(ENABLE_PLUGINS)
 // Use the PPAPI (Pepper) Flash found at the given path.
 const char kPpapiFlashPath[] = "ppapi-flash-path";
@@ -23,6 +23,7 @@ extern const char kXWalkDisableSaveFormData[];
 #endif
 extern const char kAllowRunningInsecureContent[];
 extern const char kNoDisplayingInsecureContent[];
+extern const char kServePackagesFromArchive[];
 
 #if defined(OS_ANDROID)
 extern const char kXWalkProfileName[];
@@ -5,6 +5,7 @@
 
 #include "xwalk/runtime/renderer/xwalk_render_thread_observer_generic.h"
 
+#include "base/trace_event/trace_event.h"
 #include "content/public/renderer/render_thread.h"
 #include "extensions/common/url_pattern.h"
 #include "ipc/ipc_message_macros.h"
@@ -17,27 +18,6 @@
 
 
 namespace xwalk {
-struct AccessWhitelistItem {
-  AccessWhitelistItem(const GURL& source,
-                      const GURL& dest,
-                      const std::string& dest_host,
-                      bool allow_subdomains);
-  GURL source;
-  GURL dest;
-  // Have host as a separate field in order to consider CSP directives ('*');
-  std::string dest_host;
-  bool allow_subdomains;
-};
-
-AccessWhitelistItem::AccessWhitelistItem(
-    const GURL& source, const GURL& dest,
-    const std::string& dest_host, bool allow_subdomains)
-    : source(source),
-      dest(dest),
-      dest_host(dest_host),
-      allow_subdomains(allow_subdomains) {
-}
-
 
 void XWalkRenderThreadObserver::AddAccessWhiteListEntry(
     const GURL& source,
@@ -53,7 +33,8 @@ void XWalkRenderThreadObserver::AddAccessWhiteListEntry(
 
 XWalkRenderThreadObserver::XWalkRenderThreadObserver()
     : is_blink_initialized_(false),
-      security_mode_(application::ApplicationSecurityPolicy::NoSecurity) {
+      security_mode_(application::ApplicationSecurityPolicy::NoSecurity),
+      access_whitelist_(new application::AccessWhitelistMatcher) {
 }
 
 XWalkRenderThreadObserver::~XWalkRenderThreadObserver() {
@@ -63,8 +44,7 @@ bool XWalkRenderThreadObserver::OnControlMessageReceived(
     const IPC::Message& message) {
   bool handled = true;
   IPC_BEGIN_MESSAGE_MAP(XWalkRenderThreadObserver, message)
-    IPC_MESSAGE_HANDLER(ViewMsg_SetAccessWhiteList, OnSetAccessWhiteList)
-    IPC_MESSAGE_HANDLER(ViewMsg_EnableSecurityMode, OnEnableSecurityMode)
+    IPC_MESSAGE_HANDLER(ViewMsg_SetSecurityPolicy, OnSetSecurityPolicy)
     IPC_MESSAGE_UNHANDLED(handled = false)
   IPC_END_MESSAGE_MAP()
   return handled;
@@ -74,22 +54,36 @@ void XWalkRenderThreadObserver::OnRenderProcessShutdown() {
   is_blink_initialized_ = false;
 }
 
-void XWalkRenderThreadObserver::OnSetAccessWhiteList(
-    const GURL& source, const GURL& dest,
-    const std::string& dest_host, bool allow_subdomains) {
-  base::AutoLock lock(lock_);
-  if (is_blink_initialized_)
-    AddAccessWhiteListEntry(source, dest, dest_host, allow_subdomains);
+void XWalkRenderThreadObserver::OnSetSecurityPolicy(
+    const ViewMsg_SecurityPolicy_Params& params) {
+  TRACE_EVENT2("xwalk", "XWalkRenderThreadObserver::OnSetSecurityPolicy",
+               "entries", params.whitelist.size(),
+               "delivery_ms",
+               (base::TimeTicks::Now() - params.send_time).InMillisecondsF());
+  if (params.version !=
+      application::ApplicationSecurityPolicy::kSecurityPolicyVersion) {
+    LOG(ERROR) << "Ignoring a security policy of version " << params.version;
+    return;
+  }
 
-  access_whitelist_.push_back(
-      new AccessWhitelistItem(source, dest, dest_host, allow_subdomains));
-}
+  // Built before taking the lock, requests see either policy but never
+  // a partial one.
+  std::unique_ptr<application::AccessWhitelistMatcher> access_whitelist(
+      new application::AccessWhitelistMatcher);
+  for (const ViewMsg_AccessWhiteListEntry& entry : params.whitelist) {
+    if (is_blink_initialized_) {
+      AddAccessWhiteListEntry(params.app_url, entry.dest, entry.dest_host,
+                              entry.allow_subdomains);
+    }
+    // Ports always need to match, unlike in the browser.
+    access_whitelist->AddEntry(params.app_url, entry.dest,
+                               entry.allow_subdomains, true);
+  }
 
-void XWalkRenderThreadObserver::OnEnableSecurityMode(
-    const GURL& url,
-    application::ApplicationSecurityPolicy::SecurityMode mode) {
-  app_url_ = url;
-  security_mode_ = mode;
+  base::AutoLock lock(lock_);
+  access_whitelist_.swap(access_whitelist);
+  app_url_ = params.app_url;
+  security_mode_ = params.mode;
 }
 
 bool XWalkRenderThreadObserver::CanRequest(const GURL& orig,
@@ -97,26 +91,8 @@ bool XWalkRenderThreadObserver::CanRequest(const GURL& orig,
   if (!blink::WebSecurityOrigin::create(orig.GetOrigin()).canRequest(dest))
     return false;
 
-  // Need to check the port.
   base::AutoLock lock(lock_);
-  for (const auto& whitelist_entry : access_whitelist_) {
-    if (whitelist_entry->source.GetOrigin() != orig.GetOrigin())
-      continue;
-    const GURL& dest_url = whitelist_entry->dest;
-    if (!whitelist_entry->allow_subdomains &&
-        whitelist_entry->dest.GetOrigin() == dest.GetOrigin() &&
-        base::StartsWith(dest.path(), dest_url.path(),
-                         base::CompareCase::INSENSITIVE_ASCII))
-      return true;
-    if (whitelist_entry->allow_subdomains &&
-        dest.scheme() == dest_url.scheme() &&
-        dest.DomainIs(dest_url.host().c_str()) &&
-        dest.port() == dest_url.port() &&
-        base::StartsWith(dest.path(), dest_url.path(),
-                         base::CompareCase::INSENSITIVE_ASCII))
-      return true;
-  }
-  return false;
+  return access_whitelist_->Matches(orig, dest);
 }
 
 }  // namespace xwalk
@@ -6,22 +6,24 @@
 #ifndef XWALK_RUNTIME_RENDERER_XWALK_RENDER_THREAD_OBSERVER_GENERIC_H_
 #define XWALK_RUNTIME_RENDERER_XWALK_RENDER_THREAD_OBSERVER_GENERIC_H_
 
+#include <memory>
 #include <string>
 
 #include "base/compiler_specific.h"
-#include "base/memory/scoped_vector.h"
 #include "base/synchronization/lock.h"
 #include "content/public/renderer/render_thread_observer.h"
 #include "url/gurl.h"
 #include "v8/include/v8.h"
 #include "xwalk/application/browser/application_security_policy.h"
+#include "xwalk/application/common/access_whitelist_matcher.h"
+
+struct ViewMsg_SecurityPolicy_Params;
 
 namespace blink {
 class WebFrame;
 }  // namespace blink
 
 namespace xwalk {
-struct AccessWhitelistItem;
 
 // FIXME: Using filename "xwalk_render_thread_observer_generic.cc(h)" temporary
 // , due to the conflict filename with Android port.
@@ -47,14 +49,7 @@ class XWalkRenderThreadObserver : public content::RenderThreadObserver {
   bool CanRequest(const GURL& orig, const GURL& dest) const;
 
  private:
-  void OnSetAccessWhiteList(
-      const GURL& source,
-      const GURL& dest,
-      const std::string& dest_host,
-      bool allow_subdomains);
-  void OnEnableSecurityMode(
-      const GURL& url,
-      application::ApplicationSecurityPolicy::SecurityMode mode);
+  void OnSetSecurityPolicy(const ViewMsg_SecurityPolicy_Params& params);
   void AddAccessWhiteListEntry(const GURL& source,
                                const GURL& dest,
                                const std::string& dest_host,
@@ -63,7 +58,8 @@ class XWalkRenderThreadObserver : public content::RenderThreadObserver {
   bool is_blink_initialized_;
   application::ApplicationSecurityPolicy::SecurityMode security_mode_;
   GURL app_url_;
-  ScopedVector<AccessWhitelistItem> access_whitelist_;
+  // Replaced as a whole when a new policy arrives.
+  std::unique_ptr<application::AccessWhitelistMatcher> access_whitelist_;
   mutable base::Lock lock_;
 };
 }  // namespace xwalk
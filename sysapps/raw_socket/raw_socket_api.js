@@ -37,6 +37,52 @@ var ReadyStateObserver = function(object_id, initial_state) {
 
 ReadyStateObserver.prototype = new common.EventTargetPrototype();
 
+// The SentBytesObserver is a proxy object, like the ReadyStateObserver,
+// that keeps track of how many bytes the native side sent so far.
+//
+var SentBytesObserver = function(object_id) {
+  common.BindingObject.call(this, object_id);
+  common.EventTarget.call(this);
+
+  this._addEvent("sent");
+  this.sentBytes = 0;
+
+  var that = this;
+  this.onsent = function(event) {
+    that.sentBytes = event.data;
+  };
+
+  this.destructor = function() {
+    this.onsent = null;
+  };
+};
+
+SentBytesObserver.prototype = new common.EventTargetPrototype();
+
+// send() returns false once this many bytes are waiting to be sent, and a
+// "drain" event is fired when they are.
+var kSendHighWaterMark = 64 * 1024;
+
+// Returns the size of |string| encoded in UTF-8, which is how it is sent.
+function getUTF8Length(string) {
+  var length = 0;
+  for (var i = 0; i < string.length; ++i) {
+    var code = string.charCodeAt(i);
+    if (code < 0x80) {
+      length += 1;
+    } else if (code < 0x800) {
+      length += 2;
+    } else if (code >= 0xd800 && code < 0xdc00 && i + 1 < string.length) {
+      // A surrogate pair.
+      length += 4;
+      ++i;
+    } else {
+      length += 3;
+    }
+  }
+  return length;
+}
+
 // TCPSocket interface.
 //
 // TODO(tmpsantos): We are currently not throwing any exceptions
@@ -69,6 +115,7 @@ var TCPSocket = function(remoteAddress, remotePort, options, object_id) {
   this._addMethod("suspend");
   this._addMethod("resume");
   this._addMethod("_sendString");
+  this._addMethod("_sendArrayBuffer");
 
   this._addEvent("drain");
   this._addEvent("open");
@@ -76,15 +123,23 @@ var TCPSocket = function(remoteAddress, remotePort, options, object_id) {
   this._addEvent("error");
   this._addEvent("data");
 
-  function sendWrapper(data) {
-    this._sendString(data);
+  // Bytes passed to send() so far. The native side reports the bytes it
+  // sent, the difference is the bufferedAmount.
+  var queuedBytes = 0;
 
-    // FIXME(tmpsantos): The spec says that send() should always
-    // return if you can keep sending data. This can only be
-    // verified in the native implementation, which makes this
-    // call sync. We are returning always true here to keep the
-    // implementation async.
-    return true;
+  function sendWrapper(data) {
+    if (data instanceof ArrayBuffer || ArrayBuffer.isView(data)) {
+      queuedBytes += data.byteLength;
+      this._sendArrayBuffer(data);
+    } else {
+      data = String(data);
+      queuedBytes += getUTF8Length(data);
+      this._sendString(data);
+    }
+
+    // The bufferedAmount only goes down asynchronously, so a caller
+    // waiting for "drain" after a false return always gets it.
+    return this.bufferedAmount < kSendHighWaterMark;
   };
 
   function closeWrapper(data) {
@@ -111,6 +166,12 @@ var TCPSocket = function(remoteAddress, remotePort, options, object_id) {
     "_readyStateObserverDeleter": {
       value: v8tools.lifecycleTracker(),
     },
+    "_sentBytesObserver": {
+      value: new SentBytesObserver(this._id),
+    },
+    "_sentBytesObserverDeleter": {
+      value: v8tools.lifecycleTracker(),
+    },
     "send": {
       value: sendWrapper,
       enumerable: true,
@@ -148,7 +209,9 @@ var TCPSocket = function(remoteAddress, remotePort, options, object_id) {
       enumerable: true,
     },
     "bufferedAmount": {
-      value: 0,
+      get: function() {
+        return queuedBytes - this._sentBytesObserver.sentBytes;
+      },
       enumerable: true,
     },
     "readyState": {
@@ -162,6 +225,11 @@ var TCPSocket = function(remoteAddress, remotePort, options, object_id) {
     watcher.destructor();
   };
 
+  var sentBytesWatcher = this._sentBytesObserver;
+  this._sentBytesObserverDeleter.destructor = function() {
+    sentBytesWatcher.destructor();
+  };
+
   // This is needed, otherwise events like "error" can get fired before
   // we give the user a chance to register a listener.
   function delayedInitialization(obj) {
@@ -315,6 +383,21 @@ var UDPSocket = function(options) {
   this._addEvent("error");
   this._addEvent("message", MessageEvent);
 
+  // The native side sends every datagram received at once in a single
+  // "message" event, which is split here into one event per datagram.
+  var dispatchEventFromExtension =
+      Object.getPrototypeOf(this)._dispatchEventFromExtension;
+
+  function dispatchMessages(type, data) {
+    if (type != "message") {
+      dispatchEventFromExtension.call(this, type, data);
+      return;
+    }
+
+    for (var i = 0; i < data.length; ++i)
+      dispatchEventFromExtension.call(this, type, data[i]);
+  };
+
   function sendWrapper(data, remoteAddress, remotePort) {
     this._sendString(data, remoteAddress, remotePort);
 
@@ -341,6 +424,9 @@ var UDPSocket = function(options) {
     "_readyStateObserverDeleter": {
       value: v8tools.lifecycleTracker(),
     },
+    "_dispatchEventFromExtension": {
+      value: dispatchMessages,
+    },
     "send": {
       value: sendWrapper,
       enumerable: true,
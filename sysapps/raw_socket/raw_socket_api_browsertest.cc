@@ -4,9 +4,11 @@
 
 #include "base/path_service.h"
 #include "base/strings/utf_string_conversions.h"
+#include "base/values.h"
 #include "content/public/test/browser_test_utils.h"
 #include "content/public/test/test_utils.h"
 #include "net/base/filename_util.h"
+#include "testing/perf/perf_test.h"
 #include "xwalk/extensions/browser/xwalk_extension_service.h"
 #include "xwalk/extensions/common/xwalk_extension.h"
 #include "xwalk/runtime/browser/runtime.h"
@@ -73,3 +75,24 @@ IN_PROC_BROWSER_TEST_F(SysAppsRawSocketTest, SysAppsRawSocket) {
   xwalk_test_utils::NavigateToURL(runtime, net::FilePathToFileURL(test_file));
   EXPECT_EQ(passString, title_watcher.WaitAndGetTitle());
 }
+
+IN_PROC_BROWSER_TEST_F(SysAppsRawSocketTest, UDPReceiveThroughput) {
+  base::FilePath test_file;
+  PathService::Get(base::DIR_SOURCE_ROOT, &test_file);
+  test_file = test_file
+      .Append(FILE_PATH_LITERAL("xwalk"))
+      .Append(FILE_PATH_LITERAL("sysapps"))
+      .Append(FILE_PATH_LITERAL("raw_socket"))
+      .Append(FILE_PATH_LITERAL("raw_socket_udp_benchmark.html"));
+
+  std::unique_ptr<base::DictionaryValue> results;
+  ASSERT_TRUE(xwalk_test_utils::RunPerfPage(
+      CreateRuntime(), net::FilePathToFileURL(test_file), &results));
+
+  double datagrams_per_second = 0;
+  ASSERT_TRUE(results->GetDouble("datagrams_per_second",
+                                 &datagrams_per_second));
+  EXPECT_GT(datagrams_per_second, 0);
+  perf_test::PrintResult("raw_socket_udp_receive", "", "loopback",
+                         datagrams_per_second, "datagrams/s", true);
+}
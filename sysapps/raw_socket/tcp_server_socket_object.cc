@@ -6,7 +6,10 @@
 
 #include <string.h>
 #include "base/guid.h"
+#include "base/location.h"
 #include "base/logging.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "base/time/time.h"
 #include "net/base/ip_endpoint.h"
 #include "net/base/net_errors.h"
 #include "net/socket/stream_socket.h"
@@ -18,13 +21,28 @@
 using namespace xwalk::jsapi::tcp_server_socket; // NOLINT
 using namespace xwalk::jsapi::raw_socket; // NOLINT
 
+namespace {
+
+const int kDefaultBacklog = 128;
+const int kDefaultMaxConnections = 1024;
+
+// Accept() failing right away, like when running out of file descriptors,
+// would fail again if retried immediately.
+const int kAcceptRetryDelayMs = 100;
+
+}  // namespace
+
 namespace xwalk {
 namespace sysapps {
 
 TCPServerSocketObject::TCPServerSocketObject(RawSocketInstance* instance)
   : is_suspended_(false),
     is_accepting_(false),
-    instance_(instance) {
+    has_accept_pending_(false),
+    max_connections_(kDefaultMaxConnections),
+    connection_count_(0),
+    instance_(instance),
+    weak_factory_(this) {
   handler_.Register("init",
       base::Bind(&TCPServerSocketObject::OnInit, base::Unretained(this)));
   handler_.Register("_close",
@@ -38,9 +56,92 @@ TCPServerSocketObject::TCPServerSocketObject(RawSocketInstance* instance)
 TCPServerSocketObject::~TCPServerSocketObject() {}
 
 void TCPServerSocketObject::DoAccept() {
-  socket_->Accept(&accepted_socket_,
-                  base::Bind(&TCPServerSocketObject::OnAccept,
-                             base::Unretained(this)));
+  while (socket_ && !has_accept_pending_ && !is_suspended_) {
+    int ret = socket_->Accept(&accepted_socket_,
+                              base::Bind(&TCPServerSocketObject::OnAccept,
+                                         base::Unretained(this)));
+
+    if (ret == net::ERR_IO_PENDING) {
+      has_accept_pending_ = true;
+      return;
+    }
+
+    if (!HandleAccept(ret)) {
+      RetryAcceptLater();
+      return;
+    }
+  }
+}
+
+void TCPServerSocketObject::RetryAcceptLater() {
+  base::ThreadTaskRunnerHandle::Get()->PostDelayedTask(
+      FROM_HERE,
+      base::Bind(&TCPServerSocketObject::DoAccept,
+                 weak_factory_.GetWeakPtr()),
+      base::TimeDelta::FromMilliseconds(kAcceptRetryDelayMs));
+}
+
+bool TCPServerSocketObject::HandleAccept(int status) {
+  if (status != net::OK) {
+    LOG(WARNING) << "Failed to accept a connection: "
+                 << net::ErrorToString(status);
+    DispatchConnectError(SOCKET_ERROR_TYPE_TCP_SERVER_CONNECTION_NOT_ACCEPTED);
+    return false;
+  }
+
+  std::unique_ptr<net::StreamSocket> accepted_socket(
+      std::move(accepted_socket_));
+
+  // The spec is not really clear about what to do when we get a incoming
+  // connection but nobody is listening. We are just closing the socket in
+  // this case.
+  if (!is_accepting_)
+    return true;
+
+  if (connection_count_ >= max_connections_) {
+    DispatchConnectError(SOCKET_ERROR_TYPE_TCP_SERVER_MAX_CONNECTIONS);
+    return true;
+  }
+
+  net::IPEndPoint local_address;
+  accepted_socket->GetLocalAddress(&local_address);
+
+  jsapi::tcp_socket::TCPOptions options;
+  options.local_address = local_address.ToStringWithoutPort();
+  options.local_port = local_address.port();
+  options.address_reuse = false;
+  options.no_delay = true;
+  options.use_secure_transport = false;
+
+  std::string object_id = base::GenerateGUID();
+  std::unique_ptr<TCPSocketObject> obj(
+      new TCPSocketObject(std::move(accepted_socket)));
+  obj->set_close_callback(
+      base::Bind(&TCPServerSocketObject::OnConnectionClosed,
+                 weak_factory_.GetWeakPtr()));
+  instance_->AddBindingObject(object_id, std::move(obj));
+  ++connection_count_;
+
+  std::unique_ptr<base::ListValue> dataList(new base::ListValue);
+  dataList->AppendString(object_id);
+  dataList->Append(options.ToValue().release());
+
+  std::unique_ptr<base::ListValue> eventData(new base::ListValue);
+  eventData->Append(dataList.release());
+
+  DispatchEvent("connect", std::move(eventData));
+  return true;
+}
+
+void TCPServerSocketObject::DispatchConnectError(SocketErrorType error) {
+  std::unique_ptr<base::ListValue> eventData(new base::ListValue);
+  eventData->AppendString(ToString(error));
+  DispatchEvent("connecterror", std::move(eventData));
+}
+
+void TCPServerSocketObject::OnConnectionClosed() {
+  DCHECK_GT(connection_count_, 0);
+  --connection_count_;
 }
 
 void TCPServerSocketObject::StartEvent(const std::string& type) {
@@ -72,10 +173,16 @@ void TCPServerSocketObject::OnInit(
     return;
   }
 
+  int backlog = kDefaultBacklog;
+  if (params->options.backlog && *params->options.backlog > 0)
+    backlog = *params->options.backlog;
+  if (params->options.max_connections && *params->options.max_connections > 0)
+    max_connections_ = *params->options.max_connections;
+
   socket_.reset(new net::TCPServerSocket(NULL, net::NetLog::Source()));
   net::IPEndPoint address(ip_number, params->options.local_port);
 
-  if (socket_->Listen(address, 5) != net::OK) {
+  if (socket_->Listen(address, backlog) != net::OK) {
     LOG(WARNING) << "Failed to listen on " << params->options.local_address
         << " port " << params->options.local_port;
     setReadyState(READY_STATE_CLOSED);
@@ -93,6 +200,10 @@ void TCPServerSocketObject::OnClose(
   if (socket_)
     socket_.reset();
 
+  // Closing the listening socket cancels the pending accept. Connections
+  // already accepted stay open.
+  has_accept_pending_ = false;
+
   setReadyState(READY_STATE_CLOSED);
   DispatchEvent("close");
 }
@@ -104,39 +215,18 @@ void TCPServerSocketObject::OnSuspend(
 
 void TCPServerSocketObject::OnResume(
     std::unique_ptr<XWalkExtensionFunctionInfo> info) {
+  if (!is_suspended_)
+    return;
+
   is_suspended_ = false;
+  DoAccept();
 }
 
 void TCPServerSocketObject::OnAccept(int status) {
-  if (is_accepting_ && !is_suspended_) {
-    net::IPEndPoint local_address;
-    accepted_socket_->GetLocalAddress(&local_address);
-
-    jsapi::tcp_socket::TCPOptions options;
-    options.local_address = local_address.ToStringWithoutPort();
-    options.local_port = local_address.port();
-    options.address_reuse = false;
-    options.no_delay = true;
-    options.use_secure_transport = false;
-
-    std::string object_id = base::GenerateGUID();
-    std::unique_ptr<BindingObject> obj(new TCPSocketObject(
-                            std::move(accepted_socket_)));
-    instance_->AddBindingObject(object_id, std::move(obj));
-
-    std::unique_ptr<base::ListValue> dataList(new base::ListValue);
-    dataList->AppendString(object_id);
-    dataList->Append(options.ToValue().release());
-
-    std::unique_ptr<base::ListValue> eventData(new base::ListValue);
-    eventData->Append(dataList.release());
-
-    DispatchEvent("connect", std::move(eventData));
-  } else {
-    // The spec is not really clear about what to do when we get a incoming
-    // connection but nobody is listening. We are just closing the socket in
-    // this case.
-    accepted_socket_.reset();
+  has_accept_pending_ = false;
+  if (!HandleAccept(status)) {
+    RetryAcceptLater();
+    return;
   }
 
   DoAccept();
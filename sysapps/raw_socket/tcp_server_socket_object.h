@@ -6,6 +6,7 @@
 #define XWALK_SYSAPPS_RAW_SOCKET_TCP_SERVER_SOCKET_OBJECT_H_
 
 #include <string>
+#include "base/memory/weak_ptr.h"
 #include "net/socket/tcp_server_socket.h"
 #include "xwalk/sysapps/common/event_target.h"
 #include "xwalk/sysapps/raw_socket/raw_socket_extension.h"
@@ -16,6 +17,10 @@ namespace sysapps {
 
 class BindingObjectStore;
 
+// Accepts every pending connection each time the listening socket is ready,
+// and stops accepting while suspended, which leaves new connections in the
+// listen backlog. The number of connections accepted and not closed yet is
+// limited by the maxConnections option.
 class TCPServerSocketObject : public RawSocketObject {
  public:
   explicit TCPServerSocketObject(RawSocketInstance* instance);
@@ -23,6 +28,11 @@ class TCPServerSocketObject : public RawSocketObject {
 
  private:
   void DoAccept();
+  // Returns false if accepting should be retried later.
+  bool HandleAccept(int status);
+  void RetryAcceptLater();
+  void DispatchConnectError(jsapi::raw_socket::SocketErrorType error);
+  void OnConnectionClosed();
 
   // EventTarget implementation.
   void StartEvent(const std::string& type) override;
@@ -39,11 +49,17 @@ class TCPServerSocketObject : public RawSocketObject {
 
   bool is_suspended_;
   bool is_accepting_;
+  bool has_accept_pending_;
+
+  int max_connections_;
+  int connection_count_;
 
   std::unique_ptr<net::TCPServerSocket> socket_;
   std::unique_ptr<net::StreamSocket> accepted_socket_;
 
   RawSocketInstance* instance_;
+
+  base::WeakPtrFactory<TCPServerSocketObject> weak_factory_;
 };
 
 }  // namespace sysapps
@@ -5,8 +5,13 @@
 #include "xwalk/sysapps/raw_socket/tcp_socket_object.h"
 
 #include <string.h>
+
+#include <algorithm>
+
+#include "base/location.h"
 #include "base/logging.h"
 #include "base/numerics/safe_conversions.h"
+#include "base/threading/thread_task_runner_handle.h"
 #include "net/base/net_errors.h"
 #include "xwalk/sysapps/raw_socket/tcp_socket.h"
 
@@ -15,7 +20,14 @@ using namespace xwalk::jsapi::raw_socket; // NOLINT
 
 namespace {
 
-const size_t kBufferSize = 4096;
+const int kMinReadBufferSize = 4096;
+const int kDefaultMaxReadBufferSize = 64 * 1024;
+const int kMaxReadBufferSize = 1024 * 1024;
+
+// Reading yields the thread after this many reads or bytes, so that a fast
+// peer doesn't hold up the other sockets and extension messages.
+const int kMaxReadsPerTask = 16;
+const int kMaxBytesReadPerTask = 1024 * 1024;
 
 }  // namespace
 
@@ -23,27 +35,42 @@ namespace xwalk {
 namespace sysapps {
 
 TCPSocketObject::TCPSocketObject()
-    : has_write_pending_(false),
+    : has_read_pending_(false),
+      has_write_pending_(false),
       is_suspended_(false),
       is_half_closed_(false),
-      read_buffer_(new net::IOBuffer(kBufferSize)),
-      write_buffer_(new net::IOBuffer(kBufferSize)),
+      is_waiting_for_data_listener_(false),
+      read_buffer_size_(kMinReadBufferSize),
+      max_read_buffer_size_(kDefaultMaxReadBufferSize),
+      sent_bytes_(0),
+      reported_sent_bytes_(0),
       resolver_(net::HostResolver::CreateDefaultResolver(NULL)),
-      single_resolver_(new net::SingleRequestHostResolver(resolver_.get())) {
+      single_resolver_(new net::SingleRequestHostResolver(resolver_.get())),
+      weak_factory_(this) {
+  AllocateReadBuffer();
   RegisterHandlers();
 }
 
 TCPSocketObject::TCPSocketObject(std::unique_ptr<net::StreamSocket> socket)
-    : has_write_pending_(false),
+    : has_read_pending_(false),
+      has_write_pending_(false),
       is_suspended_(false),
       is_half_closed_(false),
-      read_buffer_(new net::IOBuffer(kBufferSize)),
-      write_buffer_(new net::IOBuffer(kBufferSize)),
-      socket_(socket.release()) {
+      is_waiting_for_data_listener_(true),
+      read_buffer_size_(kMinReadBufferSize),
+      max_read_buffer_size_(kDefaultMaxReadBufferSize),
+      sent_bytes_(0),
+      reported_sent_bytes_(0),
+      socket_(socket.release()),
+      weak_factory_(this) {
+  AllocateReadBuffer();
   RegisterHandlers();
 }
 
-TCPSocketObject::~TCPSocketObject() {}
+TCPSocketObject::~TCPSocketObject() {
+  if (!close_callback_.is_null())
+    close_callback_.Run();
+}
 
 void TCPSocketObject::RegisterHandlers() {
   handler_.Register("init",
@@ -58,31 +85,232 @@ void TCPSocketObject::RegisterHandlers() {
       base::Bind(&TCPSocketObject::OnResume, base::Unretained(this)));
   handler_.Register("_sendString",
       base::Bind(&TCPSocketObject::OnSendString, base::Unretained(this)));
+  handler_.Register("_sendArrayBuffer",
+      base::Bind(&TCPSocketObject::OnSendArrayBuffer, base::Unretained(this)));
+}
+
+void TCPSocketObject::AllocateReadBuffer() {
+  read_data_.reset(new char[read_buffer_size_]);
+  read_buffer_ = new net::WrappedIOBuffer(read_data_.get());
+}
+
+bool TCPSocketObject::IsReadingPaused() const {
+  return is_suspended_ || is_waiting_for_data_listener_;
 }
 
 void TCPSocketObject::DoRead() {
-  if (!socket_->IsConnected())
+  int reads = 0;
+  int bytes_read = 0;
+  while (!has_read_pending_ && !IsReadingPaused()) {
+    if (!socket_.get() || !socket_->IsConnected())
+      return;
+
+    if (reads == kMaxReadsPerTask || bytes_read >= kMaxBytesReadPerTask) {
+      // Counts as a pending read, so that resume() doesn't read meanwhile.
+      has_read_pending_ = true;
+      base::ThreadTaskRunnerHandle::Get()->PostTask(
+          FROM_HERE,
+          base::Bind(&TCPSocketObject::ContinueReading,
+                     weak_factory_.GetWeakPtr()));
+      return;
+    }
+
+    int ret = socket_->Read(read_buffer_.get(),
+                            read_buffer_size_,
+                            base::Bind(&TCPSocketObject::OnRead,
+                                       base::Unretained(this)));
+
+    if (ret == net::ERR_IO_PENDING) {
+      has_read_pending_ = true;
+      return;
+    }
+
+    ++reads;
+    if (ret > 0)
+      bytes_read += ret;
+    if (!HandleRead(ret))
+      return;
+  }
+}
+
+void TCPSocketObject::ContinueReading() {
+  has_read_pending_ = false;
+  DoRead();
+}
+
+void TCPSocketObject::ResumeReading() {
+  if (IsReadingPaused())
+    return;
+
+  if (held_data_)
+    DispatchEvent("data", std::move(held_data_));
+
+  DoRead();
+}
+
+bool TCPSocketObject::HandleRead(int status) {
+  // No data means the other side has
+  // disconnected the socket.
+  if (status == 0) {
+    DropQueuedWrites();
+    socket_->Disconnect();
+    SetClosed();
+    DispatchEvent("close");
+    return false;
+  }
+
+  if (status < 0) {
+    LOG(WARNING) << "Error reading from socket: "
+                 << net::ErrorToString(status);
+    DropQueuedWrites();
+    socket_->Disconnect();
+    SetClosed();
+    DispatchEvent("error");
+    return false;
+  }
+
+  // Small reads are copied, so that a mostly empty buffer isn't held by the
+  // event. Otherwise the buffer goes with the event and a new one is made,
+  // twice as big if this read filled it.
+  std::unique_ptr<base::BinaryValue> data;
+  if (status < read_buffer_size_ / 4) {
+    data.reset(base::BinaryValue::CreateWithCopiedBuffer(read_data_.get(),
+                                                         status));
+  } else {
+    data.reset(new base::BinaryValue(std::move(read_data_), status));
+    if (status == read_buffer_size_)
+      read_buffer_size_ = std::min(read_buffer_size_ * 2,
+                                   max_read_buffer_size_);
+    AllocateReadBuffer();
+  }
+
+  std::unique_ptr<base::ListValue> eventData(new base::ListValue);
+  eventData->Append(data.release());
+
+  // A read can complete after suspend() was called. Its data is kept until
+  // reading resumes, and no more reads are made until then.
+  if (IsReadingPaused()) {
+    DCHECK(!held_data_);
+    held_data_ = std::move(eventData);
+    return true;
+  }
+
+  DispatchEvent("data", std::move(eventData));
+  return true;
+}
+
+void TCPSocketObject::SetClosed() {
+  setReadyState(READY_STATE_CLOSED);
+
+  if (!close_callback_.is_null()) {
+    close_callback_.Run();
+    close_callback_.Reset();
+  }
+}
+
+void TCPSocketObject::QueueWrite(scoped_refptr<net::IOBuffer> buffer,
+                                 int size) {
+  if (!size)
+    return;
+
+  // Data that can't be sent still counts as sent, so bufferedAmount on the
+  // JavaScript side goes back to zero.
+  if (is_half_closed_ || !socket_.get() || !socket_->IsConnected()) {
+    sent_bytes_ += size;
+    DispatchSent();
+    return;
+  }
+
+  write_queue_.push_back(new net::DrainableIOBuffer(buffer.get(), size));
+  DoWrite();
+}
+
+void TCPSocketObject::DoWrite() {
+  while (!has_write_pending_ && !write_queue_.empty()) {
+    net::DrainableIOBuffer* buffer = write_queue_.front().get();
+    int ret = socket_->Write(buffer,
+                             buffer->BytesRemaining(),
+                             base::Bind(&TCPSocketObject::OnWrite,
+                                        base::Unretained(this)));
+
+    if (ret == net::ERR_IO_PENDING) {
+      has_write_pending_ = true;
+      break;
+    }
+
+    if (!HandleWrite(ret))
+      return;
+  }
+
+  DispatchSent();
+}
+
+bool TCPSocketObject::HandleWrite(int status) {
+  if (status < 0) {
+    LOG(WARNING) << "Error writing to socket: " << net::ErrorToString(status);
+    DropQueuedWrites();
+    socket_->Disconnect();
+    SetClosed();
+    DispatchEvent("error");
+    return false;
+  }
+
+  sent_bytes_ += status;
+  net::DrainableIOBuffer* buffer = write_queue_.front().get();
+  buffer->DidConsume(status);
+  if (!buffer->BytesRemaining())
+    write_queue_.pop_front();
+
+  if (write_queue_.empty()) {
+    DispatchSent();
+    DispatchEvent("drain");
+  }
+
+  return true;
+}
+
+void TCPSocketObject::DropQueuedWrites() {
+  for (const auto& buffer : write_queue_)
+    sent_bytes_ += buffer->BytesRemaining();
+  write_queue_.clear();
+  has_write_pending_ = false;
+  DispatchSent();
+}
+
+void TCPSocketObject::DispatchSent() {
+  if (sent_bytes_ == reported_sent_bytes_)
     return;
 
-  int ret = socket_->Read(read_buffer_.get(),
-                          kBufferSize,
-                          base::Bind(&TCPSocketObject::OnRead,
-                                     base::Unretained(this)));
+  reported_sent_bytes_ = sent_bytes_;
+
+  std::unique_ptr<base::ListValue> eventData(new base::ListValue);
+  eventData->AppendDouble(sent_bytes_);
+  DispatchEvent("sent", std::move(eventData));
+}
+
+void TCPSocketObject::StartEvent(const std::string& type) {
+  if (type != "data" || !is_waiting_for_data_listener_)
+    return;
 
-  if (ret > 0)
-    OnRead(ret);
+  is_waiting_for_data_listener_ = false;
+  ResumeReading();
 }
 
 void TCPSocketObject::OnInit(std::unique_ptr<XWalkExtensionFunctionInfo> info) {
+  std::unique_ptr<Init::Params> params(Init::Params::Create(*info->arguments()));
+  if (params && params->options && params->options->receive_buffer_size) {
+    max_read_buffer_size_ = std::max(kMinReadBufferSize,
+        std::min(*params->options->receive_buffer_size, kMaxReadBufferSize));
+  }
+
   if (socket_.get()) {
     DoRead();
     return;
   }
 
-  std::unique_ptr<Init::Params> params(Init::Params::Create(*info->arguments()));
   if (!params) {
     LOG(WARNING) << "Malformed parameters passed to " << info->name();
-    setReadyState(READY_STATE_CLOSED);
+    SetClosed();
     DispatchEvent("error");
     return;
   }
@@ -104,7 +332,11 @@ void TCPSocketObject::OnClose(std::unique_ptr<XWalkExtensionFunctionInfo> info)
   if (socket_.get())
     socket_->Disconnect();
 
-  setReadyState(READY_STATE_CLOSED);
+  // Disconnecting cancels the pending read and write.
+  has_read_pending_ = false;
+  DropQueuedWrites();
+
+  SetClosed();
   DispatchEvent("close");
 }
 
@@ -121,17 +353,15 @@ void TCPSocketObject::OnSuspend(std::unique_ptr<XWalkExtensionFunctionInfo> info
 }
 
 void TCPSocketObject::OnResume(std::unique_ptr<XWalkExtensionFunctionInfo> info) {
+  if (!is_suspended_)
+    return;
+
   is_suspended_ = false;
+  ResumeReading();
 }
 
 void TCPSocketObject::OnSendString(
     std::unique_ptr<XWalkExtensionFunctionInfo> info) {
-  if (is_half_closed_ || has_write_pending_)
-    return;
-
-  if (!socket_.get() || !socket_->IsConnected())
-    return;
-
   std::unique_ptr<SendDOMString::Params>
       params(SendDOMString::Params::Create(*info->arguments()));
 
@@ -140,24 +370,23 @@ void TCPSocketObject::OnSendString(
     return;
   }
 
-  if (params->data.size() > kBufferSize) {
-    LOG(WARNING) << "Write data bigger than the write buffer.";
+  int size = base::checked_cast<int>(params->data.size());
+  QueueWrite(new net::StringIOBuffer(params->data), size);
+}
+
+void TCPSocketObject::OnSendArrayBuffer(
+    std::unique_ptr<XWalkExtensionFunctionInfo> info) {
+  // ArrayBuffers and ArrayBufferViews both arrive as binary values.
+  const base::BinaryValue* data = NULL;
+  if (!info->arguments()->GetBinary(0, &data)) {
+    LOG(WARNING) << "Malformed parameters passed to " << info->name();
     return;
   }
 
-  memcpy(write_buffer_->data(), params->data.data(), params->data.size());
-
-  int ret = socket_->Write(write_buffer_.get(),
-                           base::checked_cast<int>(params->data.size()),
-                           base::Bind(&TCPSocketObject::OnWrite,
-                                      base::Unretained(this)));
-
-  if (ret == net::ERR_IO_PENDING)
-    has_write_pending_ = true;
-  else if (ret == static_cast<int>(params->data.size()))
-    return;
-  else
-    socket_->Disconnect();
+  int size = base::checked_cast<int>(data->GetSize());
+  scoped_refptr<net::IOBuffer> buffer(new net::IOBuffer(size));
+  memcpy(buffer->data(), data->GetBuffer(), size);
+  QueueWrite(buffer, size);
 }
 
 void TCPSocketObject::OnConnect(int status) {
@@ -170,41 +399,26 @@ void TCPSocketObject::OnConnect(int status) {
     DispatchEvent("open");
     DoRead();
   } else {
-    setReadyState(READY_STATE_CLOSED);
+    SetClosed();
     DispatchEvent("error");
   }
 }
 
 void TCPSocketObject::OnRead(int status) {
-  std::unique_ptr<base::ListValue> eventData(new base::ListValue);
-
-  // No data means the other side has
-  // disconnected the socket.
-  if (status == 0) {
-    setReadyState(READY_STATE_CLOSED);
-    DispatchEvent("close", std::move(eventData));
-    return;
-  }
-
-  std::unique_ptr<base::Value> data(base::BinaryValue::CreateWithCopiedBuffer(
-      static_cast<char*>(read_buffer_->data()), status));
-
-  eventData->Append(data.release());
-
-  if (!is_suspended_)
-    DispatchEvent("data", std::move(eventData));
-
-  DoRead();
+  has_read_pending_ = false;
+  if (HandleRead(status))
+    DoRead();
 }
 
 void TCPSocketObject::OnWrite(int status) {
   has_write_pending_ = false;
-  DispatchEvent("drain");
+  if (HandleWrite(status))
+    DoWrite();
 }
 
 void TCPSocketObject::OnResolved(int status) {
   if (status != net::OK) {
-    setReadyState(READY_STATE_CLOSED);
+    SetClosed();
     DispatchEvent("error");
     return;
   }
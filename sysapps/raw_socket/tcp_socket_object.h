@@ -5,7 +5,12 @@
 #ifndef XWALK_SYSAPPS_RAW_SOCKET_TCP_SOCKET_OBJECT_H_
 #define XWALK_SYSAPPS_RAW_SOCKET_TCP_SOCKET_OBJECT_H_
 
+#include <deque>
+#include <memory>
 #include <string>
+
+#include "base/callback.h"
+#include "base/memory/weak_ptr.h"
 #include "net/dns/single_request_host_resolver.h"
 #include "net/base/io_buffer.h"
 #include "net/socket/tcp_client_socket.h"
@@ -14,15 +19,49 @@
 namespace xwalk {
 namespace sysapps {
 
+// Data is read in chunks that start small and double each time a read fills
+// the buffer, up to the receiveBufferSize option. Reading stops while the
+// socket is suspended, so the peer is throttled by TCP flow control instead
+// of data being dropped. Sent data is queued without limit; the JavaScript
+// side keeps track of bufferedAmount with the "sent" event, which reports
+// how many bytes left the queue so far.
+//
+// A socket accepted by a TCPServerSocket doesn't read anything before its
+// JavaScript object listens to "data", so no data is lost while the
+// object is being set up.
 class TCPSocketObject : public RawSocketObject {
  public:
   TCPSocketObject();
   explicit TCPSocketObject(std::unique_ptr<net::StreamSocket> socket);
   ~TCPSocketObject() override;
 
+  // |callback| is run once, when the socket gets closed or destroyed.
+  void set_close_callback(const base::Closure& callback) {
+    close_callback_ = callback;
+  }
+
  private:
   void RegisterHandlers();
+  void AllocateReadBuffer();
+  bool IsReadingPaused() const;
+  void ResumeReading();
+  // Reads until a read is pending, or posts ContinueReading() once enough
+  // was read.
   void DoRead();
+  void ContinueReading();
+  void SetClosed();
+  // Returns false if the socket can't be read any more.
+  bool HandleRead(int status);
+
+  void QueueWrite(scoped_refptr<net::IOBuffer> buffer, int size);
+  void DoWrite();
+  // Returns false if the socket can't be written any more.
+  bool HandleWrite(int status);
+  void DropQueuedWrites();
+  void DispatchSent();
+
+  // EventTarget implementation.
+  void StartEvent(const std::string& type) override;
 
   // JavaScript function handlers.
   void OnInit(std::unique_ptr<XWalkExtensionFunctionInfo> info);
@@ -31,6 +70,7 @@ class TCPSocketObject : public RawSocketObject {
   void OnSuspend(std::unique_ptr<XWalkExtensionFunctionInfo> info);
   void OnResume(std::unique_ptr<XWalkExtensionFunctionInfo> info);
   void OnSendString(std::unique_ptr<XWalkExtensionFunctionInfo> info);
+  void OnSendArrayBuffer(std::unique_ptr<XWalkExtensionFunctionInfo> info);
 
   // net::TCPClientSocket callbacks.
   void OnConnect(int status);
@@ -40,17 +80,34 @@ class TCPSocketObject : public RawSocketObject {
   // net::SingleRequestHostResolver callbacks.
   void OnResolved(int status);
 
+  bool has_read_pending_;
   bool has_write_pending_;
   bool is_suspended_;
   bool is_half_closed_;
+  bool is_waiting_for_data_listener_;
 
+  // |read_buffer_| wraps |read_data_|, which is handed over to the "data"
+  // event when a read fills most of it, instead of being copied.
+  std::unique_ptr<char[]> read_data_;
   scoped_refptr<net::IOBuffer> read_buffer_;
-  scoped_refptr<net::IOBuffer> write_buffer_;
+  int read_buffer_size_;
+  int max_read_buffer_size_;
+  // Data read when reading got paused, dispatched once it resumes.
+  std::unique_ptr<base::ListValue> held_data_;
+
+  std::deque<scoped_refptr<net::DrainableIOBuffer>> write_queue_;
+  // Bytes written or dropped so far, and the value last reported.
+  double sent_bytes_;
+  double reported_sent_bytes_;
+
   std::unique_ptr<net::StreamSocket> socket_;
+  base::Closure close_callback_;
 
   std::unique_ptr<net::HostResolver> resolver_;
   std::unique_ptr<net::SingleRequestHostResolver> single_resolver_;
   net::AddressList addresses_;
+
+  base::WeakPtrFactory<TCPSocketObject> weak_factory_;
 };
 
 }  // namespace sysapps
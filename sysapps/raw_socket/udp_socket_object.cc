@@ -4,11 +4,12 @@
 
 #include "xwalk/sysapps/raw_socket/udp_socket_object.h"
 
-#include <algorithm>
 #include <string>
 
+#include "base/location.h"
 #include "base/logging.h"
 #include "base/numerics/safe_conversions.h"
+#include "base/threading/thread_task_runner_handle.h"
 #include "net/base/net_errors.h"
 #include "xwalk/sysapps/raw_socket/udp_socket.h"
 
@@ -19,20 +20,37 @@ namespace {
 
 const size_t kBufferSize = 4096;
 
+// Big enough for any datagram.
+const int kReadBufferSize = 64 * 1024;
+
+// Bounds how long datagrams wait to be sent to JavaScript when a lot of
+// them are ready.
+const size_t kMaxMessagesPerEvent = 256;
+
+// Reading yields the thread after this many datagrams, so that a flood
+// doesn't hold up the other sockets and extension messages.
+const int kMaxReadsPerTask = 256;
+
+const int kDefaultMulticastTTL = 1;
+
 }  // namespace
 
 namespace xwalk {
 namespace sysapps {
 
 UDPSocketObject::UDPSocketObject()
-    : has_write_pending_(false),
+    : has_read_pending_(false),
+      has_write_pending_(false),
       is_suspended_(false),
       is_reading_(false),
-      read_buffer_(new net::IOBuffer(kBufferSize)),
+      multicast_loopback_(false),
+      multicast_ttl_(kDefaultMulticastTTL),
+      read_buffer_(new net::IOBuffer(kReadBufferSize)),
       write_buffer_(new net::IOBuffer(kBufferSize)),
       write_buffer_size_(0),
       resolver_(net::HostResolver::CreateDefaultResolver(NULL)),
-      single_resolver_(new net::SingleRequestHostResolver(resolver_.get())) {
+      single_resolver_(new net::SingleRequestHostResolver(resolver_.get())),
+      weak_factory_(this) {
   handler_.Register("init",
       base::Bind(&UDPSocketObject::OnInit, base::Unretained(this)));
   handler_.Register("_close",
@@ -52,19 +70,91 @@ UDPSocketObject::UDPSocketObject()
 UDPSocketObject::~UDPSocketObject() {}
 
 void UDPSocketObject::DoRead() {
-  if (!socket_->is_connected())
-    return;
+  int reads = 0;
+  while (!has_read_pending_ && !is_suspended_) {
+    if (!socket_ || !socket_->is_connected())
+      break;
+
+    is_reading_ = true;
+
+    if (reads == kMaxReadsPerTask) {
+      // Counts as a pending read, so that resume() doesn't read meanwhile.
+      has_read_pending_ = true;
+      base::ThreadTaskRunnerHandle::Get()->PostTask(
+          FROM_HERE,
+          base::Bind(&UDPSocketObject::ContinueReading,
+                     weak_factory_.GetWeakPtr()));
+      break;
+    }
+
+    int ret = socket_->RecvFrom(read_buffer_.get(),
+                                kReadBufferSize,
+                                &from_,
+                                base::Bind(&UDPSocketObject::OnRead,
+                                           base::Unretained(this)));
+
+    if (ret == net::ERR_IO_PENDING) {
+      has_read_pending_ = true;
+      break;
+    }
+
+    ++reads;
+    if (!HandleRead(ret))
+      return;
+  }
+
+  DispatchMessages();
+}
+
+void UDPSocketObject::ContinueReading() {
+  has_read_pending_ = false;
+  DoRead();
+}
+
+bool UDPSocketObject::HandleRead(int status) {
+  if (status < 0) {
+    // The datagram didn't fit the buffer and was dropped, but the next ones
+    // can still be read.
+    if (status == net::ERR_MSG_TOO_BIG)
+      return true;
 
-  is_reading_ = true;
+    LOG(WARNING) << "Error reading from socket: "
+                 << net::ErrorToString(status);
+    DispatchMessages();
+    setReadyState(READY_STATE_CLOSED);
+    DispatchEvent("error");
+    return false;
+  }
 
-  int ret = socket_->RecvFrom(read_buffer_.get(),
-                              kBufferSize,
-                              &from_,
-                              base::Bind(&UDPSocketObject::OnRead,
-                                         base::Unretained(this)));
+  // Empty datagrams are valid, they don't mean the socket was closed.
+  std::unique_ptr<base::DictionaryValue> message(new base::DictionaryValue);
+  message->Set("data", base::BinaryValue::CreateWithCopiedBuffer(
+      read_buffer_->data(), status));
+  message->SetString("remoteAddress", from_.ToStringWithoutPort());
+  message->SetInteger("remotePort", from_.port());
 
-  if (ret > 0)
-    OnRead(ret);
+  if (!pending_messages_)
+    pending_messages_.reset(new base::ListValue);
+  pending_messages_->Append(message.release());
+
+  if (pending_messages_->GetSize() >= kMaxMessagesPerEvent)
+    DispatchMessages();
+
+  return true;
+}
+
+void UDPSocketObject::DispatchMessages() {
+  if (is_suspended_ || !pending_messages_)
+    return;
+
+  std::unique_ptr<base::ListValue> eventData(new base::ListValue);
+  eventData->Append(pending_messages_.release());
+  DispatchEvent("message", std::move(eventData));
+}
+
+bool UDPSocketObject::SetMulticastOptions() {
+  return socket_->SetMulticastLoopbackMode(multicast_loopback_) == net::OK &&
+         socket_->SetMulticastTimeToLive(multicast_ttl_) == net::OK;
 }
 
 void UDPSocketObject::OnInit(std::unique_ptr<XWalkExtensionFunctionInfo> info) {
@@ -86,6 +176,10 @@ void UDPSocketObject::OnInit(std::unique_ptr<XWalkExtensionFunctionInfo> info) {
     return;
   }
 
+  multicast_loopback_ = params->options->loopback;
+  if (params->options->multicast_ttl)
+    multicast_ttl_ = *params->options->multicast_ttl;
+
   if (!params->options->local_address.empty()) {
     net::IPAddress ip_number;
     if (!net::ParseURLHostnameToAddress(params->options->local_address,
@@ -98,7 +192,8 @@ void UDPSocketObject::OnInit(std::unique_ptr<XWalkExtensionFunctionInfo> info) {
 
     const net::IPEndPoint end_point(ip_number, params->options->local_port);
 
-    if (socket_->Open(end_point.GetFamily()) != net::OK) {
+    if (socket_->Open(end_point.GetFamily()) != net::OK ||
+        !SetMulticastOptions()) {
       LOG(WARNING) << "Cannot open UDP socket";
       setReadyState(READY_STATE_CLOSED);
       DispatchEvent("error");
@@ -143,6 +238,8 @@ void UDPSocketObject::OnInit(std::unique_ptr<XWalkExtensionFunctionInfo> info) {
 
 void UDPSocketObject::OnClose(std::unique_ptr<XWalkExtensionFunctionInfo> info) {
   socket_.reset();
+  has_read_pending_ = false;
+  pending_messages_.reset();
 }
 
 void UDPSocketObject::OnSuspend(std::unique_ptr<XWalkExtensionFunctionInfo> info) {
@@ -150,15 +247,60 @@ void UDPSocketObject::OnSuspend(std::unique_ptr<XWalkExtensionFunctionInfo> info
 }
 
 void UDPSocketObject::OnResume(std::unique_ptr<XWalkExtensionFunctionInfo> info) {
+  if (!is_suspended_)
+    return;
+
   is_suspended_ = false;
+
+  // Nothing is read before the first send() of a socket that isn't bound.
+  if (is_reading_)
+    DoRead();
 }
 
 void UDPSocketObject::OnJoinMulticast(
     std::unique_ptr<XWalkExtensionFunctionInfo> info) {
+  std::unique_ptr<JoinMulticast::Params>
+      params(JoinMulticast::Params::Create(*info->arguments()));
+  if (!params) {
+    LOG(WARNING) << "Malformed parameters passed to " << info->name();
+    return;
+  }
+
+  net::IPAddress group;
+  if (!socket_ || !net::ParseURLHostnameToAddress(
+          params->multicast_group_address, &group)) {
+    LOG(WARNING) << "Cannot join " << params->multicast_group_address;
+    return;
+  }
+
+  int ret = socket_->JoinGroup(group);
+  if (ret != net::OK) {
+    LOG(WARNING) << "Cannot join " << params->multicast_group_address << ": "
+                 << net::ErrorToString(ret);
+  }
 }
 
 void UDPSocketObject::OnLeaveMulticast(
     std::unique_ptr<XWalkExtensionFunctionInfo> info) {
+  std::unique_ptr<LeaveMulticast::Params>
+      params(LeaveMulticast::Params::Create(*info->arguments()));
+  if (!params) {
+    LOG(WARNING) << "Malformed parameters passed to " << info->name();
+    return;
+  }
+
+  net::IPAddress group;
+  if (!socket_ || !net::ParseURLHostnameToAddress(
+          params->multicast_group_address, &group)) {
+    LOG(WARNING) << "Cannot leave " << params->multicast_group_address;
+    return;
+  }
+
+  int ret = socket_->LeaveGroup(group);
+  if (ret != net::OK) {
+    LOG(WARNING) << "Cannot leave " << params->multicast_group_address << ": "
+                 << net::ErrorToString(ret);
+  }
 }
 
 void UDPSocketObject::OnSendString(
@@ -204,30 +346,9 @@ void UDPSocketObject::OnSendString(
 }
 
 void UDPSocketObject::OnRead(int status) {
-  // No data means the other side has
-  // disconnected the socket.
-  if (status == 0) {
-    setReadyState(READY_STATE_CLOSED);
-    DispatchEvent("close");
-    return;
-  }
-
-  std::unique_ptr<base::Value> data(base::BinaryValue::CreateWithCopiedBuffer(
-      static_cast<char*>(read_buffer_->data()), status));
-
-  UDPMessageEvent event;
-  std::string buffer_data(read_buffer_->data(), status);
-  std::copy(buffer_data.begin(), buffer_data.end(), back_inserter(event.data));
-  event.remote_port = from_.port();
-  event.remote_address = from_.ToStringWithoutPort();
-
-  std::unique_ptr<base::ListValue> eventData(new base::ListValue);
-  eventData->Append(event.ToValue().release());
-
-  if (!is_suspended_)
-    DispatchEvent("message", std::move(eventData));
-
-  DoRead();
+  has_read_pending_ = false;
+  if (HandleRead(status))
+    DoRead();
 }
 
 void UDPSocketObject::OnWrite(int status) {
@@ -258,6 +379,7 @@ void UDPSocketObject::OnSend(int status) {
     // it means the connection was closed.
     if (is_reading_ ||
         socket_->Open(addresses_[0].GetFamily()) != net::OK ||
+        !SetMulticastOptions() ||
         socket_->Connect(addresses_[0]) != net::OK) {
       setReadyState(READY_STATE_CLOSED);
       DispatchEvent("error");
@@ -5,8 +5,10 @@
 #ifndef XWALK_SYSAPPS_RAW_SOCKET_UDP_SOCKET_OBJECT_H_
 #define XWALK_SYSAPPS_RAW_SOCKET_UDP_SOCKET_OBJECT_H_
 
+#include <memory>
 #include <string>
 
+#include "base/memory/weak_ptr.h"
 #include "net/base/address_list.h"
 #include "net/base/io_buffer.h"
 #include "net/dns/single_request_host_resolver.h"
@@ -16,6 +18,11 @@
 namespace xwalk {
 namespace sysapps {
 
+// Datagrams are received in batches: the datagrams ready when the socket
+// wakes up are read and they are sent to JavaScript together in a single
+// "message" event, whose data is a list of UDPMessageEvent dictionaries.
+// After a bounded number of datagrams, reading continues in a new task.
+// Reading stops while the socket is suspended.
 class UDPSocketObject : public RawSocketObject {
  public:
   UDPSocketObject();
@@ -23,6 +30,13 @@ class UDPSocketObject : public RawSocketObject {
 
  private:
   void DoRead();
+  void ContinueReading();
+  // Adds the datagram read to |pending_messages_|. Returns false if the
+  // socket can't be read any more.
+  bool HandleRead(int status);
+  void DispatchMessages();
+  // Must be called after opening the socket, before binding or connecting.
+  bool SetMulticastOptions();
 
   // JavaScript function handlers.
   void OnInit(std::unique_ptr<XWalkExtensionFunctionInfo> info);
@@ -41,10 +55,14 @@ class UDPSocketObject : public RawSocketObject {
   void OnConnectionOpen(int status);
   void OnSend(int status);
 
+  bool has_read_pending_;
   bool has_write_pending_;
   bool is_suspended_;
   bool is_reading_;
 
+  bool multicast_loopback_;
+  int multicast_ttl_;
+
   scoped_refptr<net::IOBuffer> read_buffer_;
   scoped_refptr<net::IOBuffer> write_buffer_;
   std::unique_ptr<net::UDPSocket> socket_;
@@ -55,6 +73,9 @@ class UDPSocketObject : public RawSocketObject {
   std::unique_ptr<net::SingleRequestHostResolver> single_resolver_;
   net::AddressList addresses_;
   net::IPEndPoint from_;
+  std::unique_ptr<base::ListValue> pending_messages_;
+
+  base::WeakPtrFactory<UDPSocketObject> weak_factory_;
 };
 
 }  // namespace sysapps
@@ -33,6 +33,7 @@
         '../../net/net.gyp:net',
         '../../skia/skia.gyp:skia',
         '../../testing/gtest.gyp:gtest',
+        '../../testing/perf/perf_test.gyp:perf_test',
         '../extensions/extensions.gyp:xwalk_extensions',
         '../test/base/base.gyp:xwalk_test_base',
         '../xwalk.gyp:xwalk_runtime',
@@ -8,10 +8,13 @@
 
 #include "base/command_line.h"
 #include "base/environment.h"
+#include "base/json/json_reader.h"
 #include "base/logging.h"
 #include "base/path_service.h"
 #include "base/run_loop.h"
 #include "base/strings/string_number_conversions.h"
+#include "base/strings/utf_string_conversions.h"
+#include "base/values.h"
 #include "xwalk/runtime/browser/runtime.h"
 #include "xwalk/runtime/common/xwalk_paths.h"
 #include "xwalk/runtime/common/xwalk_switches.h"
@@ -71,4 +74,30 @@ void NavigateToURL(xwalk::Runtime* runtime, const GURL& url) {
   content::WaitForLoadStop(runtime->web_contents());
 }
 
+bool RunPerfPage(xwalk::Runtime* runtime, const GURL& url,
+                 std::unique_ptr<base::DictionaryValue>* results) {
+  const base::string16 pass_string = base::ASCIIToUTF16("Pass");
+  content::TitleWatcher title_watcher(runtime->web_contents(), pass_string);
+  title_watcher.AlsoWaitForTitle(base::ASCIIToUTF16("Fail"));
+  NavigateToURL(runtime, url);
+  if (title_watcher.WaitAndGetTitle() != pass_string) {
+    LOG(ERROR) << "Benchmark failed: " << url.spec();
+    return false;
+  }
+
+  std::string json;
+  if (!content::ExecuteScriptAndExtractString(
+          runtime->web_contents(),
+          "window.domAutomationController.send(JSON.stringify(results));",
+          &json))
+    return false;
+
+  *results = base::DictionaryValue::From(base::JSONReader::Read(json));
+  if (!*results) {
+    LOG(ERROR) << "Invalid benchmark results: " << json;
+    return false;
+  }
+  return true;
+}
+
 }  // namespace xwalk_test_utils
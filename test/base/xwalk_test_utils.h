@@ -5,6 +5,7 @@
 #ifndef XWALK_TEST_BASE_XWALK_TEST_UTILS_H_
 #define XWALK_TEST_BASE_XWALK_TEST_UTILS_H_
 
+#include <memory>
 #include <string>
 
 #include "base/compiler_specific.h"
@@ -13,6 +14,7 @@
 
 namespace base {
 class CommandLine;
+class DictionaryValue;
 }
 
 namespace xwalk {
@@ -42,6 +44,13 @@ base::FilePath GetTestFilePath(const base::FilePath& dir,
 // navigation completes.
 void NavigateToURL(xwalk::Runtime* runtime, const GURL& url);
 
+// Runs the benchmark page at |url| in the given Runtime. The page sets its
+// title to "Pass" or "Fail" when done, and keeps its measurements in a
+// global |results| object, returned in |results|. Returns false if the page
+// failed or its results couldn't be read.
+bool RunPerfPage(xwalk::Runtime* runtime, const GURL& url,
+                 std::unique_ptr<base::DictionaryValue>* results);
+
 }  // namespace xwalk_test_utils
 
 #endif  // XWALK_TEST_BASE_XWALK_TEST_UTILS_H_